@@ -48,4 +48,12 @@ constexpr uint16_t ROM_SIZE = 0x3000;       // 12KB (Monitor + BASIC)
 constexpr uint16_t TEXT_PAGE_SIZE = 0x400;  // 1KB per text page
 constexpr uint16_t HIRES_PAGE_SIZE = 0x2000; // 8KB per hi-res page
 
+// Video timing (NTSC): 65 CPU cycles per scanline, 262 scanlines per frame.
+// Scanlines 0-191 are displayed; VBL covers scanlines 192-261.
+constexpr uint64_t CYCLES_PER_SCANLINE = 65;
+constexpr uint64_t SCANLINES_PER_FRAME = 262;
+constexpr uint64_t VISIBLE_SCANLINES = 192;
+constexpr uint64_t CYCLES_PER_VIDEO_FRAME = CYCLES_PER_SCANLINE * SCANLINES_PER_FRAME;  // 17030
+constexpr uint64_t VBL_START_CYCLE = CYCLES_PER_SCANLINE * VISIBLE_SCANLINES;          // 12480
+
 } // namespace Apple2e
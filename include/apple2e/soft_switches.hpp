@@ -79,6 +79,7 @@ constexpr uint16_t RDPAGE2 = 0xC01C;       // Read: PAGE2 status (1=page2, 0=pag
 constexpr uint16_t RDHIRES = 0xC01D;       // Read: HIRES status (1=hires, 0=lores)
 constexpr uint16_t RDALTCHAR = 0xC01E;     // Read: ALTCHAR status (1=alt, 0=primary)
 constexpr uint16_t RD80VID = 0xC01F;       // Read: 80VID status (1=80col, 0=40col)
+constexpr uint16_t RDDHIRES = 0xC07F;      // Read: DHIRES status (1=double graphics, i.e. AN3 off)
 
 // =============================================================================
 // Speaker
@@ -130,8 +131,8 @@ constexpr uint16_t CLRAN1 = 0xC05A;        // Read/Write: Annunciator 1 off
 constexpr uint16_t SETAN1 = 0xC05B;        // Read/Write: Annunciator 1 on
 constexpr uint16_t CLRAN2 = 0xC05C;        // Read/Write: Annunciator 2 off
 constexpr uint16_t SETAN2 = 0xC05D;        // Read/Write: Annunciator 2 on
-constexpr uint16_t CLRAN3 = 0xC05E;        // Read/Write: Annunciator 3 off
-constexpr uint16_t SETAN3 = 0xC05F;        // Read/Write: Annunciator 3 on
+constexpr uint16_t CLRAN3 = 0xC05E;        // Read/Write: Annunciator 3 off (DHIRES on with 80VID)
+constexpr uint16_t SETAN3 = 0xC05F;        // Read/Write: Annunciator 3 on (DHIRES off)
 
 // =============================================================================
 // Language Card / Bank Switching ($C080-$C08F)
@@ -236,6 +237,10 @@ struct SoftSwitchState
   // Debug/diagnostic values (read from zero page, not soft switches)
   uint16_t csw = 0;                  // Character output Switch Vector ($36-$37)
   uint16_t ksw = 0;                  // Keyboard input Switch Vector ($38-$39)
+
+  // Added after version 1 save files, which dump the fields above; keep it
+  // last so their layout still lines up
+  bool dhires = false;               // AN3 off: double hi-res/lo-res when 80VID is on
 };
 
 } // namespace Apple2e
@@ -86,6 +86,11 @@ private:
    */
   std::string getSaveStatePath() const;
 
+  /**
+   * Get the path for the input recording file
+   */
+  std::string getRecordingPath() const;
+
   /**
    * Request application close (triggers save dialog)
    */
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * audio_sink - Audio output back-end for the speaker
+ *
+ * The speaker renders 16-bit mono samples into its own ring buffer; a sink
+ * is the platform piece that plays them. Sinks pull: once opened they call
+ * the supplied function (usually from an audio thread) whenever they need
+ * more frames. The macOS app uses coreaudio_sink; the headless runner uses
+ * no sink at all, in which case the speaker only tracks its state.
+ */
+class audio_sink
+{
+public:
+  // Fill out[0..frames) with samples
+  using pull_callback = std::function<void(int16_t *out, uint32_t frames)>;
+
+  virtual ~audio_sink() = default;
+
+  /**
+   * Start audio output
+   * @param sample_rate Samples per second (mono, signed 16-bit)
+   * @param frames_per_buffer Preferred frames per pull
+   * @param pull Function called to fetch samples
+   * @return true if output started
+   */
+  virtual bool open(int sample_rate, uint32_t frames_per_buffer, pull_callback pull) = 0;
+
+  /**
+   * Stop audio output; no pulls happen after this returns
+   */
+  virtual void close() = 0;
+
+  /**
+   * Get a short name for log messages
+   * @return Back-end name, e.g. "CoreAudio"
+   */
+  virtual const char *getName() const = 0;
+};
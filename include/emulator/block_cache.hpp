@@ -0,0 +1,201 @@
+#pragma once
+
+#include "emulator/mmu.hpp"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * block_cache - Predecoded basic-block execution engine for the 65C02
+ *
+ * An optional fast path that runs alongside the MOS6502 interpreter.
+ * Straight-line runs of instructions (basic blocks, ending at the first
+ * branch, jump, call or return) are decoded once into a list of handler
+ * pointers with their operands and base cycle counts. Executing a block
+ * then skips the opcode/operand fetches and decode entirely; only the data
+ * accesses of each instruction go through the MMU.
+ *
+ * Blocks are keyed by the MMU physical page and offset of their first
+ * instruction, not by CPU address. Switching the language card, RAMRD or
+ * ALTZP therefore just selects a different set of blocks instead of
+ * flushing anything, so the Monitor and Applesoft in ROM stay decoded no
+ * matter how often ProDOS banks them out. A block never spans a page.
+ *
+ * Writes through the MMU to a page holding decoded code drop all blocks of
+ * that page. Pages that keep getting rewritten (code mixed with data) are
+ * given up on and left to the interpreter.
+ *
+ * ROM pages can never be written, so their blocks live until flush(). A
+ * block remembers the ROM blocks it last handed over to, which lets hot
+ * Monitor and Applesoft loops chain from block to block without going back
+ * through the page lookup while the memory map stays the same.
+ *
+ * Anything the cache does not handle is reported back to the caller to be
+ * run by the interpreter: code in I/O and slot ROM space ($C000-$CFFF),
+ * BRK/WAI/STP, the undocumented NOPs, and instructions that straddle a page.
+ */
+class block_cache
+{
+public:
+  /**
+   * CPU registers, copied in and out of the interpreter around run()
+   */
+  struct registers
+  {
+    uint16_t pc = 0;
+    uint8_t sp = 0;
+    uint8_t p = 0;
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+  };
+
+  /**
+   * Constructs the cache and registers for code write notifications
+   * @param mmu MMU used for all data accesses and page lookups
+   */
+  explicit block_cache(MMU &mmu);
+
+  /**
+   * Destructor - unregisters from the MMU
+   */
+  ~block_cache();
+
+  // Delete copy constructor and assignment (non-copyable)
+  block_cache(const block_cache &) = delete;
+  block_cache &operator=(const block_cache &) = delete;
+
+  /**
+   * Execute cached blocks starting at regs.pc
+   * Runs until the total cycle count reaches target_cycles or the next
+   * instruction has to be run by the interpreter.
+   * @param regs CPU registers, updated in place
+   * @param base_cycles Interpreter cycle count (total = base_cycles + getCycles())
+   * @param target_cycles Stop once the total cycle count reaches this value
+   * @return Number of instructions executed (0 if PC is not cacheable)
+   */
+  uint64_t run(registers &regs, uint64_t base_cycles, uint64_t target_cycles);
+
+  /**
+   * Get the number of CPU cycles executed by the cache since construction
+   * @return Cycle count
+   */
+  uint64_t getCycles() const { return cycles_; }
+
+  /**
+   * Drop all blocks decoded from a physical page
+   * Safe to call while a block from that page is executing.
+   * @param physical_page MMU physical page number
+   */
+  void invalidatePage(uint16_t physical_page);
+
+  /**
+   * Drop every decoded block (e.g. after RAM was replaced wholesale)
+   */
+  void flush();
+
+  /**
+   * Make run() return before executing the block at an address, so the
+   * caller can look at that code first (e.g. to skip a delay routine)
+   * @param pc CPU address to stop at
+   */
+  void setStopAddress(uint16_t pc) { stop_pc_ = pc; }
+
+  /**
+   * Remove the stop address set with setStopAddress()
+   */
+  void clearStopAddress() { stop_pc_ = NO_STOP_ADDRESS; }
+
+private:
+  struct ops;
+  struct decoded_instruction;
+  using handler_fn = void (*)(block_cache &, const decoded_instruction &);
+
+  /**
+   * One predecoded instruction
+   */
+  struct decoded_instruction
+  {
+    handler_fn handler;
+    uint16_t operand;  // Immediate value, address, or branch target
+    uint16_t next_pc;  // Address of the following instruction
+    uint8_t cycles;    // Base cycle count (penalties added by the handler)
+    uint8_t zp;        // Zero page address for BBR/BBS
+  };
+
+  struct block;
+
+  /**
+   * Cached successor of a block, valid for one memory map generation
+   */
+  struct block_link
+  {
+    const block *target = nullptr;
+    uint32_t generation = 0;
+    uint16_t pc = 0;
+  };
+
+  /**
+   * One basic block
+   */
+  struct block
+  {
+    std::vector<decoded_instruction> instructions;
+    std::array<block_link, 2> links;  // [0] = fall through, [1] = jump or taken branch
+    bool rom = false;                 // Decoded from ROM, lives until flush()
+  };
+
+  /**
+   * Blocks decoded from one physical page
+   * A deque so that links to existing blocks survive decoding new ones
+   */
+  struct page_blocks
+  {
+    std::array<int32_t, 256> block_at;  // Block index by start offset, -1 = not decoded
+    std::deque<block> blocks;
+    uint32_t invalidations = 0;  // Times this page was written while holding code
+    bool stale = false;          // Blocks must be dropped before next use
+  };
+
+  // Longest block decoded in one go
+  static constexpr size_t MAX_BLOCK_LENGTH = 64;
+
+  // After this many invalidations a page is left to the interpreter
+  static constexpr uint32_t MAX_PAGE_INVALIDATIONS = 32;
+
+  // Out of CPU address range, never matches a PC
+  static constexpr uint32_t NO_STOP_ADDRESS = 0x10000;
+
+  /**
+   * Find or decode the block starting at pc
+   * @param pc CPU address
+   * @return Block (possibly empty), or nullptr if pc is not cacheable
+   */
+  block *findBlock(uint16_t pc);
+
+  /**
+   * Find the block to run after from, following or recording a link
+   * @param from Block that just ran to completion
+   * @return Next block (possibly empty), or nullptr if regs_.pc is not cacheable
+   */
+  block *nextBlock(block &from);
+
+  /**
+   * Decode a new block starting at pc into a page
+   * @param page Page entry to add the block to
+   * @param physical_page Physical page number of pc
+   * @param pc CPU address of the first instruction
+   * @return Index of the new block
+   */
+  int32_t decodeBlock(page_blocks &page, uint16_t physical_page, uint16_t pc);
+
+  MMU &mmu_;
+  registers regs_;
+  uint64_t cycles_ = 0;
+  uint32_t extra_cycles_ = 0;  // Page crossing, branch and decimal cycles of the running instruction
+  uint64_t invalidations_ = 0;  // Bumped whenever any page is invalidated
+  uint32_t stop_pc_ = NO_STOP_ADDRESS;
+  std::array<std::unique_ptr<page_blocks>, MMU::PHYS_PAGE_COUNT> pages_;
+};
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "emulator/watch_condition.hpp"
+#include <array>
 #include <cstdint>
+#include <functional>
 #include <vector>
-#include <unordered_map>
 #include <string>
 
+class MMU;
+
 /**
  * breakpoint_type - Types of breakpoints supported
  */
@@ -16,83 +20,244 @@ enum class breakpoint_type
 };
 
 /**
- * breakpoint - Represents a single breakpoint
+ * memory_bank - Which memory a breakpoint address refers to
+ *
+ * The same CPU address can be backed by different memory depending on the
+ * soft switches. A breakpoint limited to a bank only fires while that bank
+ * is mapped at the address (for reads and execution, or writes for write
+ * watchpoints). Written as a prefix in descriptions, using the same names
+ * as the profiler: "main:", "aux:", "lc1:", "aux-lc1:", "lc:" (language
+ * card RAM other than bank 1), "aux-lc:" and "rom:".
+ */
+enum class memory_bank : uint8_t
+{
+  ANY,       // Whatever is mapped
+  MAIN,
+  AUX,
+  LC1,       // Language card bank 1 ($D000-$DFFF)
+  AUX_LC1,
+  LC,        // Language card bank 2 and $E000-$FFFF
+  AUX_LC,
+  ROM,
+  UNMAPPED   // I/O, slot ROM or write-protected; never matches a breakpoint
+};
+
+/**
+ * breakpoint - Represents a single breakpoint or watchpoint
  */
 struct breakpoint
 {
   uint16_t address;
   breakpoint_type type;
   bool enabled = true;
+  uint16_t end_address = 0;           // Last address covered (equal to address for one)
+  memory_bank bank = memory_bank::ANY;
+  watch_condition condition;          // Empty breaks on every hit
+};
+
+/**
+ * breakpoint_hit - What stopped execution
+ */
+struct breakpoint_hit
+{
+  breakpoint_type type = breakpoint_type::EXECUTION;
+  uint16_t address = 0;  // Address accessed, or the PC for execution
+  uint8_t value = 0;     // Byte read or written
+  uint16_t pc = 0;       // Instruction that made the access
 };
 
 /**
  * breakpoint_manager - Manages all breakpoints and watchpoints
  *
- * Provides fast O(1) lookup for breakpoint checks during execution.
+ * Each type has a 64K-bit (8 KB) map of the addresses covered by its
+ * enabled breakpoints, so the common case (no breakpoint at this address)
+ * is a single branch-free bit test. Only on a hit is the list of enabled
+ * breakpoints of that type scanned for the bank and condition.
+ *
+ * Read and write watchpoints are checked by the MMU on every access while
+ * any are enabled. A hit that passes its condition is latched; the
+ * emulator picks it up with consumeHit() once the instruction finishes and
+ * pauses there.
+ *
  * Supports serialization for persistent storage across sessions.
  */
 class breakpoint_manager
 {
 public:
+  // Fills in the registers and instruction address for a condition
+  using ContextCallback = std::function<void(watch_condition::context &)>;
+
   breakpoint_manager() = default;
 
   /**
    * Add a breakpoint at the specified address
    * @param address Memory address
    * @param type Type of breakpoint
+   * @param bank Bank the address refers to
    */
-  void addBreakpoint(uint16_t address, breakpoint_type type);
+  void addBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank = memory_bank::ANY);
+
+  /**
+   * Add a breakpoint covering an address range, with an optional condition
+   * @param address First address
+   * @param end_address Last address (inclusive)
+   * @param type Type of breakpoint
+   * @param bank Bank the addresses refer to
+   * @param condition Condition source (see watch_condition), or empty
+   * @param error Receives the reason on failure
+   * @return true if added
+   */
+  bool addBreakpoint(uint16_t address, uint16_t end_address, breakpoint_type type, memory_bank bank,
+                     const std::string& condition, std::string& error);
+
+  /**
+   * Add a breakpoint from a text description
+   * Format: "TYPE [BANK:]ADDR[-END] [if CONDITION]", where TYPE is exec,
+   * read or write (or x, r, w), e.g. "write $C0E9", "exec lc1:$D000",
+   * "read $2000-$3FFF if A==#$FF" or "exec $0800 if [$36]!=$F0".
+   * @param spec Breakpoint description
+   * @param error Receives the reason on failure
+   * @return true if added
+   */
+  bool addWatchpoint(const std::string& spec, std::string& error);
 
   /**
    * Remove a breakpoint at the specified address
    * @param address Memory address
    * @param type Type of breakpoint
+   * @param bank Bank the breakpoint is limited to
+   */
+  void removeBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank = memory_bank::ANY);
+
+  /**
+   * Remove a breakpoint by its position in getBreakpoints()
+   * @param index Breakpoint index
    */
-  void removeBreakpoint(uint16_t address, breakpoint_type type);
+  void removeBreakpointAt(size_t index);
 
   /**
    * Toggle a breakpoint (add if not exists, remove if exists)
    * @param address Memory address
    * @param type Type of breakpoint
+   * @param bank Bank the breakpoint is limited to
    */
-  void toggleBreakpoint(uint16_t address, breakpoint_type type);
+  void toggleBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank = memory_bank::ANY);
 
   /**
    * Check if a breakpoint exists at the specified address
    * @param address Memory address
    * @param type Type of breakpoint
+   * @param bank Bank the breakpoint is limited to
    * @return true if breakpoint exists
    */
-  bool hasBreakpoint(uint16_t address, breakpoint_type type) const;
+  bool hasBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank = memory_bank::ANY) const;
 
   /**
    * Enable or disable a breakpoint
    * @param address Memory address
    * @param type Type of breakpoint
    * @param enabled true to enable, false to disable
+   * @param bank Bank the breakpoint is limited to
    */
-  void setEnabled(uint16_t address, breakpoint_type type, bool enabled);
+  void setEnabled(uint16_t address, breakpoint_type type, bool enabled, memory_bank bank = memory_bank::ANY);
+
+  /**
+   * Enable or disable a breakpoint by its position in getBreakpoints()
+   * @param index Breakpoint index
+   * @param enabled true to enable, false to disable
+   */
+  void setEnabledAt(size_t index, bool enabled);
+
+  /**
+   * Set where conditions get registers, and banks and memory come from
+   * @param context Fills in registers and the current instruction address
+   * @param mmu MMU for the memory map and side-effect free reads
+   */
+  void setEvaluationContext(ContextCallback context, const MMU* mmu);
+
+  /**
+   * Get the bank currently mapped at an address
+   * @param address CPU address
+   * @param type WRITE for the write mapping, otherwise the read mapping
+   * @return Bank, or UNMAPPED (also when no MMU was set)
+   */
+  memory_bank bankAt(uint16_t address, breakpoint_type type) const;
+
+  /**
+   * Get the description prefix of a bank, e.g. "lc1:"
+   * @param bank Bank
+   * @return Prefix, empty for ANY
+   */
+  static const char* bankPrefix(memory_bank bank);
 
   /**
    * Check if execution should break at the given PC
+   * Conditions see the opcode at pc as VALUE.
    * @param pc Program counter value
-   * @return true if should break
+   * @return true if should break (the hit is latched)
    */
-  bool checkExecution(uint16_t pc) const;
+  bool checkExecution(uint16_t pc)
+  {
+    return testBit(execution_bits_, pc) &&
+           evaluate(breakpoint_type::EXECUTION, pc, peek_callback_ ? peek_callback_(pc) : 0);
+  }
 
   /**
-   * Check if read should break at the given address
+   * Check a read against the read watchpoints
    * @param address Memory address being read
-   * @return true if should break
+   * @param value Byte read
+   * @return true if should break (the hit is latched)
    */
-  bool checkRead(uint16_t address) const;
+  bool checkRead(uint16_t address, uint8_t value)
+  {
+    return testBit(read_bits_, address) && evaluate(breakpoint_type::READ, address, value);
+  }
 
   /**
-   * Check if write should break at the given address
+   * Check a write against the write watchpoints
    * @param address Memory address being written
-   * @return true if should break
+   * @param value Byte being written
+   * @return true if should break (the hit is latched)
+   */
+  bool checkWrite(uint16_t address, uint8_t value)
+  {
+    return testBit(write_bits_, address) && evaluate(breakpoint_type::WRITE, address, value);
+  }
+
+  /**
+   * Take the latched hit, if any
+   * @param pc Address of the instruction that caused it, recorded in the hit
+   * @return true if a breakpoint hit since the last call
+   */
+  bool consumeHit(uint16_t pc)
+  {
+    if (!hit_pending_)
+    {
+      return false;
+    }
+    hit_pending_ = false;
+    last_hit_.pc = pc;
+    return true;
+  }
+
+  /**
+   * Get the most recent hit taken with consumeHit()
+   */
+  const breakpoint_hit& getLastHit() const { return last_hit_; }
+
+  /**
+   * Check if any execution breakpoint is enabled
+   * The emulator uses this to pick its undebugged fast run loop
+   * @return true if at least one enabled execution breakpoint exists
+   */
+  bool hasEnabledExecutionBreakpoints() const { return enabled_execution_count_ > 0; }
+
+  /**
+   * Check if any read or write watchpoint is enabled
+   * The MMU only calls checkRead()/checkWrite() while this is true
+   * @return true if at least one enabled read or write watchpoint exists
    */
-  bool checkWrite(uint16_t address) const;
+  bool hasEnabledWatchpoints() const { return enabled_watch_count_ > 0; }
 
   /**
    * Get all breakpoints
@@ -100,9 +265,24 @@ public:
    */
   const std::vector<breakpoint>& getBreakpoints() const { return breakpoints_; }
 
+  /**
+   * Describe a breakpoint in the form accepted by addWatchpoint()
+   * @param bp Breakpoint
+   * @return e.g. "write $C0E9" or "read $2000-$3FFF if A==#$FF"
+   */
+  static std::string describe(const breakpoint& bp);
+
+  /**
+   * Describe a hit, e.g. "write $C0E9=$12 at $0803"
+   * @param hit Hit to describe
+   * @return Description
+   */
+  static std::string describe(const breakpoint_hit& hit);
+
   /**
    * Serialize breakpoints to string for persistence
-   * Format: "ADDR:TYPE:ENABLED;ADDR:TYPE:ENABLED;..."
+   * Format: "ADDR:TYPE:ENABLED:END:CONDITION;..." (END and CONDITION may be
+   * missing, as written by older versions)
    * @return Serialized string
    */
   std::string serialize() const;
@@ -119,21 +299,52 @@ public:
   void clear();
 
 private:
+  using address_bitmap = std::array<uint64_t, 65536 / 64>;
+
+  static bool testBit(const address_bitmap& bits, uint16_t address)
+  {
+    return (bits[address >> 6] >> (address & 63)) & 1;
+  }
+
+  /**
+   * Scan the breakpoints of a type covering address; slow path after a
+   * bitmap hit
+   * @return true if one is enabled and its condition holds
+   */
+  bool evaluate(breakpoint_type type, uint16_t address, uint8_t value);
+
   std::vector<breakpoint> breakpoints_;
 
-  // Fast lookup maps (address -> indices in breakpoints_ vector)
-  std::unordered_map<uint16_t, std::vector<size_t>> execution_map_;
-  std::unordered_map<uint16_t, std::vector<size_t>> read_map_;
-  std::unordered_map<uint16_t, std::vector<size_t>> write_map_;
+  // Addresses covered by enabled breakpoints, one bitmap per type
+  address_bitmap execution_bits_{};
+  address_bitmap read_bits_{};
+  address_bitmap write_bits_{};
+
+  // Indices of the enabled breakpoints of each type, scanned on a bitmap
+  // hit; cleared rather than reallocated on rebuild
+  std::array<std::vector<uint32_t>, 3> enabled_;
+
+  // Number of enabled breakpoints by kind
+  size_t enabled_execution_count_ = 0;
+  size_t enabled_watch_count_ = 0;
+
+  // Condition inputs
+  ContextCallback context_callback_;
+  watch_condition::PeekFunction peek_callback_;
+  const MMU* mmu_ = nullptr;
+
+  // Hit waiting for consumeHit()
+  bool hit_pending_ = false;
+  breakpoint_hit last_hit_;
 
   /**
-   * Rebuild lookup maps after modifications
+   * Rebuild the address bitmaps and counts after modifications
    */
   void rebuildMaps();
 
   /**
-   * Find breakpoint index in vector
+   * Find the plain single-address breakpoint of a type and bank
    * @return Index or -1 if not found
    */
-  size_t findBreakpoint(uint16_t address, breakpoint_type type) const;
+  size_t findBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank) const;
 };
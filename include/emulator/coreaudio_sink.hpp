@@ -0,0 +1,41 @@
+#pragma once
+
+#include "emulator/audio_sink.hpp"
+
+// Forward declare AudioQueue types
+typedef struct OpaqueAudioQueue* AudioQueueRef;
+typedef struct AudioQueueBuffer* AudioQueueBufferRef;
+
+/**
+ * coreaudio_sink - audio_sink on a CoreAudio AudioQueue (macOS only)
+ *
+ * The queue runs on its own audio thread with a small number of buffers in
+ * flight; each time one is played, the callback pulls the next block of
+ * samples from the speaker and re-enqueues it.
+ */
+class coreaudio_sink final : public audio_sink
+{
+public:
+  // Number of AudioQueue buffers
+  static constexpr int NUM_BUFFERS = 3;
+
+  coreaudio_sink() = default;
+  ~coreaudio_sink() override;
+
+  coreaudio_sink(const coreaudio_sink &) = delete;
+  coreaudio_sink &operator=(const coreaudio_sink &) = delete;
+
+  bool open(int sample_rate, uint32_t frames_per_buffer, pull_callback pull) override;
+  void close() override;
+  const char *getName() const override { return "CoreAudio"; }
+
+private:
+  // AudioQueue callback
+  static void audioQueueCallback(void *userData,
+                                 AudioQueueRef queue,
+                                 AudioQueueBufferRef buffer);
+
+  AudioQueueRef audioQueue_ = nullptr;
+  AudioQueueBufferRef audioBuffers_[NUM_BUFFERS] = {nullptr};
+  pull_callback pull_;
+};
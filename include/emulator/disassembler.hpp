@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * 65C02 opcode table and single-instruction formatter
+ *
+ * Shared by the CPU window and a2e-tracedump, so both print instructions
+ * the same way.
+ */
+namespace disassembler
+{
+/**
+ * Opcode information for disassembly
+ */
+struct opcode_info
+{
+  const char *mnemonic;
+  int bytes;        // Instruction length, 1-3
+  const char *mode; // Operand printf format; branch targets are absolute
+};
+
+/**
+ * Simplified opcode table for 65C02, indexed by opcode
+ */
+extern const opcode_info OPCODES[256];
+
+/**
+ * Format one instruction as mnemonic and operand, e.g. "LDA $C08C,X"
+ * Relative branches print their target address.
+ * @param address Address of the opcode
+ * @param opcode Opcode byte
+ * @param op1 First operand byte (ignored for 1-byte instructions)
+ * @param op2 Second operand byte (ignored for 1- and 2-byte instructions)
+ * @return Formatted instruction
+ */
+std::string formatInstruction(uint16_t address, uint8_t opcode, uint8_t op1, uint8_t op2);
+} // namespace disassembler
@@ -2,6 +2,8 @@
 
 #include "device.hpp"
 #include "disk_image.hpp"
+#include "event_scheduler.hpp"
+#include "save_state.hpp"
 #include <array>
 #include <cstdint>
 #include <functional>
@@ -56,6 +58,15 @@ public:
    */
   bool initialize();
 
+  /**
+   * Load the controller ROM (341-0027) from a buffer instead of the
+   * resources folder; use in place of initialize()
+   * @param data ROM contents
+   * @param size Size of the data (must be 256 bytes)
+   * @return true on success
+   */
+  bool loadControllerROM(const uint8_t *data, size_t size);
+
   /**
    * Reset the controller to power-on state
    * Resets all state except ROM contents
@@ -118,6 +129,14 @@ public:
    */
   uint64_t getCycles() const;
 
+  /**
+   * Set the scheduler used for the motor-off timeout
+   * With a scheduler the motor turns off from a scheduled event; without
+   * one, isMotorOn() checks the elapsed delay each time it is called.
+   * @param scheduler Event scheduler, or nullptr
+   */
+  void setScheduler(event_scheduler *scheduler);
+
   // ===== Disk operations =====
 
   /**
@@ -140,6 +159,14 @@ public:
    */
   void saveAllDisks();
 
+  /**
+   * Choose whether writes go back to the image files on eject and shutdown
+   * Turned off by the headless runner so that sessions sharing an image
+   * never modify it; writes then only last as long as the disk is inserted.
+   * @param enabled true to save images (the default)
+   */
+  void setWriteBack(bool enabled) { write_back_ = enabled; }
+
   /**
    * Check if a drive has a disk inserted
    * @param drive Drive number (0 or 1)
@@ -214,6 +241,67 @@ public:
    */
   uint8_t getDataLatch() const { return data_latch_; }
 
+  // ===== Rewind support =====
+
+  /**
+   * Controller latches, timing and head positions for rewind snapshots
+   * Cycle stamps are absolute CPU cycles at capture time, 0 meaning unset.
+   * Disk contents are not included.
+   */
+  struct State
+  {
+    bool motor_on = false;
+    uint64_t motor_off_cycle = 0;  // Pending motor-off request (0 = none)
+    int selected_drive = 0;
+    bool q6 = false;
+    bool q7 = false;
+    uint8_t phase_states = 0;
+    uint8_t data_latch = 0;
+    bool latch_valid = false;
+    uint8_t write_latch = 0;
+    bool write_pending = false;
+    uint64_t last_read_cycle[2] = {0, 0};
+    uint64_t last_write_cycle[2] = {0, 0};
+    DiskImage::HeadState heads[2];
+  };
+
+  /**
+   * Capture the controller state
+   * @return Current state
+   */
+  State getState() const;
+
+  /**
+   * Restore a captured state
+   * The CPU clock never runs backwards, so restored cycle stamps (and a
+   * pending motor-off) are moved forward by cycle_offset to keep the same
+   * distance from the current cycle they had when captured.
+   * @param state State from getState()
+   * @param cycle_offset Current cycle minus the cycle the state was captured at
+   */
+  void restoreState(const State &state, uint64_t cycle_offset);
+
+  // ===== Save states =====
+
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("DSK2");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  /**
+   * Write the controller state, inserted image paths and head positions
+   * to a save state. Image contents are not saved; modified images are
+   * written back to their files as usual.
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Restore from a save state, inserting or ejecting images to match
+   * A saved image that can no longer be loaded leaves its drive empty.
+   * @param chunk Disk II chunk
+   * @return false if the chunk is too short
+   */
+  bool loadState(state_chunk &chunk);
+
 private:
   // Slot 6 I/O base address
   static constexpr uint16_t IO_BASE = 0xC0E0;
@@ -256,12 +344,17 @@ private:
   // Cycle count callback for timing
   CycleCountCallback cycle_callback_;
 
+  // Optional scheduler for the motor-off timeout, and the pending event
+  event_scheduler *scheduler_ = nullptr;
+  event_scheduler::event_id motor_off_event_ = event_scheduler::NO_EVENT;
+
   // Slot ROM (256 bytes - P5 ROM 341-0027)
   std::array<uint8_t, ROM_SIZE> slot_rom_;
   bool rom_loaded_ = false;
 
   // Disk images for each drive
   std::unique_ptr<DiskImage> disk_images_[2];
+  bool write_back_ = true;  // Save images on eject/shutdown
 
   // Per-drive timing state
   uint64_t last_read_cycle_[2] = {0, 0};  // Cycle count of last read
@@ -301,4 +394,14 @@ private:
    * @return byte value for reads
    */
   uint8_t handleSoftSwitch(uint8_t offset, bool is_write);
+
+  /**
+   * Drop a pending motor-off, scheduled or not
+   */
+  void cancelMotorOff();
+
+  /**
+   * Schedule the motor to turn off MOTOR_OFF_DELAY_CYCLES after motor_off_cycle_
+   */
+  void scheduleMotorOff();
 };
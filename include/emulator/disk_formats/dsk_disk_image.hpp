@@ -45,6 +45,8 @@ public:
   void setPhase(int phase, bool on) override;
   int getQuarterTrack() const override { return quarter_track_; }
   int getTrack() const override { return quarter_track_ / 4; }
+  HeadState getHeadState() const override;
+  void setHeadState(const HeadState &state) override;
 
   // ===== Geometry =====
   int getTrackCount() const override { return TRACKS; }
@@ -43,6 +43,8 @@ public:
   void setPhase(int phase, bool on) override;
   int getQuarterTrack() const override;
   int getTrack() const override;
+  HeadState getHeadState() const override;
+  void setHeadState(const HeadState &state) override;
 
   // Geometry
   int getTrackCount() const override;
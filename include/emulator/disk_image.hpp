@@ -98,6 +98,31 @@ public:
    */
   virtual int getTrack() const = 0;
 
+  /**
+   * Head position and stepper state, for rewind snapshots
+   * Track contents are not included; a restored head reads whatever the
+   * track holds now.
+   */
+  struct HeadState
+  {
+    int quarter_track = 0;     // Head position (0-159)
+    uint8_t phase_states = 0;  // Active phase magnets (bits 0-3)
+    int last_phase = 0;        // Last activated phase, for step direction
+    uint32_t position = 0;     // Bit (WOZ) or nibble (DSK) position in the track
+  };
+
+  /**
+   * Get the head position and stepper state
+   * @return Current head state
+   */
+  virtual HeadState getHeadState() const = 0;
+
+  /**
+   * Move the head back to a previously captured state
+   * @param state State from getHeadState()
+   */
+  virtual void setHeadState(const HeadState &state) = 0;
+
   // ===== Geometry =====
 
   /**
@@ -4,16 +4,26 @@
 #include "emulator/bus.hpp"
 #include "emulator/ram.hpp"
 #include "emulator/rom.hpp"
+#include "emulator/rom_images.hpp"
 #include "emulator/mmu.hpp"
 #include "emulator/keyboard.hpp"
 #include "emulator/speaker.hpp"
+#include "emulator/audio_sink.hpp"
 #include "emulator/video_display.hpp"
 #include "emulator/breakpoint_manager.hpp"
 #include "emulator/memory_access_tracker.hpp"
 #include "emulator/disk2_controller.hpp"
+#include "emulator/event_scheduler.hpp"
+#include "emulator/guest_profiler.hpp"
+#include "emulator/idle_detector.hpp"
+#include "emulator/input_log.hpp"
+#include "emulator/rewind_buffer.hpp"
+#include "emulator/trace_recorder.hpp"
 #include "apple2e/soft_switches.hpp"
 #include <memory>
 #include <functional>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -49,6 +59,9 @@ public:
     uint8_t x = 0;
     uint8_t y = 0;
     uint64_t total_cycles = 0;
+    uint64_t instructions_executed = 0;
+    double instructions_per_host_second = 0.0; // Emulation throughput, see runCycles()
+    uint64_t idle_cycles_skipped = 0;          // Cycles fast-forwarded over idle loops
     bool initialized = false;
   };
 
@@ -72,9 +85,15 @@ public:
 
   /**
    * Initialize the emulator components
+   * @param audio Speaker output (e.g. coreaudio_sink), or nullptr to run
+   *              silently as the headless runner does
+   * @param roms ROM images loaded by rom_images::load(), or nullptr to read
+   *             the system and Disk II ROMs from resources/roms. With images
+   *             the character ROM is loaded too.
    * @return true on success, false on failure
    */
-  bool initialize();
+  bool initialize(std::unique_ptr<audio_sink> audio = nullptr,
+                  std::shared_ptr<const rom_images> roms = nullptr);
 
   /**
    * Update the emulator state using audio-driven timing
@@ -82,9 +101,162 @@ public:
    */
   void update();
 
+  /**
+   * Run the CPU until the total cycle count reaches target_cycles
+   *
+   * Uses a tight loop with at most an execution breakpoint bit test per
+   * instruction while the emulator is RUNNING with no watchpoints, and the
+   * instrumented loop (watchpoints, step over/out, tracing) otherwise.
+   * Stops early if a breakpoint, watchpoint or step mode pauses execution.
+   * @param target_cycles Absolute CPU cycle count to run up to
+   * @return Number of CPU cycles actually executed
+   */
+  uint64_t runCycles(uint64_t target_cycles);
+
+  /**
+   * Get the number of instructions executed since initialization
+   * @return Instruction count
+   */
+  uint64_t getInstructionsExecuted() const { return instructions_executed_; }
+
+  /**
+   * Get emulation throughput in instructions per second of host time spent
+   * inside runCycles(), updated about once per second. Unlike the emulated
+   * MHz this is not capped by audio-driven timing, so it shows how much
+   * headroom the run loop has.
+   * @return Instructions per host second
+   */
+  double getInstructionsPerHostSecond() const { return instructions_per_host_second_; }
+
+  /**
+   * Enable or disable the predecoded block cache (see block_cache.hpp)
+   * Only used by the fast run loop; the debugger and the memory access
+   * visualizer always run on the interpreter.
+   * @param enabled true to run cacheable code from predecoded blocks
+   */
+  void setBlockCacheEnabled(bool enabled);
+
+  /**
+   * Check if the predecoded block cache is enabled
+   * @return true if enabled
+   */
+  bool isBlockCacheEnabled() const { return block_cache_enabled_; }
+
+  /**
+   * Enable or disable fast-forwarding over idle loops (see idle_detector.hpp)
+   * Skipping is exact, but like the block cache it is only used by the
+   * fast run loop.
+   * @param enabled true to skip keyboard poll and WAIT delay loops
+   */
+  void setIdleSkipEnabled(bool enabled);
+
+  /**
+   * Check if idle loop fast-forwarding is enabled
+   * @return true if enabled
+   */
+  bool isIdleSkipEnabled() const { return idle_skip_enabled_; }
+
+  // Warp speed multiplier meaning "as fast as the host allows"
+  static constexpr uint32_t WARP_UNLIMITED = 0;
+
+  /**
+   * Turn warp mode on or off
+   * While warping, update() runs the CPU faster than real time with the
+   * speaker suspended instead of pacing it from the audio buffer.
+   * @param enabled true to warp regardless of disk activity
+   */
+  void setWarpEnabled(bool enabled) { warp_enabled_ = enabled; }
+
+  /**
+   * Check if warp mode has been turned on manually
+   * @return true if enabled
+   */
+  bool isWarpEnabled() const { return warp_enabled_; }
+
+  /**
+   * Warp automatically while a Disk II drive motor is running
+   * @param enabled true to enable auto-warp
+   */
+  void setAutoWarp(bool enabled) { auto_warp_ = enabled; }
+
+  /**
+   * Check if auto-warp on disk activity is enabled
+   * @return true if enabled
+   */
+  bool isAutoWarpEnabled() const { return auto_warp_; }
+
+  /**
+   * Set the warp speed
+   * @param multiplier Emulated frames per host frame (2, 4, 8...), or WARP_UNLIMITED
+   */
+  void setWarpSpeed(uint32_t multiplier) { warp_speed_ = multiplier; }
+
+  /**
+   * Get the warp speed
+   * @return Multiplier, or WARP_UNLIMITED
+   */
+  uint32_t getWarpSpeed() const { return warp_speed_; }
+
+  /**
+   * Check if the emulator is currently warping (manually or automatically)
+   * @return true if running faster than real time
+   */
+  bool isWarping() const;
+
+  // Rewind snapshots are taken every REWIND_INTERVAL_FRAMES video frames
+  // and kept for up to REWIND_HISTORY_SECONDS, within REWIND_MEMORY_BUDGET
+  // bytes of stored RAM pages
+  static constexpr uint32_t REWIND_INTERVAL_FRAMES = 6;
+  static constexpr uint32_t REWIND_HISTORY_SECONDS = 60;
+  static constexpr size_t REWIND_KEYFRAME_INTERVAL = 100;
+  static constexpr size_t REWIND_MEMORY_BUDGET = 4 * 1024 * 1024;
+
+  /**
+   * Turn rewind snapshots on or off
+   * Turning rewind off frees the history.
+   * @param enabled true to keep a rewind history
+   */
+  void setRewindEnabled(bool enabled);
+
+  /**
+   * Check if rewind snapshots are being taken
+   * @return true if enabled
+   */
+  bool isRewindEnabled() const { return rewind_ != nullptr; }
+
+  /**
+   * Go back in time to an earlier snapshot
+   * History after the restored snapshot is discarded. Disk contents are
+   * not rewound. Refused while recording input; ends a replay.
+   * @param frames Video frames to go back, rounded down to a snapshot
+   *               (0 restores the most recent one)
+   * @return true if a snapshot was restored
+   */
+  bool rewind(uint32_t frames);
+
+  /**
+   * Get how far back rewind can currently go
+   * @return Seconds of history
+   */
+  double getRewindSeconds() const;
+
+  /**
+   * Get the memory held by the rewind history
+   * @return Bytes of stored RAM pages
+   */
+  size_t getRewindMemoryUsage() const { return rewind_ ? rewind_->getMemoryUsage() : 0; }
+
+  /**
+   * Get the number of CPU cycles fast-forwarded over idle loops
+   * @return Cycle count since initialization
+   */
+  uint64_t getIdleCyclesSkipped() const { return idle_cycles_skipped_; }
+
   /**
    * Hard reset - simulate power cycle (cold boot)
-   * Clears RAM and resets all soft switches
+   * Clears RAM and resets all soft switches. The power-on RAM pattern comes
+   * from a seeded generator whose state is saved with the machine, so a
+   * replayed reset leaves the same pattern.
    */
   void reset();
 
@@ -134,6 +306,75 @@ public:
    */
   void keyDown(uint8_t key_code);
 
+  /**
+   * Insert a disk image into a drive
+   * Use this rather than the disk controller directly so the insert is
+   * recorded (see startRecording()).
+   * @param drive Drive number (0 or 1)
+   * @param path Disk image file
+   * @return true if the image was loaded
+   */
+  bool insertDisk(int drive, const std::string& path);
+
+  /**
+   * Eject the disk from a drive, recording it like insertDisk()
+   * @param drive Drive number (0 or 1)
+   */
+  void ejectDisk(int drive);
+
+  /**
+   * Start recording input for deterministic replay (see input_log.hpp)
+   * The current machine state becomes the starting point; from here on
+   * every keyDown(), reset(), warmReset(), insertDisk() and ejectDisk() is
+   * logged with the cycle it was applied at. Rewinding and loading a state
+   * are refused while recording. Disk contents are not recorded, so replay
+   * needs the images as they were when recording started.
+   * @return false if not initialized or already recording
+   */
+  bool startRecording();
+
+  /**
+   * Stop recording and write the recording file
+   * The recording ends even if the file can't be written.
+   * @param path File to create or replace
+   * @return true if the file was written
+   */
+  bool stopRecording(const std::string& path);
+
+  /**
+   * Check if input is being recorded
+   * @return true while recording
+   */
+  bool isRecording() const { return recording_ != nullptr; }
+
+  /**
+   * Load a recording and replay its input as the machine runs
+   * Restores the recording's starting state, then applies each event at
+   * its recorded cycle. update() runs unthrottled while replaying. Any
+   * input from the user (a key press, reset or disk change) takes over
+   * and ends the replay.
+   * @param path Recording file from stopRecording()
+   * @return false if the file is not a recording or can't be loaded
+   */
+  bool startReplay(const std::string& path);
+
+  /**
+   * Abandon a replay, leaving the machine where it is
+   */
+  void stopReplay();
+
+  /**
+   * Check if a recording is being replayed
+   * @return true until the replay reaches the end of the recording
+   */
+  bool isReplaying() const { return replay_ != nullptr; }
+
+  /**
+   * Get the cycle the replayed recording ends at
+   * @return End cycle, or 0 if not replaying
+   */
+  uint64_t getReplayEndCycle() const { return replay_ ? replay_->getEndCycle() : 0; }
+
   /**
    * Check if keyboard has a pending key (strobe is set)
    */
@@ -189,12 +430,6 @@ public:
    */
   const std::array<uint8_t, 65536>& getAuxRAM() const;
 
-  /**
-   * Initialize video display texture with Metal device
-   * @param device Metal device for texture creation
-   */
-  void initializeVideoTexture(void* device);
-
   /**
    * Load character ROM for video display
    * @param path Path to character ROM file
@@ -204,6 +439,9 @@ public:
 
   /**
    * Save emulator state to file
+   * Writes a chunked state (see save_state.hpp) covering the CPU and clock,
+   * soft switches, RAM, keyboard, speaker and Disk II controller, including
+   * the paths of the inserted disk images, and the power-on RAM generator.
    * @param path Path to save file
    * @return true on success
    */
@@ -211,6 +449,9 @@ public:
 
   /**
    * Load emulator state from file
+   * The file is memory-mapped and each component restores itself from its
+   * own chunk; chunks this build doesn't know are skipped. Refused while
+   * recording input; ends a replay.
    * @param path Path to save file
    * @return true on success
    */
@@ -267,6 +508,46 @@ public:
    */
   memory_access_tracker* getAccessTracker();
 
+  /**
+   * Turn instruction tracing on or off
+   * While tracing, execution takes the instrumented path, one instruction at
+   * a time, with no block cache or idle skip.
+   * @param enabled true to record every executed instruction
+   */
+  void setTracing(bool enabled);
+
+  /**
+   * Check if instructions are being traced
+   * @return true while tracing
+   */
+  bool isTracing() const { return tracer_ && tracer_->isEnabled(); }
+
+  /**
+   * Get the execution trace recorder
+   * @return Pointer to trace recorder, for streaming or saving the trace
+   */
+  trace_recorder* getTraceRecorder();
+
+  /**
+   * Turn the guest code profiler on or off
+   * Like tracing, profiling runs the instrumented path. Counts are kept
+   * while it is off until the profiler is cleared.
+   * @param enabled true to profile executed instructions
+   */
+  void setProfiling(bool enabled);
+
+  /**
+   * Check if the guest code profiler is running
+   * @return true while profiling
+   */
+  bool isProfiling() const { return profiler_ && profiler_->isEnabled(); }
+
+  /**
+   * Get the guest code profiler
+   * @return Pointer to profiler, for reports and export
+   */
+  guest_profiler* getProfiler();
+
   /**
    * Get disk controller for disk operations
    * @return Pointer to disk controller
@@ -277,6 +558,129 @@ private:
   // Forward declaration to avoid template complexity in header
   class cpu_wrapper;
 
+  /**
+   * Run loop for RUNNING with no watchpoints, tracing or profiling
+   * Execution breakpoints cost one bitmap test per instruction, with the
+   * block cache and idle skipping (which skip over instructions) off.
+   * @param target_cycles Absolute CPU cycle count to run up to
+   */
+  void runFast(uint64_t target_cycles);
+
+  /**
+   * Run loop with breakpoint, watchpoint and step over/out handling
+   * @param target_cycles Absolute CPU cycle count to run up to
+   */
+  void runInstrumented(uint64_t target_cycles);
+
+  /**
+   * Run one host frame's worth of warp
+   * @param cycles_per_frame CPU cycles in one real-time frame
+   */
+  void runWarp(uint64_t cycles_per_frame);
+
+  /**
+   * (Re)start the recurring VBL and audio batch events from the current cycle
+   * VBL edges stay in phase with the absolute cycle count.
+   */
+  void scheduleTimingEvents();
+
+  /**
+   * VBL start event: flag VBL in the MMU and schedule its end
+   * @param cycle Cycle the event was scheduled for
+   */
+  void onVblStart(uint64_t cycle);
+
+  /**
+   * VBL end event: clear VBL in the MMU and schedule the next start
+   * @param cycle Cycle the event was scheduled for
+   */
+  void onVblEnd(uint64_t cycle);
+
+  /**
+   * Audio batch event: bring the speaker up to date and schedule the next batch
+   * @param cycle Cycle the event was scheduled for
+   */
+  void onAudioBatch(uint64_t cycle);
+
+  /**
+   * Load a version 1 save state (raw registers, SoftSwitchState and RAM)
+   * @param data File contents
+   * @param size File size
+   * @return true on success
+   */
+  bool loadLegacyState(const uint8_t* data, size_t size);
+
+  /**
+   * Write every component's chunk to a save state
+   * @param out Save state being built
+   */
+  void writeState(state_writer& out) const;
+
+  /**
+   * Restore every component that has a chunk in a save state
+   * @param in Parsed save state
+   * @return false if a chunk was damaged (the state is then partly restored)
+   */
+  bool restoreState(const state_reader& in);
+
+  /**
+   * Bring caches, history and device timing in line with a loaded state
+   */
+  void resyncAfterLoad();
+
+  /**
+   * Cold reset, as done by reset() and by a replayed reset
+   */
+  void coldReset();
+
+  /**
+   * Warm reset, as done by warmReset() and by a replayed one
+   */
+  void applyWarmReset();
+
+  /**
+   * Log an input event if recording; user input during a replay ends it
+   */
+  void noteInput(input_log::event_type type, uint8_t value = 0, const std::string& path = std::string());
+
+  /**
+   * Apply a replayed input event
+   */
+  void applyInput(const input_log::event& e);
+
+  /**
+   * Schedule the replay event for the next logged input (or the end)
+   */
+  void scheduleReplayEvent();
+
+  /**
+   * Replay event: apply every input due by now and schedule the next
+   */
+  void onReplayEvent();
+
+  /**
+   * Next value of the power-on RAM pattern generator (xorshift64*)
+   */
+  uint32_t nextRandom();
+
+  /**
+   * Schedule the next rewind snapshot on a REWIND_INTERVAL_FRAMES boundary
+   */
+  void scheduleRewindCapture();
+
+  /**
+   * Rewind event: take a snapshot and schedule the next
+   * @param cycle Cycle the event was scheduled for
+   */
+  void onRewindCapture(uint64_t cycle);
+
+  /**
+   * Fast-forward over an idle loop at the current PC, if there is one
+   * @param max_cycles Most cycles that may be skipped
+   * @return Number of cycles skipped
+   */
+  uint64_t skipIdleLoop(uint64_t max_cycles);
+
   // Core emulator components
   std::unique_ptr<Bus> bus_;
   std::unique_ptr<RAM> ram_;
@@ -290,11 +694,64 @@ private:
 
   bool first_update_ = true; // Track first update to sync speaker timing
 
+  // Device events keyed on CPU cycles; the run loops execute up to the next
+  // deadline in one burst and fire due events between bursts
+  event_scheduler scheduler_;
+  event_scheduler::event_id vbl_event_ = event_scheduler::NO_EVENT;
+  event_scheduler::event_id audio_event_ = event_scheduler::NO_EVENT;
+  event_scheduler::event_id rewind_event_ = event_scheduler::NO_EVENT;
+
   // Debugger state
   execution_state exec_state_ = execution_state::RUNNING;
   std::unique_ptr<breakpoint_manager> breakpoint_mgr_;
   uint8_t step_out_stack_depth_ = 0;
+  uint16_t instruction_pc_ = 0;  // Instruction being executed, for watch conditions
+  bool resuming_ = false;        // Skip the execution breakpoint we resumed from
 
   // Memory access tracking for visualization
   std::unique_ptr<memory_access_tracker> access_tracker_;
+
+  // Instruction-level execution trace
+  std::unique_ptr<trace_recorder> tracer_;
+
+  // Guest code profiler
+  std::unique_ptr<guest_profiler> profiler_;
+
+  // Throughput counters
+  uint64_t instructions_executed_ = 0;
+  uint64_t ips_window_instructions_ = 0;               // Instructions in current measurement window
+  std::chrono::steady_clock::duration ips_window_busy_{}; // Host time spent in runCycles() this window
+  std::chrono::steady_clock::time_point ips_window_start_{};
+  double instructions_per_host_second_ = 0.0;
+
+  // Run cacheable code from predecoded blocks in runFast()
+  bool block_cache_enabled_ = false;
+
+  // Idle loop fast-forward in runFast()
+  std::unique_ptr<idle_detector> idle_detector_;
+  bool idle_skip_enabled_ = true;
+  uint64_t idle_cycles_skipped_ = 0;
+
+  // Warp mode
+  bool warp_enabled_ = false;
+  bool auto_warp_ = true;
+  uint32_t warp_speed_ = WARP_UNLIMITED;
+  bool warp_active_ = false;  // Speaker currently suspended for warp
+
+  // Rewind history (nullptr while rewind is off)
+  std::unique_ptr<rewind_buffer> rewind_;
+
+  // Power-on RAM pattern generator; saved with the machine state
+  static constexpr uint32_t RNG_STATE_TAG = save_state::makeTag("RNG ");
+  static constexpr uint16_t RNG_STATE_VERSION = 1;
+  uint64_t rng_state_ = 0x9E3779B97F4A7C15ULL;
+
+  // Input recording: the starting state and the events since
+  std::unique_ptr<input_log> recording_;
+  state_writer recording_start_;
+
+  // Input replay: the log being replayed and the next event to apply
+  std::unique_ptr<input_log> replay_;
+  size_t replay_next_ = 0;
+  event_scheduler::event_id replay_event_ = event_scheduler::NO_EVENT;
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+/**
+ * event_scheduler - Device events keyed on the CPU cycle count
+ *
+ * Devices register a callback to run at an absolute CPU cycle instead of
+ * polling the clock: the Disk II motor-off timeout, the VBL edges, audio
+ * sample batches and, later, interrupt sources on expansion cards. The run
+ * loop executes the CPU in one burst up to getNextDeadline() and then calls
+ * runDue(), so the timing cost is one compare per burst rather than work on
+ * every instruction.
+ *
+ * Events live in a binary min-heap ordered by cycle; events due on the same
+ * cycle fire in the order they were scheduled. Callbacks receive the cycle
+ * they were scheduled for (not the possibly later current cycle) so periodic
+ * events can reschedule themselves without drifting, and may freely schedule
+ * or cancel other events. An event fires at the first instruction boundary
+ * at or after its cycle, which is the same point a device polling the cycle
+ * count would have noticed it.
+ */
+class event_scheduler
+{
+public:
+  using event_id = uint64_t;
+  using callback = std::function<void(uint64_t cycle)>;
+
+  // Never returned by schedule(); marks "no event scheduled"
+  static constexpr event_id NO_EVENT = 0;
+
+  // getNextDeadline() when no events are pending
+  static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * Schedule a callback
+   * @param cycle Absolute CPU cycle to fire at
+   * @param fn Function to call, passed the scheduled cycle
+   * @return Id that can be passed to cancel()
+   */
+  event_id schedule(uint64_t cycle, callback fn);
+
+  /**
+   * Remove a pending event
+   * @param id Event id from schedule() (NO_EVENT is ignored)
+   * @return true if the event was pending
+   */
+  bool cancel(event_id id);
+
+  /**
+   * Check whether an event is still waiting to fire
+   * @param id Event id from schedule()
+   * @return true if pending
+   */
+  bool isPending(event_id id) const;
+
+  /**
+   * Get the cycle of the earliest pending event
+   * @return Deadline, or NO_DEADLINE if nothing is scheduled
+   */
+  uint64_t getNextDeadline() const
+  {
+    return heap_.empty() ? NO_DEADLINE : heap_.front().cycle;
+  }
+
+  /**
+   * Fire every event due at or before the given cycle, in order
+   * @param cycle Current CPU cycle count
+   */
+  void runDue(uint64_t cycle);
+
+  /**
+   * Drop all pending events
+   */
+  void clear();
+
+  /**
+   * Get the number of pending events
+   */
+  size_t size() const { return heap_.size(); }
+
+private:
+  struct event
+  {
+    uint64_t cycle;
+    event_id id;  // Increasing, so also the tie-break order
+    callback fn;
+  };
+
+  // Heap comparator: the earliest event sorts to the front
+  static bool later(const event &a, const event &b)
+  {
+    return a.cycle != b.cycle ? a.cycle > b.cycle : a.id > b.id;
+  }
+
+  std::vector<event> heap_;
+  event_id next_id_ = 1;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "emulator/frame_sink.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * file_frame_sink - frame_sink that writes frames as image files
+ *
+ * Writes every Nth frame presented to a numbered file. Images are binary
+ * PPM (P6) or PNG, picked by the file extension, at the frame's current
+ * width (280 or 560) by 192. PNGs are written with stored (uncompressed)
+ * deflate blocks, so no compression library is needed. Plain C++, so
+ * screenshots and frame dumps work in a headless process with no GPU.
+ */
+class file_frame_sink final : public frame_sink
+{
+public:
+  enum class image_format : uint8_t
+  {
+    PPM,
+    PNG
+  };
+
+  /**
+   * Constructor
+   * @param pattern Output path. One %d or %0Nd field (e.g. "frames/%05d.png")
+   *                is replaced by the frame number; without one the number
+   *                goes before the extension.
+   * @param every Write every Nth frame presented, starting with the first
+   */
+  explicit file_frame_sink(std::string pattern, uint32_t every = 1);
+
+  bool present(const video_frame &frame) override;
+  const char *getName() const override { return "file"; }
+
+  /**
+   * Get the number of frames written
+   */
+  uint64_t getFramesWritten() const { return written_; }
+
+  /**
+   * Write one frame as an image
+   * @param path Output file
+   * @param frame Frame to write
+   * @param format Image format
+   * @return true on success
+   */
+  static bool writeImage(const std::string &path, const video_frame &frame, image_format format);
+
+  /**
+   * Write one frame as an image, in the format the extension names
+   * @param path Output file (.ppm for PPM, anything else PNG)
+   * @param frame Frame to write
+   * @return true on success
+   */
+  static bool writeImage(const std::string &path, const video_frame &frame);
+
+  /**
+   * Get the image format for a path's extension
+   * @param path File path
+   * @return PPM for .ppm, otherwise PNG
+   */
+  static image_format formatForPath(const std::string &path);
+
+private:
+  /**
+   * Build the file name for a frame
+   * @param number Frame number
+   */
+  std::string framePath(uint64_t number) const;
+
+  std::string pattern_;
+  image_format format_;
+  uint32_t every_;
+  uint64_t presented_ = 0;
+  uint64_t written_ = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * video_frame - A view of a frame rendered by video_display
+ *
+ * Pixels are 32-bit RGBA (R in the low byte, as in an RGBA8 texture on a
+ * little-endian host). Only the first width pixels of each row are in use;
+ * rows are stride pixels apart.
+ */
+struct video_frame
+{
+  const uint32_t *pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+
+  // Band of rows changed by the update that rendered the frame
+  int first_changed_line = 0;
+  int changed_line_count = 0;
+};
+
+/**
+ * frame_sink - Video output back-end for the display
+ *
+ * video_display renders frames into its own buffer with no platform
+ * dependencies; a sink is the piece that shows or stores them. Sinks are
+ * pushed each frame the display changed. The macOS app uses
+ * metal_frame_sink; sdl_frame_sink feeds an SDL renderer; file_frame_sink
+ * writes image files and works anywhere, including the headless runner.
+ */
+class frame_sink
+{
+public:
+  virtual ~frame_sink() = default;
+
+  /**
+   * Take a frame
+   * Sinks that keep a copy may upload only the changed band.
+   * @param frame Frame from video_display::getFrame()
+   * @return true on success
+   */
+  virtual bool present(const video_frame &frame) = 0;
+
+  /**
+   * Get a short name for log messages
+   * @return Back-end name, e.g. "Metal"
+   */
+  virtual const char *getName() const = 0;
+};
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "emulator/mmu.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * guest_profiler - Where the running 6502 program spends its cycles
+ *
+ * Counts instructions and cycles for every code location, builds a call
+ * graph from JSR/BRK and the stack pointer, and keeps an opcode histogram.
+ * The emulator calls beginInstruction()/endInstruction() around each
+ * instruction while profiling, so counts are exact.
+ *
+ * Locations are physical rather than CPU addresses, so the same address in
+ * main RAM, aux RAM, a language card bank or ROM is counted separately: the
+ * first MMU::PHYS_PAGE_COUNT pages follow the MMU's physical page numbers,
+ * and $C000-$CFFF (slot ROM) follows them.
+ *
+ * A call frame is pushed by JSR or BRK and popped once the stack pointer
+ * rises back to where it was before the call, which covers RTS and RTI as
+ * well as code that drops its return address and jumps. Each frame is also
+ * a node in a tree of call paths, which gives exclusive cycles per path for
+ * collapsed-stack (flame graph) export.
+ */
+class guest_profiler
+{
+public:
+  static constexpr uint32_t SLOT_SPACE = MMU::PHYS_PAGE_COUNT * 256u;
+  static constexpr uint32_t LOCATION_COUNT = SLOT_SPACE + 0x1000;
+
+  // Function id for code run outside any call seen by the profiler
+  static constexpr uint32_t TOP_LEVEL = 0xFFFFFFFF;
+
+  // Deepest call stack tracked; deeper calls count toward their caller
+  static constexpr size_t MAX_DEPTH = 256;
+
+  struct hot_spot
+  {
+    uint32_t location;
+    uint64_t instructions;
+    uint64_t cycles;
+  };
+
+  struct function_stats
+  {
+    uint32_t entry;             // Location of the first instruction
+    uint64_t calls = 0;
+    uint64_t inclusive_cycles = 0;  // Including callees, counted once under recursion
+    uint64_t exclusive_cycles = 0;  // In the function's own code
+  };
+
+  struct call_edge
+  {
+    uint32_t caller;
+    uint32_t callee;
+    uint64_t calls = 0;
+    uint64_t cycles = 0;        // Inclusive cycles of calls along this edge
+  };
+
+  struct opcode_stats
+  {
+    uint64_t count = 0;
+    uint64_t cycles = 0;
+  };
+
+  /**
+   * Constructs a profiler
+   * @param mmu MMU used to find the physical location and opcode at the PC
+   */
+  explicit guest_profiler(const MMU &mmu);
+
+  /**
+   * Turn profiling on or off; counts are kept until clear()
+   * @param enabled true to profile
+   */
+  void setEnabled(bool enabled);
+
+  /**
+   * Check whether profiling is on
+   */
+  bool isEnabled() const { return enabled_; }
+
+  /**
+   * Discard all counts
+   */
+  void clear();
+
+  /**
+   * Forget the call stack, e.g. after a state load replaced the stack
+   */
+  void resetCallStack();
+
+  /**
+   * Note the instruction about to execute
+   * @param pc Address of the opcode
+   * @param sp Stack pointer before execution
+   * @param cycle CPU cycle count before execution
+   */
+  void beginInstruction(uint16_t pc, uint8_t sp, uint64_t cycle);
+
+  /**
+   * Account for the instruction started by beginInstruction()
+   * @param next_pc Program counter after execution
+   * @param sp Stack pointer after execution
+   * @param cycle CPU cycle count after execution
+   */
+  void endInstruction(uint16_t next_pc, uint8_t sp, uint64_t cycle);
+
+  /**
+   * Get the busiest locations by cycles
+   * @param count Most entries to return
+   * @return Hot spots, most cycles first
+   */
+  std::vector<hot_spot> getHotSpots(size_t count) const;
+
+  /**
+   * Get every function called since the last clear()
+   * @return Functions, most inclusive cycles first; the first entry may be
+   *         TOP_LEVEL for cycles spent outside any call
+   */
+  std::vector<function_stats> getFunctions() const;
+
+  /**
+   * Get every caller/callee pair seen since the last clear()
+   * @return Edges, most cycles first
+   */
+  std::vector<call_edge> getCallEdges() const;
+
+  /**
+   * Get the opcode histogram
+   */
+  const std::array<opcode_stats, 256> &getOpcodeStats() const { return opcodes_; }
+
+  uint64_t getTotalInstructions() const { return total_instructions_; }
+  uint64_t getTotalCycles() const { return total_cycles_; }
+
+  /**
+   * Map a CPU address to a location using the current memory map
+   * @param address CPU address
+   * @return Profiler location
+   */
+  uint32_t locationOf(uint16_t address) const;
+
+  /**
+   * Get the CPU address a location is normally seen at
+   * @param location Profiler location
+   * @return CPU address
+   */
+  static uint16_t locationAddress(uint32_t location);
+
+  /**
+   * Name a location or function for reports, e.g. "$0800", "aux:$0800",
+   * "lc1:$D000", "rom:$FC58"; TOP_LEVEL is "[top]"
+   * @param location Profiler location or TOP_LEVEL
+   * @return Name with no spaces or semicolons
+   */
+  static std::string describeLocation(uint32_t location);
+
+  /**
+   * Write cycles per call path in collapsed-stack format
+   * One line per path: "[top];$0800;rom:$FDED 1234", root first.
+   * @param path File to create or replace
+   * @return true on success
+   */
+  bool writeCollapsedStacks(const std::string &path) const;
+
+  /**
+   * Write a text report of hot spots, functions and opcodes
+   * @param path File to create or replace
+   * @return true on success
+   */
+  bool writeReport(const std::string &path) const;
+
+private:
+  struct frame
+  {
+    uint32_t function;
+    uint32_t node;
+    uint64_t entry_cycle;
+    uint8_t sp;  // Stack pointer before the call
+  };
+
+  // A call path: the function called and the path it was called from
+  struct path_node
+  {
+    uint32_t function;
+    uint32_t parent;
+    uint64_t self_cycles;
+  };
+
+  struct function_counters
+  {
+    uint64_t calls = 0;
+    uint64_t inclusive_cycles = 0;
+    uint32_t active = 0;  // Frames of this function on the stack
+  };
+
+  struct edge_counters
+  {
+    uint64_t calls = 0;
+    uint64_t cycles = 0;
+  };
+
+  /**
+   * Find or add the node for calling function from parent
+   */
+  uint32_t childNode(uint32_t parent, uint32_t function);
+
+  void pushFrame(uint32_t function, uint8_t sp, uint64_t cycle);
+  void popFrame(uint64_t cycle);
+
+  static uint64_t edgeKey(uint32_t caller, uint32_t callee)
+  {
+    return static_cast<uint64_t>(caller) << 32 | callee;
+  }
+
+  const MMU &mmu_;
+  bool enabled_ = false;
+
+  // Flat per-location counters (allocated on first enable)
+  std::vector<uint64_t> location_instructions_;
+  std::vector<uint64_t> location_cycles_;
+  std::array<opcode_stats, 256> opcodes_{};
+  uint64_t total_instructions_ = 0;
+  uint64_t total_cycles_ = 0;
+
+  // Instruction in progress
+  uint32_t location_ = 0;
+  uint8_t opcode_ = 0;
+  uint8_t sp_ = 0;
+  uint64_t start_cycle_ = 0;
+  bool in_instruction_ = false;
+
+  // Call graph
+  std::vector<frame> stack_;
+  std::vector<path_node> nodes_;                   // nodes_[0] is the top level
+  std::unordered_map<uint64_t, uint32_t> children_;  // edgeKey(parent node, function) -> node
+  std::unordered_map<uint32_t, function_counters> functions_;
+  std::unordered_map<uint64_t, edge_counters> edges_;
+};
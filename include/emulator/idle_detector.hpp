@@ -0,0 +1,73 @@
+#pragma once
+
+#include "emulator/block_cache.hpp"
+#include "emulator/mmu.hpp"
+#include <cstdint>
+
+/**
+ * idle_detector - Recognizes idle loops and fast-forwards through them
+ *
+ * At the BASIC and Monitor prompts the CPU spends nearly all of its time in
+ * two kinds of loop that do nothing observable:
+ *
+ * - Keyboard polls: the firmware's KEYIN loops ($C27D on the enhanced IIe,
+ *   $C841 in the 80-column firmware) count the random seed at $4E/$4F while
+ *   waiting for bit 7 of KBD ($C000):
+ *
+ *     loop: INC zp        ; 5 cycles
+ *           BNE poll      ; 3
+ *           ...           ; rare path (high byte of counter, cursor blink)
+ *     poll: LDA $C000     ; 4 (or BIT $C000)
+ *           BPL loop      ; 3
+ *
+ * - The Monitor WAIT routine at $FCA8, a pure delay of
+ *   (26 + 27A + 5A^2) / 2 cycles including the JSR.
+ *
+ * Both are matched by their code bytes through MMU::peek(), so a patched or
+ * relocated copy is only skipped if it is byte-for-byte the same loop. The
+ * result of skipping is exact: the counter, registers, flags, stack byte and
+ * cycle count end up as if every iteration had run. Keys only arrive between
+ * emulator updates, so a keyboard poll that sees no key now would keep
+ * seeing none until the end of the current run.
+ */
+class idle_detector
+{
+public:
+  // Monitor WAIT delay routine entry point
+  static constexpr uint16_t WAIT_ENTRY = 0xFCA8;
+
+  /**
+   * Constructs the detector
+   * @param mmu MMU used to inspect code and memory and to apply results
+   */
+  explicit idle_detector(MMU &mmu);
+
+  /**
+   * Try to fast-forward through an idle loop starting at regs.pc
+   * @param regs CPU registers, updated in place if a loop was skipped
+   * @param max_cycles Most cycles that may be skipped
+   * @return Number of cycles skipped (0 if regs.pc is not at an idle loop)
+   */
+  uint64_t fastForward(block_cache::registers &regs, uint64_t max_cycles);
+
+private:
+  /**
+   * Skip whole iterations of a counting keyboard poll loop
+   */
+  uint64_t skipKeyboardPoll(block_cache::registers &regs, uint64_t max_cycles);
+
+  /**
+   * Skip a call of the Monitor WAIT routine up to its RTS
+   */
+  uint64_t skipWait(block_cache::registers &regs, uint64_t max_cycles);
+
+  /**
+   * Extra cycle for a taken branch into another page
+   */
+  static uint64_t branchPenalty(uint16_t next_pc, uint16_t target)
+  {
+    return ((next_pc ^ target) & 0xFF00) ? 1 : 0;
+  }
+
+  MMU &mmu_;
+};
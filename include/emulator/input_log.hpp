@@ -0,0 +1,84 @@
+#pragma once
+
+#include "emulator/save_state.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * input_log - Externally driven events of a recorded session
+ *
+ * Everything that reaches the machine from outside the emulated hardware
+ * (key presses, including pasted text, disk inserts and ejects, and resets)
+ * is logged with the CPU cycle it was applied at. Given the same starting
+ * state, applying the events at the same cycles reproduces the session
+ * exactly, since the emulation itself is deterministic.
+ *
+ * A recording is stored as a save state of the starting point followed by
+ * an "INPT" chunk with the log, so it loads anywhere a save state does.
+ * Events are stored as cycle deltas in LEB128 varints, so a key press
+ * typically costs three to five bytes.
+ */
+class input_log
+{
+public:
+  enum class event_type : uint8_t
+  {
+    KEY_DOWN = 1,     // value: key code
+    RESET = 2,        // Cold reset (power cycle)
+    WARM_RESET = 3,   // Ctrl+Reset
+    DISK_INSERT = 4,  // value: drive, path: image file
+    DISK_EJECT = 5    // value: drive
+  };
+
+  struct event
+  {
+    uint64_t cycle = 0;  // CPU cycle the event was applied at
+    event_type type = event_type::KEY_DOWN;
+    uint8_t value = 0;
+    std::string path;
+  };
+
+  // Save state chunk
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("INPT");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  /**
+   * Start an empty log
+   * @param start_cycle Cycle of the starting state
+   */
+  void begin(uint64_t start_cycle);
+
+  /**
+   * Append an event; events must be added in cycle order
+   */
+  void add(const event &e) { events_.push_back(e); }
+
+  /**
+   * Set the cycle the session ended at
+   */
+  void finish(uint64_t end_cycle) { end_cycle_ = end_cycle; }
+
+  uint64_t getStartCycle() const { return start_cycle_; }
+  uint64_t getEndCycle() const { return end_cycle_; }
+  const std::vector<event> &getEvents() const { return events_; }
+
+  /**
+   * Write the log as a save state chunk
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Read the log from its chunk
+   * @param chunk Input log chunk
+   * @return false if the chunk is truncated or the events are malformed
+   */
+  bool loadState(state_chunk &chunk);
+
+private:
+  uint64_t start_cycle_ = 0;
+  uint64_t end_cycle_ = 0;
+  std::vector<event> events_;
+};
@@ -2,6 +2,7 @@
 
 #include "device.hpp"
 #include "apple2e/soft_switches.hpp"
+#include "save_state.hpp"
 #include <cstdint>
 
 /**
@@ -80,6 +81,40 @@ public:
    */
   bool isStrobeSet() const { return key_waiting_; }
 
+  /**
+   * Get the latched keycode (valid whether or not the strobe is set)
+   * @return Keycode (0-127)
+   */
+  uint8_t getLatchedKeycode() const { return latched_keycode_; }
+
+  /**
+   * Restore the latch from a rewind snapshot
+   * @param key_code Latched keycode (0-127)
+   * @param strobe true if the key was still waiting to be read
+   */
+  void restoreLatch(uint8_t key_code, bool strobe)
+  {
+    latched_keycode_ = key_code & 0x7F;
+    key_waiting_ = strobe;
+  }
+
+  // Save state chunk
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("KBD ");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  /**
+   * Write the latch and strobe to a save state
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Restore the latch and strobe from a save state
+   * @param chunk Keyboard chunk
+   * @return false if the chunk is too short
+   */
+  bool loadState(state_chunk &chunk);
+
 private:
   // Latched keycode (7-bit, 0-127)
   uint8_t latched_keycode_ = 0;
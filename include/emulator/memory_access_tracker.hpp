@@ -13,54 +13,79 @@ enum class access_type : uint8_t
   WRITE = 2
 };
 
-/**
- * memory_access_entry - State for a single memory location
- */
-struct memory_access_entry
-{
-  access_type type = access_type::NONE;
-  float fade_timer = 0.0f; // Seconds remaining until fade complete
-};
-
 /**
  * memory_access_tracker - Tracks memory read/write accesses for visualization
  *
- * Records when each memory location is read or written, and maintains
- * fade timers for visual display. Can be enabled/disabled for performance.
+ * Each address holds one 32-bit stamp: the low 32 bits of the CPU cycle of
+ * its last access, with the access type in the bottom two bits. Recording
+ * an access is a single store, and nothing is done per frame. How far an
+ * access has faded is worked out from the current cycle only when the
+ * heatmap is built, so fading follows emulated time and stops while the
+ * emulator is paused.
+ *
+ * Can be enabled/disabled for performance.
  */
 class memory_access_tracker
 {
 public:
-  static constexpr float FADE_DURATION = 1.0f; // 1 second fade
+  // Cycles for an access to fade back to grey (about 1 second at 1.023 MHz)
+  static constexpr uint32_t FADE_CYCLES = 1u << 20;
+
+  // Heatmap colors (ABGR, as expected by RGBA8 textures)
+  static constexpr uint32_t COLOR_GREY = 0xFF808080;  // RGB(128,128,128)
+  static constexpr uint32_t COLOR_GREEN = 0xFF00FF00; // RGB(0,255,0)
+  static constexpr uint32_t COLOR_RED = 0xFF0000FF;   // RGB(255,0,0)
 
   /**
    * Record a read access at an address
    * @param address Memory address that was read
+   * @param cycle CPU cycle of the access
    */
-  void recordRead(uint16_t address);
+  void recordRead(uint16_t address, uint64_t cycle)
+  {
+    if (enabled_)
+    {
+      stamps_[address] = makeStamp(cycle, access_type::READ);
+    }
+  }
 
   /**
    * Record a write access at an address
+   * Last access wins - a write overwrites a read
    * @param address Memory address that was written
+   * @param cycle CPU cycle of the access
    */
-  void recordWrite(uint16_t address);
+  void recordWrite(uint16_t address, uint64_t cycle)
+  {
+    if (enabled_)
+    {
+      stamps_[address] = makeStamp(cycle, access_type::WRITE);
+    }
+  }
 
   /**
-   * Update fade timers (call once per frame)
-   * @param deltaTime Time elapsed since last update in seconds
+   * Get the type of the last access to an address, if it hasn't faded
+   * @param address Memory address
+   * @param current_cycle Current CPU cycle
+   * @return READ or WRITE, or NONE once faded
    */
-  void update(float deltaTime);
+  access_type getAccess(uint16_t address, uint64_t current_cycle) const;
 
   /**
-   * Get the access entry for an address
-   * @param address Memory address
-   * @return Reference to the access entry
+   * Build the 256x256 heatmap, one pixel per address (row = high byte)
+   *
+   * Pixels fade from green (read) or red (write) to grey over FADE_CYCLES.
+   * Stamps that have fully faded are cleared on the way, so the 32-bit
+   * cycle stamps can't come back into range when the counter wraps.
+   * @param current_cycle Current CPU cycle
+   * @param pixels Receives 65536 ABGR pixels
    */
-  const memory_access_entry &getEntry(uint16_t address) const;
+  void buildHeatmap(uint64_t current_cycle, uint32_t *pixels);
 
   /**
    * Enable or disable tracking
-   * When disabled, recordRead/recordWrite do nothing
+   * When disabled, recordRead/recordWrite do nothing. Stamps left from an
+   * earlier session are discarded when tracking is turned back on.
    * @param enabled True to enable tracking
    */
   void setEnabled(bool enabled);
@@ -69,7 +94,7 @@ public:
    * Check if tracking is enabled
    * @return True if tracking is enabled
    */
-  bool isEnabled() const;
+  bool isEnabled() const { return enabled_; }
 
   /**
    * Clear all access state (reset to NONE)
@@ -77,6 +102,14 @@ public:
   void clear();
 
 private:
-  std::array<memory_access_entry, 65536> entries_{};
+  static constexpr uint32_t TYPE_MASK = 3;
+
+  static uint32_t makeStamp(uint64_t cycle, access_type type)
+  {
+    return (static_cast<uint32_t>(cycle) & ~TYPE_MASK) | static_cast<uint32_t>(type);
+  }
+
+  // Last access per address; 0 means none
+  std::array<uint32_t, 65536> stamps_{};
   bool enabled_ = false;
 };
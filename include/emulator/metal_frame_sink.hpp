@@ -0,0 +1,40 @@
+#pragma once
+
+#include "emulator/frame_sink.hpp"
+
+/**
+ * metal_frame_sink - frame_sink that uploads frames to a Metal texture
+ * (macOS only)
+ *
+ * The texture is RGBA8, as wide as an 80-column frame, and gets only the
+ * band of scanlines each frame changed. The video window draws it with
+ * ImGui, showing the part of each row the current mode uses.
+ */
+class metal_frame_sink final : public frame_sink
+{
+public:
+  metal_frame_sink() = default;
+  ~metal_frame_sink() override;
+
+  metal_frame_sink(const metal_frame_sink &) = delete;
+  metal_frame_sink &operator=(const metal_frame_sink &) = delete;
+
+  /**
+   * Create the texture
+   * @param device Metal device pointer (id<MTLDevice>)
+   * @return true on success
+   */
+  bool initialize(void *device);
+
+  bool present(const video_frame &frame) override;
+  const char *getName() const override { return "Metal"; }
+
+  /**
+   * Get the texture
+   * @return id<MTLTexture>, or nullptr before initialize()
+   */
+  void *getTexture() const { return texture_; }
+
+private:
+  void *texture_ = nullptr; // id<MTLTexture>
+};
@@ -5,10 +5,17 @@
 #include "apple2e/soft_switches.hpp"
 #include "ram.hpp"
 #include "rom.hpp"
+#include "save_state.hpp"
 #include "keyboard.hpp"
 #include "speaker.hpp"
 #include "emulator/memory_access_tracker.hpp"
+#include "emulator/video_dirty_map.hpp"
+#include "emulator/video_switch_log.hpp"
+#include "emulator/trace_recorder.hpp"
+#include "emulator/breakpoint_manager.hpp"
 #include "emulator/disk2_controller.hpp"
+#include <array>
+#include <functional>
 #include <memory>
 #include <cstdint>
 
@@ -18,8 +25,11 @@
  * The MMU handles bank switching, soft switches, and routes memory accesses
  * to the appropriate devices (RAM, ROM, I/O). It implements the Apple IIe
  * memory map and soft switch behavior.
+ *
+ * MMU is final so that the CPU's bus accessors can call read()/write()
+ * directly instead of through the Device vtable.
  */
-class MMU : public Device
+class MMU final : public Device
 {
 public:
   /**
@@ -48,10 +58,45 @@ public:
    * Read a byte through the MMU
    * Routes to RAM or ROM based on address and current configuration
    * NOTE: This may trigger side effects for soft switch reads
+   *
+   * Plain RAM/ROM pages are served straight from the read page table; only
+   * I/O and slot ROM pages ($C000-$CFFF) fall through to readIO().
    * @param address 16-bit address
    * @return byte value
    */
-  uint8_t read(uint16_t address) override;
+  uint8_t read(uint16_t address) override
+  {
+    // Track memory access for visualization
+    if (access_tracker_)
+    {
+      access_tracker_->recordRead(address, cycle_count_);
+    }
+
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+
+    const uint8_t *page = read_pages_[address >> 8];
+    if (tracer_ || watch_)
+    {
+      uint8_t value = page ? page[address & 0xFF] : readIO(address);
+      if (tracer_)
+      {
+        tracer_->recordAccess(address, value, false);
+      }
+      if (watch_)
+      {
+        watch_->checkRead(address, value);
+      }
+      return value;
+    }
+    if (page)
+    {
+      return page[address & 0xFF];
+    }
+    return readIO(address);
+  }
 
   /**
    * Peek a byte through the MMU without triggering side effects
@@ -64,10 +109,48 @@ public:
   /**
    * Write a byte through the MMU
    * Routes to RAM or handles soft switches
+   *
+   * Writable RAM pages come from the write page table; everything else
+   * (I/O, slot ROM, write-protected ROM/language card) goes to writeIO().
    * @param address 16-bit address
    * @param value byte value
    */
-  void write(uint16_t address, uint8_t value) override;
+  void write(uint16_t address, uint8_t value) override
+  {
+    // Track memory access for visualization
+    if (access_tracker_)
+    {
+      access_tracker_->recordWrite(address, cycle_count_);
+    }
+    if (tracer_)
+    {
+      tracer_->recordAccess(address, value, true);
+    }
+    if (watch_)
+    {
+      watch_->checkWrite(address, value);
+    }
+
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+
+    uint8_t *page = write_pages_[address >> 8];
+    if (page)
+    {
+      page[address & 0xFF] = value;
+      const uint16_t physical = write_physical_[address >> 8];
+      dirty_pages_[physical >> 6] |= uint64_t{1} << (physical & 63);
+      video_dirty_.markWrite(physical, static_cast<uint8_t>(address));
+      if (code_write_watch_[address >> 8])
+      {
+        notifyCodeWrite(address >> 8);
+      }
+      return;
+    }
+    writeIO(address, value);
+  }
 
   /**
    * Get the address range this MMU occupies
@@ -83,9 +166,15 @@ public:
 
   /**
    * Get current soft switch state
+   * The caller may modify the switches directly, so the memory map is
+   * re-checked on the next access.
    * @return reference to soft switch state
    */
-  Apple2e::SoftSwitchState &getSoftSwitchState() { return soft_switches_; }
+  Apple2e::SoftSwitchState &getSoftSwitchState()
+  {
+    memory_map_dirty_ = true;
+    return soft_switches_;
+  }
 
   /**
    * Get const current soft switch state
@@ -100,7 +189,217 @@ public:
    */
   Apple2e::SoftSwitchState getSoftSwitchSnapshot() const;
 
+  // Save state chunk
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("MMU ");
+  static constexpr uint16_t STATE_VERSION = 2;  // 2: DHIRES
+
+  /**
+   * Write the soft switches to a save state, one field at a time so the
+   * file doesn't depend on the SoftSwitchState layout
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Restore the soft switches from a save state
+   * @param chunk MMU chunk
+   * @return false if the chunk is too short
+   */
+  bool loadState(state_chunk &chunk);
+
+  // ===== Physical pages =====
+  //
+  // Every 256-byte page of backing store has a physical page number, so code
+  // caches can key on what is actually mapped rather than on the CPU address:
+  // main RAM pages are 0x000-0x0FF, aux RAM 0x100-0x1FF and the $D000-$FFFF
+  // ROM 0x200-0x22F. Language card bank 1 lives at $C000-$CFFF of the RAM
+  // arrays, so it shows up as physical pages 0x0C0-0x0CF (or 0x1C0-0x1CF).
+
+  static constexpr uint16_t PHYS_MAIN_RAM = 0x000;
+  static constexpr uint16_t PHYS_AUX_RAM = 0x100;
+  static constexpr uint16_t PHYS_ROM = 0x200;
+  static constexpr uint16_t PHYS_PAGE_COUNT = 0x230;
+  static constexpr uint16_t NO_PHYSICAL_PAGE = 0xFFFF;
+
+  // Callback type for writes landing in pages that hold cached code
+  using CodeWriteCallback = std::function<void(uint16_t physical_page)>;
+
+  /**
+   * Get the physical page currently mapped for reads at a CPU page
+   * @param page CPU address bits 15-8
+   * @return Physical page number, or NO_PHYSICAL_PAGE for I/O and slot ROM
+   */
+  uint16_t getReadPhysicalPage(uint8_t page) const
+  {
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+    return read_physical_[page];
+  }
+
+  /**
+   * Get the physical page currently mapped for writes at a CPU page
+   * @param page CPU address bits 15-8
+   * @return Physical page number, or NO_PHYSICAL_PAGE where writes don't
+   *         land in RAM (I/O, slot ROM, ROM, write-protected language card)
+   */
+  uint16_t getWritePhysicalPage(uint8_t page) const
+  {
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+    return write_physical_[page];
+  }
+
+  /**
+   * Get a pointer to the 256 bytes currently mapped for reads at a CPU page
+   * Reading through this pointer has no side effects
+   * @param page CPU address bits 15-8
+   * @return Page pointer, or nullptr for I/O and slot ROM
+   */
+  const uint8_t *getReadPage(uint8_t page) const
+  {
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+    return read_pages_[page];
+  }
+
+  /**
+   * Get a counter that increases every time the page tables are rebuilt
+   * Cached decodes of the current mapping are stale once this changes
+   * @return Memory map generation
+   */
+  uint32_t getMemoryMapGeneration() const
+  {
+    if (memory_map_dirty_)
+    {
+      updateMemoryMap();
+    }
+    return memory_map_generation_;
+  }
+
+  /**
+   * Mark or unmark a physical page as holding cached code
+   * Writes through the MMU to a marked page clear the mark and invoke the
+   * code write callback.
+   * @param physical_page Physical page number
+   * @param has_code true if the page holds cached code
+   */
+  void setCodePage(uint16_t physical_page, bool has_code);
+
+  /**
+   * Clear all code page marks
+   */
+  void clearCodePages();
+
+  /**
+   * Set the callback invoked when a write lands in a marked code page
+   * @param callback Function receiving the physical page written
+   */
+  void setCodeWriteCallback(CodeWriteCallback callback) { code_write_callback_ = std::move(callback); }
+
+  // ===== Dirty RAM pages =====
+  //
+  // Every write through the MMU marks the physical RAM page it lands in, so
+  // rewind snapshots can store just the pages changed since the last one.
+  // Writable pages are always RAM, so the map covers physical pages
+  // 0x000-0x1FF (main then aux), one bit each.
+
+  static constexpr uint16_t RAM_PAGE_COUNT = 0x200;
+  using DirtyPageMap = std::array<uint64_t, RAM_PAGE_COUNT / 64>;
+
+  /**
+   * Get the RAM pages written since the last call, clearing the map
+   * @return Bitmap with bit (n & 63) of word (n >> 6) set for dirty page n
+   */
+  DirtyPageMap takeDirtyPages()
+  {
+    DirtyPageMap dirty = dirty_pages_;
+    dirty_pages_.fill(0);
+    return dirty;
+  }
+
+  /**
+   * Forget all dirty page marks (after RAM has been restored wholesale)
+   */
+  void clearDirtyPages() { dirty_pages_.fill(0); }
+
+  // ===== Dirty display scanlines =====
+  //
+  // Writes into the text/lo-res and hi-res pages (main or aux) also mark
+  // the scanlines they show up on, so the video display only redraws what
+  // changed. See video_dirty_map.
+
+  /**
+   * Get the display scanlines written since the last call, clearing them
+   * @return Marked scanlines per display page
+   */
+  video_dirty_map takeVideoDirty()
+  {
+    video_dirty_map dirty = video_dirty_;
+    video_dirty_.clear();
+    return dirty;
+  }
+
+  /**
+   * Mark the whole display dirty (after RAM or the soft switches were
+   * changed behind the MMU's back)
+   * Also drops the video switch log, whose history no longer leads to the
+   * current switches.
+   */
+  void markVideoDirty()
+  {
+    video_dirty_.markAll();
+    video_switches_.clear();
+  }
+
+  /**
+   * Get the log of video mode switch changes, stamped with the cycle they
+   * were made at
+   * @return Video switch log
+   */
+  const video_switch_log &getVideoSwitchLog() const { return video_switches_; }
+
 private:
+  /**
+   * Slow path for reads that are not backed by a page table entry
+   * Handles I/O space ($C000-$C0FF) and the slot/expansion ROM area
+   * ($C100-$CFFF), which has INTC8ROM side effects
+   * @param address 16-bit address
+   * @return byte value
+   */
+  uint8_t readIO(uint16_t address);
+
+  /**
+   * Slow path for writes that are not backed by a page table entry
+   * Handles soft switches; writes to ROM and slot ROM are ignored
+   * @param address 16-bit address
+   * @param value byte value
+   */
+  void writeIO(uint16_t address, uint8_t value);
+
+  /**
+   * Recompute the read/write page tables from the current soft switches
+   * Does nothing if the switches affecting memory mapping are unchanged
+   * since the last rebuild. Const so that peek() can refresh a stale map.
+   */
+  void updateMemoryMap() const;
+
+  /**
+   * Recompute code_write_watch_ from the code page marks and write mapping
+   */
+  void updateCodeWriteWatch() const;
+
+  /**
+   * Handle a write to a CPU page that maps to a marked code page
+   * @param page CPU address bits 15-8
+   */
+  void notifyCodeWrite(uint8_t page);
+
   /**
    * Handle soft switch read
    * @param address Soft switch address
@@ -115,6 +414,31 @@ private:
    */
   void writeSoftSwitch(uint16_t address, uint8_t value);
 
+  /**
+   * Check whether an I/O access may change a video mode switch
+   * Writes to $C000-$C00F set 80STORE, 80COL and ALTCHARSET; reads or
+   * writes of $C050-$C05F set TEXT, MIXED, PAGE2, HIRES and (through AN3)
+   * DHIRES.
+   * @param address I/O address
+   */
+  static bool isVideoSwitch(uint16_t address)
+  {
+    return (address & 0xFFF0) == 0xC000 || (address & 0xFFF0) == 0xC050;
+  }
+
+  /**
+   * Log the video switches if the access just made changed them
+   * @param before Packed switches before the access
+   */
+  void noteVideoSwitches(uint8_t before)
+  {
+    const uint8_t after = video_switch_log::pack(soft_switches_);
+    if (after != before)
+    {
+      video_switches_.record(cycle_count_, before, after);
+    }
+  }
+
   /**
    * Handle bank switching soft switch
    * @param address Bank switch address
@@ -140,6 +464,8 @@ private:
   Speaker *speaker_;   // Optional, can be nullptr
   Apple2e::SoftSwitchState soft_switches_;
   uint64_t cycle_count_ = 0; // Track cycles for speaker timing
+  bool keyboard_polled_ = false; // KBD read with no key waiting, see consumeKeyboardPoll()
+  bool vertical_blank_ = false;  // In VBL (scanlines 192-261), see setVerticalBlank()
 
 public:
   /**
@@ -148,12 +474,44 @@ public:
    */
   void setCycleCount(uint64_t cycles) { cycle_count_ = cycles; }
 
+  /**
+   * Set the vertical blank state reported by RDVBLBAR ($C019)
+   * Driven by scheduled events at the start and end of VBL each frame.
+   * @param active true during VBL
+   */
+  void setVerticalBlank(bool active) { vertical_blank_ = active; }
+
+  /**
+   * Check whether KBD was read with no key waiting since the last call
+   * Used as a cheap hint that the CPU may be sitting in a keyboard poll loop.
+   * @return true if an empty keyboard poll happened, clearing the flag
+   */
+  bool consumeKeyboardPoll()
+  {
+    bool polled = keyboard_polled_;
+    keyboard_polled_ = false;
+    return polled;
+  }
+
   /**
    * Set the memory access tracker for visualization
    * @param tracker Pointer to tracker (can be nullptr to disable)
    */
   void setAccessTracker(memory_access_tracker *tracker) { access_tracker_ = tracker; }
 
+  /**
+   * Set the execution trace recorder that is told of every bus access
+   * @param tracer Pointer to recorder (nullptr while not tracing)
+   */
+  void setTraceRecorder(trace_recorder *tracer) { tracer_ = tracer; }
+
+  /**
+   * Set the breakpoints whose read and write watchpoints are checked on
+   * every bus access; a hit is latched for the emulator to act on
+   * @param watch Pointer to breakpoints (nullptr while none are enabled)
+   */
+  void setWatchpoints(breakpoint_manager *watch) { watch_ = watch; }
+
   /**
    * Set the disk controller for slot 6 I/O routing
    * @param disk Pointer to disk controller (can be nullptr)
@@ -162,5 +520,37 @@ public:
 
 private:
   memory_access_tracker *access_tracker_ = nullptr;
+  trace_recorder *tracer_ = nullptr;
+  breakpoint_manager *watch_ = nullptr;
   Disk2Controller *disk_controller_ = nullptr;
+
+  // Page tables: one entry per 256-byte page of the 64KB address space.
+  // Each entry points at the backing page in RAM or ROM, or is nullptr for
+  // pages that must go through readIO()/writeIO(). The tables are rebuilt by
+  // updateMemoryMap() whenever a mapping soft switch changes.
+  static constexpr size_t PAGE_COUNT = 256;
+  mutable std::array<const uint8_t *, PAGE_COUNT> read_pages_{};
+  mutable std::array<uint8_t *, PAGE_COUNT> write_pages_{};
+  mutable bool memory_map_dirty_ = true;
+  mutable uint16_t memory_map_key_ = 0xFFFF; // Mapping switches at last rebuild
+  mutable uint32_t memory_map_generation_ = 0;
+
+  // Physical page numbers for each CPU page (NO_PHYSICAL_PAGE when unmapped)
+  mutable std::array<uint16_t, PAGE_COUNT> read_physical_{};
+  mutable std::array<uint16_t, PAGE_COUNT> write_physical_{};
+
+  // Code cache support: physical pages holding cached code, and the CPU
+  // pages whose writes currently land in one of them
+  std::array<bool, PHYS_PAGE_COUNT> code_pages_{};
+  mutable std::array<bool, PAGE_COUNT> code_write_watch_{};
+  CodeWriteCallback code_write_callback_;
+
+  // RAM pages written since the last takeDirtyPages()
+  DirtyPageMap dirty_pages_{};
+
+  // Display scanlines written since the last takeVideoDirty()
+  video_dirty_map video_dirty_;
+
+  // Recent video mode switch changes, for mid-frame mode changes
+  video_switch_log video_switches_;
 };
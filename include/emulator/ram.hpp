@@ -2,6 +2,7 @@
 
 #include "device.hpp"
 #include "apple2e/memory_map.hpp"
+#include "save_state.hpp"
 #include <array>
 #include <cstdint>
 
@@ -94,6 +95,23 @@ public:
    */
   const std::array<uint8_t, Apple2e::RAM_SIZE> &getAuxBank() const { return aux_bank_; }
 
+  // Save state chunk
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("RAM ");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  /**
+   * Write both banks to a save state
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Restore both banks from a save state, copying straight from the chunk
+   * @param chunk RAM chunk
+   * @return false if the chunk is too short
+   */
+  bool loadState(state_chunk &chunk);
+
   /**
    * Direct read from memory with aux bank selection
    * Used by video system for consistent memory access
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "emulator/disk2_controller.hpp"
+#include "emulator/mmu.hpp"
+#include "emulator/ram.hpp"
+#include "apple2e/soft_switches.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * rewind_buffer - In-memory history of machine snapshots for rewind
+ *
+ * Snapshots are taken every few frames into a fixed-size ring. Copying all
+ * 128KB of RAM each time would cost ~7.5MB per second of history, so only
+ * every keyframe_interval-th snapshot (and the oldest one) holds a full
+ * copy; the rest hold just the 256-byte pages written since the snapshot
+ * before them, as reported by MMU::takeDirtyPages(). Restoring walks back to
+ * the nearest keyframe and replays the page deltas forward from there.
+ *
+ * When the ring is full, or the stored pages exceed the memory budget, the
+ * oldest snapshot is dropped and its RAM is folded into the next one, which
+ * becomes the new oldest keyframe. Heavy writers (hi-res page flipping) thus
+ * get a shorter history rather than more memory.
+ *
+ * Besides RAM a snapshot holds the CPU registers, soft switches, keyboard
+ * latch, Disk II controller and head state and the speaker level. Disk
+ * contents are not captured.
+ */
+class rewind_buffer
+{
+public:
+  /**
+   * Everything other than RAM that a snapshot restores
+   */
+  struct machine_state
+  {
+    uint64_t cycle = 0;  // CPU cycle count at capture
+    uint16_t pc = 0;
+    uint8_t sp = 0;
+    uint8_t p = 0;
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    Apple2e::SoftSwitchState switches;
+    uint8_t key_code = 0;
+    bool key_strobe = false;
+    Disk2Controller::State disk;
+    bool speaker_high = false;
+  };
+
+  /**
+   * Constructs an empty buffer
+   * @param capacity Most snapshots kept
+   * @param keyframe_interval Store a full RAM copy every this many snapshots
+   * @param memory_budget Most bytes of RAM pages kept across all snapshots
+   */
+  rewind_buffer(size_t capacity, size_t keyframe_interval, size_t memory_budget);
+
+  /**
+   * Add a snapshot, dropping the oldest ones if over capacity or budget
+   * The first snapshot after clear() is always a keyframe.
+   * @param state Registers and device state
+   * @param ram RAM to snapshot
+   * @param dirty RAM pages written since the previous capture
+   */
+  void capture(const machine_state &state, const RAM &ram, const MMU::DirtyPageMap &dirty);
+
+  /**
+   * Restore a snapshot and drop everything newer than it
+   * The caller should then clear the MMU's dirty pages, so the next
+   * capture's delta is relative to the restored RAM.
+   * @param snapshots_back 0 for the most recent snapshot, 1 for the one
+   *                       before, ...; clamped to the oldest
+   * @param state Receives the registers and device state
+   * @param ram RAM to overwrite with the snapshot's contents
+   * @return false if the buffer is empty
+   */
+  bool restore(size_t snapshots_back, machine_state &state, RAM &ram);
+
+  /**
+   * Drop all snapshots
+   */
+  void clear();
+
+  /**
+   * Get the number of snapshots held
+   */
+  size_t size() const { return count_; }
+
+  /**
+   * Get the bytes of RAM pages held across all snapshots
+   */
+  size_t getMemoryUsage() const { return memory_used_; }
+
+private:
+  static constexpr size_t PAGE_SIZE = 256;
+  static constexpr size_t BANK_PAGES = MMU::RAM_PAGE_COUNT / 2;
+
+  struct snapshot
+  {
+    machine_state state;
+    bool keyframe = false;
+    std::vector<uint16_t> pages;  // Physical RAM pages in data (deltas only)
+    std::vector<uint8_t> data;    // Page contents; all of RAM for a keyframe
+  };
+
+  /**
+   * Get the ring slot of the i-th oldest snapshot
+   */
+  size_t slot(size_t i) const { return (head_ + i) % slots_.size(); }
+
+  /**
+   * Get the backing bytes of a physical RAM page
+   */
+  static const uint8_t *pageData(const RAM &ram, uint16_t physical_page);
+  static uint8_t *pageData(RAM &ram, uint16_t physical_page);
+
+  /**
+   * Drop the oldest snapshot, turning the next one into a keyframe
+   */
+  void dropOldest();
+
+  /**
+   * Free a snapshot's pages and update the memory count
+   */
+  void release(snapshot &snap);
+
+  std::vector<snapshot> slots_;
+  size_t head_ = 0;   // Slot of the oldest snapshot
+  size_t count_ = 0;
+  size_t keyframe_interval_;
+  size_t memory_budget_;
+  size_t memory_used_ = 0;
+  size_t since_keyframe_ = 0;  // Deltas captured since the last keyframe
+};
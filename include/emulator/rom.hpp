@@ -101,12 +101,26 @@ public:
    */
   uint8_t readExpansionROM(uint16_t address);
 
-private:
-  std::array<uint8_t, Apple2e::ROM_SIZE> rom_data_;
-  
   // Expansion ROM area ($C100-$CFFF) - 3840 bytes (0xF00)
   // This comes from the lower portion of the CD ROM chip
   static constexpr size_t EXPANSION_ROM_SIZE = 0x0F00;  // $C100-$CFFF
+
+  /**
+   * Load the expansion ROM area ($C100-$CFFF) from a buffer
+   * @param data Pointer to expansion ROM data
+   * @param size Size of the data (must be EXPANSION_ROM_SIZE)
+   * @return true on success, false on failure
+   */
+  bool loadExpansionFromData(const uint8_t *data, size_t size);
+
+  /**
+   * Get const access to the expansion ROM area
+   * @return const reference to expansion ROM array
+   */
+  const std::array<uint8_t, EXPANSION_ROM_SIZE> &getExpansionData() const { return expansion_rom_; }
+
+private:
+  std::array<uint8_t, Apple2e::ROM_SIZE> rom_data_;
   std::array<uint8_t, EXPANSION_ROM_SIZE> expansion_rom_;
 
   /**
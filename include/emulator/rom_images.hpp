@@ -0,0 +1,34 @@
+#pragma once
+
+#include "emulator/rom.hpp"
+#include "apple2e/memory_map.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * rom_images - ROM contents loaded once and shared between emulators
+ *
+ * Holds the system ROM, character ROM and Disk II P5 ROM as read from
+ * resources/roms. Tools that run many emulator instances (a2e-batch) load
+ * the images once and pass them to each emulator::initialize(), instead of
+ * every instance re-reading and re-parsing the files. The images are never
+ * modified after load(), so one set can be shared by instances on any
+ * number of threads.
+ */
+struct rom_images
+{
+  std::array<uint8_t, Apple2e::ROM_SIZE> system{};           // $D000-$FFFF
+  std::array<uint8_t, ROM::EXPANSION_ROM_SIZE> expansion{};  // $C100-$CFFF
+  std::vector<uint8_t> character;  // Character ROM file; empty if missing
+  std::vector<uint8_t> disk2;      // Disk II P5 ROM (341-0027); empty if missing
+
+  /**
+   * Load the ROM images from the resources folder
+   * The character and Disk II ROMs are optional, as they are for a single
+   * emulator: without them text isn't rendered and slot 6 is empty.
+   * @return The images, or nullptr if the system ROM couldn't be loaded
+   */
+  static std::shared_ptr<const rom_images> load();
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Save state file format
+ *
+ * A save state is a small header followed by a sequence of chunks, one per
+ * component, each written and read by the component that owns the state:
+ *
+ *   header:  "A2E" 0x02                       (4 bytes)
+ *   chunk:   tag      FourCC, e.g. "RAM "     (4 bytes)
+ *            version  chunk layout version    (u16)
+ *            reserved 0                       (u16)
+ *            size     payload bytes           (u32)
+ *            payload  size bytes
+ *
+ * All integers are little-endian. Loaders look chunks up by tag, so unknown
+ * chunks are skipped and a missing chunk leaves that component as it is.
+ * Within a chunk, a newer version may only append fields: a loader reads
+ * appended fields only when getVersion() says they are there, and a loader
+ * given a newer version than it knows reads the prefix it understands.
+ * Changes that can't be expressed by appending get a new tag.
+ *
+ * Version 1 files ("A2E" 0x01, a raw struct dump) are still accepted by
+ * emulator::loadState().
+ */
+namespace save_state
+{
+// File magic and format generation
+constexpr uint8_t MAGIC[3] = {'A', '2', 'E'};
+constexpr uint8_t FORMAT_CHUNKED = 0x02;
+constexpr size_t HEADER_SIZE = 4;
+constexpr size_t CHUNK_HEADER_SIZE = 12;
+
+/**
+ * Build a chunk tag from four characters
+ * @param id Four character identifier, padded with spaces
+ * @return Tag as stored in the file
+ */
+constexpr uint32_t makeTag(const char (&id)[5])
+{
+  return static_cast<uint32_t>(static_cast<uint8_t>(id[0])) |
+         static_cast<uint32_t>(static_cast<uint8_t>(id[1])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(id[2])) << 16 |
+         static_cast<uint32_t>(static_cast<uint8_t>(id[3])) << 24;
+}
+} // namespace save_state
+
+/**
+ * state_writer - Builds a chunked save state in memory
+ */
+class state_writer
+{
+public:
+  state_writer();
+
+  /**
+   * Start a chunk; every field written until endChunk() goes in its payload
+   * @param tag Chunk tag from save_state::makeTag()
+   * @param version Layout version of the payload
+   */
+  void beginChunk(uint32_t tag, uint16_t version);
+
+  /**
+   * Finish the current chunk, filling in its size
+   */
+  void endChunk();
+
+  void writeU8(uint8_t value) { buffer_.push_back(value); }
+  void writeU16(uint16_t value);
+  void writeU32(uint32_t value);
+  void writeU64(uint64_t value);
+  void writeBool(bool value) { writeU8(value ? 1 : 0); }
+
+  /**
+   * Write an unsigned integer in 1-10 bytes (LEB128: 7 bits per byte, low
+   * bits first, high bit set on all but the last byte)
+   */
+  void writeVarint(uint64_t value);
+
+  /**
+   * Write a length-prefixed (u32) string
+   */
+  void writeString(const std::string &value);
+
+  /**
+   * Write raw bytes
+   */
+  void writeBytes(const void *data, size_t size);
+
+  /**
+   * Get the encoded file contents
+   * @return Header and all finished chunks
+   */
+  const std::vector<uint8_t> &getData() const { return buffer_; }
+
+  /**
+   * Write the encoded state to a file
+   * @param path File to create or replace
+   * @return true on success
+   */
+  bool saveToFile(const std::string &path) const;
+
+private:
+  std::vector<uint8_t> buffer_;
+  size_t chunk_start_ = 0;  // Offset of the open chunk's header
+  bool in_chunk_ = false;
+};
+
+/**
+ * state_chunk - Cursor over one chunk's payload
+ *
+ * Reads past the end of the payload return zero (or an empty string or
+ * nullptr) and mark the chunk truncated rather than failing, so loaders can
+ * read every field and check isTruncated() once at the end.
+ */
+class state_chunk
+{
+public:
+  state_chunk() = default;
+  state_chunk(uint32_t tag, uint16_t version, const uint8_t *data, size_t size)
+      : tag_(tag), version_(version), data_(data), size_(size)
+  {
+  }
+
+  uint32_t getTag() const { return tag_; }
+  uint16_t getVersion() const { return version_; }
+  size_t getSize() const { return size_; }
+  size_t getRemaining() const { return size_ - pos_; }
+
+  /**
+   * Check whether a read ran past the end of the payload
+   */
+  bool isTruncated() const { return truncated_; }
+
+  uint8_t readU8();
+  uint16_t readU16();
+  uint32_t readU32();
+  uint64_t readU64();
+  bool readBool() { return readU8() != 0; }
+  uint64_t readVarint();
+  std::string readString();
+
+  /**
+   * Read raw bytes in place (no copy)
+   * @param size Number of bytes
+   * @return Pointer into the file data, or nullptr if fewer bytes remain
+   */
+  const uint8_t *readBytes(size_t size);
+
+private:
+  uint32_t tag_ = 0;
+  uint16_t version_ = 0;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  bool truncated_ = false;
+};
+
+/**
+ * state_reader - Indexes the chunks of a save state held in memory
+ *
+ * The reader doesn't copy the data; chunks point straight into it, so it
+ * must outlive them. Use mapped_file to read a state without an
+ * intermediate copy.
+ */
+class state_reader
+{
+public:
+  /**
+   * Parse the header and chunk table
+   * @param data File contents
+   * @param size Size in bytes
+   * @return false if the data is not a chunked save state or a chunk
+   *         runs past the end
+   */
+  bool open(const uint8_t *data, size_t size);
+
+  /**
+   * Look up a chunk by tag
+   * @param tag Chunk tag
+   * @param chunk Receives a fresh cursor over the chunk's payload
+   * @return true if the chunk is present
+   */
+  bool findChunk(uint32_t tag, state_chunk &chunk) const;
+
+  /**
+   * Get the number of chunks in the file
+   */
+  size_t getChunkCount() const { return chunks_.size(); }
+
+private:
+  std::vector<state_chunk> chunks_;
+};
+
+/**
+ * mapped_file - Read-only view of a whole file
+ *
+ * Memory-mapped where the platform supports it, so loading a state touches
+ * only the pages that are read and copies RAM straight from the page cache;
+ * elsewhere the file is read into a buffer.
+ */
+class mapped_file
+{
+public:
+  mapped_file() = default;
+  ~mapped_file();
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  /**
+   * Map a file
+   * @param path File to open
+   * @return true on success
+   */
+  bool open(const std::string &path);
+
+  /**
+   * Unmap the file
+   */
+  void close();
+
+  const uint8_t *getData() const { return data_; }
+  size_t getSize() const { return size_; }
+
+private:
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> fallback_;  // Contents when mmap is unavailable
+};
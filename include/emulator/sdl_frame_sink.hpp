@@ -0,0 +1,42 @@
+#pragma once
+
+#include "emulator/frame_sink.hpp"
+
+struct SDL_Renderer;
+struct SDL_Texture;
+
+/**
+ * sdl_frame_sink - frame_sink that uploads frames to an SDL3 texture
+ *
+ * For front ends that draw with an SDL_Renderer instead of Metal. The
+ * streaming texture is created on the first frame, as wide as an
+ * 80-column frame, and gets only the band of scanlines each frame changed.
+ * It uses nearest-neighbour scaling so pixels stay sharp.
+ */
+class sdl_frame_sink final : public frame_sink
+{
+public:
+  /**
+   * Constructor
+   * @param renderer Renderer to create the texture on; must outlive the sink
+   */
+  explicit sdl_frame_sink(SDL_Renderer *renderer) : renderer_(renderer) {}
+  ~sdl_frame_sink() override;
+
+  sdl_frame_sink(const sdl_frame_sink &) = delete;
+  sdl_frame_sink &operator=(const sdl_frame_sink &) = delete;
+
+  bool present(const video_frame &frame) override;
+  const char *getName() const override { return "SDL3"; }
+
+  /**
+   * Get the texture
+   * Only the left width pixels of each row of the last frame are in use.
+   * @return Texture, or nullptr before the first frame
+   */
+  SDL_Texture *getTexture() const { return texture_; }
+
+private:
+  SDL_Renderer *renderer_ = nullptr;
+  SDL_Texture *texture_ = nullptr;
+};
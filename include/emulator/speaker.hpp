@@ -1,16 +1,13 @@
 #pragma once
 
+#include "emulator/audio_sink.hpp"
+#include "emulator/save_state.hpp"
 #include <cstdint>
 #include <array>
 #include <mutex>
 #include <memory>
 #include <atomic>
 
-// Forward declare AudioQueue types
-typedef struct OpaqueAudioQueue* AudioQueueRef;
-typedef struct AudioQueueBuffer* AudioQueueBufferRef;
-struct AudioQueueBufferRefWrapper;
-
 /**
  * Speaker - Apple IIe speaker emulation
  *
@@ -18,9 +15,10 @@ struct AudioQueueBufferRefWrapper;
  * Reading or writing to this address toggles the speaker cone position,
  * producing a click. Rapid toggling at specific frequencies produces tones.
  *
- * This implementation uses CoreAudio's AudioQueue for reliable audio output:
+ * Sample generation is platform-neutral; playback goes through an audio_sink
+ * (CoreAudio on macOS):
  * - Ring buffer holds generated samples
- * - AudioQueue callback pulls samples when needed
+ * - The sink pulls samples from its audio thread when needed
  * - Uses PWM (pulse-width modulation) to calculate sample values based on
  *   the ratio of high to low speaker states during each sample period
  */
@@ -31,11 +29,8 @@ public:
   static constexpr int SAMPLE_RATE = 48000;
   static constexpr int CHANNELS = 1;
   static constexpr int BITS_PER_SAMPLE = 16;
-  
-  // Number of AudioQueue buffers
-  static constexpr int NUM_BUFFERS = 3;
-  
-  // Frames per AudioQueue buffer - larger for more consistent callback timing
+
+  // Frames per sink pull - larger for more consistent callback timing
   static constexpr int FRAMES_PER_BUFFER = 512;
   
   // Ring buffer for audio samples (~250ms at 48000Hz)
@@ -55,10 +50,13 @@ public:
   ~Speaker();
 
   /**
-   * Initialize the audio system
+   * Start audio output through a sink
+   * Without a sink (or if it fails to open) the speaker still tracks its
+   * state but generates no samples.
+   * @param sink Platform audio output; the speaker takes ownership
    * @return true if successful
    */
-  bool initialize();
+  bool initialize(std::unique_ptr<audio_sink> sink);
 
   /**
    * Shutdown the audio system
@@ -93,6 +91,15 @@ public:
   void setMuted(bool muted);
   bool isMuted() const { return muted_; }
 
+  /**
+   * Suspend sample generation (used while running faster than real time)
+   * Toggles still track the speaker state but produce no samples; call
+   * reset() when resuming to resync with the CPU clock.
+   * @param suspended true to stop generating samples
+   */
+  void setSuspended(bool suspended) { suspended_ = suspended; }
+  bool isSuspended() const { return suspended_; }
+
   /**
    * Reset speaker state (call when focus changes to avoid audio glitches)
    * @param current_cycle Current CPU cycle count to sync to
@@ -109,6 +116,37 @@ public:
    */
   bool getSpeakerState() const { return speaker_state_; }
 
+  /**
+   * Put the speaker cone back where a rewind snapshot had it
+   * Timing is resynced to the current cycle as with reset().
+   * @param high Speaker state from getSpeakerState()
+   * @param current_cycle Current CPU cycle count to sync to
+   */
+  void restoreState(bool high, uint64_t current_cycle)
+  {
+    speaker_state_ = high;
+    reset(current_cycle);
+  }
+
+  // Save state chunk
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("SPKR");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  /**
+   * Write the speaker level to a save state
+   * Volume and mute are user settings and are not saved.
+   * @param out Save state being built
+   */
+  void saveState(state_writer &out) const;
+
+  /**
+   * Restore the speaker level from a save state
+   * Call reset() afterwards to resync timing with the restored clock.
+   * @param chunk Speaker chunk
+   * @return false if the chunk is too short
+   */
+  bool loadState(state_chunk &chunk);
+
   /**
    * Get the current buffer fill level (0.0 to 1.0)
    * Used for audio-driven timing
@@ -116,11 +154,6 @@ public:
   float getBufferFillPercentage() const;
 
 private:
-  // AudioQueue callback
-  static void audioQueueCallback(void* userData,
-                                  AudioQueueRef queue,
-                                  AudioQueueBufferRef buffer);
-
   // Fill audio output buffer from ring buffer
   void fillAudioBuffer(uint32_t framesPerBuffer, int16_t* out);
 
@@ -129,8 +162,7 @@ private:
 
   // Audio system state
   bool initialized_ = false;
-  AudioQueueRef audioQueue_ = nullptr;
-  AudioQueueBufferRef audioBuffers_[NUM_BUFFERS] = {nullptr};
+  std::unique_ptr<audio_sink> sink_;
 
   // Speaker state
   bool speaker_state_ = false;  // Current speaker position (high/low)
@@ -148,6 +180,7 @@ private:
   // Audio generation
   float volume_ = 0.5f;
   bool muted_ = false;
+  bool suspended_ = false;  // No sample generation (warp)
 
   // Ring buffer for audio samples (thread-safe access)
   mutable std::mutex buffer_mutex_;
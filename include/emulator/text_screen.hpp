@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class emulator;
+
+/**
+ * Convert a text screen byte to printable ASCII (primary character set)
+ * Inverse and flashing characters map to their normal forms; anything
+ * unprintable becomes a space.
+ * @param code Screen byte
+ * @return ASCII character
+ */
+char screenCodeToAscii(uint8_t code);
+
+/**
+ * Read the displayed text page as 24 lines of 40 or 80 characters
+ * Used by the headless and batch runners to check and report the screen.
+ * @param emu Emulator to read
+ * @return Screen lines, top to bottom
+ */
+std::vector<std::string> readTextScreen(const emulator &emu);
+
+/**
+ * Check whether text appears on any line of the text screen
+ * @param emu Emulator to read
+ * @param text Text to look for
+ * @return true if found
+ */
+bool screenContains(const emulator &emu, const std::string &text);
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Execution trace file format
+ *
+ *   header:  "A2ET"                 (4 bytes)
+ *            version                (u16)
+ *            record size            (u16, sizeof(trace_record))
+ *   records: trace_record, back to back, oldest first
+ *
+ * Records are written exactly as they sit in memory, so the format is
+ * little-endian on every host a2e runs on. Readers should use the record
+ * size from the header to step through the file.
+ */
+namespace trace_format
+{
+constexpr uint8_t MAGIC[4] = {'A', '2', 'E', 'T'};
+constexpr uint16_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 8;
+} // namespace trace_format
+
+/**
+ * trace_record - One executed instruction
+ *
+ * Registers are as they were before the instruction ran. Accesses are the
+ * instruction's data reads and writes in bus order, after its opcode and
+ * operand fetches; only the first MAX_ACCESSES are kept, but access_count
+ * counts them all.
+ */
+struct trace_record
+{
+  static constexpr size_t MAX_ACCESSES = 4;
+  static constexpr uint8_t FLAG_GAP = 0x80;  // Records were dropped before this one
+
+  uint64_t cycle;         // CPU cycle count at the start of the instruction
+  uint16_t pc;
+  uint8_t bytes[3];       // Opcode and operands; unused bytes are zero
+  uint8_t a;
+  uint8_t x;
+  uint8_t y;
+  uint8_t p;
+  uint8_t sp;
+  uint8_t access_count;
+  uint8_t flags;          // Bit i set if access i was a write; FLAG_GAP
+  uint16_t address[MAX_ACCESSES];
+  uint8_t value[MAX_ACCESSES];
+};
+
+static_assert(sizeof(trace_record) == 32, "trace_record is a file format");
+
+/**
+ * trace_recorder - Instruction-level execution trace
+ *
+ * The emulation thread fills in one fixed-size record per instruction and
+ * appends it to a ring buffer; nothing is formatted or allocated while
+ * tracing. The ring normally keeps the most recent records, overwriting
+ * the oldest, for saveBuffer() to write out after the fact.
+ *
+ * While streaming, the ring becomes a single-producer, single-consumer
+ * queue instead: a background thread drains it to the trace file, and the
+ * emulation thread never waits for it. If the writer falls behind (warp
+ * speed on a slow disk, or a single-core host), records that don't fit are
+ * dropped and the next one kept is marked with FLAG_GAP. Runs that aren't
+ * tied to real time can ask to wait for room instead with setLossless().
+ *
+ * Everything except the writer thread's loop runs on the emulation thread.
+ */
+class trace_recorder
+{
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 262144;  // 8MB of records
+
+  /**
+   * Constructs a recorder; the ring is allocated when tracing starts
+   * @param capacity Records held in the ring, rounded up to a power of two
+   */
+  explicit trace_recorder(size_t capacity = DEFAULT_CAPACITY);
+
+  /**
+   * Destructor - finishes any stream in progress
+   */
+  ~trace_recorder();
+
+  trace_recorder(const trace_recorder &) = delete;
+  trace_recorder &operator=(const trace_recorder &) = delete;
+
+  /**
+   * Turn recording on or off
+   * @param enabled true to record executed instructions
+   */
+  void setEnabled(bool enabled);
+
+  /**
+   * Check whether instructions are being recorded
+   */
+  bool isEnabled() const { return enabled_; }
+
+  /**
+   * Start a record for the instruction about to execute
+   * @param cycle CPU cycle count
+   * @param pc Address of the opcode
+   * @param bytes Opcode and the two bytes after it
+   * @param a, x, y, p, sp Registers before execution
+   */
+  void beginInstruction(uint64_t cycle, uint16_t pc, const uint8_t (&bytes)[3],
+                        uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t sp);
+
+  /**
+   * Note a bus access made by the current instruction
+   * The instruction's own opcode and operand fetches are skipped.
+   * @param address Address accessed
+   * @param value Byte read or written
+   * @param write true for a write
+   */
+  void recordAccess(uint16_t address, uint8_t value, bool write)
+  {
+    if (!in_instruction_)
+    {
+      return;
+    }
+    if (!write && fetches_left_ > 0 && address == next_fetch_)
+    {
+      --fetches_left_;
+      ++next_fetch_;
+      return;
+    }
+
+    uint8_t index = current_.access_count;
+    if (index < trace_record::MAX_ACCESSES)
+    {
+      current_.address[index] = address;
+      current_.value[index] = value;
+      if (write)
+      {
+        current_.flags |= static_cast<uint8_t>(1 << index);
+      }
+    }
+    if (index < 0xFF)
+    {
+      current_.access_count = static_cast<uint8_t>(index + 1);
+    }
+  }
+
+  /**
+   * Finish the current record and append it to the ring
+   */
+  void endInstruction();
+
+  /**
+   * Stream records to a file from a background thread until stopStreaming()
+   * Only records made after this call are written.
+   * @param path Trace file to create or replace
+   * @return false if the file can't be created
+   */
+  bool startStreaming(const std::string &path);
+
+  /**
+   * Flush the ring to the trace file and stop the writer thread
+   * @return false if writing failed
+   */
+  bool stopStreaming();
+
+  /**
+   * Choose what happens when the writer falls behind while streaming
+   * @param lossless true to wait for the writer, false to drop records
+   */
+  void setLossless(bool lossless) { lossless_ = lossless; }
+
+  /**
+   * Check whether records are being streamed to a file
+   */
+  bool isStreaming() const { return streaming_; }
+
+  /**
+   * Write the records currently held in the ring to a trace file
+   * @param path Trace file to create or replace
+   * @return false if streaming or if the file can't be written
+   */
+  bool saveBuffer(const std::string &path) const;
+
+  /**
+   * Forget the records held in the ring
+   */
+  void clear();
+
+  /**
+   * Get the number of records held in the ring
+   */
+  size_t getBufferedCount() const;
+
+  /**
+   * Get the number of records made since tracing was first enabled
+   */
+  uint64_t getRecordCount() const { return recorded_; }
+
+  /**
+   * Get the number of records dropped by the current or last stream
+   */
+  uint64_t getDroppedCount() const { return dropped_; }
+
+private:
+  /**
+   * Writer thread: drain the ring to the file until asked to stop
+   */
+  void writerLoop();
+
+  std::vector<trace_record> ring_;
+  size_t capacity_;
+  size_t mask_ = 0;
+
+  // Ring positions count records ever written and consumed; the slot is the
+  // position masked. Only the writer thread advances tail_ while streaming.
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+
+  trace_record current_{};
+  bool in_instruction_ = false;
+  uint8_t fetches_left_ = 0;
+  uint16_t next_fetch_ = 0;
+
+  bool enabled_ = false;
+  bool gap_ = false;
+  uint64_t recorded_ = 0;
+  uint64_t dropped_ = 0;
+
+  bool streaming_ = false;
+  bool lossless_ = false;
+  std::ofstream stream_;  // Used only by the writer thread while streaming
+  std::thread writer_;
+  std::atomic<bool> stop_writer_{false};
+  std::atomic<bool> write_failed_{false};
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * video_dirty_map - Display scanlines touched by writes to video memory
+ *
+ * The MMU marks every write that lands in a display page, so the video
+ * display can redraw just the scanlines that may have changed. Each
+ * source (text/lo-res page 1 or 2, hi-res page 1 or 2, in main or aux RAM)
+ * has its own set of the 192 scanlines, because which ones are on screen
+ * depends on the video mode at render time.
+ *
+ * A text/lo-res byte covers the 8 scanlines of its text row; a hi-res
+ * byte covers one. Writes to the screen holes (the last 8 bytes of each
+ * 128) don't mark anything.
+ */
+struct video_dirty_map
+{
+  enum source : uint8_t
+  {
+    TEXT1,   // $0400-$07FF
+    TEXT2,   // $0800-$0BFF
+    HIRES1,  // $2000-$3FFF
+    HIRES2,  // $4000-$5FFF
+    SOURCE_COUNT
+  };
+
+  static constexpr int SCANLINES = 192;
+  using scanline_bits = std::array<uint64_t, SCANLINES / 64>;
+
+  // Main RAM sources, then aux
+  std::array<scanline_bits, SOURCE_COUNT * 2> bits{};
+
+  /**
+   * Mark the scanlines shown from a byte of RAM
+   * Cheap for pages outside display memory, so it can be called on every write.
+   * @param physical_page Physical RAM page (0x000-0x0FF main, 0x100-0x1FF aux)
+   * @param offset Byte within the page
+   */
+  void markWrite(uint16_t physical_page, uint8_t offset)
+  {
+    const unsigned page = physical_page & 0xFF;
+    const unsigned bank = (physical_page >> 8) ? SOURCE_COUNT : 0;
+    if (page - 0x04u < 0x08u)
+    {
+      // Text row = (row % 8) * $80 + (row / 8) * $28 within the 1K page
+      const unsigned off = ((page & 0x03u) << 8) | offset;
+      const unsigned third = (off & 0x7Fu) / 40;
+      if (third < 3)
+      {
+        const unsigned row = (off >> 7) + third * 8;
+        bits[bank + (page < 0x08 ? TEXT1 : TEXT2)][row >> 3] |= uint64_t{0xFF} << ((row & 7) * 8);
+      }
+    }
+    else if (page - 0x20u < 0x40u)
+    {
+      // Line = (line % 8) * $400 + ((line / 8) % 8) * $80 + (line / 64) * $28
+      const unsigned off = ((page & 0x1Fu) << 8) | offset;
+      const unsigned third = (off & 0x7Fu) / 40;
+      if (third < 3)
+      {
+        const unsigned line = ((off >> 10) & 7) + ((off >> 7) & 7) * 8 + third * 64;
+        bits[bank + (page < 0x40 ? HIRES1 : HIRES2)][line >> 6] |= uint64_t{1} << (line & 63);
+      }
+    }
+  }
+
+  /**
+   * Mark every scanline of every source (after RAM was replaced wholesale)
+   */
+  void markAll()
+  {
+    for (auto &lines : bits)
+    {
+      lines.fill(~uint64_t{0});
+    }
+  }
+
+  /**
+   * Forget all marks
+   */
+  void clear()
+  {
+    for (auto &lines : bits)
+    {
+      lines.fill(0);
+    }
+  }
+
+  /**
+   * Get the marked scanlines of a source
+   * @param src Display page
+   * @param aux true for the aux RAM copy
+   */
+  const scanline_bits &get(source src, bool aux) const { return bits[(aux ? SOURCE_COUNT : 0) + src]; }
+};
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "apple2e/soft_switches.hpp"
+#include "emulator/frame_sink.hpp"
+#include "emulator/video_dirty_map.hpp"
+#include "emulator/video_switch_log.hpp"
 #include <cstdint>
 #include <functional>
 #include <array>
+#include <span>
 #include <vector>
 #include <string>
 
@@ -20,9 +24,13 @@ enum class VideoStandard : uint8_t
 /**
  * Video Display
  *
- * Generates the Apple IIe video output as a texture.
- * Handles all video modes: text (40/80-column), lo-res, and hi-res graphics.
- * This is an emulator component - the actual display is handled by the UI layer.
+ * Generates the Apple IIe video output into an RGBA frame buffer.
+ * Handles all video modes: text (40/80-column), lo-res and hi-res graphics,
+ * and their doubled forms (80x48 lo-res and 560-dot hi-res from interleaved
+ * aux/main memory) when 80COL and DHIRES are both on.
+ * This is an emulator component with no platform dependencies - presenting
+ * the frame is up to a frame_sink (a Metal texture in the app, image files
+ * from the headless runner).
  */
 class video_display
 {
@@ -38,54 +46,109 @@ public:
   ~video_display();
 
   /**
-   * Initialize the Metal texture for rendering
-   * @param device Metal device pointer (id<MTLDevice>)
+   * Load character ROM for text rendering
+   * @param filepath Path to the character ROM file
    * @return true on success
    */
-  bool initializeTexture(void *device);
+  bool loadCharacterROM(const std::string &filepath);
 
   /**
-   * Load character ROM for text rendering
-   * @param filepath Path to the character ROM file
+   * Load character ROM from a buffer
+   * @param data Character ROM contents (2KB primary set, or the full 8KB
+   *             ROM with the alternate set at $1000)
+   * @param size Size of the data in bytes
    * @return true on success
    */
-  bool loadCharacterROM(const std::string &filepath);
+  bool loadCharacterROM(const uint8_t *data, size_t size);
 
   /**
    * Update the video buffer from memory
-   * Call this each frame to refresh the display
+   * Call this each frame to refresh the display. With a dirty callback set,
+   * only the scanlines written since the last update are redrawn, plus
+   * rows with flashing text when the flash toggles; a change of video mode
+   * or display option redraws everything.
+   *
+   * With a switch log set, a frame whose visible scanlines saw a video mode
+   * change is drawn line by line, each scanline in the mode it was scanned
+   * in (see setSwitchLog()).
+   * @return true if any scanline changed (see getFirstChangedLine())
+   */
+  bool update();
+
+  /**
+   * Get the first scanline changed by the last update()
+   * @return Scanline, or getDisplayHeight() if nothing changed
+   */
+  int getFirstChangedLine() const { return changed_first_line_; }
+
+  /**
+   * Get the number of scanlines from getFirstChangedLine() that may have
+   * changed in the last update()
+   * @return Line count, 0 if nothing changed
    */
-  void update();
+  int getChangedLineCount() const
+  {
+    return changed_last_line_ >= changed_first_line_ ? changed_last_line_ - changed_first_line_ + 1 : 0;
+  }
 
   /**
-   * Set the memory read callback (main RAM)
-   * @param callback Function that reads a byte from an address
+   * Set the RAM the display shows
+   * The display reads the banks directly, as the video circuitry does, and
+   * keeps the views, so the memory must outlive it.
+   * @param main Main RAM bank
+   * @param aux Auxiliary RAM bank (80-column text)
    */
-  void setMemoryReadCallback(std::function<uint8_t(uint16_t)> callback);
+  void setMemory(std::span<const uint8_t, 65536> main, std::span<const uint8_t, 65536> aux);
 
   /**
-   * Set the auxiliary memory read callback for 80-column mode
-   * @param callback Function that reads a byte from aux memory at an address
+   * Set the soft switches that select the video mode
+   * Read once at the start of each update(); must outlive the display.
+   * @param switches Soft switch state (the MMU's)
    */
-  void setAuxMemoryReadCallback(std::function<uint8_t(uint16_t)> callback);
+  void setSoftSwitches(const Apple2e::SoftSwitchState &switches);
 
   /**
-   * Set the video mode state callback
-   * @param callback Function that returns current soft switch state
+   * Set the callback that hands over the display scanlines written since
+   * the last call (MMU::takeVideoDirty())
+   * Without one, every update() redraws the whole screen.
+   * @param callback Function returning and clearing the dirty scanlines
    */
-  void setVideoModeCallback(std::function<Apple2e::SoftSwitchState()> callback);
+  void setDirtyCallback(std::function<video_dirty_map()> callback);
 
   /**
-   * Get the texture handle for rendering
-   * @return Metal texture pointer (id<MTLTexture>), or nullptr if not initialized
+   * Set the log of video switch changes (MMU::getVideoSwitchLog()) and the
+   * CPU cycle source it is stamped against
+   * The last fully scanned frame is the one shown. When the log holds
+   * changes made while its visible scanlines were scanned, each scanline
+   * is drawn in the mode in effect when the beam reached it, from memory
+   * as it is now. Otherwise the whole frame uses the current switches.
+   * @param log Video switch log; must outlive the display
+   * @param cycle_callback Function returning the current CPU cycle
    */
-  void *getTexture() const { return texture_; }
+  void setSwitchLog(const video_switch_log &log, std::function<uint64_t()> cycle_callback);
 
   /**
-   * Check if texture is initialized
-   * @return true if texture is ready for use
+   * Redraw the whole screen on the next update()
    */
-  bool isTextureInitialized() const { return texture_initialized_; }
+  void invalidate() { full_redraw_ = true; }
+
+  /**
+   * Get the rendered frame (RGBA, getMaxDisplayWidth() x getDisplayHeight())
+   * Only the left getCurrentDisplayWidth() pixels of each row are in use.
+   * @return Pointer to the first pixel of the top row
+   */
+  const uint32_t *getFrameBuffer() const { return frame_buffer_.data(); }
+
+  /**
+   * Get the rendered frame and the band the last update() changed, for a
+   * frame_sink
+   * @return View of the frame buffer
+   */
+  video_frame getFrame() const
+  {
+    return {frame_buffer_.data(), current_display_width_, DISPLAY_HEIGHT, DISPLAY_WIDTH,
+            changed_first_line_, getChangedLineCount()};
+  }
 
   /**
    * Get the current display width (changes based on 40/80 column mode)
@@ -118,7 +181,7 @@ public:
    * Only applies to NTSC mode.
    * @param enabled true to enable fringing, false to disable
    */
-  void setColorFringing(bool enabled) { color_fringing_enabled_ = enabled; }
+  void setColorFringing(bool enabled);
 
   /**
    * Check if color fringing is enabled
@@ -130,7 +193,7 @@ public:
    * Set the video standard (NTSC, PAL Color, or PAL Mono)
    * @param standard The video standard to use
    */
-  void setVideoStandard(VideoStandard standard) { video_standard_ = standard; }
+  void setVideoStandard(VideoStandard standard);
 
   /**
    * Get the current video standard
@@ -142,7 +205,7 @@ public:
    * Set whether to use green phosphor text (true) or white text (false)
    * @param green true for green phosphor, false for white
    */
-  void setGreenText(bool green) { green_text_ = green; }
+  void setGreenText(bool green);
 
   /**
    * Check if green phosphor text is enabled
@@ -152,30 +215,112 @@ public:
 
 private:
   /**
-   * Render text mode (40 or 80 column based on col80_mode)
+   * Render one text row (40 or 80 column based on the effective mode)
+   * 80-column text uses interleaved memory: even columns from aux RAM,
+   * odd columns from main RAM
+   * @param row Text row (0-23)
+   * @param from First scanline of the row to draw (0-7)
+   * @param to Scanline of the row to stop before (1-8)
+   */
+  void renderTextRow(int row, int from = 0, int to = GLYPH_HEIGHT);
+
+  /**
+   * Render one hi-res scanline (280 pixels, or 560 in double hi-res)
+   * @param line Scanline (0-191)
+   */
+  void renderHiResLine(int line);
+
+  /**
+   * Render one double hi-res scanline (560 dots as 140 color cells)
+   * Each column shows 7 dots from aux RAM, then 7 from main RAM.
+   * @param line Scanline (0-191)
+   */
+  void renderDoubleHiResLine(int line);
+
+  /**
+   * Render one text row's worth of lo-res blocks (40x2)
+   * @param row Text row (0-23)
+   * @param from First scanline of the row to draw (0-7)
+   * @param to Scanline of the row to stop before (1-8)
+   */
+  void renderLoResRow(int row, int from = 0, int to = GLYPH_HEIGHT);
+
+  /**
+   * Render one text row's worth of double lo-res blocks (80x2)
+   * Even columns come from aux RAM, odd columns from main RAM.
+   * @param row Text row (0-23)
+   * @param from First scanline of the row to draw (0-7)
+   * @param to Scanline of the row to stop before (1-8)
+   */
+  void renderDoubleLoResRow(int row, int from, int to);
+
+  /**
+   * Work out effective_col80_mode_ and double_graphics_ from video_state_
+   */
+  void updateColumnModes();
+
+  /**
+   * Get the lo-res palette for the video standard
+   * @return 16 colors
+   */
+  const uint32_t *loResPalette() const;
+
+  /**
+   * Get the address of a hi-res scanline on the page shown
+   * @param line Scanline (0-191)
    */
-  void renderTextMode();
+  uint16_t hiResLineAddress(int line) const;
 
   /**
-   * Render 40-column text mode (40x24)
+   * Find the frame to draw line by line, if any
+   * @param frame_start Receives the cycle the frame's first scanline was
+   *                    scanned at
+   * @return true if the switch log holds a video mode change made during
+   *         the visible part of the last fully scanned frame
    */
-  void renderTextMode40();
+  bool findMidFrameChanges(uint64_t &frame_start) const;
 
   /**
-   * Render 80-column text mode (80x24)
-   * Uses interleaved memory: even columns from aux RAM, odd columns from main RAM
+   * Redraw the whole screen, each scanline in the mode it was scanned in
+   * @param frame_start Cycle of the frame's first scanline
    */
-  void renderTextMode80();
+  void renderScannedFrame(uint64_t frame_start);
 
   /**
-   * Render hi-res graphics mode (280x192)
+   * Draw a run of scanlines in the mode held in video_state_
+   * @param first_line First scanline
+   * @param end_line Scanline to stop before
    */
-  void renderHiResMode();
+  void renderLines(int first_line, int end_line);
 
   /**
-   * Render lo-res graphics mode (40x48)
+   * Double a 280-pixel scanline out to 560 pixels in place
+   * @param line Scanline (0-191)
    */
-  void renderLoResMode();
+  void widenLine(int line);
+
+  /**
+   * Check whether the current mode shows page 2 (PAGE2 without 80STORE)
+   */
+  bool showsPage2() const;
+
+  /**
+   * Get the number of scanlines from the top that show graphics in the
+   * current mode (0 in text mode, 160 when mixed, else 192)
+   */
+  int graphicsLines() const;
+
+  /**
+   * Check whether any of a text row's scanlines is marked
+   * @param lines Marked scanlines
+   * @param row Text row (0-23)
+   */
+  static bool rowDirty(const video_dirty_map::scanline_bits &lines, int row);
+
+  /**
+   * Extend the changed scanline range reported for this update()
+   */
+  void markChanged(int first_line, int last_line);
 
   /**
    * Get the hi-res color for a pixel based on bit pattern and position
@@ -189,38 +334,44 @@ private:
   uint32_t getHiResColor(bool bit_on, int x_pos, bool high_bit, bool prev_bit, bool next_bit);
 
   /**
-   * Draw a character at the specified position (40-column mode)
-   * @param col Column (0-39)
-   * @param row Row (0-23)
-   * @param ch Character code from memory
+   * Rebuild hires_table_ and dhgr_table_ for the current video standard
+   * and fringing
    */
-  void drawCharacter(int col, int row, uint8_t ch);
+  void buildHiResTable();
 
   /**
-   * Draw a character at the specified position (80-column mode)
-   * @param col Column (0-79)
-   * @param row Row (0-23)
-   * @param ch Character code from memory
+   * Rebuild glyph_atlas_ from the character ROM and text color
    */
-  void drawCharacter80(int col, int row, uint8_t ch);
+  void buildGlyphAtlas();
 
   /**
-   * Set a pixel in the frame buffer
-   * @param x X coordinate
-   * @param y Y coordinate
-   * @param color RGBA color value
+   * Get a glyph's position in glyph_atlas_
+   * @param ch Character code from memory
+   * @param altchar ALTCHARSET on
+   * @param flash_on Flash phase in which flashing characters show inverted
    */
-  void setPixel(int x, int y, uint32_t color);
+  static size_t glyphIndex(uint8_t ch, bool altchar, bool flash_on)
+  {
+    return ch | (altchar ? 0x100u : 0u) | (flash_on ? 0x200u : 0u);
+  }
 
   /**
-   * Upload frame buffer to texture
+   * Copy a glyph into the frame buffer
+   * @param out Top-left pixel of the character cell
+   * @param glyph First pixel of the glyph in glyph_atlas_
+   * @param from First glyph row to copy
+   * @param to Glyph row to stop before
    */
-  void uploadTexture();
+  static void drawGlyph(uint32_t *out, const uint32_t *glyph, int from, int to);
 
   // Callbacks
-  std::function<uint8_t(uint16_t)> memory_read_callback_;
-  std::function<uint8_t(uint16_t)> aux_memory_read_callback_;
-  std::function<Apple2e::SoftSwitchState()> video_mode_callback_;
+  // Displayed RAM and the switches selecting what is shown
+  std::span<const uint8_t> main_memory_;
+  std::span<const uint8_t> aux_memory_;
+  const Apple2e::SoftSwitchState *soft_switches_ = nullptr;
+  std::function<video_dirty_map()> dirty_callback_;
+  const video_switch_log *switch_log_ = nullptr;
+  std::function<uint64_t()> cycle_callback_;
 
   // Character ROM (256 characters, 8 bytes each = 2KB per set, 2 sets = 4KB)
   // Primary set at offset 0, alternate set at offset 2048
@@ -234,11 +385,11 @@ private:
   static constexpr int TEXT_WIDTH_40 = 40;
   static constexpr int TEXT_WIDTH_80 = 80;
   static constexpr int TEXT_HEIGHT = 24;
-  static constexpr int CHAR_WIDTH = 7;
-  static constexpr int CHAR_HEIGHT = 8;
-  static constexpr int DISPLAY_WIDTH_40 = TEXT_WIDTH_40 * CHAR_WIDTH; // 280 pixels
-  static constexpr int DISPLAY_WIDTH_80 = TEXT_WIDTH_80 * CHAR_WIDTH; // 560 pixels
-  static constexpr int DISPLAY_HEIGHT = TEXT_HEIGHT * CHAR_HEIGHT;    // 192 pixels
+  static constexpr int GLYPH_WIDTH = 7;
+  static constexpr int GLYPH_HEIGHT = 8;
+  static constexpr int DISPLAY_WIDTH_40 = TEXT_WIDTH_40 * GLYPH_WIDTH; // 280 pixels
+  static constexpr int DISPLAY_WIDTH_80 = TEXT_WIDTH_80 * GLYPH_WIDTH; // 560 pixels
+  static constexpr int DISPLAY_HEIGHT = TEXT_HEIGHT * GLYPH_HEIGHT;    // 192 pixels
 
   // Use 80-column width as the maximum display width
   static constexpr int DISPLAY_WIDTH = DISPLAY_WIDTH_80;
@@ -246,14 +397,17 @@ private:
   // Legacy alias for compatibility
   static constexpr int TEXT_WIDTH = TEXT_WIDTH_40;
 
+  // Every character ready to copy: 8 rows of 7 pixels for each code in
+  // each character set and flash phase (see glyphIndex()). 40- and
+  // 80-column text share it, as both draw 7-pixel cells. Rebuilt when the
+  // ROM or the text color changes.
+  static constexpr size_t GLYPH_COUNT = 256 * 2 * 2;
+  static constexpr size_t GLYPH_PIXELS = GLYPH_HEIGHT * GLYPH_WIDTH;
+  std::vector<uint32_t> glyph_atlas_;
+
   // Frame buffer (RGBA)
   std::vector<uint32_t> frame_buffer_;
 
-  // Metal texture handle
-  void *texture_ = nullptr; // id<MTLTexture>
-  void *device_ = nullptr;  // id<MTLDevice>
-  bool texture_initialized_ = false;
-
   // Color fringing: true = adjacent pixels blend to white (authentic), false = pure artifact colors
   // Only applies to NTSC mode
   bool color_fringing_enabled_ = true;
@@ -267,17 +421,62 @@ private:
   // Current display width (changes based on 40/80 column mode)
   int current_display_width_ = DISPLAY_WIDTH_40;
 
-  // Effective 80-column mode (accounts for CSW vector state)
+  // 80-column text window: 80COL on in text or mixed mode
   bool effective_col80_mode_ = false;
 
-  // Previous 80-column mode state (to detect mode changes)
-  bool prev_col80_mode_ = false;
+  // Double hi-res/lo-res graphics: 80COL and DHIRES on in graphics mode
+  bool double_graphics_ = false;
+
+  // Soft switches for the frame being rendered
+  Apple2e::SoftSwitchState video_state_;
+
+  // Everything that decides how unchanged memory looks; when it differs
+  // from the last frame the whole screen is redrawn
+  struct render_key
+  {
+    Apple2e::VideoMode video_mode = Apple2e::VideoMode::TEXT;
+    Apple2e::GraphicsMode graphics_mode = Apple2e::GraphicsMode::LORES;
+    Apple2e::ScreenMode screen_mode = Apple2e::ScreenMode::FULL;
+    bool page2 = false;
+    bool col80 = false;
+    bool double_graphics = false;
+    bool altchar = false;
+    VideoStandard standard = VideoStandard::NTSC;
+    bool fringing = false;
+    bool green = false;
+
+    bool operator==(const render_key &) const = default;
+  };
+  render_key render_key_;
+  bool full_redraw_ = true;
+
+  // Scanlines redrawn by the last update(), inclusive (first > last if none)
+  int changed_first_line_ = DISPLAY_HEIGHT;
+  int changed_last_line_ = -1;
+
+  // Text rows that hold flashing characters, one bit per row
+  uint32_t flash_rows_ = 0;
 
   // Flash state for flashing characters
   bool flash_state_ = false;
   int flash_counter_ = 0;
   static constexpr int FLASH_RATE = 30;
 
+  // Hi-res byte to pixels: the 7 colors of a byte given bit 6 of the byte
+  // before it, bit 0 of the byte after it and the column modulo 4 (the
+  // artifact color phase; PAL changes color every 2 pixels, so its pattern
+  // repeats every 4 bytes). Index: prev_bit | byte << 1 | next_bit << 9 |
+  // (col & 3) << 10. Rebuilt when the video standard or fringing changes.
+  static constexpr size_t HIRES_TABLE_SIZE = 2 * 256 * 2 * 4;
+  std::vector<std::array<uint32_t, 7>> hires_table_;
+
+  // Double hi-res 4-dot color cell to pixels, indexed by the cell's bits
+  // (leftmost dot in bit 0). Rebuilt with hires_table_.
+  std::array<std::array<uint32_t, 4>, 16> dhgr_table_{};
+
+  // Hi-res or lo-res scanlines above the text window in mixed mode
+  static constexpr int MIXED_GRAPHICS_LINES = 160;
+
   // Text page base addresses
   static constexpr uint16_t TEXT_PAGE1_BASE = 0x0400;
   static constexpr uint16_t TEXT_PAGE2_BASE = 0x0800;
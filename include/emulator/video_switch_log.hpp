@@ -0,0 +1,100 @@
+#pragma once
+
+#include "apple2e/soft_switches.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * video_switch_log - Cycle-stamped history of the video mode switches
+ *
+ * The MMU records every access that flips one of the switches deciding
+ * what is on screen (TEXT, MIXED, PAGE2, HIRES, 80COL, ALTCHARSET,
+ * 80STORE and DHIRES), with the switches packed into a byte before and
+ * after. The video display uses it to find the mode each scanline was
+ * drawn in when a program changes modes part way down the screen.
+ *
+ * The log is a fixed ring; once it wraps, the oldest changes are lost and
+ * covers() reports that history before them can't be rebuilt.
+ */
+class video_switch_log
+{
+public:
+  // Packed switch bits
+  static constexpr uint8_t TEXT = 0x01;
+  static constexpr uint8_t MIXED = 0x02;
+  static constexpr uint8_t PAGE2 = 0x04;
+  static constexpr uint8_t HIRES = 0x08;
+  static constexpr uint8_t COL80 = 0x10;
+  static constexpr uint8_t ALTCHAR = 0x20;
+  static constexpr uint8_t STORE80 = 0x40;
+  static constexpr uint8_t DHIRES = 0x80;
+
+  static constexpr size_t CAPACITY = 256;
+
+  /**
+   * Pack the video switches of a state
+   * @param state Soft switch state
+   * @return Switch bits
+   */
+  static uint8_t pack(const Apple2e::SoftSwitchState &state);
+
+  /**
+   * Set the video switches of a state from packed bits
+   * Other switches are left alone.
+   * @param bits Switch bits
+   * @param state State to update
+   */
+  static void unpack(uint8_t bits, Apple2e::SoftSwitchState &state);
+
+  /**
+   * Record a change
+   * @param cycle CPU cycle of the access
+   * @param before Switch bits before the access
+   * @param after Switch bits after it
+   */
+  void record(uint64_t cycle, uint8_t before, uint8_t after)
+  {
+    changes_[count_ % CAPACITY] = {cycle, before, after};
+    ++count_;
+  }
+
+  /**
+   * Forget all changes (after the switches were replaced wholesale)
+   */
+  void clear() { count_ = 0; }
+
+  /**
+   * Check whether every change after a cycle is still held
+   * @param cycle CPU cycle
+   * @return true unless changes after cycle were dropped
+   */
+  bool covers(uint64_t cycle) const;
+
+  /**
+   * Check for changes in a span of cycles
+   * @param after Start of the span (exclusive)
+   * @param until End of the span (inclusive)
+   * @return true if a change was recorded in (after, until]
+   */
+  bool changedBetween(uint64_t after, uint64_t until) const;
+
+  /**
+   * Get the switches as they were at a cycle
+   * @param cycle CPU cycle; changes at this cycle count as made
+   * @param current Switch bits now
+   * @return Switch bits at the cycle (only valid while covers(cycle))
+   */
+  uint8_t bitsAt(uint64_t cycle, uint8_t current) const;
+
+private:
+  struct change
+  {
+    uint64_t cycle;
+    uint8_t before;
+    uint8_t after;
+  };
+
+  std::array<change, CAPACITY> changes_{};
+  uint64_t count_ = 0;  // Changes recorded since the last clear(); the ring holds the newest
+};
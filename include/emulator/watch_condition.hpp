@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * watch_condition - Compiled condition for a breakpoint or watchpoint
+ *
+ * Conditions are small expressions compiled once into a stack bytecode, so
+ * a hit only costs a short loop over a few instructions. The syntax:
+ *
+ *   A==#$FF            register compared with a constant
+ *   [$36]!=$F0         byte in memory (the address may be an expression)
+ *   VALUE>=$80         byte being read or written
+ *   ADDR==$C0E9 && X<4 combined with &&, ||, ! and parentheses
+ *   P&$01              bitwise and (non-zero is true)
+ *
+ * Operands are the registers A, X, Y, SP, P and PC (the instruction's
+ * address), VALUE and ADDR for the access that hit, and numbers in hex
+ * ($FF or 0xFF), binary (%1010) or decimal. A leading # is allowed and
+ * ignored. Names are case-insensitive. Comparisons are == != < <= > >=.
+ */
+class watch_condition
+{
+public:
+  /**
+   * State a condition is evaluated against
+   */
+  struct context
+  {
+    uint16_t pc = 0;
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t sp = 0;
+    uint8_t p = 0;
+    uint16_t address = 0;  // Access address (the PC for execution breakpoints)
+    uint8_t value = 0;     // Byte read or written (the opcode for execution)
+  };
+
+  // Reads memory for [addr] without side effects
+  using PeekFunction = std::function<uint8_t(uint16_t)>;
+
+  /**
+   * Compile a condition, replacing any previous one
+   * An empty or all-blank text compiles to "always true".
+   * @param text Condition source
+   * @param error Receives a description of the first error
+   * @return true on success; on failure the condition is left empty
+   */
+  bool compile(const std::string &text, std::string &error);
+
+  /**
+   * Check whether there is no condition (always true)
+   */
+  bool empty() const { return code_.empty(); }
+
+  /**
+   * Get the source the condition was compiled from
+   */
+  const std::string &getText() const { return text_; }
+
+  /**
+   * Evaluate the condition
+   * @param ctx Registers and access
+   * @param peek Memory reader for [addr] operands
+   * @return true if the condition holds (always true when empty)
+   */
+  bool evaluate(const context &ctx, const PeekFunction &peek) const;
+
+private:
+  enum class opcode : uint8_t
+  {
+    PUSH,     // Push operand
+    REG_A,
+    REG_X,
+    REG_Y,
+    REG_SP,
+    REG_P,
+    REG_PC,
+    VALUE,
+    ADDRESS,
+    LOAD,     // Replace top with the byte at that address
+    NOT,
+    BIT_AND,
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    LOGICAL_AND,
+    LOGICAL_OR
+  };
+
+  struct instruction
+  {
+    opcode op;
+    uint16_t operand;
+  };
+
+  // Deepest evaluation stack a condition may need
+  static constexpr size_t MAX_STACK = 16;
+
+  class compiler;
+
+  std::vector<instruction> code_;
+  std::string text_;
+};
@@ -40,6 +40,8 @@ public:
     // Cycle information
     uint64_t total_cycles = 0;
     uint64_t instructions_executed = 0;
+    double instructions_per_host_second = 0.0;
+    uint64_t idle_cycles_skipped = 0;
 
     // Stack contents (top 16 bytes)
     std::array<uint8_t, 16> stack_preview = {};
@@ -8,6 +8,7 @@
 
 class emulator;
 class breakpoint_manager;
+class trace_recorder;
 enum class breakpoint_type;
 
 /**
@@ -17,6 +18,7 @@ enum class breakpoint_type;
  * - Disassembly view that follows the program counter
  * - Execution controls (Step Over, Run/Pause, Step Out)
  * - Breakpoint management (execution, read, write watchpoints)
+ * - Execution trace recording to a buffer or a file
  * - Visual indicators for current PC and breakpoints
  */
 class debugger_window : public base_window
@@ -55,10 +57,17 @@ private:
   std::function<void()> pause_callback_;
   std::function<bool()> is_paused_callback_;
   std::function<breakpoint_manager*()> get_breakpoint_mgr_callback_;
+  std::function<void(bool)> set_tracing_callback_;
+  std::function<bool()> is_tracing_callback_;
+  std::function<trace_recorder*()> get_trace_recorder_callback_;
 
   // UI state
   bool auto_follow_pc_ = true;
   bool show_breakpoints_ = true;
+  bool show_trace_ = false;
+  char trace_path_[256] = "trace.a2t";
+  char watch_spec_[128] = "";
+  std::string watch_error_;
   int disasm_lines_ = 30;
   uint16_t current_pc_ = 0;
   uint16_t scroll_to_address_ = 0;
@@ -84,6 +93,7 @@ private:
   void renderControls();
   void renderDisassembly();
   void renderBreakpoints();
+  void renderTrace();
 
   // Helper methods
   void updateDisassemblyCache(uint16_t center_address);
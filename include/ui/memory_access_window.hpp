@@ -17,7 +17,8 @@ class emulator;
  * - Green: Recent read
  * - Red: Recent write
  *
- * Colors fade back to grey over time.
+ * Colors fade back to grey over about a second of emulated time, so the
+ * picture holds still while the emulator is paused.
  */
 class memory_access_window : public base_window
 {
@@ -73,15 +74,6 @@ private:
    */
   void renderTooltip(uint16_t address);
 
-  /**
-   * Interpolate between two colors
-   * @param colorA Starting color (grey)
-   * @param colorB Target color (green/red)
-   * @param t Interpolation factor (0.0 to 1.0)
-   * @return Interpolated color
-   */
-  uint32_t interpolateColor(uint32_t colorA, uint32_t colorB, float t) const;
-
   /**
    * Get memory region name for an address
    * @param address Memory address
@@ -108,9 +100,5 @@ private:
   // Callbacks
   std::function<memory_access_tracker *()> get_tracker_;
   std::function<uint8_t(uint16_t)> peek_memory_;
-
-  // Colors (ABGR format for Metal RGBA8)
-  static constexpr uint32_t COLOR_GREY = 0xFF808080;  // RGB(128,128,128)
-  static constexpr uint32_t COLOR_GREEN = 0xFF00FF00; // RGB(0,255,0)
-  static constexpr uint32_t COLOR_RED = 0xFF0000FF;   // RGB(255,0,0) - Note: ABGR
+  std::function<uint64_t()> get_cycles_;
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ui/base_window.hpp"
+#include "emulator/guest_profiler.hpp"
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+class emulator;
+
+/**
+ * profiler_window - Live view of the guest code profiler
+ *
+ * Shows where the running 6502 program spends its cycles:
+ * - Hot spots: the busiest instructions, by bank and address
+ * - Functions: calls with inclusive and exclusive cycles
+ * - Call graph: caller/callee pairs
+ * - Opcodes: instruction frequency histogram
+ *
+ * Profiles export as collapsed stacks for flame graph tools, or as a text
+ * report. The tables are refreshed a few times a second rather than every
+ * frame, since building them walks every code location.
+ */
+class profiler_window : public base_window
+{
+public:
+  /**
+   * Construct profiler window with emulator reference
+   * @param emu Reference to emulator
+   */
+  explicit profiler_window(emulator& emu);
+
+  /**
+   * Refresh the tables while open
+   * @param deltaTime Time since last frame
+   */
+  void update(float deltaTime) override;
+
+  /**
+   * Render profiler UI
+   */
+  void render() override;
+
+  /**
+   * Get window name
+   * @return Window title
+   */
+  const char* getName() const override { return "Profiler"; }
+
+private:
+  static constexpr float REFRESH_INTERVAL = 0.5f;  // Seconds between table rebuilds
+  static constexpr size_t HOT_SPOT_ROWS = 200;
+
+  // Callbacks to emulator
+  std::function<guest_profiler*()> get_profiler_callback_;
+  std::function<void(bool)> set_profiling_callback_;
+  std::function<bool()> is_profiling_callback_;
+  std::function<uint8_t(uint16_t)> memory_read_callback_;
+
+  // Snapshot of the profiler shown in the tables
+  std::vector<guest_profiler::hot_spot> hot_spots_;
+  std::vector<guest_profiler::function_stats> functions_;
+  std::vector<guest_profiler::call_edge> call_edges_;
+  std::vector<int> opcode_order_;  // Opcodes seen, most cycles first
+  uint64_t total_cycles_ = 0;
+  uint64_t total_instructions_ = 0;
+  float since_refresh_ = REFRESH_INTERVAL;
+
+  // UI state
+  char export_path_[256] = "profile.folded";
+  char report_path_[256] = "profile.txt";
+
+  // Rendering methods
+  void renderControls(guest_profiler& profiler);
+  void renderHotSpots(const guest_profiler& profiler);
+  void renderFunctions();
+  void renderCallGraph();
+  void renderOpcodes(const guest_profiler& profiler);
+
+  // Helper methods
+  void refresh(const guest_profiler& profiler);
+  double percentOfTotal(uint64_t cycles) const;
+};
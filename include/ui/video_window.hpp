@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base_window.hpp"
+#include "emulator/metal_frame_sink.hpp"
 #include <cstdint>
 #include <functional>
 
@@ -13,7 +14,8 @@ class emulator;
  *
  * Displays the Apple IIe video output in an ImGui window.
  * This is a thin UI wrapper that:
- * - Displays a texture provided by video_display
+ * - Presents the frame rendered by video_display to a metal_frame_sink and
+ *   displays its texture
  * - Handles keyboard input and passes it to the emulator
  */
 class video_window : public base_window
@@ -26,9 +28,11 @@ public:
   explicit video_window(emulator& emu);
 
   /**
-   * Destructor
+   * Initialize the Metal texture for display
+   * @param device Metal device pointer (id<MTLDevice>)
+   * @return true on success
    */
-  ~video_window() override;
+  bool initializeTexture(void *device);
 
   /**
    * Update the video display (generates new frame)
@@ -65,6 +69,9 @@ private:
   // Video display (owned by application)
   video_display *video_display_ = nullptr;
 
+  // Metal texture the frame is uploaded to
+  metal_frame_sink sink_;
+
   // Key press callback
   std::function<void(uint8_t)> key_press_callback_;
 
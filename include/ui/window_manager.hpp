@@ -6,6 +6,7 @@
 #include "ui/video_window.hpp"
 #include "ui/soft_switches_window.hpp"
 #include "ui/debugger_window.hpp"
+#include "ui/profiler_window.hpp"
 #include "ui/memory_access_window.hpp"
 #include "ui/disk_window.hpp"
 #include "ui/log_window.hpp"
@@ -80,6 +81,7 @@ public:
   video_window* getVideoWindow() { return video_window_; }
   soft_switches_window* getSoftSwitchesWindow() { return soft_switches_window_; }
   debugger_window* getDebuggerWindow() { return debugger_window_; }
+  profiler_window* getProfilerWindow() { return profiler_window_; }
   memory_access_window* getMemoryAccessWindow() { return memory_access_window_; }
   disk_window* getDiskWindow() { return disk_window_; }
   log_window* getLogWindow() { return log_window_; }
@@ -94,6 +96,7 @@ private:
   video_window* video_window_ = nullptr;
   soft_switches_window* soft_switches_window_ = nullptr;
   debugger_window* debugger_window_ = nullptr;
+  profiler_window* profiler_window_ = nullptr;
   memory_access_window* memory_access_window_ = nullptr;
   disk_window* disk_window_ = nullptr;
   log_window* log_window_ = nullptr;
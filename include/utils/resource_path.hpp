@@ -18,3 +18,20 @@ std::string getResourcePath();
  * @return The full path to the resource
  */
 std::string getResourcePath(const std::string &resourceName);
+
+/**
+ * Overrides the directory returned by getResourcePath(), e.g. from a command
+ * line option of the headless runner.
+ *
+ * @param path Directory containing resources/, or empty to search as usual
+ */
+void setResourcePath(const std::string &path);
+
+/**
+ * Platform default for getResourcePath() when no override is set: the .app
+ * bundle on macOS (resource_path.mm), otherwise a search of the working
+ * directory and its parent (resource_path.cpp).
+ *
+ * @return The path to the resources directory
+ */
+std::string findResourcePath();
@@ -1,4 +1,5 @@
 #include "application.hpp"
+#include "emulator/coreaudio_sink.hpp"
 #include "emulator/video_display.hpp"
 #include "ui/file_browser_dialog.hpp"
 #include "utils/paste_handler.hpp"
@@ -6,6 +7,7 @@
 #include <imgui.h>
 #include <imgui_impl_metal_custom.h>
 #include <SDL3/SDL_clipboard.h>
+#include <cstdio>
 #include <iostream>
 #include <filesystem>
 
@@ -20,6 +22,12 @@ application::~application()
 {
   // Save window state before shutdown
   saveWindowState();
+
+  // Keep a recording that was still running
+  if (emulator_ && emulator_->isRecording())
+  {
+    emulator_->stopRecording(getRecordingPath());
+  }
 }
 
 bool application::initialize()
@@ -28,7 +36,7 @@ bool application::initialize()
   {
     // Create and initialize the emulator
     emulator_ = std::make_unique<emulator>();
-    if (!emulator_->initialize())
+    if (!emulator_->initialize(std::make_unique<coreaudio_sink>()))
     {
       std::cerr << "Failed to initialize emulator" << std::endl;
       return false;
@@ -150,6 +158,30 @@ void application::renderMenuBar()
         }
       }
       ImGui::Separator();
+      if (emulator_->isRecording())
+      {
+        if (ImGui::MenuItem("Stop Recording"))
+        {
+          emulator_->stopRecording(getRecordingPath());
+        }
+      }
+      else if (ImGui::MenuItem("Record Input"))
+      {
+        emulator_->startRecording();
+      }
+      if (emulator_->isReplaying())
+      {
+        if (ImGui::MenuItem("Stop Replay"))
+        {
+          emulator_->stopReplay();
+        }
+      }
+      else if (ImGui::MenuItem("Replay Recording", nullptr, false,
+                               !emulator_->isRecording() && emulator::savedStateExists(getRecordingPath())))
+      {
+        emulator_->startReplay(getRecordingPath());
+      }
+      ImGui::Separator();
       if (ImGui::MenuItem("Exit"))
       {
         requestClose();
@@ -229,6 +261,15 @@ void application::renderMenuBar()
         }
       }
 
+      if (auto* win = window_manager_->getProfilerWindow())
+      {
+        bool is_open = win->isOpen();
+        if (ImGui::MenuItem("Profiler", nullptr, &is_open))
+        {
+          win->setOpen(is_open);
+        }
+      }
+
       if (auto* win = window_manager_->getMemoryAccessWindow())
       {
         bool is_open = win->isOpen();
@@ -331,6 +372,78 @@ void application::renderMenuBar()
       ImGui::EndMenu();
     }
 
+    if (ImGui::BeginMenu("Emulation"))
+    {
+      // Run cacheable code from predecoded basic blocks
+      bool block_cache = emulator_->isBlockCacheEnabled();
+      if (ImGui::MenuItem("Block Cache", nullptr, &block_cache))
+      {
+        emulator_->setBlockCacheEnabled(block_cache);
+      }
+
+      // Fast-forward through keyboard poll and delay loops
+      bool idle_skip = emulator_->isIdleSkipEnabled();
+      if (ImGui::MenuItem("Skip Idle Loops", nullptr, &idle_skip))
+      {
+        emulator_->setIdleSkipEnabled(idle_skip);
+      }
+
+      ImGui::Separator();
+
+      // Run faster than real time (audio suspended)
+      bool warp = emulator_->isWarpEnabled();
+      if (ImGui::MenuItem("Warp", nullptr, &warp))
+      {
+        emulator_->setWarpEnabled(warp);
+      }
+
+      bool auto_warp = emulator_->isAutoWarpEnabled();
+      if (ImGui::MenuItem("Auto-Warp While Disk Motor On", nullptr, &auto_warp))
+      {
+        emulator_->setAutoWarp(auto_warp);
+      }
+
+      if (ImGui::BeginMenu("Warp Speed"))
+      {
+        uint32_t current = emulator_->getWarpSpeed();
+        for (uint32_t multiplier : {2u, 4u, 8u})
+        {
+          char label[8];
+          snprintf(label, sizeof(label), "%ux", multiplier);
+          if (ImGui::MenuItem(label, nullptr, current == multiplier))
+          {
+            emulator_->setWarpSpeed(multiplier);
+          }
+        }
+        if (ImGui::MenuItem("Unlimited", nullptr, current == emulator::WARP_UNLIMITED))
+        {
+          emulator_->setWarpSpeed(emulator::WARP_UNLIMITED);
+        }
+        ImGui::EndMenu();
+      }
+
+      ImGui::Separator();
+
+      // Keep a history of snapshots to step back through
+      bool rewind = emulator_->isRewindEnabled();
+      if (ImGui::MenuItem("Rewind History", nullptr, &rewind))
+      {
+        emulator_->setRewindEnabled(rewind);
+      }
+
+      for (uint32_t seconds : {1u, 5u, 30u})
+      {
+        char label[32];
+        snprintf(label, sizeof(label), "Rewind %u Second%s", seconds, seconds == 1 ? "" : "s");
+        if (ImGui::MenuItem(label, nullptr, false, emulator_->getRewindSeconds() > 0.0))
+        {
+          emulator_->rewind(seconds * 60);
+        }
+      }
+
+      ImGui::EndMenu();
+    }
+
     if (ImGui::BeginMenu("Audio"))
     {
       if (emulator_->isSpeakerInitialized())
@@ -490,6 +603,20 @@ void application::loadWindowState()
   }
   ImGui_ImplMetal_SetSamplerLinear(preferences_->getBool("video.linear_filtering", false));
 
+  // Load emulation settings
+  if (emulator_)
+  {
+    emulator_->setBlockCacheEnabled(preferences_->getBool("emulation.block_cache", false));
+    emulator_->setIdleSkipEnabled(preferences_->getBool("emulation.idle_skip", true));
+    emulator_->setAutoWarp(preferences_->getBool("emulation.auto_warp", true));
+    emulator_->setRewindEnabled(preferences_->getBool("emulation.rewind", true));
+    int warp_speed = preferences_->getInt("emulation.warp_speed", static_cast<int>(emulator::WARP_UNLIMITED));
+    if (warp_speed >= 0)
+    {
+      emulator_->setWarpSpeed(static_cast<uint32_t>(warp_speed));
+    }
+  }
+
   // Load file browser last path
   std::string last_path = preferences_->getString("filebrowser.last_path", "");
   if (!last_path.empty())
@@ -551,6 +678,16 @@ void application::saveWindowState()
   }
   preferences_->setBool("video.linear_filtering", ImGui_ImplMetal_GetSamplerLinear());
 
+  // Save emulation settings
+  if (emulator_)
+  {
+    preferences_->setBool("emulation.block_cache", emulator_->isBlockCacheEnabled());
+    preferences_->setBool("emulation.idle_skip", emulator_->isIdleSkipEnabled());
+    preferences_->setBool("emulation.auto_warp", emulator_->isAutoWarpEnabled());
+    preferences_->setBool("emulation.rewind", emulator_->isRewindEnabled());
+    preferences_->setInt("emulation.warp_speed", static_cast<int>(emulator_->getWarpSpeed()));
+  }
+
   // Save file browser last path
   const std::string &last_path = FileBrowserDialog::getLastPath();
   if (!last_path.empty())
@@ -626,6 +763,12 @@ std::string application::getSaveStatePath() const
   return (save_dir / "state.a2e").string();
 }
 
+std::string application::getRecordingPath() const
+{
+  // Recordings live next to the save state
+  return (std::filesystem::path(getSaveStatePath()).parent_path() / "recording.a2e").string();
+}
+
 void application::requestClose()
 {
   // Show the save state dialog instead of closing immediately
@@ -0,0 +1,660 @@
+/**
+ * a2e-batch - Run a manifest of emulator jobs across all cores
+ *
+ * Each job boots its own emulator instance, optionally with disk images and a
+ * save state, types a key script, and runs for a cycle budget or until a
+ * condition is met. Jobs are dealt to one worker thread per core, longest
+ * budget first; a worker that runs out of jobs steals from the others, so one
+ * slow disk doesn't leave the rest of the machine idle. The ROM images are
+ * loaded once and shared by every instance.
+ *
+ * Manifest: one job per line of key=value fields separated by spaces. Values
+ * containing spaces are double-quoted, with \", \\ and \n (Return) escapes.
+ * Blank lines and lines starting with # are skipped.
+ *
+ *   id=NAME          Name in the report (default: the line number)
+ *   disk=FILE        Disk image for drive 1; a second disk= fills drive 2
+ *   state=FILE       Save state to start from
+ *   type=TEXT        Keys to type as the program reads them
+ *   cycles=N         Cycle budget (default 10 s of emulated time)
+ *   until-text=TEXT  Stop when TEXT appears on the text screen
+ *   until-pc=ADDR    Stop when the PC reaches ADDR (hex)
+ *
+ * Relative paths are resolved against the manifest's directory. Disk images
+ * are never written back.
+ *
+ * Report: one JSON object per job, in completion order, with the job id and
+ * manifest line, status ("ok", "condition-not-met" or "error"), the stop
+ * reason, cycles run, final PC, wall time, FNV-1a hashes of main and aux RAM
+ * and the final text screen.
+ *
+ * Exit status:
+ *   0  every job finished and met its condition
+ *   1  setup error (bad arguments or manifest, missing ROMs)
+ *   2  a job failed or didn't meet its condition
+ */
+
+#include "emulator/emulator.hpp"
+#include "emulator/rom_images.hpp"
+#include "emulator/text_screen.hpp"
+#include "utils/logger.hpp"
+#include "utils/resource_path.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Ten seconds of emulated time
+constexpr uint64_t DEFAULT_CYCLES = 10230000;
+
+// Conditions and typed keys are checked once per video frame
+constexpr uint64_t SLICE_CYCLES = Apple2e::CYCLES_PER_VIDEO_FRAME;
+
+struct options
+{
+  std::string manifest;
+  std::string report;
+  std::string resource_dir;
+  unsigned jobs = 0;  // Worker threads; 0 for one per core
+  bool idle_skip = true;
+  bool block_cache = false;
+  bool verbose = false;
+};
+
+struct job
+{
+  std::string id;
+  int line = 0;
+  std::vector<std::string> disks;
+  std::string state;
+  std::string type_text;
+  uint64_t cycles = DEFAULT_CYCLES;
+  bool until_pc_set = false;
+  uint16_t until_pc = 0;
+  std::string until_text;
+};
+
+struct job_result
+{
+  const char *status = "ok";
+  std::string reason;
+  uint64_t cycles = 0;
+  uint16_t pc = 0;
+  double wall_seconds = 0.0;
+  uint64_t main_hash = 0;
+  uint64_t aux_hash = 0;
+  std::vector<std::string> screen;
+};
+
+void printUsage(const char *program)
+{
+  std::cout
+      << "Usage: " << program << " [options] MANIFEST REPORT\n"
+      << "\n"
+      << "Runs the jobs in MANIFEST in parallel and writes one JSON line per\n"
+      << "job to REPORT.\n"
+      << "\n"
+      << "Options:\n"
+      << "  -j, --jobs N         Worker threads (default: one per core)\n"
+      << "  --resources DIR      Directory containing resources/roms\n"
+      << "  --no-idle-skip       Run idle loops instead of fast-forwarding them\n"
+      << "  --block-cache        Run code from the predecoded block cache\n"
+      << "  -v, --verbose        Echo the emulator log to the console\n"
+      << "  -h, --help           Show this help\n";
+}
+
+bool parseOptions(int argc, char **argv, options &opts)
+{
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      std::exit(0);
+    }
+    else if (arg == "-j" || arg == "--jobs" || arg == "--resources")
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << arg << " needs a value" << std::endl;
+        return false;
+      }
+      if (arg == "--resources")
+      {
+        opts.resource_dir = argv[++i];
+      }
+      else
+      {
+        try
+        {
+          opts.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        catch (const std::exception &)
+        {
+          std::cerr << "Bad value for " << arg << std::endl;
+          return false;
+        }
+      }
+    }
+    else if (arg == "--no-idle-skip")
+    {
+      opts.idle_skip = false;
+    }
+    else if (arg == "--block-cache")
+    {
+      opts.block_cache = true;
+    }
+    else if (arg == "-v" || arg == "--verbose")
+    {
+      opts.verbose = true;
+    }
+    else if (!arg.empty() && arg[0] == '-')
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+    else
+    {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != 2)
+  {
+    std::cerr << "Expected a manifest and a report file" << std::endl;
+    return false;
+  }
+  opts.manifest = positional[0];
+  opts.report = positional[1];
+  return true;
+}
+
+/**
+ * Split a manifest line into fields, honouring double quotes and escapes
+ * @return false on an unterminated quote
+ */
+bool splitFields(const std::string &line, std::vector<std::string> &fields)
+{
+  std::string field;
+  bool in_field = false;
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); ++i)
+  {
+    char c = line[i];
+    if (quoted && c == '\\' && i + 1 < line.size())
+    {
+      char next = line[++i];
+      field += (next == 'n' || next == 'r') ? '\r' : next;
+    }
+    else if (c == '"')
+    {
+      quoted = !quoted;
+      in_field = true;
+    }
+    else if (!quoted && (c == ' ' || c == '\t'))
+    {
+      if (in_field)
+      {
+        fields.push_back(field);
+        field.clear();
+        in_field = false;
+      }
+    }
+    else
+    {
+      field += c;
+      in_field = true;
+    }
+  }
+  if (in_field)
+  {
+    fields.push_back(field);
+  }
+  return !quoted;
+}
+
+/**
+ * Parse one manifest line into a job
+ * @return false (with a message on stderr) if a field is malformed
+ */
+bool parseJob(const std::string &line, int line_number, const std::filesystem::path &base, job &result)
+{
+  auto fail = [&](const std::string &message)
+  {
+    std::cerr << "Manifest line " << line_number << ": " << message << std::endl;
+    return false;
+  };
+  auto resolve = [&](const std::string &path)
+  {
+    std::filesystem::path p(path);
+    return p.is_absolute() ? p.string() : (base / p).string();
+  };
+
+  std::vector<std::string> fields;
+  if (!splitFields(line, fields))
+  {
+    return fail("unterminated quote");
+  }
+
+  result.line = line_number;
+  result.id = std::to_string(line_number);
+  for (const std::string &field : fields)
+  {
+    size_t eq = field.find('=');
+    if (eq == std::string::npos)
+    {
+      return fail("expected key=value, got '" + field + "'");
+    }
+    std::string key = field.substr(0, eq);
+    std::string value = field.substr(eq + 1);
+
+    try
+    {
+      if (key == "id")
+      {
+        result.id = value;
+      }
+      else if (key == "disk")
+      {
+        if (result.disks.size() >= 2)
+        {
+          return fail("at most two disk images can be given");
+        }
+        result.disks.push_back(resolve(value));
+      }
+      else if (key == "state")
+      {
+        result.state = resolve(value);
+      }
+      else if (key == "type")
+      {
+        result.type_text += value;
+      }
+      else if (key == "cycles")
+      {
+        result.cycles = std::stoull(value);
+      }
+      else if (key == "until-text")
+      {
+        result.until_text = value;
+      }
+      else if (key == "until-pc")
+      {
+        std::string addr = (!value.empty() && value[0] == '$') ? value.substr(1) : value;
+        unsigned long pc = std::stoul(addr, nullptr, 16);
+        if (pc > 0xFFFF)
+        {
+          return fail("until-pc address out of range: " + value);
+        }
+        result.until_pc = static_cast<uint16_t>(pc);
+        result.until_pc_set = true;
+      }
+      else
+      {
+        return fail("unknown key '" + key + "'");
+      }
+    }
+    catch (const std::exception &)
+    {
+      return fail("bad value for " + key);
+    }
+  }
+  return true;
+}
+
+bool loadManifest(const std::string &path, std::vector<job> &jobs)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    std::cerr << "Failed to open manifest: " << path << std::endl;
+    return false;
+  }
+
+  const std::filesystem::path base = std::filesystem::path(path).parent_path();
+  std::string line;
+  int line_number = 0;
+  while (std::getline(file, line))
+  {
+    ++line_number;
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#')
+    {
+      continue;
+    }
+
+    job entry;
+    if (!parseJob(line, line_number, base, entry))
+    {
+      return false;
+    }
+    jobs.push_back(std::move(entry));
+  }
+  return true;
+}
+
+/**
+ * 64-bit FNV-1a hash of a RAM bank
+ */
+uint64_t hashMemory(const std::array<uint8_t, 65536> &bank)
+{
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (uint8_t byte : bank)
+  {
+    hash = (hash ^ byte) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+/**
+ * Boot an emulator for a job and run it to its budget or condition
+ */
+job_result runJob(const job &spec, const std::shared_ptr<const rom_images> &roms, const options &opts)
+{
+  job_result result;
+  const auto start_time = std::chrono::steady_clock::now();
+  auto fail = [&](const std::string &message)
+  {
+    result.status = "error";
+    result.reason = message;
+    result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return result;
+  };
+
+  emulator emu;
+  if (!emu.initialize(nullptr, roms))
+  {
+    return fail("emulator initialization failed");
+  }
+  emu.setIdleSkipEnabled(opts.idle_skip);
+  emu.setBlockCacheEnabled(opts.block_cache);
+
+  Disk2Controller *disk = emu.getDiskController();
+  disk->setWriteBack(false);
+  if (!spec.state.empty() && !emu.loadState(spec.state))
+  {
+    return fail("failed to load save state: " + spec.state);
+  }
+
+  // The state puts back the disks it was saved with; the job's own disks go
+  // in afterwards so they win over those
+  for (size_t drive = 0; drive < spec.disks.size(); ++drive)
+  {
+    if (!disk->insertDisk(static_cast<int>(drive), spec.disks[drive]))
+    {
+      return fail("failed to load disk image: " + spec.disks[drive]);
+    }
+  }
+  if (spec.until_pc_set)
+  {
+    emu.getBreakpointManager()->addBreakpoint(spec.until_pc, breakpoint_type::EXECUTION);
+  }
+
+  std::deque<char> keys(spec.type_text.begin(), spec.type_text.end());
+  const bool has_condition = spec.until_pc_set || !spec.until_text.empty();
+  const uint64_t start_cycles = emu.getCPUState().total_cycles;
+  const uint64_t end_cycles = start_cycles + spec.cycles;
+  bool condition_met = false;
+  result.reason = "cycle limit";
+
+  uint64_t cycles = start_cycles;
+  while (cycles < end_cycles)
+  {
+    if (!keys.empty() && !emu.isKeyboardStrobeSet())
+    {
+      emu.keyDown(static_cast<uint8_t>(keys.front()));
+      keys.pop_front();
+    }
+
+    emu.runCycles(std::min(end_cycles, cycles + SLICE_CYCLES));
+    cycles = emu.getCPUState().total_cycles;
+
+    if (spec.until_pc_set && emu.isPaused())
+    {
+      result.reason = "PC reached";
+      condition_met = true;
+      break;
+    }
+    if (!spec.until_text.empty() && screenContains(emu, spec.until_text))
+    {
+      result.reason = "text found";
+      condition_met = true;
+      break;
+    }
+  }
+
+  const emulator::cpu_state state = emu.getCPUState();
+  result.status = (has_condition && !condition_met) ? "condition-not-met" : "ok";
+  result.cycles = state.total_cycles - start_cycles;
+  result.pc = state.pc;
+  result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  result.main_hash = hashMemory(emu.getMainRAM());
+  result.aux_hash = hashMemory(emu.getAuxRAM());
+  result.screen = readTextScreen(emu);
+  return result;
+}
+
+/**
+ * Quote a string for JSON
+ */
+std::string jsonString(const std::string &text)
+{
+  std::string out = "\"";
+  for (char c : text)
+  {
+    switch (c)
+    {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20)
+      {
+        char escape[8];
+        std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+        out += escape;
+      }
+      else
+      {
+        out += c;
+      }
+    }
+  }
+  return out + "\"";
+}
+
+std::string formatResult(const job &spec, const job_result &result)
+{
+  char numbers[160];
+  std::snprintf(numbers, sizeof(numbers),
+                "\"cycles\":%llu,\"pc\":%u,\"wall_seconds\":%.3f,"
+                "\"main_ram_fnv1a\":\"%016llx\",\"aux_ram_fnv1a\":\"%016llx\"",
+                static_cast<unsigned long long>(result.cycles), result.pc, result.wall_seconds,
+                static_cast<unsigned long long>(result.main_hash),
+                static_cast<unsigned long long>(result.aux_hash));
+
+  std::string line = "{\"id\":" + jsonString(spec.id) +
+                     ",\"line\":" + std::to_string(spec.line) +
+                     ",\"status\":" + jsonString(result.status) +
+                     ",\"reason\":" + jsonString(result.reason) +
+                     "," + numbers + ",\"screen\":[";
+  for (size_t i = 0; i < result.screen.size(); ++i)
+  {
+    line += (i ? "," : "") + jsonString(result.screen[i]);
+  }
+  return line + "]}";
+}
+
+/**
+ * work_queues - Per-worker job deques with stealing
+ *
+ * Jobs are dealt out up front and none are added later, so a worker whose
+ * own deque and every other deque are empty is done. A worker takes its own
+ * jobs from the front and steals from the back of the others', which keeps
+ * the owner and thieves at opposite ends.
+ */
+class work_queues
+{
+public:
+  explicit work_queues(size_t workers) : queues_(workers) {}
+
+  void deal(const std::vector<size_t> &jobs)
+  {
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+      queues_[i % queues_.size()].jobs.push_back(jobs[i]);
+    }
+  }
+
+  /**
+   * Take the next job for a worker
+   * @return false when no jobs are left anywhere
+   */
+  bool take(size_t worker, size_t &job_index)
+  {
+    for (size_t k = 0; k < queues_.size(); ++k)
+    {
+      queue &q = queues_[(worker + k) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.jobs.empty())
+      {
+        continue;
+      }
+      if (k == 0)
+      {
+        job_index = q.jobs.front();
+        q.jobs.pop_front();
+      }
+      else
+      {
+        job_index = q.jobs.back();
+        q.jobs.pop_back();
+      }
+      return true;
+    }
+    return false;
+  }
+
+private:
+  struct queue
+  {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+  };
+  std::vector<queue> queues_;
+};
+} // namespace
+
+int main(int argc, char **argv)
+{
+  options opts;
+  if (!parseOptions(argc, argv, opts))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  Logger::instance().setEchoToConsole(opts.verbose);
+  if (!opts.resource_dir.empty())
+  {
+    setResourcePath(opts.resource_dir);
+  }
+
+  std::vector<job> jobs;
+  if (!loadManifest(opts.manifest, jobs))
+  {
+    return 1;
+  }
+
+  std::shared_ptr<const rom_images> roms = rom_images::load();
+  if (!roms)
+  {
+    std::cerr << "Failed to load ROM images (are the ROMs in resources/roms?)" << std::endl;
+    return 1;
+  }
+
+  std::ofstream report(opts.report, std::ios::trunc);
+  if (!report)
+  {
+    std::cerr << "Failed to open report file: " << opts.report << std::endl;
+    return 1;
+  }
+
+  // Longest budgets first, so the big jobs start early and the short ones
+  // fill in around them
+  std::vector<size_t> order(jobs.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                   { return jobs[a].cycles > jobs[b].cycles; });
+
+  unsigned worker_count = opts.jobs ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+  worker_count = static_cast<unsigned>(std::min<size_t>(worker_count, std::max<size_t>(jobs.size(), 1)));
+  work_queues queues(worker_count);
+  queues.deal(order);
+
+  std::mutex report_mutex;
+  std::atomic<size_t> failures{0};
+  size_t finished = 0;
+  const auto start_time = std::chrono::steady_clock::now();
+
+  auto worker = [&](size_t index)
+  {
+    size_t job_index = 0;
+    while (queues.take(index, job_index))
+    {
+      const job &spec = jobs[job_index];
+      job_result result = runJob(spec, roms, opts);
+      if (std::string(result.status) != "ok")
+      {
+        ++failures;
+      }
+
+      std::string line = formatResult(spec, result);
+      std::lock_guard<std::mutex> lock(report_mutex);
+      report << line << '\n';
+      report.flush();
+      std::fprintf(stderr, "[%zu/%zu] %s: %s (%s)\n", ++finished, jobs.size(), spec.id.c_str(),
+                   result.status, result.reason.c_str());
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < worker_count; ++i)
+  {
+    workers.emplace_back(worker, i);
+  }
+  for (std::thread &t : workers)
+  {
+    t.join();
+  }
+
+  const double host_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  std::fprintf(stderr, "%zu jobs on %u workers in %.2fs, %zu not ok\n", jobs.size(), worker_count,
+               host_seconds, failures.load());
+
+  return failures ? 2 : 0;
+}
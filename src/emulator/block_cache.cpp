@@ -0,0 +1,759 @@
+#include "emulator/block_cache.hpp"
+
+namespace
+{
+// Status flag bit positions
+constexpr uint8_t FLAG_C = 0x01; // Carry
+constexpr uint8_t FLAG_Z = 0x02; // Zero
+constexpr uint8_t FLAG_D = 0x08; // Decimal Mode
+constexpr uint8_t FLAG_B = 0x10; // Break
+constexpr uint8_t FLAG_U = 0x20; // Unused (always 1)
+constexpr uint8_t FLAG_V = 0x40; // Overflow
+constexpr uint8_t FLAG_N = 0x80; // Negative
+
+// Addressing modes of the data operand
+enum class mode
+{
+  IMM, // #$nn
+  ZP,  // $nn
+  ZPX, // $nn,X
+  ZPY, // $nn,Y
+  ABS, // $nnnn
+  ABX, // $nnnn,X
+  ABY, // $nnnn,Y
+  INX, // ($nn,X)
+  INY, // ($nn),Y
+  ZPI  // ($nn)
+};
+
+// How the operand bytes of an instruction are decoded
+enum class operand_kind
+{
+  NONE,     // Implied / accumulator
+  BYTE,     // One operand byte
+  WORD,     // Two operand bytes
+  RELATIVE, // One signed offset byte, stored as the branch target
+  ZP_REL    // Zero page byte then signed offset byte (BBR/BBS)
+};
+} // namespace
+
+// Instruction handlers. Each one is entered with the PC already pointing at
+// the next instruction and the base cycle count already added; handlers add
+// any page-crossing, branch or decimal mode penalties themselves.
+struct block_cache::ops
+{
+  struct opcode_entry
+  {
+    handler_fn handler = nullptr;  // nullptr = interpreter only
+    uint8_t cycles = 0;
+    operand_kind kind = operand_kind::NONE;
+    bool ends_block = false;
+  };
+
+  static const std::array<opcode_entry, 256> table;
+  static std::array<opcode_entry, 256> buildTable();
+
+  // ===== Helpers =====
+
+  static uint8_t read(block_cache &c, uint16_t address) { return c.mmu_.read(address); }
+  static void write(block_cache &c, uint16_t address, uint8_t value) { c.mmu_.write(address, value); }
+
+  static uint8_t setNZ(block_cache &c, uint8_t value)
+  {
+    c.regs_.p = static_cast<uint8_t>((c.regs_.p & ~(FLAG_N | FLAG_Z)) | (value & FLAG_N) | (value ? 0 : FLAG_Z));
+    return value;
+  }
+
+  static void setFlag(block_cache &c, uint8_t flag, bool on)
+  {
+    c.regs_.p = on ? (c.regs_.p | flag) : (c.regs_.p & ~flag);
+  }
+
+  static void push(block_cache &c, uint8_t value)
+  {
+    write(c, 0x0100 | c.regs_.sp, value);
+    --c.regs_.sp;
+  }
+
+  static uint8_t pull(block_cache &c)
+  {
+    ++c.regs_.sp;
+    return read(c, 0x0100 | c.regs_.sp);
+  }
+
+  static uint16_t readZeroPageWord(block_cache &c, uint8_t zp)
+  {
+    return static_cast<uint16_t>(read(c, zp) | (read(c, static_cast<uint8_t>(zp + 1)) << 8));
+  }
+
+  // Add one cycle if base and base + index are on different pages
+  static uint16_t indexed(block_cache &c, uint16_t base, uint8_t index, bool page_penalty)
+  {
+    uint16_t address = static_cast<uint16_t>(base + index);
+    if (page_penalty && ((base ^ address) & 0xFF00))
+    {
+      ++c.extra_cycles_;
+    }
+    return address;
+  }
+
+  // Effective address; PENALTY adds the page crossing cycle for indexed modes
+  template <mode M, bool PENALTY>
+  static uint16_t address(block_cache &c, const decoded_instruction &i)
+  {
+    switch (M)
+    {
+    case mode::ZP:
+      return i.operand;
+    case mode::ZPX:
+      return static_cast<uint8_t>(i.operand + c.regs_.x);
+    case mode::ZPY:
+      return static_cast<uint8_t>(i.operand + c.regs_.y);
+    case mode::ABS:
+      return i.operand;
+    case mode::ABX:
+      return indexed(c, i.operand, c.regs_.x, PENALTY);
+    case mode::ABY:
+      return indexed(c, i.operand, c.regs_.y, PENALTY);
+    case mode::INX:
+      return readZeroPageWord(c, static_cast<uint8_t>(i.operand + c.regs_.x));
+    case mode::INY:
+      return indexed(c, readZeroPageWord(c, static_cast<uint8_t>(i.operand)), c.regs_.y, PENALTY);
+    case mode::ZPI:
+      return readZeroPageWord(c, static_cast<uint8_t>(i.operand));
+    case mode::IMM:
+      break;
+    }
+    return 0;
+  }
+
+  template <mode M>
+  static uint8_t load(block_cache &c, const decoded_instruction &i)
+  {
+    if constexpr (M == mode::IMM)
+    {
+      return static_cast<uint8_t>(i.operand);
+    }
+    else
+    {
+      return read(c, address<M, true>(c, i));
+    }
+  }
+
+  // ===== Loads, stores and ALU =====
+
+  template <mode M> static void lda(block_cache &c, const decoded_instruction &i) { c.regs_.a = setNZ(c, load<M>(c, i)); }
+  template <mode M> static void ldx(block_cache &c, const decoded_instruction &i) { c.regs_.x = setNZ(c, load<M>(c, i)); }
+  template <mode M> static void ldy(block_cache &c, const decoded_instruction &i) { c.regs_.y = setNZ(c, load<M>(c, i)); }
+
+  template <mode M> static void sta(block_cache &c, const decoded_instruction &i) { write(c, address<M, false>(c, i), c.regs_.a); }
+  template <mode M> static void stx(block_cache &c, const decoded_instruction &i) { write(c, address<M, false>(c, i), c.regs_.x); }
+  template <mode M> static void sty(block_cache &c, const decoded_instruction &i) { write(c, address<M, false>(c, i), c.regs_.y); }
+  template <mode M> static void stz(block_cache &c, const decoded_instruction &i) { write(c, address<M, false>(c, i), 0); }
+
+  template <mode M> static void ora(block_cache &c, const decoded_instruction &i) { c.regs_.a = setNZ(c, c.regs_.a | load<M>(c, i)); }
+  template <mode M> static void and_(block_cache &c, const decoded_instruction &i) { c.regs_.a = setNZ(c, c.regs_.a & load<M>(c, i)); }
+  template <mode M> static void eor(block_cache &c, const decoded_instruction &i) { c.regs_.a = setNZ(c, c.regs_.a ^ load<M>(c, i)); }
+
+  static void addBinary(block_cache &c, uint8_t value)
+  {
+    uint16_t sum = static_cast<uint16_t>(c.regs_.a + value + (c.regs_.p & FLAG_C));
+    setFlag(c, FLAG_V, (~(c.regs_.a ^ value) & (c.regs_.a ^ sum) & 0x80) != 0);
+    setFlag(c, FLAG_C, sum > 0xFF);
+    c.regs_.a = setNZ(c, static_cast<uint8_t>(sum));
+  }
+
+  template <mode M>
+  static void adc(block_cache &c, const decoded_instruction &i)
+  {
+    uint8_t value = load<M>(c, i);
+    if (!(c.regs_.p & FLAG_D))
+    {
+      addBinary(c, value);
+      return;
+    }
+
+    // 65C02 decimal mode: N, V and Z are valid, and it costs one extra cycle
+    uint8_t a = c.regs_.a;
+    int carry = c.regs_.p & FLAG_C;
+    int low = (a & 0x0F) + (value & 0x0F) + carry;
+    if (low >= 0x0A)
+    {
+      low = ((low + 0x06) & 0x0F) + 0x10;
+    }
+    int sum = (a & 0xF0) + (value & 0xF0) + low;
+    int signed_sum = static_cast<int8_t>(a & 0xF0) + static_cast<int8_t>(value & 0xF0) + low;
+    setFlag(c, FLAG_V, signed_sum < -128 || signed_sum > 127);
+    if (sum >= 0xA0)
+    {
+      sum += 0x60;
+    }
+    setFlag(c, FLAG_C, sum >= 0x100);
+    c.regs_.a = setNZ(c, static_cast<uint8_t>(sum));
+    ++c.extra_cycles_;
+  }
+
+  template <mode M>
+  static void sbc(block_cache &c, const decoded_instruction &i)
+  {
+    uint8_t value = load<M>(c, i);
+    if (!(c.regs_.p & FLAG_D))
+    {
+      addBinary(c, static_cast<uint8_t>(~value));
+      return;
+    }
+
+    // 65C02 decimal mode: carry and overflow as in binary mode
+    uint8_t a = c.regs_.a;
+    int borrow = (c.regs_.p & FLAG_C) ? 0 : 1;
+    int low = (a & 0x0F) - (value & 0x0F) - borrow;
+    int diff = a - value - borrow;
+    uint16_t binary = static_cast<uint16_t>(a + static_cast<uint8_t>(~value) + (1 - borrow));
+    setFlag(c, FLAG_V, ((a ^ value) & (a ^ binary) & 0x80) != 0);
+    setFlag(c, FLAG_C, binary > 0xFF);
+    if (diff < 0)
+    {
+      diff -= 0x60;
+    }
+    if (low < 0)
+    {
+      diff -= 0x06;
+    }
+    c.regs_.a = setNZ(c, static_cast<uint8_t>(diff));
+    ++c.extra_cycles_;
+  }
+
+  static void compare(block_cache &c, uint8_t reg, uint8_t value)
+  {
+    setFlag(c, FLAG_C, reg >= value);
+    setNZ(c, static_cast<uint8_t>(reg - value));
+  }
+
+  template <mode M> static void cmp(block_cache &c, const decoded_instruction &i) { compare(c, c.regs_.a, load<M>(c, i)); }
+  template <mode M> static void cpx(block_cache &c, const decoded_instruction &i) { compare(c, c.regs_.x, load<M>(c, i)); }
+  template <mode M> static void cpy(block_cache &c, const decoded_instruction &i) { compare(c, c.regs_.y, load<M>(c, i)); }
+
+  template <mode M>
+  static void bit(block_cache &c, const decoded_instruction &i)
+  {
+    uint8_t value = load<M>(c, i);
+    setFlag(c, FLAG_Z, (c.regs_.a & value) == 0);
+    if constexpr (M != mode::IMM)
+    {
+      // BIT #imm only affects Z
+      c.regs_.p = static_cast<uint8_t>((c.regs_.p & ~(FLAG_N | FLAG_V)) | (value & (FLAG_N | FLAG_V)));
+    }
+  }
+
+  // ===== Read-modify-write =====
+
+  static uint8_t asl(block_cache &c, uint8_t v) { setFlag(c, FLAG_C, v & 0x80); return setNZ(c, static_cast<uint8_t>(v << 1)); }
+  static uint8_t lsr(block_cache &c, uint8_t v) { setFlag(c, FLAG_C, v & 0x01); return setNZ(c, static_cast<uint8_t>(v >> 1)); }
+  static uint8_t rol(block_cache &c, uint8_t v)
+  {
+    uint8_t result = static_cast<uint8_t>((v << 1) | (c.regs_.p & FLAG_C));
+    setFlag(c, FLAG_C, v & 0x80);
+    return setNZ(c, result);
+  }
+  static uint8_t ror(block_cache &c, uint8_t v)
+  {
+    uint8_t result = static_cast<uint8_t>((v >> 1) | ((c.regs_.p & FLAG_C) << 7));
+    setFlag(c, FLAG_C, v & 0x01);
+    return setNZ(c, result);
+  }
+  static uint8_t inc(block_cache &c, uint8_t v) { return setNZ(c, static_cast<uint8_t>(v + 1)); }
+  static uint8_t dec(block_cache &c, uint8_t v) { return setNZ(c, static_cast<uint8_t>(v - 1)); }
+  static uint8_t tsb(block_cache &c, uint8_t v) { setFlag(c, FLAG_Z, (c.regs_.a & v) == 0); return v | c.regs_.a; }
+  static uint8_t trb(block_cache &c, uint8_t v) { setFlag(c, FLAG_Z, (c.regs_.a & v) == 0); return v & ~c.regs_.a; }
+
+  // PENALTY: the 65C02 shifts/rotates with abs,X take an extra cycle on a
+  // page crossing, while INC/DEC abs,X always take 7
+  template <uint8_t (*OP)(block_cache &, uint8_t), mode M, bool PENALTY = false>
+  static void rmw(block_cache &c, const decoded_instruction &i)
+  {
+    uint16_t addr = address<M, PENALTY>(c, i);
+    write(c, addr, OP(c, read(c, addr)));
+  }
+
+  template <uint8_t (*OP)(block_cache &, uint8_t)>
+  static void accumulator(block_cache &c, const decoded_instruction &) { c.regs_.a = OP(c, c.regs_.a); }
+
+  template <uint8_t BIT, bool SET>
+  static void rsmb(block_cache &c, const decoded_instruction &i)
+  {
+    uint8_t value = read(c, i.operand);
+    write(c, i.operand, SET ? (value | (1 << BIT)) : (value & ~(1 << BIT)));
+  }
+
+  // ===== Register transfers, flags, increments =====
+
+  static void tax(block_cache &c, const decoded_instruction &) { c.regs_.x = setNZ(c, c.regs_.a); }
+  static void tay(block_cache &c, const decoded_instruction &) { c.regs_.y = setNZ(c, c.regs_.a); }
+  static void txa(block_cache &c, const decoded_instruction &) { c.regs_.a = setNZ(c, c.regs_.x); }
+  static void tya(block_cache &c, const decoded_instruction &) { c.regs_.a = setNZ(c, c.regs_.y); }
+  static void tsx(block_cache &c, const decoded_instruction &) { c.regs_.x = setNZ(c, c.regs_.sp); }
+  static void txs(block_cache &c, const decoded_instruction &) { c.regs_.sp = c.regs_.x; }
+  static void inx(block_cache &c, const decoded_instruction &) { c.regs_.x = setNZ(c, static_cast<uint8_t>(c.regs_.x + 1)); }
+  static void iny(block_cache &c, const decoded_instruction &) { c.regs_.y = setNZ(c, static_cast<uint8_t>(c.regs_.y + 1)); }
+  static void dex(block_cache &c, const decoded_instruction &) { c.regs_.x = setNZ(c, static_cast<uint8_t>(c.regs_.x - 1)); }
+  static void dey(block_cache &c, const decoded_instruction &) { c.regs_.y = setNZ(c, static_cast<uint8_t>(c.regs_.y - 1)); }
+  static void nop(block_cache &, const decoded_instruction &) {}
+
+  template <uint8_t FLAG, bool SET>
+  static void flag(block_cache &c, const decoded_instruction &) { setFlag(c, FLAG, SET); }
+
+  // ===== Stack =====
+
+  static void pha(block_cache &c, const decoded_instruction &) { push(c, c.regs_.a); }
+  static void phx(block_cache &c, const decoded_instruction &) { push(c, c.regs_.x); }
+  static void phy(block_cache &c, const decoded_instruction &) { push(c, c.regs_.y); }
+  static void php(block_cache &c, const decoded_instruction &) { push(c, c.regs_.p | FLAG_B | FLAG_U); }
+  static void pla(block_cache &c, const decoded_instruction &) { c.regs_.a = setNZ(c, pull(c)); }
+  static void plx(block_cache &c, const decoded_instruction &) { c.regs_.x = setNZ(c, pull(c)); }
+  static void ply(block_cache &c, const decoded_instruction &) { c.regs_.y = setNZ(c, pull(c)); }
+  static void plp(block_cache &c, const decoded_instruction &) { c.regs_.p = pull(c) | FLAG_U; }
+
+  // ===== Control flow (always the last instruction of a block) =====
+
+  static void takeBranch(block_cache &c, const decoded_instruction &i)
+  {
+    ++c.extra_cycles_;
+    if ((i.next_pc ^ i.operand) & 0xFF00)
+    {
+      ++c.extra_cycles_;
+    }
+    c.regs_.pc = i.operand;
+  }
+
+  template <uint8_t FLAG, bool SET>
+  static void branch(block_cache &c, const decoded_instruction &i)
+  {
+    if (((c.regs_.p & FLAG) != 0) == SET)
+    {
+      takeBranch(c, i);
+    }
+  }
+
+  static void bra(block_cache &c, const decoded_instruction &i) { takeBranch(c, i); }
+
+  template <uint8_t BIT, bool SET>
+  static void bbx(block_cache &c, const decoded_instruction &i)
+  {
+    if (((read(c, i.zp) & (1 << BIT)) != 0) == SET)
+    {
+      takeBranch(c, i);
+    }
+  }
+
+  static void jmp(block_cache &c, const decoded_instruction &i) { c.regs_.pc = i.operand; }
+
+  static void jmpIndirect(block_cache &c, const decoded_instruction &i)
+  {
+    // The 65C02 fixed the NMOS page wrap bug
+    c.regs_.pc = static_cast<uint16_t>(read(c, i.operand) | (read(c, static_cast<uint16_t>(i.operand + 1)) << 8));
+  }
+
+  static void jmpIndexedIndirect(block_cache &c, const decoded_instruction &i)
+  {
+    uint16_t pointer = static_cast<uint16_t>(i.operand + c.regs_.x);
+    c.regs_.pc = static_cast<uint16_t>(read(c, pointer) | (read(c, static_cast<uint16_t>(pointer + 1)) << 8));
+  }
+
+  static void jsr(block_cache &c, const decoded_instruction &i)
+  {
+    uint16_t return_address = static_cast<uint16_t>(i.next_pc - 1);
+    push(c, static_cast<uint8_t>(return_address >> 8));
+    push(c, static_cast<uint8_t>(return_address));
+    c.regs_.pc = i.operand;
+  }
+
+  static void rts(block_cache &c, const decoded_instruction &)
+  {
+    uint16_t low = pull(c);
+    uint16_t high = pull(c);
+    c.regs_.pc = static_cast<uint16_t>(((high << 8) | low) + 1);
+  }
+
+  static void rti(block_cache &c, const decoded_instruction &)
+  {
+    c.regs_.p = pull(c) | FLAG_U;
+    uint16_t low = pull(c);
+    uint16_t high = pull(c);
+    c.regs_.pc = static_cast<uint16_t>((high << 8) | low);
+  }
+};
+
+// Build the 65C02 decode table. BRK, WAI, STP and the undocumented NOPs are
+// left empty so the interpreter handles them.
+std::array<block_cache::ops::opcode_entry, 256> block_cache::ops::buildTable()
+{
+  using o = block_cache::ops;
+  std::array<opcode_entry, 256> t{};
+
+  auto set = [&t](uint8_t opcode, auto handler, uint8_t cycles, operand_kind kind, bool ends_block = false)
+  {
+    t[opcode] = {handler, cycles, kind, ends_block};
+  };
+
+  constexpr auto N = operand_kind::NONE;
+  constexpr auto B = operand_kind::BYTE;
+  constexpr auto W = operand_kind::WORD;
+  constexpr auto R = operand_kind::RELATIVE;
+
+  // Loads
+  set(0xA9, &o::lda<mode::IMM>, 2, B); set(0xA5, &o::lda<mode::ZP>, 3, B);  set(0xB5, &o::lda<mode::ZPX>, 4, B);
+  set(0xAD, &o::lda<mode::ABS>, 4, W); set(0xBD, &o::lda<mode::ABX>, 4, W); set(0xB9, &o::lda<mode::ABY>, 4, W);
+  set(0xA1, &o::lda<mode::INX>, 6, B); set(0xB1, &o::lda<mode::INY>, 5, B); set(0xB2, &o::lda<mode::ZPI>, 5, B);
+  set(0xA2, &o::ldx<mode::IMM>, 2, B); set(0xA6, &o::ldx<mode::ZP>, 3, B);  set(0xB6, &o::ldx<mode::ZPY>, 4, B);
+  set(0xAE, &o::ldx<mode::ABS>, 4, W); set(0xBE, &o::ldx<mode::ABY>, 4, W);
+  set(0xA0, &o::ldy<mode::IMM>, 2, B); set(0xA4, &o::ldy<mode::ZP>, 3, B);  set(0xB4, &o::ldy<mode::ZPX>, 4, B);
+  set(0xAC, &o::ldy<mode::ABS>, 4, W); set(0xBC, &o::ldy<mode::ABX>, 4, W);
+
+  // Stores
+  set(0x85, &o::sta<mode::ZP>, 3, B);  set(0x95, &o::sta<mode::ZPX>, 4, B); set(0x8D, &o::sta<mode::ABS>, 4, W);
+  set(0x9D, &o::sta<mode::ABX>, 5, W); set(0x99, &o::sta<mode::ABY>, 5, W); set(0x81, &o::sta<mode::INX>, 6, B);
+  set(0x91, &o::sta<mode::INY>, 6, B); set(0x92, &o::sta<mode::ZPI>, 5, B);
+  set(0x86, &o::stx<mode::ZP>, 3, B);  set(0x96, &o::stx<mode::ZPY>, 4, B); set(0x8E, &o::stx<mode::ABS>, 4, W);
+  set(0x84, &o::sty<mode::ZP>, 3, B);  set(0x94, &o::sty<mode::ZPX>, 4, B); set(0x8C, &o::sty<mode::ABS>, 4, W);
+  set(0x64, &o::stz<mode::ZP>, 3, B);  set(0x74, &o::stz<mode::ZPX>, 4, B); set(0x9C, &o::stz<mode::ABS>, 4, W);
+  set(0x9E, &o::stz<mode::ABX>, 5, W);
+
+  // ALU operations share the same eight addressing modes; base opcode is the ($nn,X) form
+  auto alu = [&set](uint8_t base, auto imm, auto zp, auto zpx, auto abs, auto abx, auto aby, auto inx, auto iny, auto zpi)
+  {
+    set(base + 0x08, imm, 2, B); set(base + 0x04, zp, 3, B);  set(base + 0x14, zpx, 4, B);
+    set(base + 0x0C, abs, 4, W); set(base + 0x1C, abx, 4, W); set(base + 0x18, aby, 4, W);
+    set(base + 0x00, inx, 6, B); set(base + 0x10, iny, 5, B); set(base + 0x11, zpi, 5, B);
+  };
+  alu(0x01, &o::ora<mode::IMM>, &o::ora<mode::ZP>, &o::ora<mode::ZPX>, &o::ora<mode::ABS>, &o::ora<mode::ABX>,
+      &o::ora<mode::ABY>, &o::ora<mode::INX>, &o::ora<mode::INY>, &o::ora<mode::ZPI>);
+  alu(0x21, &o::and_<mode::IMM>, &o::and_<mode::ZP>, &o::and_<mode::ZPX>, &o::and_<mode::ABS>, &o::and_<mode::ABX>,
+      &o::and_<mode::ABY>, &o::and_<mode::INX>, &o::and_<mode::INY>, &o::and_<mode::ZPI>);
+  alu(0x41, &o::eor<mode::IMM>, &o::eor<mode::ZP>, &o::eor<mode::ZPX>, &o::eor<mode::ABS>, &o::eor<mode::ABX>,
+      &o::eor<mode::ABY>, &o::eor<mode::INX>, &o::eor<mode::INY>, &o::eor<mode::ZPI>);
+  alu(0x61, &o::adc<mode::IMM>, &o::adc<mode::ZP>, &o::adc<mode::ZPX>, &o::adc<mode::ABS>, &o::adc<mode::ABX>,
+      &o::adc<mode::ABY>, &o::adc<mode::INX>, &o::adc<mode::INY>, &o::adc<mode::ZPI>);
+  alu(0xC1, &o::cmp<mode::IMM>, &o::cmp<mode::ZP>, &o::cmp<mode::ZPX>, &o::cmp<mode::ABS>, &o::cmp<mode::ABX>,
+      &o::cmp<mode::ABY>, &o::cmp<mode::INX>, &o::cmp<mode::INY>, &o::cmp<mode::ZPI>);
+  alu(0xE1, &o::sbc<mode::IMM>, &o::sbc<mode::ZP>, &o::sbc<mode::ZPX>, &o::sbc<mode::ABS>, &o::sbc<mode::ABX>,
+      &o::sbc<mode::ABY>, &o::sbc<mode::INX>, &o::sbc<mode::INY>, &o::sbc<mode::ZPI>);
+
+  set(0xE0, &o::cpx<mode::IMM>, 2, B); set(0xE4, &o::cpx<mode::ZP>, 3, B); set(0xEC, &o::cpx<mode::ABS>, 4, W);
+  set(0xC0, &o::cpy<mode::IMM>, 2, B); set(0xC4, &o::cpy<mode::ZP>, 3, B); set(0xCC, &o::cpy<mode::ABS>, 4, W);
+
+  set(0x89, &o::bit<mode::IMM>, 2, B); set(0x24, &o::bit<mode::ZP>, 3, B);  set(0x34, &o::bit<mode::ZPX>, 4, B);
+  set(0x2C, &o::bit<mode::ABS>, 4, W); set(0x3C, &o::bit<mode::ABX>, 4, W);
+
+  // Shifts and rotates
+  auto shift = [&set](uint8_t base, auto acc, auto zp, auto zpx, auto abs, auto abx)
+  {
+    set(base + 0x04, acc, 2, N); set(base + 0x00, zp, 5, B); set(base + 0x10, zpx, 6, B);
+    set(base + 0x08, abs, 6, W); set(base + 0x18, abx, 6, W);
+  };
+  shift(0x06, &o::accumulator<&o::asl>, &o::rmw<&o::asl, mode::ZP>, &o::rmw<&o::asl, mode::ZPX>,
+        &o::rmw<&o::asl, mode::ABS>, &o::rmw<&o::asl, mode::ABX, true>);
+  shift(0x26, &o::accumulator<&o::rol>, &o::rmw<&o::rol, mode::ZP>, &o::rmw<&o::rol, mode::ZPX>,
+        &o::rmw<&o::rol, mode::ABS>, &o::rmw<&o::rol, mode::ABX, true>);
+  shift(0x46, &o::accumulator<&o::lsr>, &o::rmw<&o::lsr, mode::ZP>, &o::rmw<&o::lsr, mode::ZPX>,
+        &o::rmw<&o::lsr, mode::ABS>, &o::rmw<&o::lsr, mode::ABX, true>);
+  shift(0x66, &o::accumulator<&o::ror>, &o::rmw<&o::ror, mode::ZP>, &o::rmw<&o::ror, mode::ZPX>,
+        &o::rmw<&o::ror, mode::ABS>, &o::rmw<&o::ror, mode::ABX, true>);
+
+  // Increments and decrements
+  set(0xE6, &o::rmw<&o::inc, mode::ZP>, 5, B);  set(0xF6, &o::rmw<&o::inc, mode::ZPX>, 6, B);
+  set(0xEE, &o::rmw<&o::inc, mode::ABS>, 6, W); set(0xFE, &o::rmw<&o::inc, mode::ABX>, 7, W);
+  set(0xC6, &o::rmw<&o::dec, mode::ZP>, 5, B);  set(0xD6, &o::rmw<&o::dec, mode::ZPX>, 6, B);
+  set(0xCE, &o::rmw<&o::dec, mode::ABS>, 6, W); set(0xDE, &o::rmw<&o::dec, mode::ABX>, 7, W);
+  set(0x1A, &o::accumulator<&o::inc>, 2, N);    set(0x3A, &o::accumulator<&o::dec>, 2, N);
+  set(0xE8, &o::inx, 2, N); set(0xC8, &o::iny, 2, N); set(0xCA, &o::dex, 2, N); set(0x88, &o::dey, 2, N);
+
+  // Test and set/reset bits
+  set(0x04, &o::rmw<&o::tsb, mode::ZP>, 5, B); set(0x0C, &o::rmw<&o::tsb, mode::ABS>, 6, W);
+  set(0x14, &o::rmw<&o::trb, mode::ZP>, 5, B); set(0x1C, &o::rmw<&o::trb, mode::ABS>, 6, W);
+
+  // Transfers
+  set(0xAA, &o::tax, 2, N); set(0xA8, &o::tay, 2, N); set(0x8A, &o::txa, 2, N);
+  set(0x98, &o::tya, 2, N); set(0xBA, &o::tsx, 2, N); set(0x9A, &o::txs, 2, N);
+  set(0xEA, &o::nop, 2, N);
+
+  // Flags
+  set(0x18, &o::flag<FLAG_C, false>, 2, N); set(0x38, &o::flag<FLAG_C, true>, 2, N);
+  set(0x58, &o::flag<0x04, false>, 2, N);   set(0x78, &o::flag<0x04, true>, 2, N);
+  set(0xD8, &o::flag<FLAG_D, false>, 2, N); set(0xF8, &o::flag<FLAG_D, true>, 2, N);
+  set(0xB8, &o::flag<FLAG_V, false>, 2, N);
+
+  // Stack
+  set(0x48, &o::pha, 3, N); set(0xDA, &o::phx, 3, N); set(0x5A, &o::phy, 3, N); set(0x08, &o::php, 3, N);
+  set(0x68, &o::pla, 4, N); set(0xFA, &o::plx, 4, N); set(0x7A, &o::ply, 4, N); set(0x28, &o::plp, 4, N);
+
+  // Branches
+  set(0x10, &o::branch<FLAG_N, false>, 2, R, true); set(0x30, &o::branch<FLAG_N, true>, 2, R, true);
+  set(0x50, &o::branch<FLAG_V, false>, 2, R, true); set(0x70, &o::branch<FLAG_V, true>, 2, R, true);
+  set(0x90, &o::branch<FLAG_C, false>, 2, R, true); set(0xB0, &o::branch<FLAG_C, true>, 2, R, true);
+  set(0xD0, &o::branch<FLAG_Z, false>, 2, R, true); set(0xF0, &o::branch<FLAG_Z, true>, 2, R, true);
+  set(0x80, &o::bra, 2, R, true);
+
+  // Jumps, calls and returns
+  set(0x4C, &o::jmp, 3, W, true);
+  set(0x6C, &o::jmpIndirect, 6, W, true);
+  set(0x7C, &o::jmpIndexedIndirect, 6, W, true);
+  set(0x20, &o::jsr, 6, W, true);
+  set(0x60, &o::rts, 6, N, true);
+  set(0x40, &o::rti, 6, N, true);
+
+  // Rockwell/WDC bit instructions: RMBn/SMBn at $n7, BBRn/BBSn at $nF
+  set(0x07, &o::rsmb<0, false>, 5, B); set(0x17, &o::rsmb<1, false>, 5, B);
+  set(0x27, &o::rsmb<2, false>, 5, B); set(0x37, &o::rsmb<3, false>, 5, B);
+  set(0x47, &o::rsmb<4, false>, 5, B); set(0x57, &o::rsmb<5, false>, 5, B);
+  set(0x67, &o::rsmb<6, false>, 5, B); set(0x77, &o::rsmb<7, false>, 5, B);
+  set(0x87, &o::rsmb<0, true>, 5, B);  set(0x97, &o::rsmb<1, true>, 5, B);
+  set(0xA7, &o::rsmb<2, true>, 5, B);  set(0xB7, &o::rsmb<3, true>, 5, B);
+  set(0xC7, &o::rsmb<4, true>, 5, B);  set(0xD7, &o::rsmb<5, true>, 5, B);
+  set(0xE7, &o::rsmb<6, true>, 5, B);  set(0xF7, &o::rsmb<7, true>, 5, B);
+
+  constexpr auto ZR = operand_kind::ZP_REL;
+  set(0x0F, &o::bbx<0, false>, 5, ZR, true); set(0x1F, &o::bbx<1, false>, 5, ZR, true);
+  set(0x2F, &o::bbx<2, false>, 5, ZR, true); set(0x3F, &o::bbx<3, false>, 5, ZR, true);
+  set(0x4F, &o::bbx<4, false>, 5, ZR, true); set(0x5F, &o::bbx<5, false>, 5, ZR, true);
+  set(0x6F, &o::bbx<6, false>, 5, ZR, true); set(0x7F, &o::bbx<7, false>, 5, ZR, true);
+  set(0x8F, &o::bbx<0, true>, 5, ZR, true);  set(0x9F, &o::bbx<1, true>, 5, ZR, true);
+  set(0xAF, &o::bbx<2, true>, 5, ZR, true);  set(0xBF, &o::bbx<3, true>, 5, ZR, true);
+  set(0xCF, &o::bbx<4, true>, 5, ZR, true);  set(0xDF, &o::bbx<5, true>, 5, ZR, true);
+  set(0xEF, &o::bbx<6, true>, 5, ZR, true);  set(0xFF, &o::bbx<7, true>, 5, ZR, true);
+
+  return t;
+}
+
+const std::array<block_cache::ops::opcode_entry, 256> block_cache::ops::table = block_cache::ops::buildTable();
+
+block_cache::block_cache(MMU &mmu)
+    : mmu_(mmu)
+{
+  mmu_.setCodeWriteCallback([this](uint16_t physical_page)
+  {
+    invalidatePage(physical_page);
+  });
+}
+
+block_cache::~block_cache()
+{
+  mmu_.setCodeWriteCallback(nullptr);
+  mmu_.clearCodePages();
+}
+
+uint64_t block_cache::run(registers &regs, uint64_t base_cycles, uint64_t target_cycles)
+{
+  if (base_cycles + cycles_ >= target_cycles)
+  {
+    return 0;
+  }
+
+  // Work in this cache's own cycle count
+  const uint64_t cycle_limit = target_cycles - base_cycles;
+  uint64_t instructions = 0;
+  regs_ = regs;
+
+  block *current = regs_.pc == stop_pc_ ? nullptr : findBlock(regs_.pc);
+  while (current && !current->instructions.empty() && cycles_ < cycle_limit)
+  {
+    const uint32_t map_generation = mmu_.getMemoryMapGeneration();
+    const uint64_t invalidations = invalidations_;
+    bool interrupted = false;
+
+    for (const decoded_instruction &insn : current->instructions)
+    {
+      // Keep the MMU's cycle count current for disk, speaker and VBL timing.
+      // The cache's own count only moves once the instruction is done, so
+      // the disk (which reads getCycles()) sees the same start-of-instruction
+      // clock as the MMU, as it does under the interpreter.
+      mmu_.setCycleCount(base_cycles + cycles_);
+
+      regs_.pc = insn.next_pc;
+      insn.handler(*this, insn);
+      cycles_ += insn.cycles + extra_cycles_;
+      extra_cycles_ = 0;
+      ++instructions;
+
+      if (cycles_ >= cycle_limit)
+      {
+        break;
+      }
+
+      // Re-resolve the PC if a soft switch remapped memory or a store hit a
+      // page holding decoded code (possibly this block)
+      if (map_generation != mmu_.getMemoryMapGeneration() || invalidations != invalidations_)
+      {
+        interrupted = true;
+        break;
+      }
+    }
+
+    if (cycles_ >= cycle_limit)
+    {
+      break;
+    }
+
+    if (regs_.pc == stop_pc_)
+    {
+      break;
+    }
+
+    // A block that was cut short may be stale, so don't link from it
+    current = interrupted ? findBlock(regs_.pc) : nextBlock(*current);
+  }
+
+  regs = regs_;
+  return instructions;
+}
+
+void block_cache::invalidatePage(uint16_t physical_page)
+{
+  if (physical_page >= pages_.size() || !pages_[physical_page])
+  {
+    return;
+  }
+
+  // Blocks are only freed on the next lookup, since one of them may be running
+  pages_[physical_page]->stale = true;
+  ++pages_[physical_page]->invalidations;
+  ++invalidations_;
+}
+
+void block_cache::flush()
+{
+  for (auto &page : pages_)
+  {
+    page.reset();
+  }
+  mmu_.clearCodePages();
+  ++invalidations_;
+}
+
+block_cache::block *block_cache::nextBlock(block &from)
+{
+  const uint32_t generation = mmu_.getMemoryMapGeneration();
+  for (const block_link &link : from.links)
+  {
+    if (link.target && link.pc == regs_.pc && link.generation == generation)
+    {
+      return const_cast<block *>(link.target);
+    }
+  }
+
+  block *target = findBlock(regs_.pc);
+
+  // Only ROM blocks are linked: they are never invalidated, so the link
+  // can't outlive its target
+  if (target && target->rom && !target->instructions.empty())
+  {
+    const bool fall_through = regs_.pc == from.instructions.back().next_pc;
+    from.links[fall_through ? 0 : 1] = {target, mmu_.getMemoryMapGeneration(), regs_.pc};
+  }
+  return target;
+}
+
+block_cache::block *block_cache::findBlock(uint16_t pc)
+{
+  const uint16_t physical_page = mmu_.getReadPhysicalPage(static_cast<uint8_t>(pc >> 8));
+  if (physical_page == MMU::NO_PHYSICAL_PAGE)
+  {
+    return nullptr;
+  }
+
+  auto &page = pages_[physical_page];
+  if (!page)
+  {
+    page = std::make_unique<page_blocks>();
+    page->block_at.fill(-1);
+  }
+  else if (page->stale)
+  {
+    page->blocks.clear();
+    page->block_at.fill(-1);
+    page->stale = false;
+  }
+
+  // Self-modifying code or code sharing a page with busy data
+  if (page->invalidations >= MAX_PAGE_INVALIDATIONS)
+  {
+    return nullptr;
+  }
+
+  int32_t index = page->block_at[pc & 0xFF];
+  if (index < 0)
+  {
+    index = decodeBlock(*page, physical_page, pc);
+  }
+  return &page->blocks[static_cast<size_t>(index)];
+}
+
+int32_t block_cache::decodeBlock(page_blocks &page, uint16_t physical_page, uint16_t pc)
+{
+  // Decode straight from the backing page - no side effects, and the page
+  // pointer is valid because getReadPhysicalPage() just refreshed the map
+  const uint8_t *memory = mmu_.getReadPage(static_cast<uint8_t>(pc >> 8));
+
+  block decoded;
+  decoded.rom = physical_page >= MMU::PHYS_ROM;
+  uint16_t address = pc;
+  while (decoded.instructions.size() < MAX_BLOCK_LENGTH)
+  {
+    const uint8_t offset = static_cast<uint8_t>(address);
+    const ops::opcode_entry &entry = ops::table[memory[offset]];
+    if (!entry.handler)
+    {
+      break;  // Interpreter only
+    }
+
+    const size_t length = entry.kind == operand_kind::NONE ? 1
+                          : (entry.kind == operand_kind::WORD || entry.kind == operand_kind::ZP_REL) ? 3
+                                                                                                     : 2;
+    if (offset + length > 256)
+    {
+      break;  // Instruction straddles the page
+    }
+
+    decoded_instruction insn{};
+    insn.handler = entry.handler;
+    insn.cycles = entry.cycles;
+    insn.next_pc = static_cast<uint16_t>(address + length);
+
+    switch (entry.kind)
+    {
+    case operand_kind::NONE:
+      break;
+    case operand_kind::BYTE:
+      insn.operand = memory[offset + 1];
+      break;
+    case operand_kind::WORD:
+      insn.operand = static_cast<uint16_t>(memory[offset + 1] | (memory[offset + 2] << 8));
+      break;
+    case operand_kind::RELATIVE:
+      insn.operand = static_cast<uint16_t>(insn.next_pc + static_cast<int8_t>(memory[offset + 1]));
+      break;
+    case operand_kind::ZP_REL:
+      insn.zp = memory[offset + 1];
+      insn.operand = static_cast<uint16_t>(insn.next_pc + static_cast<int8_t>(memory[offset + 2]));
+      break;
+    }
+
+    decoded.instructions.push_back(insn);
+    address = insn.next_pc;
+
+    if (entry.ends_block || (address & 0xFF00) != (pc & 0xFF00))
+    {
+      break;
+    }
+  }
+
+  // ROM can't be written, so only RAM pages need watching
+  if (!decoded.rom && !decoded.instructions.empty())
+  {
+    mmu_.setCodePage(physical_page, true);
+  }
+
+  page.blocks.push_back(std::move(decoded));
+  int32_t index = static_cast<int32_t>(page.blocks.size() - 1);
+  page.block_at[pc & 0xFF] = index;
+  return index;
+}
@@ -1,129 +1,382 @@
 #include "emulator/breakpoint_manager.hpp"
+#include "emulator/mmu.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
 
-void breakpoint_manager::addBreakpoint(uint16_t address, breakpoint_type type)
+namespace
+{
+const char* typeName(breakpoint_type type)
+{
+  switch (type)
+  {
+  case breakpoint_type::READ:
+    return "read";
+  case breakpoint_type::WRITE:
+    return "write";
+  default:
+    return "exec";
+  }
+}
+
+// Bank prefixes, indexed by memory_bank
+const char* const BANK_PREFIXES[] = {"", "main:", "aux:", "lc1:", "aux-lc1:", "lc:", "aux-lc:", "rom:", "none:"};
+
+/**
+ * Parse a hex address with an optional $ or 0x prefix
+ */
+bool parseAddress(const std::string& text, uint16_t& address)
+{
+  std::string digits = text;
+  if (!digits.empty() && digits[0] == '$')
+  {
+    digits.erase(0, 1);
+  }
+  else if (digits.size() > 1 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+  {
+    digits.erase(0, 2);
+  }
+  if (digits.empty() || digits.size() > 4 ||
+      !std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isxdigit(c); }))
+  {
+    return false;
+  }
+  address = static_cast<uint16_t>(std::stoul(digits, nullptr, 16));
+  return true;
+}
+} // namespace
+
+void breakpoint_manager::addBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank)
 {
   // Check if already exists
-  if (hasBreakpoint(address, type))
+  if (hasBreakpoint(address, type, bank))
   {
     return;
   }
 
   breakpoint bp;
   bp.address = address;
+  bp.end_address = address;
   bp.type = type;
+  bp.bank = bank;
   bp.enabled = true;
 
-  size_t index = breakpoints_.size();
   breakpoints_.push_back(bp);
+  rebuildMaps();
+}
 
-  // Add to appropriate map
-  switch (type)
+bool breakpoint_manager::addBreakpoint(uint16_t address, uint16_t end_address, breakpoint_type type,
+                                       memory_bank bank, const std::string& condition, std::string& error)
+{
+  if (end_address < address)
   {
-  case breakpoint_type::EXECUTION:
-    execution_map_[address].push_back(index);
-    break;
-  case breakpoint_type::READ:
-    read_map_[address].push_back(index);
-    break;
-  case breakpoint_type::WRITE:
-    write_map_[address].push_back(index);
-    break;
+    error = "range ends before it starts";
+    return false;
+  }
+
+  breakpoint bp;
+  bp.address = address;
+  bp.end_address = end_address;
+  bp.type = type;
+  bp.bank = bank;
+  bp.enabled = true;
+  if (!bp.condition.compile(condition, error))
+  {
+    return false;
+  }
+
+  breakpoints_.push_back(std::move(bp));
+  rebuildMaps();
+  return true;
+}
+
+bool breakpoint_manager::addWatchpoint(const std::string& spec, std::string& error)
+{
+  std::istringstream iss(spec);
+  std::string type_str, range_str;
+  if (!(iss >> type_str >> range_str))
+  {
+    error = "expected TYPE ADDR[-END] [if CONDITION]";
+    return false;
+  }
+
+  std::transform(type_str.begin(), type_str.end(), type_str.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  breakpoint_type type;
+  if (type_str == "exec" || type_str == "x")
+  {
+    type = breakpoint_type::EXECUTION;
+  }
+  else if (type_str == "read" || type_str == "r")
+  {
+    type = breakpoint_type::READ;
+  }
+  else if (type_str == "write" || type_str == "w")
+  {
+    type = breakpoint_type::WRITE;
+  }
+  else
+  {
+    error = "unknown type '" + type_str + "' (use exec, read or write)";
+    return false;
+  }
+
+  // Optional bank prefix
+  memory_bank bank = memory_bank::ANY;
+  size_t colon = range_str.find(':');
+  if (colon != std::string::npos)
+  {
+    std::string prefix = range_str.substr(0, colon + 1);
+    std::transform(prefix.begin(), prefix.end(), prefix.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (prefix == "lc2:" || prefix == "aux-lc2:")
+    {
+      prefix.erase(prefix.size() - 2, 1);
+    }
+    auto it = std::find_if(std::begin(BANK_PREFIXES) + 1, std::end(BANK_PREFIXES) - 1,
+                           [&prefix](const char* name) { return prefix == name; });
+    if (it == std::end(BANK_PREFIXES) - 1)
+    {
+      error = "unknown bank '" + prefix + "' (use main, aux, lc1, aux-lc1, lc, aux-lc or rom)";
+      return false;
+    }
+    bank = static_cast<memory_bank>(it - std::begin(BANK_PREFIXES));
+    range_str.erase(0, colon + 1);
+  }
+
+  uint16_t address = 0;
+  uint16_t end_address = 0;
+  size_t dash = range_str.find('-');
+  if (!parseAddress(range_str.substr(0, dash), address) ||
+      !parseAddress(dash == std::string::npos ? range_str : range_str.substr(dash + 1), end_address))
+  {
+    error = "bad address '" + range_str + "'";
+    return false;
+  }
+
+  std::string condition;
+  std::string keyword;
+  if (iss >> keyword)
+  {
+    if (keyword != "if")
+    {
+      error = "expected 'if' before the condition";
+      return false;
+    }
+    std::getline(iss, condition);
+    size_t start = condition.find_first_not_of(" \t");
+    if (start == std::string::npos)
+    {
+      error = "missing condition after 'if'";
+      return false;
+    }
+    condition.erase(0, start);
   }
+
+  return addBreakpoint(address, end_address, type, bank, condition, error);
 }
 
-void breakpoint_manager::removeBreakpoint(uint16_t address, breakpoint_type type)
+void breakpoint_manager::removeBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank)
 {
-  size_t index = findBreakpoint(address, type);
+  size_t index = findBreakpoint(address, type, bank);
   if (index == static_cast<size_t>(-1))
   {
     return;
   }
 
-  breakpoints_.erase(breakpoints_.begin() + index);
+  removeBreakpointAt(index);
+}
+
+void breakpoint_manager::removeBreakpointAt(size_t index)
+{
+  if (index >= breakpoints_.size())
+  {
+    return;
+  }
+
+  breakpoints_.erase(breakpoints_.begin() + static_cast<std::ptrdiff_t>(index));
   rebuildMaps();
 }
 
-void breakpoint_manager::toggleBreakpoint(uint16_t address, breakpoint_type type)
+void breakpoint_manager::toggleBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank)
 {
-  if (hasBreakpoint(address, type))
+  if (hasBreakpoint(address, type, bank))
   {
-    removeBreakpoint(address, type);
+    removeBreakpoint(address, type, bank);
   }
   else
   {
-    addBreakpoint(address, type);
+    addBreakpoint(address, type, bank);
   }
 }
 
-bool breakpoint_manager::hasBreakpoint(uint16_t address, breakpoint_type type) const
+bool breakpoint_manager::hasBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank) const
 {
-  return findBreakpoint(address, type) != static_cast<size_t>(-1);
+  return findBreakpoint(address, type, bank) != static_cast<size_t>(-1);
 }
 
-void breakpoint_manager::setEnabled(uint16_t address, breakpoint_type type, bool enabled)
+void breakpoint_manager::setEnabled(uint16_t address, breakpoint_type type, bool enabled, memory_bank bank)
 {
-  size_t index = findBreakpoint(address, type);
-  if (index != static_cast<size_t>(-1))
+  setEnabledAt(findBreakpoint(address, type, bank), enabled);
+}
+
+void breakpoint_manager::setEnabledAt(size_t index, bool enabled)
+{
+  if (index < breakpoints_.size())
   {
     breakpoints_[index].enabled = enabled;
+    rebuildMaps();
   }
 }
 
-bool breakpoint_manager::checkExecution(uint16_t pc) const
+void breakpoint_manager::setEvaluationContext(ContextCallback context, const MMU* mmu)
 {
-  auto it = execution_map_.find(pc);
-  if (it == execution_map_.end())
+  context_callback_ = std::move(context);
+  mmu_ = mmu;
+  peek_callback_ = nullptr;
+  if (mmu)
   {
-    return false;
+    peek_callback_ = [mmu](uint16_t address) { return mmu->peek(address); };
+  }
+}
+
+memory_bank breakpoint_manager::bankAt(uint16_t address, breakpoint_type type) const
+{
+  if (!mmu_)
+  {
+    return memory_bank::UNMAPPED;
   }
 
-  for (size_t index : it->second)
+  const uint8_t page = static_cast<uint8_t>(address >> 8);
+  const uint16_t physical = (type == breakpoint_type::WRITE) ? mmu_->getWritePhysicalPage(page)
+                                                              : mmu_->getReadPhysicalPage(page);
+  if (physical == MMU::NO_PHYSICAL_PAGE)
   {
-    if (breakpoints_[index].enabled)
+    return memory_bank::UNMAPPED;
+  }
+  if (physical >= MMU::PHYS_ROM)
+  {
+    return memory_bank::ROM;
+  }
+
+  // Language card bank 1 is stored at $C000-$CFFF of the RAM bank
+  const bool aux = physical >= MMU::PHYS_AUX_RAM;
+  const uint16_t bank_page = physical & 0xFF;
+  if (bank_page >= 0xC0 && bank_page <= 0xCF)
+  {
+    return aux ? memory_bank::AUX_LC1 : memory_bank::LC1;
+  }
+  if (bank_page >= 0xD0)
+  {
+    return aux ? memory_bank::AUX_LC : memory_bank::LC;
+  }
+  return aux ? memory_bank::AUX : memory_bank::MAIN;
+}
+
+const char* breakpoint_manager::bankPrefix(memory_bank bank)
+{
+  return BANK_PREFIXES[static_cast<size_t>(bank)];
+}
+
+bool breakpoint_manager::evaluate(breakpoint_type type, uint16_t address, uint8_t value)
+{
+  watch_condition::context ctx;
+  bool have_context = false;
+  bool have_bank = false;
+  memory_bank mapped = memory_bank::UNMAPPED;
+
+  for (uint32_t index : enabled_[static_cast<size_t>(type)])
+  {
+    const auto& bp = breakpoints_[index];
+    if (address < bp.address || address > bp.end_address)
     {
-      return true;
+      continue;
     }
+
+    if (bp.bank != memory_bank::ANY)
+    {
+      if (!have_bank)
+      {
+        mapped = bankAt(address, type);
+        have_bank = true;
+      }
+      if (bp.bank != mapped)
+      {
+        continue;
+      }
+    }
+
+    if (!bp.condition.empty())
+    {
+      if (!have_context)
+      {
+        if (context_callback_)
+        {
+          context_callback_(ctx);
+        }
+        ctx.address = address;
+        ctx.value = value;
+        if (type == breakpoint_type::EXECUTION)
+        {
+          ctx.pc = address;
+        }
+        have_context = true;
+      }
+      if (!bp.condition.evaluate(ctx, peek_callback_))
+      {
+        continue;
+      }
+    }
+
+    // Keep the first hit of an instruction
+    if (!hit_pending_)
+    {
+      hit_pending_ = true;
+      last_hit_.type = type;
+      last_hit_.address = address;
+      last_hit_.value = value;
+      last_hit_.pc = address;
+    }
+    return true;
   }
   return false;
 }
 
-bool breakpoint_manager::checkRead(uint16_t address) const
+std::string breakpoint_manager::describe(const breakpoint& bp)
 {
-  auto it = read_map_.find(address);
-  if (it == read_map_.end())
+  char buf[48];
+  if (bp.end_address != bp.address)
   {
-    return false;
+    std::snprintf(buf, sizeof(buf), "%s %s$%04X-$%04X", typeName(bp.type), bankPrefix(bp.bank), bp.address,
+                  bp.end_address);
+  }
+  else
+  {
+    std::snprintf(buf, sizeof(buf), "%s %s$%04X", typeName(bp.type), bankPrefix(bp.bank), bp.address);
   }
 
-  for (size_t index : it->second)
+  std::string text = buf;
+  if (!bp.condition.empty())
   {
-    if (breakpoints_[index].enabled)
-    {
-      return true;
-    }
+    text += " if " + bp.condition.getText();
   }
-  return false;
+  return text;
 }
 
-bool breakpoint_manager::checkWrite(uint16_t address) const
+std::string breakpoint_manager::describe(const breakpoint_hit& hit)
 {
-  auto it = write_map_.find(address);
-  if (it == write_map_.end())
+  char buf[48];
+  if (hit.type == breakpoint_type::EXECUTION)
   {
-    return false;
+    std::snprintf(buf, sizeof(buf), "exec $%04X", hit.address);
   }
-
-  for (size_t index : it->second)
+  else
   {
-    if (breakpoints_[index].enabled)
-    {
-      return true;
-    }
+    std::snprintf(buf, sizeof(buf), "%s $%04X=$%02X at $%04X", typeName(hit.type), hit.address, hit.value, hit.pc);
   }
-  return false;
+  return buf;
 }
 
 std::string breakpoint_manager::serialize() const
@@ -141,7 +394,10 @@ std::string breakpoint_manager::serialize() const
 
     oss << std::hex << std::setw(4) << std::setfill('0') << bp.address << ":"
         << static_cast<int>(bp.type) << ":"
-        << (bp.enabled ? "1" : "0");
+        << (bp.enabled ? "1" : "0") << ":"
+        << std::setw(4) << bp.end_address << ":"
+        << bp.condition.getText() << ":"
+        << static_cast<int>(bp.bank);
   }
 
   return oss.str();
@@ -162,7 +418,7 @@ void breakpoint_manager::deserialize(const std::string& data)
   while (std::getline(iss, token, ';'))
   {
     std::istringstream token_stream(token);
-    std::string addr_str, type_str, enabled_str;
+    std::string addr_str, type_str, enabled_str, end_str, condition, bank_str;
 
     if (!std::getline(token_stream, addr_str, ':') ||
         !std::getline(token_stream, type_str, ':') ||
@@ -170,6 +426,9 @@ void breakpoint_manager::deserialize(const std::string& data)
     {
       continue;
     }
+    std::getline(token_stream, end_str, ':');
+    std::getline(token_stream, condition, ':');
+    std::getline(token_stream, bank_str, ':');
 
     try
     {
@@ -179,10 +438,21 @@ void breakpoint_manager::deserialize(const std::string& data)
 
       breakpoint bp;
       bp.address = address;
+      bp.end_address = end_str.empty() ? address : static_cast<uint16_t>(std::stoul(end_str, nullptr, 16));
       bp.type = static_cast<breakpoint_type>(type_int);
       bp.enabled = enabled;
-
-      breakpoints_.push_back(bp);
+      int bank_int = bank_str.empty() ? 0 : std::stoi(bank_str);
+      bp.bank = static_cast<memory_bank>(bank_int);
+
+      std::string error;
+      if (type_int < 0 || type_int > static_cast<int>(breakpoint_type::WRITE) ||
+          bank_int < 0 || bank_int >= static_cast<int>(memory_bank::UNMAPPED) ||
+          bp.end_address < bp.address || !bp.condition.compile(condition, error))
+      {
+        continue;
+      }
+
+      breakpoints_.push_back(std::move(bp));
     }
     catch (...)
     {
@@ -197,41 +467,57 @@ void breakpoint_manager::deserialize(const std::string& data)
 void breakpoint_manager::clear()
 {
   breakpoints_.clear();
-  execution_map_.clear();
-  read_map_.clear();
-  write_map_.clear();
+  rebuildMaps();
+  hit_pending_ = false;
 }
 
 void breakpoint_manager::rebuildMaps()
 {
-  execution_map_.clear();
-  read_map_.clear();
-  write_map_.clear();
+  execution_bits_.fill(0);
+  read_bits_.fill(0);
+  write_bits_.fill(0);
+  for (auto& indices : enabled_)
+  {
+    indices.clear();
+  }
 
   for (size_t i = 0; i < breakpoints_.size(); ++i)
   {
     const auto& bp = breakpoints_[i];
+    if (!bp.enabled)
+    {
+      continue;
+    }
+    enabled_[static_cast<size_t>(bp.type)].push_back(static_cast<uint32_t>(i));
+
+    address_bitmap* bits = &execution_bits_;
+    if (bp.type == breakpoint_type::READ)
+    {
+      bits = &read_bits_;
+    }
+    else if (bp.type == breakpoint_type::WRITE)
+    {
+      bits = &write_bits_;
+    }
 
-    switch (bp.type)
+    for (uint32_t address = bp.address; address <= bp.end_address; ++address)
     {
-    case breakpoint_type::EXECUTION:
-      execution_map_[bp.address].push_back(i);
-      break;
-    case breakpoint_type::READ:
-      read_map_[bp.address].push_back(i);
-      break;
-    case breakpoint_type::WRITE:
-      write_map_[bp.address].push_back(i);
-      break;
+      (*bits)[address >> 6] |= uint64_t{1} << (address & 63);
     }
   }
+
+  enabled_execution_count_ = enabled_[static_cast<size_t>(breakpoint_type::EXECUTION)].size();
+  enabled_watch_count_ = enabled_[static_cast<size_t>(breakpoint_type::READ)].size() +
+                         enabled_[static_cast<size_t>(breakpoint_type::WRITE)].size();
 }
 
-size_t breakpoint_manager::findBreakpoint(uint16_t address, breakpoint_type type) const
+size_t breakpoint_manager::findBreakpoint(uint16_t address, breakpoint_type type, memory_bank bank) const
 {
   for (size_t i = 0; i < breakpoints_.size(); ++i)
   {
-    if (breakpoints_[i].address == address && breakpoints_[i].type == type)
+    const auto& bp = breakpoints_[i];
+    if (bp.address == address && bp.end_address == address && bp.type == type && bp.bank == bank &&
+        bp.condition.empty())
     {
       return i;
     }
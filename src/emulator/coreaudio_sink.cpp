@@ -0,0 +1,119 @@
+#include "emulator/coreaudio_sink.hpp"
+#include <AudioToolbox/AudioToolbox.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <cstring>
+#include <iostream>
+
+coreaudio_sink::~coreaudio_sink()
+{
+  close();
+}
+
+void coreaudio_sink::audioQueueCallback(void* userData,
+                                        AudioQueueRef queue,
+                                        AudioQueueBufferRef buffer)
+{
+  auto* sink = static_cast<coreaudio_sink*>(userData);
+  auto* out = static_cast<int16_t*>(buffer->mAudioData);
+  uint32_t frames = buffer->mAudioDataByteSize / sizeof(int16_t);
+
+  sink->pull_(out, frames);
+
+  // Re-enqueue the buffer
+  AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr);
+}
+
+bool coreaudio_sink::open(int sample_rate, uint32_t frames_per_buffer, pull_callback pull)
+{
+  if (audioQueue_)
+  {
+    return true;
+  }
+
+  pull_ = std::move(pull);
+
+  // Set up the audio format
+  AudioStreamBasicDescription format = {};
+  format.mSampleRate = sample_rate;
+  format.mFormatID = kAudioFormatLinearPCM;
+  format.mFormatFlags = kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked;
+  format.mBitsPerChannel = 16;
+  format.mChannelsPerFrame = 1;
+  format.mBytesPerFrame = sizeof(int16_t);
+  format.mFramesPerPacket = 1;
+  format.mBytesPerPacket = format.mBytesPerFrame;
+
+  // Create the audio queue with NULL run loop - uses internal audio thread
+  OSStatus status = AudioQueueNewOutput(
+    &format,
+    audioQueueCallback,
+    this,
+    NULL,
+    NULL,
+    0,
+    &audioQueue_
+  );
+
+  if (status != noErr)
+  {
+    std::cerr << "AudioQueueNewOutput error: " << status << std::endl;
+    audioQueue_ = nullptr;
+    return false;
+  }
+
+  // Allocate and enqueue buffers
+  uint32_t bufferSize = frames_per_buffer * sizeof(int16_t);
+  for (int i = 0; i < NUM_BUFFERS; i++)
+  {
+    status = AudioQueueAllocateBuffer(audioQueue_, bufferSize, &audioBuffers_[i]);
+    if (status != noErr)
+    {
+      std::cerr << "AudioQueueAllocateBuffer error: " << status << std::endl;
+      AudioQueueDispose(audioQueue_, true);
+      audioQueue_ = nullptr;
+      return false;
+    }
+
+    // Initialize buffer with silence
+    audioBuffers_[i]->mAudioDataByteSize = bufferSize;
+    memset(audioBuffers_[i]->mAudioData, 0, bufferSize);
+
+    // Enqueue the buffer
+    status = AudioQueueEnqueueBuffer(audioQueue_, audioBuffers_[i], 0, nullptr);
+    if (status != noErr)
+    {
+      std::cerr << "AudioQueueEnqueueBuffer error: " << status << std::endl;
+      AudioQueueDispose(audioQueue_, true);
+      audioQueue_ = nullptr;
+      return false;
+    }
+  }
+
+  // Start the audio queue
+  status = AudioQueueStart(audioQueue_, nullptr);
+  if (status != noErr)
+  {
+    std::cerr << "AudioQueueStart error: " << status << std::endl;
+    AudioQueueDispose(audioQueue_, true);
+    audioQueue_ = nullptr;
+    return false;
+  }
+
+  return true;
+}
+
+void coreaudio_sink::close()
+{
+  if (audioQueue_)
+  {
+    AudioQueueStop(audioQueue_, true);
+    AudioQueueDispose(audioQueue_, true);
+    audioQueue_ = nullptr;
+  }
+
+  // Clear buffer pointers (memory freed by AudioQueueDispose)
+  for (int i = 0; i < NUM_BUFFERS; i++)
+  {
+    audioBuffers_[i] = nullptr;
+  }
+}
@@ -3,6 +3,7 @@
 #include "emulator/disk_formats/dsk_disk_image.hpp"
 #include "utils/resource_path.hpp"
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
@@ -16,8 +17,8 @@ Disk2Controller::Disk2Controller()
 void Disk2Controller::reset()
 {
   // Reset controller to power-on state
+  cancelMotorOff();
   motor_on_ = false;
-  motor_off_cycle_ = 0;
   selected_drive_ = 0;
   q6_ = false;
   q7_ = false;
@@ -69,18 +70,26 @@ bool Disk2Controller::loadControllerROM()
   size_t file_size = file.tellg();
   file.seekg(0, std::ios::beg);
 
-  if (file_size != ROM_SIZE)
+  std::array<uint8_t, ROM_SIZE> data;
+  if (file_size == ROM_SIZE)
+  {
+    file.read(reinterpret_cast<char *>(data.data()), ROM_SIZE);
+  }
+  file.close();
+
+  return loadControllerROM(data.data(), file_size);
+}
+
+bool Disk2Controller::loadControllerROM(const uint8_t *data, size_t size)
+{
+  if (!data || size != ROM_SIZE)
   {
     std::cerr << "Disk II ROM size mismatch: expected " << ROM_SIZE
-              << " bytes, got " << file_size << std::endl;
-    file.close();
+              << " bytes, got " << size << std::endl;
     return false;
   }
 
-  // Read ROM data
-  file.read(reinterpret_cast<char *>(slot_rom_.data()), ROM_SIZE);
-  file.close();
-
+  std::copy(data, data + ROM_SIZE, slot_rom_.begin());
   rom_loaded_ = true;
   std::cout << "Loaded Disk II controller ROM (341-0027) at $C600-$C6FF" << std::endl;
 
@@ -176,6 +185,36 @@ uint64_t Disk2Controller::getCycles() const
   return 0;
 }
 
+void Disk2Controller::setScheduler(event_scheduler *scheduler)
+{
+  cancelMotorOff();
+  scheduler_ = scheduler;
+}
+
+void Disk2Controller::cancelMotorOff()
+{
+  if (scheduler_)
+  {
+    scheduler_->cancel(motor_off_event_);
+  }
+  motor_off_event_ = event_scheduler::NO_EVENT;
+  motor_off_cycle_ = 0;
+}
+
+void Disk2Controller::scheduleMotorOff()
+{
+  if (scheduler_)
+  {
+    motor_off_event_ = scheduler_->schedule(motor_off_cycle_ + MOTOR_OFF_DELAY_CYCLES,
+                                            [this](uint64_t)
+    {
+      motor_off_event_ = event_scheduler::NO_EVENT;
+      motor_off_cycle_ = 0;
+      motor_on_ = false;
+    });
+  }
+}
+
 uint8_t Disk2Controller::handleSoftSwitch(uint8_t offset, bool is_write)
 {
   (void)is_write; // Both reads and writes toggle/access the switches
@@ -229,11 +268,12 @@ uint8_t Disk2Controller::handleSoftSwitch(uint8_t offset, bool is_write)
     if (motor_on_ && motor_off_cycle_ == 0)
     {
       motor_off_cycle_ = getCycles();
+      scheduleMotorOff();
     }
     break;
   case MOTOR_ON:
     // Cancel any pending motor-off and turn motor on
-    motor_off_cycle_ = 0;
+    cancelMotorOff();
     motor_on_ = true;
     break;
 
@@ -346,20 +386,23 @@ void Disk2Controller::ejectDisk(int drive)
     // (don't disrupt the other drive if it's active)
     if (selected_drive_ == drive)
     {
+      cancelMotorOff();
       motor_on_ = false;
-      motor_off_cycle_ = 0;
     }
 
     // Save any modifications before ejecting
-    std::cout << "Saving disk image..." << std::endl;
-    bool saved = disk_images_[drive]->save();
-    if (saved)
+    if (write_back_)
     {
-      std::cout << "Saved disk in drive " << (drive + 1) << std::endl;
-    }
-    else
-    {
-      std::cerr << "Warning: Failed to save disk in drive " << (drive + 1) << std::endl;
+      std::cout << "Saving disk image..." << std::endl;
+      bool saved = disk_images_[drive]->save();
+      if (saved)
+      {
+        std::cout << "Saved disk in drive " << (drive + 1) << std::endl;
+      }
+      else
+      {
+        std::cerr << "Warning: Failed to save disk in drive " << (drive + 1) << std::endl;
+      }
     }
 
     std::cout << "Releasing disk image..." << std::endl;
@@ -370,6 +413,11 @@ void Disk2Controller::ejectDisk(int drive)
 
 void Disk2Controller::saveAllDisks()
 {
+  if (!write_back_)
+  {
+    return;
+  }
+
   for (int drive = 0; drive < 2; drive++)
   {
     if (disk_images_[drive])
@@ -402,8 +450,8 @@ const DiskImage *Disk2Controller::getDiskImage(int drive) const
 
 bool Disk2Controller::isMotorOn() const
 {
-  // Check if motor-off delay has elapsed
-  if (motor_on_ && motor_off_cycle_ != 0)
+  // Without a scheduler, check if the motor-off delay has elapsed
+  if (!scheduler_ && motor_on_ && motor_off_cycle_ != 0)
   {
     uint64_t current = getCycles();
     if (current >= motor_off_cycle_ + MOTOR_OFF_DELAY_CYCLES)
@@ -444,6 +492,137 @@ int Disk2Controller::getQuarterTrack() const
   return -1;
 }
 
+Disk2Controller::State Disk2Controller::getState() const
+{
+  State state;
+  state.motor_on = motor_on_;
+  state.motor_off_cycle = motor_off_cycle_;
+  state.selected_drive = selected_drive_;
+  state.q6 = q6_;
+  state.q7 = q7_;
+  state.phase_states = phase_states_;
+  state.data_latch = data_latch_;
+  state.latch_valid = latch_valid_;
+  state.write_latch = write_latch_;
+  state.write_pending = write_pending_;
+  for (int drive = 0; drive < 2; drive++)
+  {
+    state.last_read_cycle[drive] = last_read_cycle_[drive];
+    state.last_write_cycle[drive] = last_write_cycle_[drive];
+    if (disk_images_[drive])
+    {
+      state.heads[drive] = disk_images_[drive]->getHeadState();
+    }
+  }
+  return state;
+}
+
+void Disk2Controller::restoreState(const State &state, uint64_t cycle_offset)
+{
+  auto rebase = [cycle_offset](uint64_t cycle) { return cycle != 0 ? cycle + cycle_offset : 0; };
+
+  cancelMotorOff();
+  motor_on_ = state.motor_on;
+  selected_drive_ = state.selected_drive;
+  q6_ = state.q6;
+  q7_ = state.q7;
+  phase_states_ = state.phase_states;
+  data_latch_ = state.data_latch;
+  latch_valid_ = state.latch_valid;
+  write_latch_ = state.write_latch;
+  write_pending_ = state.write_pending;
+  for (int drive = 0; drive < 2; drive++)
+  {
+    last_read_cycle_[drive] = rebase(state.last_read_cycle[drive]);
+    last_write_cycle_[drive] = rebase(state.last_write_cycle[drive]);
+    if (disk_images_[drive])
+    {
+      disk_images_[drive]->setHeadState(state.heads[drive]);
+    }
+  }
+
+  if (motor_on_ && state.motor_off_cycle != 0)
+  {
+    motor_off_cycle_ = rebase(state.motor_off_cycle);
+    scheduleMotorOff();
+  }
+}
+
+void Disk2Controller::saveState(state_writer &out) const
+{
+  State state = getState();
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeBool(state.motor_on);
+  out.writeU64(state.motor_off_cycle);
+  out.writeU8(static_cast<uint8_t>(state.selected_drive));
+  out.writeBool(state.q6);
+  out.writeBool(state.q7);
+  out.writeU8(state.phase_states);
+  out.writeU8(state.data_latch);
+  out.writeBool(state.latch_valid);
+  out.writeU8(state.write_latch);
+  out.writeBool(state.write_pending);
+  for (int drive = 0; drive < 2; drive++)
+  {
+    out.writeString(disk_images_[drive] ? disk_images_[drive]->getFilepath() : std::string());
+    out.writeU64(state.last_read_cycle[drive]);
+    out.writeU64(state.last_write_cycle[drive]);
+    out.writeU8(static_cast<uint8_t>(state.heads[drive].quarter_track));
+    out.writeU8(state.heads[drive].phase_states);
+    out.writeU8(static_cast<uint8_t>(state.heads[drive].last_phase));
+    out.writeU32(state.heads[drive].position);
+  }
+  out.endChunk();
+}
+
+bool Disk2Controller::loadState(state_chunk &chunk)
+{
+  State state;
+  std::string paths[2];
+  state.motor_on = chunk.readBool();
+  state.motor_off_cycle = chunk.readU64();
+  state.selected_drive = chunk.readU8() & 1;
+  state.q6 = chunk.readBool();
+  state.q7 = chunk.readBool();
+  state.phase_states = chunk.readU8();
+  state.data_latch = chunk.readU8();
+  state.latch_valid = chunk.readBool();
+  state.write_latch = chunk.readU8();
+  state.write_pending = chunk.readBool();
+  for (int drive = 0; drive < 2; drive++)
+  {
+    paths[drive] = chunk.readString();
+    state.last_read_cycle[drive] = chunk.readU64();
+    state.last_write_cycle[drive] = chunk.readU64();
+    state.heads[drive].quarter_track = chunk.readU8();
+    state.heads[drive].phase_states = chunk.readU8();
+    state.heads[drive].last_phase = chunk.readU8() & 3;
+    state.heads[drive].position = chunk.readU32();
+  }
+  if (chunk.isTruncated())
+  {
+    return false;
+  }
+
+  // Put the saved disks back in the drives, leaving ones already there alone
+  for (int drive = 0; drive < 2; drive++)
+  {
+    const std::string current = disk_images_[drive] ? disk_images_[drive]->getFilepath() : std::string();
+    if (paths[drive] == current)
+    {
+      continue;
+    }
+    ejectDisk(drive);
+    if (!paths[drive].empty() && !insertDisk(drive, paths[drive]))
+    {
+      std::cerr << "Save state disk image not available: " << paths[drive] << std::endl;
+    }
+  }
+
+  restoreState(state, 0);
+  return true;
+}
+
 uint8_t Disk2Controller::readDiskData()
 {
   // If motor is off or no disk, return 0
@@ -505,7 +684,7 @@ void Disk2Controller::writeDiskData()
   // If motor is off, no disk, or not in write mode, do nothing
   if (!isMotorOn() || !hasDisk(selected_drive_) || !q7_)
   {
-    static int skip_count = 0;
+    static std::atomic<int> skip_count{0};
     if (++skip_count <= 10)
       std::cerr << "Write skipped: motor=" << isMotorOn()
                 << " hasDisk=" << hasDisk(selected_drive_)
@@ -518,7 +697,7 @@ void Disk2Controller::writeDiskData()
   // Check write protection
   if (disk->isWriteProtected())
   {
-    static int wp_count = 0;
+    static std::atomic<int> wp_count{0};
     if (++wp_count <= 10)
       std::cerr << "Write skipped: disk is write protected" << std::endl;
     return;
@@ -527,7 +706,7 @@ void Disk2Controller::writeDiskData()
   // Check if current head position has data
   if (!disk->hasData())
   {
-    static int nodata_count = 0;
+    static std::atomic<int> nodata_count{0};
     if (++nodata_count <= 10)
       std::cerr << "Write skipped: no data at quarter-track "
                 << disk->getQuarterTrack() << std::endl;
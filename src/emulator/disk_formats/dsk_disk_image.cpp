@@ -1,6 +1,7 @@
 #include "emulator/disk_formats/dsk_disk_image.hpp"
 #include "emulator/disk_formats/gcr_encoding.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -598,6 +599,32 @@ void DskDiskImage::updateHeadPosition(int phase)
   last_phase_ = phase;
 }
 
+DiskImage::HeadState DskDiskImage::getHeadState() const
+{
+  HeadState state;
+  state.quarter_track = quarter_track_;
+  state.phase_states = phase_states_;
+  state.last_phase = last_phase_;
+  state.position = static_cast<uint32_t>(nibble_position_);
+  return state;
+}
+
+void DskDiskImage::setHeadState(const HeadState &state)
+{
+  quarter_track_ = std::clamp(state.quarter_track, 0, TRACKS * 4 - 1);
+  phase_states_ = state.phase_states;
+  last_phase_ = state.last_phase;
+  nibble_position_ = state.position;
+
+  // Keep the position inside the track's nibble stream
+  if (loaded_)
+  {
+    ensureTrackNibblized();
+    const auto &nt = nibble_tracks_[quarter_track_ / 4];
+    nibble_position_ = nt.nibbles.empty() ? 0 : nibble_position_ % nt.nibbles.size();
+  }
+}
+
 bool DskDiskImage::hasData() const
 {
   int track = quarter_track_ / 4;
@@ -694,7 +721,7 @@ void DskDiskImage::writeNibble(uint8_t nibble)
   int track = quarter_track_ / 4;
   if (track < 0 || track >= TRACKS)
   {
-    static int bad_track_count = 0;
+    static std::atomic<int> bad_track_count{0};
     if (++bad_track_count <= 10)
     {
       std::cout << "DSK: writeNibble invalid track=" << track
@@ -1,5 +1,6 @@
 #include "emulator/disk_formats/woz_disk_image.hpp"
 #include "emulator/disk_formats/dos33_formatter.hpp"
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
@@ -389,6 +390,25 @@ int WozDiskImage::getTrack() const
   return quarter_track_ / 4;
 }
 
+DiskImage::HeadState WozDiskImage::getHeadState() const
+{
+  HeadState state;
+  state.quarter_track = quarter_track_;
+  state.phase_states = phase_states_;
+  state.last_phase = last_phase_;
+  state.position = bit_position_;
+  return state;
+}
+
+void WozDiskImage::setHeadState(const HeadState &state)
+{
+  // Bit positions wrap to the track length when read
+  quarter_track_ = std::clamp(state.quarter_track, 0, QUARTER_TRACK_COUNT - 1);
+  phase_states_ = state.phase_states;
+  last_phase_ = state.last_phase;
+  bit_position_ = state.position;
+}
+
 bool WozDiskImage::hasData() const
 {
   if (quarter_track_ < 0 || quarter_track_ >= QUARTER_TRACK_COUNT)
@@ -1,27 +1,81 @@
 #include "emulator/emulator.hpp"
+#include "emulator/block_cache.hpp"
+#include "emulator/idle_detector.hpp"
+#include "emulator/save_state.hpp"
 #include "utils/logger.hpp"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <filesystem>
 #include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <utility>
+
+// Audio batch length: the speaker generates samples every ~1ms of emulated
+// time rather than once per update(), keeping the audio buffer fed evenly
+static constexpr uint64_t AUDIO_BATCH_CYCLES = 1023;
+
+// Memory bus accessors handed to the CPU core.
+//
+// The CPU template calls its read/write functors for every opcode fetch,
+// operand read and store, so this is the hottest path in the emulator. Using
+// small concrete functors that hold an MMU reference (rather than a type
+// erased std::function) lets the compiler see straight through to MMU::read
+// and MMU::write when it instantiates the instruction loop. MMU is final so
+// the calls are direct rather than virtual.
+//
+// Define A2E_CPU_STD_FUNCTION_CALLBACKS (cmake -DA2E_CPU_STD_FUNCTION_CALLBACKS=ON)
+// to fall back to std::function callbacks, which is handy when you want to
+// break on or intercept every bus access from a debug build.
+#ifndef A2E_CPU_STD_FUNCTION_CALLBACKS
+struct mmu_bus_read
+{
+  MMU *mmu;
+  uint8_t operator()(uint16_t address) const { return mmu->read(address); }
+};
+
+struct mmu_bus_write
+{
+  MMU *mmu;
+  void operator()(uint16_t address, uint8_t value) const { mmu->write(address, value); }
+};
+#endif
 
 // CPU wrapper to hide template complexity
 class emulator::cpu_wrapper
 {
 public:
+#ifdef A2E_CPU_STD_FUNCTION_CALLBACKS
   using ReadCallback = std::function<uint8_t(uint16_t)>;
   using WriteCallback = std::function<void(uint16_t, uint8_t)>;
-  using CPU = MOS6502::CPU6502<ReadCallback, WriteCallback, MOS6502::CPUVariant::CMOS_65C02>;
 
-  cpu_wrapper(ReadCallback read, WriteCallback write)
-      : cpu_(std::move(read), std::move(write))
+  explicit cpu_wrapper(MMU &mmu)
+      : cpu_([&mmu](uint16_t address) -> uint8_t { return mmu.read(address); },
+             [&mmu](uint16_t address, uint8_t value) { mmu.write(address, value); }),
+        cache_(mmu)
+  {
+  }
+#else
+  using ReadCallback = mmu_bus_read;
+  using WriteCallback = mmu_bus_write;
+
+  explicit cpu_wrapper(MMU &mmu)
+      : cpu_(ReadCallback{&mmu}, WriteCallback{&mmu}),
+        cache_(mmu)
   {
   }
+#endif
+
+  using CPU = MOS6502::CPU6502<ReadCallback, WriteCallback, MOS6502::CPUVariant::CMOS_65C02>;
 
   void reset() { cpu_.reset(); }
   uint32_t executeInstruction() { return cpu_.executeInstruction(); }
-  uint64_t getTotalCycles() const { return cpu_.getTotalCycles(); }
+  // Cycles run by the block cache or skipped over idle loops count towards
+  // the total so disk, speaker and VBL timing see one continuous clock
+  uint64_t getTotalCycles() const { return cpu_.getTotalCycles() + cache_.getCycles() + skipped_cycles_; }
   uint16_t getPC() const { return cpu_.getPC(); }
   uint8_t getSP() const { return cpu_.getSP(); }
   uint8_t getP() const { return cpu_.getP(); }
@@ -37,8 +91,94 @@ public:
   void setX(uint8_t val) { cpu_.setX(val); }
   void setY(uint8_t val) { cpu_.setY(val); }
 
+  block_cache::registers getRegisters() const
+  {
+    block_cache::registers regs;
+    regs.pc = cpu_.getPC();
+    regs.sp = cpu_.getSP();
+    regs.p = cpu_.getP();
+    regs.a = cpu_.getA();
+    regs.x = cpu_.getX();
+    regs.y = cpu_.getY();
+    return regs;
+  }
+
+  void setRegisters(const block_cache::registers &regs)
+  {
+    cpu_.setPC(regs.pc);
+    cpu_.setSP(regs.sp);
+    cpu_.setP(regs.p);
+    cpu_.setA(regs.a);
+    cpu_.setX(regs.x);
+    cpu_.setY(regs.y);
+  }
+
+  // Run predecoded blocks from the current PC, syncing registers with the
+  // interpreter. Returns 0 if the next instruction needs the interpreter.
+  uint64_t executeCached(uint64_t target_cycles)
+  {
+    block_cache::registers regs = getRegisters();
+    uint64_t instructions = cache_.run(regs, cpu_.getTotalCycles() + skipped_cycles_, target_cycles);
+    if (instructions > 0)
+    {
+      setRegisters(regs);
+    }
+    return instructions;
+  }
+
+  // Advance the clock over code that was fast-forwarded instead of run
+  void skipCycles(uint64_t cycles) { skipped_cycles_ += cycles; }
+
+  // Set the clock outright (save state load). The offset wraps modulo 2^64
+  // if the clock goes backwards, which still sums to the right total.
+  void setTotalCycles(uint64_t cycles) { skipped_cycles_ = cycles - cpu_.getTotalCycles() - cache_.getCycles(); }
+
+  // Save state chunk: registers and the cycle counter
+  static constexpr uint32_t STATE_TAG = save_state::makeTag("CPU ");
+  static constexpr uint16_t STATE_VERSION = 1;
+
+  void saveState(state_writer &out) const
+  {
+    out.beginChunk(STATE_TAG, STATE_VERSION);
+    out.writeU16(cpu_.getPC());
+    out.writeU8(cpu_.getSP());
+    out.writeU8(cpu_.getP());
+    out.writeU8(cpu_.getA());
+    out.writeU8(cpu_.getX());
+    out.writeU8(cpu_.getY());
+    out.writeU64(getTotalCycles());
+    out.endChunk();
+  }
+
+  bool loadState(state_chunk &chunk)
+  {
+    block_cache::registers regs;
+    regs.pc = chunk.readU16();
+    regs.sp = chunk.readU8();
+    regs.p = chunk.readU8();
+    regs.a = chunk.readU8();
+    regs.x = chunk.readU8();
+    regs.y = chunk.readU8();
+    uint64_t cycles = chunk.readU64();
+    if (chunk.isTruncated())
+    {
+      return false;
+    }
+
+    setRegisters(regs);
+    setTotalCycles(cycles);
+    return true;
+  }
+
+  void setCacheStopAddress(uint16_t pc) { cache_.setStopAddress(pc); }
+  void clearCacheStopAddress() { cache_.clearStopAddress(); }
+
+  void flushCache() { cache_.flush(); }
+
 private:
   CPU cpu_;
+  block_cache cache_;
+  uint64_t skipped_cycles_ = 0;
 };
 
 emulator::emulator() = default;
@@ -58,12 +198,17 @@ emulator::~emulator()
   }
 }
 
-bool emulator::initialize()
+bool emulator::initialize(std::unique_ptr<audio_sink> audio, std::shared_ptr<const rom_images> roms)
 {
   try
   {
     LOG_INFO("Initializing Apple IIe Emulator...");
 
+    // Each session gets its own power-on RAM pattern; recordings carry the
+    // generator state so replays get the same one
+    std::random_device seed;
+    rng_state_ = (static_cast<uint64_t>(seed()) << 32 | seed()) | 1;
+
     // Create RAM (64KB with main/aux banks)
     ram_ = std::make_unique<RAM>();
     LOG_INFO("RAM initialized (64KB main + 64KB aux)");
@@ -71,8 +216,13 @@ bool emulator::initialize()
     // Create ROM (12KB)
     rom_ = std::make_unique<ROM>();
 
-    // Load Apple IIe ROMs from resources/roms folder
-    if (!rom_->loadAppleIIeROMs())
+    // Load Apple IIe ROMs from the shared images or resources/roms folder
+    if (roms)
+    {
+      rom_->loadFromData(roms->system.data(), roms->system.size());
+      rom_->loadExpansionFromData(roms->expansion.data(), roms->expansion.size());
+    }
+    else if (!rom_->loadAppleIIeROMs())
     {
       LOG_ERROR("Error: Failed to load Apple IIe ROM files");
       LOG_ERROR("Please ensure ROM files are present in resources/roms/");
@@ -85,7 +235,11 @@ bool emulator::initialize()
 
     // Create speaker
     speaker_ = std::make_unique<Speaker>();
-    if (!speaker_->initialize())
+    if (!audio)
+    {
+      LOG_INFO("Speaker has no audio output");
+    }
+    else if (!speaker_->initialize(std::move(audio)))
     {
       LOG_ERROR("Warning: Failed to initialize speaker (audio disabled)");
     }
@@ -96,6 +250,10 @@ bool emulator::initialize()
 
     // Create video display (generates video output texture)
     video_display_ = std::make_unique<video_display>();
+    if (roms && !roms->character.empty())
+    {
+      video_display_->loadCharacterROM(roms->character.data(), roms->character.size());
+    }
     LOG_INFO("Video display initialized");
 
     // Create MMU (handles memory mapping and soft switches)
@@ -104,7 +262,8 @@ bool emulator::initialize()
 
     // Create Disk II controller (slot 6)
     disk_controller_ = std::make_unique<Disk2Controller>();
-    if (!disk_controller_->initialize())
+    if (roms ? !disk_controller_->loadControllerROM(roms->disk2.data(), roms->disk2.size())
+             : !disk_controller_->initialize())
     {
       LOG_ERROR("Warning: Failed to initialize Disk II controller");
     }
@@ -116,25 +275,27 @@ bool emulator::initialize()
     mmu_->setAccessTracker(access_tracker_.get());
     LOG_INFO("Memory access tracker initialized");
 
+    // Execution trace recorder; the MMU reports to it only while tracing
+    tracer_ = std::make_unique<trace_recorder>();
+
+    // Guest code profiler, fed by the instrumented run loop
+    profiler_ = std::make_unique<guest_profiler>(*mmu_);
+
     // Create bus
     bus_ = std::make_unique<Bus>();
     LOG_INFO("Bus initialized");
 
-    // Define memory read callback (routes through MMU)
-    auto read = [this](uint16_t address) -> uint8_t
-    {
-      return mmu_->read(address);
-    };
+    // Create CPU with 65C02 variant (all memory accesses route through the MMU)
+    cpu_ = std::make_unique<cpu_wrapper>(*mmu_);
+    LOG_INFO("CPU initialized (65C02)");
 
-    // Define memory write callback (routes through MMU)
-    auto write = [this](uint16_t address, uint8_t value) -> void
+    // Idle loop fast-forward; cached code stops at the Monitor WAIT routine
+    // so it can be skipped as a whole
+    idle_detector_ = std::make_unique<idle_detector>(*mmu_);
+    if (idle_skip_enabled_)
     {
-      mmu_->write(address, value);
-    };
-
-    // Create CPU with 65C02 variant
-    cpu_ = std::make_unique<cpu_wrapper>(read, write);
-    LOG_INFO("CPU initialized (65C02)");
+      cpu_->setCacheStopAddress(idle_detector::WAIT_ENTRY);
+    }
 
     // Reset CPU
     cpu_->reset();
@@ -148,34 +309,42 @@ bool emulator::initialize()
       {
         return cpu_ ? cpu_->getTotalCycles() : 0;
       });
+      disk_controller_->setScheduler(&scheduler_);
     }
 
-    // Configure video_display with memory callbacks
+    // Recurring device timing: VBL edges and audio batches
+    scheduleTimingEvents();
+
     // Video reads directly from RAM, bypassing MMU soft switches
     // This matches real hardware where video circuitry reads display memory directly
-    video_display_->setMemoryReadCallback([this](uint16_t address) -> uint8_t
-    {
-      return ram_->getMainBank()[address];
-    });
+    video_display_->setMemory(ram_->getMainBank(), ram_->getAuxBank());
+    video_display_->setSoftSwitches(std::as_const(*mmu_).getSoftSwitchState());
 
-    // Set auxiliary memory read callback for 80-column mode
-    video_display_->setAuxMemoryReadCallback([this](uint16_t address) -> uint8_t
+    // Only scanlines written through the MMU since the last frame are redrawn
+    video_display_->setDirtyCallback([this]() -> video_dirty_map
     {
-      return ram_->getAuxBank()[address];
+      return mmu_->takeVideoDirty();
     });
 
-    // Set video mode callback for video_display
-    video_display_->setVideoModeCallback([this]() -> Apple2e::SoftSwitchState
+    // Mode changes while the screen is scanned are drawn scanline by scanline
+    video_display_->setSwitchLog(mmu_->getVideoSwitchLog(), [this]() -> uint64_t
     {
-      if (mmu_)
-      {
-        return mmu_->getSoftSwitchState();
-      }
-      return Apple2e::SoftSwitchState();
+      return cpu_->getTotalCycles();
     });
 
     // Create breakpoint manager for debugging
     breakpoint_mgr_ = std::make_unique<breakpoint_manager>();
+    breakpoint_mgr_->setEvaluationContext(
+        [this](watch_condition::context &ctx)
+        {
+          ctx.pc = instruction_pc_;
+          ctx.a = cpu_->getA();
+          ctx.x = cpu_->getX();
+          ctx.y = cpu_->getY();
+          ctx.sp = cpu_->getSP();
+          ctx.p = cpu_->getP();
+        },
+        mmu_.get());
     LOG_INFO("Breakpoint manager initialized");
 
     LOG_INFO("\nEmulator initialization complete!");
@@ -202,14 +371,37 @@ void emulator::update()
     return;
   }
 
-  // Audio-driven timing: run CPU cycles based on audio buffer fill level
-  // This keeps emulation perfectly in sync with audio output
-
   // Apple IIe runs at approximately 1.023 MHz
   // At 44100 Hz sample rate, that's ~23.2 cycles per sample
   // One frame at 60fps = ~17050 cycles
   constexpr uint64_t CYCLES_PER_FRAME = 17050;
 
+  // Warp: run ahead of real time with the speaker suspended. The display is
+  // only drawn once per host frame, so skipped frames come for free.
+  bool warping = isWarping();
+  if (warping != warp_active_)
+  {
+    warp_active_ = warping;
+    if (speaker_)
+    {
+      speaker_->setSuspended(warping);
+      if (!warping)
+      {
+        // Resync audio to the CPU clock after running ahead
+        speaker_->reset(cpu_->getTotalCycles());
+      }
+    }
+  }
+
+  if (warping)
+  {
+    runWarp(CYCLES_PER_FRAME);
+    return;
+  }
+
+  // Audio-driven timing: run CPU cycles based on audio buffer fill level
+  // This keeps emulation perfectly in sync with audio output
+
   // Check audio buffer fill level
   float bufferFill = 0.5f;  // Default to 50% if no speaker
   if (speaker_ && speaker_->isInitialized())
@@ -246,10 +438,375 @@ void emulator::update()
     cyclesToRun = CYCLES_PER_FRAME / 2;
   }
 
-  // Execute the calculated number of cycles
-  uint64_t targetCycles = cpu_->getTotalCycles() + cyclesToRun;
+  // Execute the calculated number of cycles; the speaker is brought up to
+  // date by the audio batch events as the CPU runs
+  runCycles(cpu_->getTotalCycles() + cyclesToRun);
+}
+
+void emulator::runWarp(uint64_t cycles_per_frame)
+{
+  if (warp_speed_ != WARP_UNLIMITED && !replay_)
+  {
+    runCycles(cpu_->getTotalCycles() + cycles_per_frame * warp_speed_);
+    return;
+  }
+
+  // Unlimited: as many emulated frames as fit in most of a host frame,
+  // leaving time for the UI to stay responsive
+  constexpr auto WARP_TIME_BUDGET = std::chrono::milliseconds(12);
+  const auto deadline = std::chrono::steady_clock::now() + WARP_TIME_BUDGET;
+  do
+  {
+    if (runCycles(cpu_->getTotalCycles() + cycles_per_frame) == 0)
+    {
+      break;  // Paused by the debugger
+    }
+  } while (std::chrono::steady_clock::now() < deadline);
+}
+
+bool emulator::isWarping() const
+{
+  if (warp_enabled_)
+  {
+    return true;
+  }
+  if (replay_)
+  {
+    return true;  // Replays run unthrottled
+  }
+  return auto_warp_ && disk_controller_ && disk_controller_->isMotorOn();
+}
+
+uint64_t emulator::runCycles(uint64_t target_cycles)
+{
+  if (!cpu_ || !mmu_)
+  {
+    return 0;
+  }
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const uint64_t start_cycles = cpu_->getTotalCycles();
+  const uint64_t start_instructions = instructions_executed_;
+
+  // The debugger can only change breakpoints or the execution state between
+  // calls, so the loop choice holds for the whole run. The MMU only checks
+  // watchpoints while some are enabled, so they cost nothing otherwise.
+  const bool watching = breakpoint_mgr_ && breakpoint_mgr_->hasEnabledWatchpoints();
+  mmu_->setWatchpoints(watching ? breakpoint_mgr_.get() : nullptr);
+
+  bool debugging = exec_state_ != execution_state::RUNNING || watching || isTracing() || isProfiling();
+  if (debugging)
+  {
+    runInstrumented(target_cycles);
+  }
+  else
+  {
+    runFast(target_cycles);
+  }
+  resuming_ = false;
+
+  // Throughput measurement: instructions per second of host time spent
+  // executing, published roughly once per wall-clock second
+  const auto end_time = std::chrono::steady_clock::now();
+  ips_window_instructions_ += instructions_executed_ - start_instructions;
+  ips_window_busy_ += end_time - start_time;
+  if (end_time - ips_window_start_ >= std::chrono::seconds(1))
+  {
+    double busy_seconds = std::chrono::duration<double>(ips_window_busy_).count();
+    if (busy_seconds > 0.0)
+    {
+      instructions_per_host_second_ = static_cast<double>(ips_window_instructions_) / busy_seconds;
+    }
+    ips_window_instructions_ = 0;
+    ips_window_busy_ = {};
+    ips_window_start_ = end_time;
+  }
+
+  return cpu_->getTotalCycles() - start_cycles;
+}
+
+void emulator::runFast(uint64_t target_cycles)
+{
+  uint64_t instructions = 0;
+  uint64_t cycles = cpu_->getTotalCycles();
+
+  // The block cache skips opcode fetches and idle skipping skips whole
+  // loops, so keep both out of the way while the memory access visualizer
+  // wants to see every access or execution breakpoints every PC
+  const bool tracking = access_tracker_ && access_tracker_->isEnabled();
+  breakpoint_manager *breakpoints =
+      (breakpoint_mgr_ && breakpoint_mgr_->hasEnabledExecutionBreakpoints()) ? breakpoint_mgr_.get() : nullptr;
+  const bool use_cache = block_cache_enabled_ && !tracking && !breakpoints;
+  const bool skip_idle = idle_skip_enabled_ && !tracking && !breakpoints;
+
+  // The breakpoint execution resumed from is skipped once
+  bool skip_breakpoint = resuming_;
+
+  // Instructions left to look for a keyboard poll loop after an empty KBD read
+  int idle_checks = 0;
 
-  while (cpu_->getTotalCycles() < targetCycles)
+  while (cycles < target_cycles)
+  {
+    // Run in one burst up to the next device event (or the end of the run).
+    // A device access can schedule an earlier event, so the burst end is
+    // pulled in after anything that may have touched I/O.
+    uint64_t burst_end = std::min(target_cycles, scheduler_.getNextDeadline());
+    while (cycles < burst_end)
+    {
+      if (use_cache)
+      {
+        instructions += cpu_->executeCached(burst_end);
+        cycles = cpu_->getTotalCycles();
+        burst_end = std::min(burst_end, scheduler_.getNextDeadline());
+        if (cycles >= burst_end)
+        {
+          break;
+        }
+      }
+
+      if (skip_idle && (idle_checks > 0 || cpu_->getPC() == idle_detector::WAIT_ENTRY))
+      {
+        if (skipIdleLoop(burst_end - cycles))
+        {
+          idle_checks = 0;
+          cycles = cpu_->getTotalCycles();
+          continue;
+        }
+        if (idle_checks > 0)
+        {
+          --idle_checks;
+        }
+      }
+
+      if (breakpoints)
+      {
+        const uint16_t pc = cpu_->getPC();
+        if (breakpoints->checkExecution(pc))
+        {
+          breakpoints->consumeHit(pc);
+          if (!skip_breakpoint)
+          {
+            exec_state_ = execution_state::PAUSED;
+            break;
+          }
+        }
+        skip_breakpoint = false;
+      }
+
+      // Interpreter: everything the cache can't run (I/O and slot ROM space,
+      // BRK/WAI/STP, ...). Update MMU cycle count BEFORE instruction for
+      // accurate disk timing
+      mmu_->setCycleCount(cycles);
+      cpu_->executeInstruction();
+      cycles = cpu_->getTotalCycles();
+      ++instructions;
+      burst_end = std::min(burst_end, scheduler_.getNextDeadline());
+
+      // The poll loop's INC is at most a few instructions after the KBD read
+      if (skip_idle && mmu_->consumeKeyboardPoll())
+      {
+        idle_checks = 4;
+      }
+    }
+
+    scheduler_.runDue(cycles);
+    if (exec_state_ == execution_state::PAUSED)
+    {
+      break;
+    }
+  }
+
+  instructions_executed_ += instructions;
+}
+
+void emulator::scheduleTimingEvents()
+{
+  scheduler_.cancel(vbl_event_);
+  scheduler_.cancel(audio_event_);
+  if (!cpu_ || !mmu_)
+  {
+    return;
+  }
+
+  const uint64_t now = cpu_->getTotalCycles();
+  const uint64_t frame_start = now - now % Apple2e::CYCLES_PER_VIDEO_FRAME;
+  const uint64_t vbl_start = frame_start + Apple2e::VBL_START_CYCLE;
+  if (now < vbl_start)
+  {
+    mmu_->setVerticalBlank(false);
+    vbl_event_ = scheduler_.schedule(vbl_start, [this](uint64_t cycle) { onVblStart(cycle); });
+  }
+  else
+  {
+    mmu_->setVerticalBlank(true);
+    vbl_event_ = scheduler_.schedule(frame_start + Apple2e::CYCLES_PER_VIDEO_FRAME,
+                                     [this](uint64_t cycle) { onVblEnd(cycle); });
+  }
+
+  audio_event_ = scheduler_.schedule(now + AUDIO_BATCH_CYCLES,
+                                     [this](uint64_t cycle) { onAudioBatch(cycle); });
+
+  scheduleRewindCapture();
+}
+
+void emulator::onVblStart(uint64_t cycle)
+{
+  mmu_->setVerticalBlank(true);
+  vbl_event_ = scheduler_.schedule(cycle + Apple2e::CYCLES_PER_VIDEO_FRAME - Apple2e::VBL_START_CYCLE,
+                                   [this](uint64_t next) { onVblEnd(next); });
+}
+
+void emulator::onVblEnd(uint64_t cycle)
+{
+  mmu_->setVerticalBlank(false);
+  vbl_event_ = scheduler_.schedule(cycle + Apple2e::VBL_START_CYCLE,
+                                   [this](uint64_t next) { onVblStart(next); });
+}
+
+void emulator::onAudioBatch(uint64_t cycle)
+{
+  if (speaker_)
+  {
+    speaker_->update(cycle);
+  }
+  audio_event_ = scheduler_.schedule(cycle + AUDIO_BATCH_CYCLES,
+                                     [this](uint64_t next) { onAudioBatch(next); });
+}
+
+void emulator::scheduleRewindCapture()
+{
+  scheduler_.cancel(rewind_event_);
+  rewind_event_ = event_scheduler::NO_EVENT;
+  if (!rewind_ || !cpu_)
+  {
+    return;
+  }
+
+  constexpr uint64_t INTERVAL = uint64_t{Apple2e::CYCLES_PER_VIDEO_FRAME} * REWIND_INTERVAL_FRAMES;
+  const uint64_t next = (cpu_->getTotalCycles() / INTERVAL + 1) * INTERVAL;
+  rewind_event_ = scheduler_.schedule(next, [this](uint64_t cycle) { onRewindCapture(cycle); });
+}
+
+void emulator::onRewindCapture(uint64_t cycle)
+{
+  rewind_buffer::machine_state state;
+  state.cycle = cpu_->getTotalCycles();
+  state.pc = cpu_->getPC();
+  state.sp = cpu_->getSP();
+  state.p = cpu_->getP();
+  state.a = cpu_->getA();
+  state.x = cpu_->getX();
+  state.y = cpu_->getY();
+  state.switches = mmu_->getSoftSwitchState();
+  state.key_code = keyboard_->getLatchedKeycode();
+  state.key_strobe = keyboard_->isStrobeSet();
+  state.disk = disk_controller_->getState();
+  state.speaker_high = speaker_->getSpeakerState();
+  rewind_->capture(state, *ram_, mmu_->takeDirtyPages());
+
+  rewind_event_ = scheduler_.schedule(cycle + uint64_t{Apple2e::CYCLES_PER_VIDEO_FRAME} * REWIND_INTERVAL_FRAMES,
+                                      [this](uint64_t next) { onRewindCapture(next); });
+}
+
+void emulator::setRewindEnabled(bool enabled)
+{
+  if (enabled == isRewindEnabled())
+  {
+    return;
+  }
+
+  if (enabled)
+  {
+    rewind_ = std::make_unique<rewind_buffer>(REWIND_HISTORY_SECONDS * 60 / REWIND_INTERVAL_FRAMES,
+                                              REWIND_KEYFRAME_INTERVAL, REWIND_MEMORY_BUDGET);
+  }
+  else
+  {
+    rewind_.reset();
+  }
+  scheduleRewindCapture();
+}
+
+bool emulator::rewind(uint32_t frames)
+{
+  if (!rewind_ || !cpu_ || !mmu_)
+  {
+    return false;
+  }
+  if (recording_)
+  {
+    LOG_WARNING("Rewind is not available while recording input");
+    return false;
+  }
+  stopReplay();
+
+  rewind_buffer::machine_state state;
+  if (!rewind_->restore(frames / REWIND_INTERVAL_FRAMES, state, *ram_))
+  {
+    return false;
+  }
+
+  // The clock never runs backwards (scheduled events and the block cache
+  // key on it), so instead move it forward to the same point in the video
+  // frame the snapshot was taken at and shift the device cycle stamps by
+  // the distance from the snapshot
+  const uint64_t now = cpu_->getTotalCycles();
+  const uint64_t frame_skip = (state.cycle % Apple2e::CYCLES_PER_VIDEO_FRAME + Apple2e::CYCLES_PER_VIDEO_FRAME -
+                               now % Apple2e::CYCLES_PER_VIDEO_FRAME) % Apple2e::CYCLES_PER_VIDEO_FRAME;
+  cpu_->skipCycles(frame_skip);
+  const uint64_t cycle_offset = now + frame_skip - state.cycle;
+
+  block_cache::registers regs;
+  regs.pc = state.pc;
+  regs.sp = state.sp;
+  regs.p = state.p;
+  regs.a = state.a;
+  regs.x = state.x;
+  regs.y = state.y;
+  cpu_->setRegisters(regs);
+
+  mmu_->getSoftSwitchState() = state.switches;
+  mmu_->clearDirtyPages();
+  mmu_->markVideoDirty();
+  keyboard_->restoreLatch(state.key_code, state.key_strobe);
+  disk_controller_->restoreState(state.disk, cycle_offset);
+  speaker_->restoreState(state.speaker_high, cpu_->getTotalCycles());
+
+  // RAM was rewritten behind the MMU's back, so drop any predecoded code
+  cpu_->flushCache();
+
+  scheduleTimingEvents();
+  return true;
+}
+
+double emulator::getRewindSeconds() const
+{
+  if (!rewind_ || rewind_->size() == 0)
+  {
+    return 0.0;
+  }
+  return static_cast<double>(rewind_->size() * REWIND_INTERVAL_FRAMES) / 60.0;
+}
+
+uint64_t emulator::skipIdleLoop(uint64_t max_cycles)
+{
+  block_cache::registers regs = cpu_->getRegisters();
+  uint64_t skipped = idle_detector_->fastForward(regs, max_cycles);
+  if (skipped > 0)
+  {
+    cpu_->setRegisters(regs);
+    cpu_->skipCycles(skipped);
+    idle_cycles_skipped_ += skipped;
+  }
+  return skipped;
+}
+
+void emulator::runInstrumented(uint64_t target_cycles)
+{
+  trace_recorder *tracer = isTracing() ? tracer_.get() : nullptr;
+  guest_profiler *profiler = isProfiling() ? profiler_.get() : nullptr;
+
+  while (cpu_->getTotalCycles() < target_cycles)
   {
     // Check if execution is paused
     if (exec_state_ == execution_state::PAUSED)
@@ -257,24 +814,62 @@ void emulator::update()
       break;
     }
 
-    // Check execution breakpoints before instruction
-    if (breakpoint_mgr_ && breakpoint_mgr_->checkExecution(cpu_->getPC()))
+    // Check execution breakpoints before instruction, except for the one
+    // execution was resumed from
+    instruction_pc_ = cpu_->getPC();
+    if (breakpoint_mgr_ && !resuming_ && breakpoint_mgr_->checkExecution(instruction_pc_))
     {
+      breakpoint_mgr_->consumeHit(instruction_pc_);
       exec_state_ = execution_state::PAUSED;
       break;
     }
+    resuming_ = false;
 
     // Track stack pointer for step-out detection
     uint8_t prev_sp = cpu_->getSP();
 
     // Update MMU cycle count BEFORE instruction for accurate disk timing
     // This ensures disk reads during instruction execution see correct cycles
-    if (mmu_)
+    mmu_->setCycleCount(cpu_->getTotalCycles());
+
+    if (tracer)
+    {
+      const uint16_t pc = cpu_->getPC();
+      const uint8_t bytes[3] = {mmu_->peek(pc), mmu_->peek(static_cast<uint16_t>(pc + 1)),
+                                mmu_->peek(static_cast<uint16_t>(pc + 2))};
+      tracer->beginInstruction(cpu_->getTotalCycles(), pc, bytes, cpu_->getA(), cpu_->getX(),
+                               cpu_->getY(), cpu_->getP(), cpu_->getSP());
+    }
+
+    if (profiler)
     {
-      mmu_->setCycleCount(cpu_->getTotalCycles());
+      profiler->beginInstruction(cpu_->getPC(), cpu_->getSP(), cpu_->getTotalCycles());
     }
 
     cpu_->executeInstruction();
+    ++instructions_executed_;
+
+    if (tracer)
+    {
+      tracer->endInstruction();
+    }
+    if (profiler)
+    {
+      profiler->endInstruction(cpu_->getPC(), cpu_->getSP(), cpu_->getTotalCycles());
+    }
+
+    if (cpu_->getTotalCycles() >= scheduler_.getNextDeadline())
+    {
+      scheduler_.runDue(cpu_->getTotalCycles());
+    }
+
+    // A watchpoint hit during the instruction stops after it completes
+    if (breakpoint_mgr_ && breakpoint_mgr_->consumeHit(instruction_pc_))
+    {
+      LOG_INFOF("Watchpoint: %s", breakpoint_manager::describe(breakpoint_mgr_->getLastHit()).c_str());
+      exec_state_ = execution_state::PAUSED;
+      break;
+    }
 
     // Handle step modes after instruction execution
     if (exec_state_ == execution_state::STEP_OVER)
@@ -293,15 +888,48 @@ void emulator::update()
       }
     }
   }
+}
+
+void emulator::setBlockCacheEnabled(bool enabled)
+{
+  if (block_cache_enabled_ == enabled)
+  {
+    return;
+  }
 
-  // Update speaker with current cycle count
-  if (speaker_)
+  block_cache_enabled_ = enabled;
+
+  // Free the decoded blocks and stop the MMU watching code pages
+  if (!enabled && cpu_)
   {
-    speaker_->update(cpu_->getTotalCycles());
+    cpu_->flushCache();
+  }
+}
+
+void emulator::setIdleSkipEnabled(bool enabled)
+{
+  idle_skip_enabled_ = enabled;
+
+  if (cpu_)
+  {
+    if (enabled)
+    {
+      cpu_->setCacheStopAddress(idle_detector::WAIT_ENTRY);
+    }
+    else
+    {
+      cpu_->clearCacheStopAddress();
+    }
   }
 }
 
 void emulator::reset()
+{
+  noteInput(input_log::event_type::RESET);
+  coldReset();
+}
+
+void emulator::coldReset()
 {
   // Hard reset - simulate power cycle (cold boot)
 
@@ -315,7 +943,8 @@ void emulator::reset()
     // Or add some randomness
     for (int i = 0; i < 65536; i++) {
         uint8_t base = ((i >> 1) & 0x01) ? 0x00 : 0xFF;
-        ram_->getMainBank()[i] = (rand() % 100 < 95) ? base : (rand() & 0xFF);
+        uint32_t r = nextRandom();
+        ram_->getMainBank()[i] = (r % 100 < 95) ? base : static_cast<uint8_t>(r >> 24);
     }
 
 
@@ -342,16 +971,38 @@ void emulator::reset()
   }
 
   // Reset CPU (reads reset vector from ROM)
+  // RAM was rewritten behind the MMU's back, so drop any predecoded code
+  // and redraw the whole screen
   if (cpu_)
   {
+    cpu_->flushCache();
     cpu_->reset();
   }
+  if (mmu_)
+  {
+    mmu_->markVideoDirty();
+  }
+
+  // History from before a power cycle is not worth keeping
+  if (rewind_)
+  {
+    rewind_->clear();
+  }
+
+  // Put the VBL and audio events back in step with the CPU clock
+  scheduleTimingEvents();
 
   // Reset first update flag to resync speaker
   first_update_ = true;
 }
 
 void emulator::warmReset()
+{
+  noteInput(input_log::event_type::WARM_RESET);
+  applyWarmReset();
+}
+
+void emulator::applyWarmReset()
 {
   // Warm reset - preserves RAM but resets CPU
   // Simulates pressing the RESET button on real hardware
@@ -360,6 +1011,7 @@ void emulator::warmReset()
   if (mmu_)
   {
     mmu_->getSoftSwitchState() = Apple2e::SoftSwitchState();
+    mmu_->markVideoDirty();
   }
 
   // Clear keyboard strobe
@@ -393,6 +1045,9 @@ emulator::cpu_state emulator::getCPUState() const
     state.x = cpu_->getX();
     state.y = cpu_->getY();
     state.total_cycles = cpu_->getTotalCycles();
+    state.instructions_executed = instructions_executed_;
+    state.instructions_per_host_second = instructions_per_host_second_;
+    state.idle_cycles_skipped = idle_cycles_skipped_;
     state.initialized = true;
   }
   return state;
@@ -451,10 +1106,30 @@ void emulator::keyDown(uint8_t key_code)
 {
   if (keyboard_)
   {
+    noteInput(input_log::event_type::KEY_DOWN, key_code);
     keyboard_->keyDown(key_code);
   }
 }
 
+bool emulator::insertDisk(int drive, const std::string& path)
+{
+  if (!disk_controller_)
+  {
+    return false;
+  }
+  noteInput(input_log::event_type::DISK_INSERT, static_cast<uint8_t>(drive), path);
+  return disk_controller_->insertDisk(drive, path);
+}
+
+void emulator::ejectDisk(int drive)
+{
+  if (disk_controller_)
+  {
+    noteInput(input_log::event_type::DISK_EJECT, static_cast<uint8_t>(drive));
+    disk_controller_->ejectDisk(drive);
+  }
+}
+
 bool emulator::isKeyboardStrobeSet() const
 {
   if (keyboard_)
@@ -522,14 +1197,6 @@ const std::array<uint8_t, 65536>& emulator::getAuxRAM() const
   return ram_->getAuxBank();
 }
 
-void emulator::initializeVideoTexture(void* device)
-{
-  if (video_display_)
-  {
-    video_display_->initializeTexture(device);
-  }
-}
-
 bool emulator::loadCharacterROM(const std::string& path)
 {
   if (video_display_)
@@ -539,14 +1206,11 @@ bool emulator::loadCharacterROM(const std::string& path)
   return false;
 }
 
-// Save state file format:
-// - Magic number: "A2E\x01" (4 bytes)
-// - CPU state: PC(2) + SP(1) + P(1) + A(1) + X(1) + Y(1) = 7 bytes
-// - Soft switch state (serialized)
-// - Main RAM: 65536 bytes
-// - Aux RAM: 65536 bytes
-
-static constexpr uint32_t SAVE_STATE_MAGIC = 0x01453241;  // "A2E\x01" little-endian
+// Save states are chunked (see save_state.hpp): one chunk per component,
+// each written and read by the component itself. Version 1 files, a raw
+// dump of the registers, SoftSwitchState and both RAM banks, can still be
+// loaded.
+static constexpr uint8_t LEGACY_STATE_VERSION = 0x01;
 
 bool emulator::saveState(const std::string& path)
 {
@@ -556,120 +1220,357 @@ bool emulator::saveState(const std::string& path)
     return false;
   }
 
-  std::ofstream file(path, std::ios::binary);
-  if (!file)
+  state_writer out;
+  writeState(out);
+  if (!out.saveToFile(path))
+  {
+    return false;
+  }
+
+  LOG_INFOF("State saved to: %s", path.c_str());
+  return true;
+}
+
+bool emulator::loadState(const std::string& path)
+{
+  if (!cpu_ || !ram_ || !mmu_)
+  {
+    LOG_ERROR("Cannot load state: emulator not initialized");
+    return false;
+  }
+  if (recording_)
+  {
+    LOG_ERROR("Cannot load state while recording input");
+    return false;
+  }
+  stopReplay();
+
+  mapped_file file;
+  if (!file.open(path))
   {
     LOG_ERRORF("Failed to open save file: %s", path.c_str());
     return false;
   }
 
-  // Write magic number
-  file.write(reinterpret_cast<const char*>(&SAVE_STATE_MAGIC), sizeof(SAVE_STATE_MAGIC));
+  const uint8_t *data = file.getData();
+  const size_t size = file.getSize();
+  bool loaded = false;
+  if (size >= save_state::HEADER_SIZE &&
+      std::memcmp(data, save_state::MAGIC, sizeof(save_state::MAGIC)) == 0 &&
+      data[3] == LEGACY_STATE_VERSION)
+  {
+    loaded = loadLegacyState(data, size);
+  }
+  else
+  {
+    state_reader in;
+    if (!in.open(data, size))
+    {
+      LOG_ERROR("Invalid save file format");
+      return false;
+    }
+    loaded = restoreState(in);
+  }
+
+  resyncAfterLoad();
 
-  // Write CPU state
-  uint16_t pc = cpu_->getPC();
-  uint8_t sp = cpu_->getSP();
-  uint8_t p = cpu_->getP();
-  uint8_t a = cpu_->getA();
-  uint8_t x = cpu_->getX();
-  uint8_t y = cpu_->getY();
+  if (!loaded)
+  {
+    LOG_ERRORF("Save file is damaged, state only partly restored: %s", path.c_str());
+    return false;
+  }
+
+  LOG_INFOF("State loaded from: %s", path.c_str());
+  return true;
+}
+
+void emulator::writeState(state_writer& out) const
+{
+  cpu_->saveState(out);
+  mmu_->saveState(out);
+  ram_->saveState(out);
+  keyboard_->saveState(out);
+  speaker_->saveState(out);
+  disk_controller_->saveState(out);
+
+  out.beginChunk(RNG_STATE_TAG, RNG_STATE_VERSION);
+  out.writeU64(rng_state_);
+  out.endChunk();
+}
+
+bool emulator::restoreState(const state_reader& in)
+{
+  // Components whose chunk is missing keep their current state
+  state_chunk chunk;
+  bool loaded = true;
+  if (in.findChunk(cpu_wrapper::STATE_TAG, chunk))
+  {
+    loaded = cpu_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(MMU::STATE_TAG, chunk))
+  {
+    loaded = mmu_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(RAM::STATE_TAG, chunk))
+  {
+    loaded = ram_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(Keyboard::STATE_TAG, chunk))
+  {
+    loaded = keyboard_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(Speaker::STATE_TAG, chunk))
+  {
+    loaded = speaker_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(Disk2Controller::STATE_TAG, chunk))
+  {
+    loaded = disk_controller_->loadState(chunk) && loaded;
+  }
+  if (in.findChunk(RNG_STATE_TAG, chunk))
+  {
+    uint64_t rng_state = chunk.readU64();
+    if (chunk.isTruncated() || rng_state == 0)
+    {
+      loaded = false;
+    }
+    else
+    {
+      rng_state_ = rng_state;
+    }
+  }
+  return loaded;
+}
 
-  file.write(reinterpret_cast<const char*>(&pc), sizeof(pc));
-  file.write(reinterpret_cast<const char*>(&sp), sizeof(sp));
-  file.write(reinterpret_cast<const char*>(&p), sizeof(p));
-  file.write(reinterpret_cast<const char*>(&a), sizeof(a));
-  file.write(reinterpret_cast<const char*>(&x), sizeof(x));
-  file.write(reinterpret_cast<const char*>(&y), sizeof(y));
+void emulator::resyncAfterLoad()
+{
+  // RAM was replaced wholesale, so any predecoded code and the displayed
+  // frame are stale, and the rewind history belongs to the session that
+  // was replaced
+  cpu_->flushCache();
+  mmu_->markVideoDirty();
+  if (rewind_)
+  {
+    rewind_->clear();
+  }
+  if (profiler_)
+  {
+    profiler_->resetCallStack();
+  }
 
-  // Write soft switch state
-  Apple2e::SoftSwitchState switches = mmu_->getSoftSwitchState();
-  file.write(reinterpret_cast<const char*>(&switches), sizeof(switches));
+  // The clock may have moved, so put VBL and audio back in step with it
+  // and resync the speaker to avoid audio glitches
+  scheduleTimingEvents();
+  if (speaker_)
+  {
+    speaker_->reset(cpu_->getTotalCycles());
+  }
+}
 
-  // Write RAM banks
-  const auto& main_ram = ram_->getMainBank();
-  const auto& aux_ram = ram_->getAuxBank();
-  file.write(reinterpret_cast<const char*>(main_ram.data()), main_ram.size());
-  file.write(reinterpret_cast<const char*>(aux_ram.data()), aux_ram.size());
+// ===== Input recording and replay =====
 
-  if (!file)
+bool emulator::startRecording()
+{
+  if (!cpu_ || !ram_ || !mmu_)
   {
-    LOG_ERROR("Error writing save file");
+    LOG_ERROR("Cannot record: emulator not initialized");
     return false;
   }
+  if (recording_)
+  {
+    return false;
+  }
+  stopReplay();
 
-  LOG_INFOF("State saved to: %s", path.c_str());
+  recording_start_ = state_writer();
+  writeState(recording_start_);
+  recording_ = std::make_unique<input_log>();
+  recording_->begin(cpu_->getTotalCycles());
+  LOG_INFO("Input recording started");
   return true;
 }
 
-bool emulator::loadState(const std::string& path)
+bool emulator::stopRecording(const std::string& path)
+{
+  if (!recording_)
+  {
+    return false;
+  }
+
+  recording_->finish(cpu_->getTotalCycles());
+  recording_->saveState(recording_start_);
+  const size_t event_count = recording_->getEvents().size();
+  recording_.reset();
+
+  bool saved = recording_start_.saveToFile(path);
+  recording_start_ = state_writer();
+  if (saved)
+  {
+    LOG_INFOF("Recording of %zu input events saved to: %s", event_count, path.c_str());
+  }
+  return saved;
+}
+
+bool emulator::startReplay(const std::string& path)
 {
   if (!cpu_ || !ram_ || !mmu_)
   {
-    LOG_ERROR("Cannot load state: emulator not initialized");
+    LOG_ERROR("Cannot replay: emulator not initialized");
     return false;
   }
+  if (recording_)
+  {
+    LOG_ERROR("Cannot replay while recording input");
+    return false;
+  }
+  stopReplay();
 
-  std::ifstream file(path, std::ios::binary);
-  if (!file)
+  mapped_file file;
+  state_reader in;
+  if (!file.open(path) || !in.open(file.getData(), file.getSize()))
   {
-    LOG_ERRORF("Failed to open save file: %s", path.c_str());
+    LOG_ERRORF("Failed to open recording: %s", path.c_str());
     return false;
   }
 
-  // Read and verify magic number
-  uint32_t magic = 0;
-  file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-  if (magic != SAVE_STATE_MAGIC)
+  auto log = std::make_unique<input_log>();
+  state_chunk chunk;
+  if (!in.findChunk(input_log::STATE_TAG, chunk) || !log->loadState(chunk))
   {
-    LOG_ERROR("Invalid save file format");
+    LOG_ERRORF("Not an input recording, or the input log is damaged: %s", path.c_str());
     return false;
   }
 
-  // Read CPU state
-  uint16_t pc;
-  uint8_t sp, p, a, x, y;
+  bool loaded = restoreState(in);
+  resyncAfterLoad();
+  if (!loaded)
+  {
+    LOG_ERRORF("Recording's starting state is damaged: %s", path.c_str());
+    return false;
+  }
 
-  file.read(reinterpret_cast<char*>(&pc), sizeof(pc));
-  file.read(reinterpret_cast<char*>(&sp), sizeof(sp));
-  file.read(reinterpret_cast<char*>(&p), sizeof(p));
-  file.read(reinterpret_cast<char*>(&a), sizeof(a));
-  file.read(reinterpret_cast<char*>(&x), sizeof(x));
-  file.read(reinterpret_cast<char*>(&y), sizeof(y));
+  replay_ = std::move(log);
+  replay_next_ = 0;
+  scheduleReplayEvent();
+  LOG_INFOF("Replaying %zu input events from: %s", replay_->getEvents().size(), path.c_str());
+  return true;
+}
 
-  // Read soft switch state
-  Apple2e::SoftSwitchState switches;
-  file.read(reinterpret_cast<char*>(&switches), sizeof(switches));
+void emulator::stopReplay()
+{
+  scheduler_.cancel(replay_event_);
+  replay_event_ = event_scheduler::NO_EVENT;
+  replay_.reset();
+}
 
-  // Read RAM banks
-  auto& main_ram = ram_->getMainBank();
-  auto& aux_ram = ram_->getAuxBank();
-  file.read(reinterpret_cast<char*>(main_ram.data()), main_ram.size());
-  file.read(reinterpret_cast<char*>(aux_ram.data()), aux_ram.size());
+void emulator::noteInput(input_log::event_type type, uint8_t value, const std::string& path)
+{
+  if (replay_)
+  {
+    LOG_INFO("Replay stopped by user input");
+    stopReplay();
+  }
+  if (recording_)
+  {
+    recording_->add({cpu_->getTotalCycles(), type, value, path});
+  }
+}
 
-  if (!file)
+void emulator::applyInput(const input_log::event& e)
+{
+  switch (e.type)
   {
-    LOG_ERROR("Error reading save file");
-    return false;
+  case input_log::event_type::KEY_DOWN:
+    keyboard_->keyDown(e.value);
+    break;
+  case input_log::event_type::RESET:
+    coldReset();
+    break;
+  case input_log::event_type::WARM_RESET:
+    applyWarmReset();
+    break;
+  case input_log::event_type::DISK_INSERT:
+    if (!disk_controller_->insertDisk(e.value, e.path))
+    {
+      LOG_WARNINGF("Replay: failed to insert disk image: %s", e.path.c_str());
+    }
+    break;
+  case input_log::event_type::DISK_EJECT:
+    disk_controller_->ejectDisk(e.value);
+    break;
   }
+}
 
-  // Apply CPU state
-  cpu_->setPC(pc);
-  cpu_->setSP(sp);
-  cpu_->setP(p);
-  cpu_->setA(a);
-  cpu_->setX(x);
-  cpu_->setY(y);
+void emulator::scheduleReplayEvent()
+{
+  scheduler_.cancel(replay_event_);
+  const std::vector<input_log::event>& events = replay_->getEvents();
+  const uint64_t next = replay_next_ < events.size() ? events[replay_next_].cycle : replay_->getEndCycle();
+  replay_event_ = scheduler_.schedule(next, [this](uint64_t) { onReplayEvent(); });
+}
 
-  // Apply soft switch state
-  mmu_->getSoftSwitchState() = switches;
+void emulator::onReplayEvent()
+{
+  // Events were logged between instructions, and execution is the same as
+  // when they were recorded, so the event fires on the exact cycle
+  replay_event_ = event_scheduler::NO_EVENT;
+  const uint64_t now = cpu_->getTotalCycles();
+  const std::vector<input_log::event>& events = replay_->getEvents();
+  while (replay_next_ < events.size() && events[replay_next_].cycle <= now)
+  {
+    applyInput(events[replay_next_++]);
+  }
 
-  // Reset speaker timing to avoid audio glitches
-  if (speaker_ && cpu_)
+  if (replay_next_ == events.size() && now >= replay_->getEndCycle())
   {
-    speaker_->reset(cpu_->getTotalCycles());
+    LOG_INFO("Replay finished");
+    replay_.reset();
+    return;
   }
+  scheduleReplayEvent();
+}
 
-  LOG_INFOF("State loaded from: %s", path.c_str());
+uint32_t emulator::nextRandom()
+{
+  rng_state_ ^= rng_state_ >> 12;
+  rng_state_ ^= rng_state_ << 25;
+  rng_state_ ^= rng_state_ >> 27;
+  return static_cast<uint32_t>((rng_state_ * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+bool emulator::loadLegacyState(const uint8_t* data, size_t size)
+{
+  // Magic, PC(2) SP P A X Y, SoftSwitchState as laid out when saved (up to
+  // the fields added since), RAM
+  constexpr size_t REGISTERS_SIZE = 7;
+  constexpr size_t SWITCHES_SIZE = offsetof(Apple2e::SoftSwitchState, dhires);
+  constexpr size_t BANK_SIZE = Apple2e::RAM_SIZE;
+  const size_t expected = save_state::HEADER_SIZE + REGISTERS_SIZE + SWITCHES_SIZE + 2 * BANK_SIZE;
+  if (size != expected)
+  {
+    LOG_ERROR("Version 1 save file does not match this build's layout");
+    return false;
+  }
+
+  const uint8_t *p = data + save_state::HEADER_SIZE;
+  block_cache::registers regs;
+  regs.pc = static_cast<uint16_t>(p[0] | p[1] << 8);
+  regs.sp = p[2];
+  regs.p = p[3];
+  regs.a = p[4];
+  regs.x = p[5];
+  regs.y = p[6];
+  p += REGISTERS_SIZE;
+
+  Apple2e::SoftSwitchState switches;
+  std::memcpy(static_cast<void *>(&switches), p, SWITCHES_SIZE);
+  p += SWITCHES_SIZE;
+
+  std::memcpy(ram_->getMainBank().data(), p, BANK_SIZE);
+  std::memcpy(ram_->getAuxBank().data(), p + BANK_SIZE, BANK_SIZE);
+
+  cpu_->setRegisters(regs);
+  mmu_->getSoftSwitchState() = switches;
   return true;
 }
 
@@ -685,16 +1586,19 @@ void emulator::pause()
 
 void emulator::resume()
 {
+  resuming_ = exec_state_ == execution_state::PAUSED;
   exec_state_ = execution_state::RUNNING;
 }
 
 void emulator::stepOver()
 {
+  resuming_ = exec_state_ == execution_state::PAUSED;
   exec_state_ = execution_state::STEP_OVER;
 }
 
 void emulator::stepOut()
 {
+  resuming_ = exec_state_ == execution_state::PAUSED;
   exec_state_ = execution_state::STEP_OUT;
   step_out_stack_depth_ = cpu_->getSP();
 }
@@ -719,6 +1623,35 @@ memory_access_tracker* emulator::getAccessTracker()
   return access_tracker_.get();
 }
 
+void emulator::setTracing(bool enabled)
+{
+  if (!tracer_ || !mmu_)
+  {
+    return;
+  }
+
+  tracer_->setEnabled(enabled);
+  mmu_->setTraceRecorder(enabled ? tracer_.get() : nullptr);
+}
+
+trace_recorder* emulator::getTraceRecorder()
+{
+  return tracer_.get();
+}
+
+void emulator::setProfiling(bool enabled)
+{
+  if (profiler_)
+  {
+    profiler_->setEnabled(enabled);
+  }
+}
+
+guest_profiler* emulator::getProfiler()
+{
+  return profiler_.get();
+}
+
 Disk2Controller* emulator::getDiskController()
 {
   return disk_controller_.get();
@@ -0,0 +1,56 @@
+#include "emulator/event_scheduler.hpp"
+#include <algorithm>
+
+event_scheduler::event_id event_scheduler::schedule(uint64_t cycle, callback fn)
+{
+  event_id id = next_id_++;
+  heap_.push_back({cycle, id, std::move(fn)});
+  std::push_heap(heap_.begin(), heap_.end(), later);
+  return id;
+}
+
+bool event_scheduler::cancel(event_id id)
+{
+  if (id == NO_EVENT)
+  {
+    return false;
+  }
+
+  // Only a handful of events are ever pending, so a linear search and
+  // re-heapify is cheaper than maintaining an index
+  auto it = std::find_if(heap_.begin(), heap_.end(),
+                         [id](const event &e) { return e.id == id; });
+  if (it == heap_.end())
+  {
+    return false;
+  }
+
+  *it = std::move(heap_.back());
+  heap_.pop_back();
+  std::make_heap(heap_.begin(), heap_.end(), later);
+  return true;
+}
+
+bool event_scheduler::isPending(event_id id) const
+{
+  return id != NO_EVENT &&
+         std::any_of(heap_.begin(), heap_.end(), [id](const event &e) { return e.id == id; });
+}
+
+void event_scheduler::runDue(uint64_t cycle)
+{
+  while (!heap_.empty() && heap_.front().cycle <= cycle)
+  {
+    // Take the event off the heap before calling it, so the callback can
+    // reschedule itself or cancel others
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    event due = std::move(heap_.back());
+    heap_.pop_back();
+    due.fn(due.cycle);
+  }
+}
+
+void event_scheduler::clear()
+{
+  heap_.clear();
+}
@@ -0,0 +1,251 @@
+#include "emulator/file_frame_sink.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Largest stored deflate block
+constexpr size_t STORED_BLOCK_MAX = 65535;
+
+const std::array<uint32_t, 256> &crcTable()
+{
+  static const std::array<uint32_t, 256> table = []
+  {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+      {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      t[n] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+  const auto &table = crcTable();
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+  {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t adler32(const uint8_t *data, size_t size)
+{
+  // Sums stay below 2^32 for 5552 bytes between reductions
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while (size > 0)
+  {
+    const size_t run = std::min<size_t>(size, 5552);
+    for (size_t i = 0; i < run; ++i)
+    {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+    data += run;
+    size -= run;
+  }
+  return (b << 16) | a;
+}
+
+void putU32BE(std::vector<uint8_t> &out, uint32_t value)
+{
+  out.push_back(static_cast<uint8_t>(value >> 24));
+  out.push_back(static_cast<uint8_t>(value >> 16));
+  out.push_back(static_cast<uint8_t>(value >> 8));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void putChunk(std::vector<uint8_t> &out, const char type[4], const std::vector<uint8_t> &data)
+{
+  putU32BE(out, static_cast<uint32_t>(data.size()));
+  const size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putU32BE(out, crc32(out.data() + start, out.size() - start));
+}
+
+/**
+ * Get a frame's pixels as packed 8-bit RGB rows
+ */
+std::vector<uint8_t> rgbRows(const video_frame &frame)
+{
+  std::vector<uint8_t> rgb;
+  rgb.reserve(static_cast<size_t>(frame.width) * frame.height * 3);
+  for (int y = 0; y < frame.height; ++y)
+  {
+    const uint32_t *row = frame.pixels + static_cast<size_t>(y) * frame.stride;
+    for (int x = 0; x < frame.width; ++x)
+    {
+      rgb.push_back(static_cast<uint8_t>(row[x]));
+      rgb.push_back(static_cast<uint8_t>(row[x] >> 8));
+      rgb.push_back(static_cast<uint8_t>(row[x] >> 16));
+    }
+  }
+  return rgb;
+}
+
+std::vector<uint8_t> encodePPM(const video_frame &frame)
+{
+  char header[32];
+  const int length = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", frame.width, frame.height);
+  std::vector<uint8_t> out(header, header + length);
+  const std::vector<uint8_t> rgb = rgbRows(frame);
+  out.insert(out.end(), rgb.begin(), rgb.end());
+  return out;
+}
+
+std::vector<uint8_t> encodePNG(const video_frame &frame)
+{
+  // Scanlines, each led by filter type 0 (none)
+  const size_t row_bytes = static_cast<size_t>(frame.width) * 3;
+  const std::vector<uint8_t> rgb = rgbRows(frame);
+  std::vector<uint8_t> raw;
+  raw.reserve((row_bytes + 1) * frame.height);
+  for (int y = 0; y < frame.height; ++y)
+  {
+    raw.push_back(0);
+    raw.insert(raw.end(), rgb.begin() + y * row_bytes, rgb.begin() + (y + 1) * row_bytes);
+  }
+
+  // zlib stream of stored deflate blocks
+  std::vector<uint8_t> zlib = {0x78, 0x01};
+  size_t offset = 0;
+  do
+  {
+    const size_t length = std::min(raw.size() - offset, STORED_BLOCK_MAX);
+    const bool last = offset + length == raw.size();
+    zlib.push_back(last ? 1 : 0);
+    zlib.push_back(static_cast<uint8_t>(length));
+    zlib.push_back(static_cast<uint8_t>(length >> 8));
+    zlib.push_back(static_cast<uint8_t>(~length));
+    zlib.push_back(static_cast<uint8_t>(~length >> 8));
+    zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+    offset += length;
+  } while (offset < raw.size());
+  putU32BE(zlib, adler32(raw.data(), raw.size()));
+
+  // 8-bit RGB, no interlace
+  std::vector<uint8_t> header;
+  putU32BE(header, static_cast<uint32_t>(frame.width));
+  putU32BE(header, static_cast<uint32_t>(frame.height));
+  header.insert(header.end(), {8, 2, 0, 0, 0});
+
+  std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  putChunk(out, "IHDR", header);
+  putChunk(out, "IDAT", zlib);
+  putChunk(out, "IEND", {});
+  return out;
+}
+} // namespace
+
+file_frame_sink::file_frame_sink(std::string pattern, uint32_t every)
+    : pattern_(std::move(pattern)), format_(formatForPath(pattern_)), every_(std::max<uint32_t>(every, 1))
+{
+}
+
+bool file_frame_sink::present(const video_frame &frame)
+{
+  const uint64_t number = presented_++;
+  if (number % every_ != 0)
+  {
+    return true;
+  }
+  if (!writeImage(framePath(number), frame, format_))
+  {
+    return false;
+  }
+  ++written_;
+  return true;
+}
+
+std::string file_frame_sink::framePath(uint64_t number) const
+{
+  // Replace a %d or %0Nd field
+  const size_t percent = pattern_.find('%');
+  if (percent != std::string::npos)
+  {
+    size_t end = percent + 1;
+    int width = 0;
+    while (end < pattern_.size() && std::isdigit(static_cast<unsigned char>(pattern_[end])))
+    {
+      width = width * 10 + (pattern_[end++] - '0');
+    }
+    if (end < pattern_.size() && pattern_[end] == 'd' && width <= 20)
+    {
+      char digits[32];
+      std::snprintf(digits, sizeof(digits), "%0*llu", width, static_cast<unsigned long long>(number));
+      return pattern_.substr(0, percent) + digits + pattern_.substr(end + 1);
+    }
+  }
+
+  // Otherwise number the file before its extension
+  char digits[32];
+  std::snprintf(digits, sizeof(digits), "_%06llu", static_cast<unsigned long long>(number));
+  const size_t dot = pattern_.find_last_of('.');
+  const size_t slash = pattern_.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+  {
+    return pattern_ + digits;
+  }
+  return pattern_.substr(0, dot) + digits + pattern_.substr(dot);
+}
+
+file_frame_sink::image_format file_frame_sink::formatForPath(const std::string &path)
+{
+  std::string extension;
+  const size_t dot = path.find_last_of('.');
+  if (dot != std::string::npos)
+  {
+    extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  }
+  return extension == "ppm" ? image_format::PPM : image_format::PNG;
+}
+
+bool file_frame_sink::writeImage(const std::string &path, const video_frame &frame)
+{
+  return writeImage(path, frame, formatForPath(path));
+}
+
+bool file_frame_sink::writeImage(const std::string &path, const video_frame &frame, image_format format)
+{
+  if (!frame.pixels || frame.width <= 0 || frame.height <= 0)
+  {
+    LOG_ERRORF("No frame to write to %s", path.c_str());
+    return false;
+  }
+
+  const std::vector<uint8_t> image = format == image_format::PPM ? encodePPM(frame) : encodePNG(frame);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    LOG_ERRORF("Failed to create image file: %s", path.c_str());
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+  if (!file)
+  {
+    LOG_ERRORF("Error writing image file: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,395 @@
+#include "emulator/guest_profiler.hpp"
+#include "emulator/disassembler.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <unordered_set>
+
+namespace
+{
+constexpr uint8_t OPCODE_BRK = 0x00;
+constexpr uint8_t OPCODE_JSR = 0x20;
+
+constexpr size_t REPORT_HOT_SPOTS = 50;
+constexpr size_t REPORT_FUNCTIONS = 50;
+
+double percent(uint64_t part, uint64_t whole)
+{
+  return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+}
+} // namespace
+
+guest_profiler::guest_profiler(const MMU &mmu)
+    : mmu_(mmu)
+{
+  stack_.reserve(MAX_DEPTH);
+  nodes_.push_back({TOP_LEVEL, 0, 0});
+}
+
+void guest_profiler::setEnabled(bool enabled)
+{
+  if (enabled && location_cycles_.empty())
+  {
+    location_instructions_.assign(LOCATION_COUNT, 0);
+    location_cycles_.assign(LOCATION_COUNT, 0);
+  }
+  enabled_ = enabled;
+  in_instruction_ = false;
+}
+
+void guest_profiler::clear()
+{
+  std::fill(location_instructions_.begin(), location_instructions_.end(), 0);
+  std::fill(location_cycles_.begin(), location_cycles_.end(), 0);
+  opcodes_ = {};
+  total_instructions_ = 0;
+  total_cycles_ = 0;
+
+  stack_.clear();
+  nodes_.assign(1, {TOP_LEVEL, 0, 0});
+  children_.clear();
+  functions_.clear();
+  edges_.clear();
+}
+
+void guest_profiler::resetCallStack()
+{
+  // The clock may have moved backwards, so the open calls go uncounted
+  for (const frame &f : stack_)
+  {
+    --functions_[f.function].active;
+  }
+  stack_.clear();
+  in_instruction_ = false;
+}
+
+uint32_t guest_profiler::locationOf(uint16_t address) const
+{
+  const uint16_t physical = mmu_.getReadPhysicalPage(static_cast<uint8_t>(address >> 8));
+  if (physical == MMU::NO_PHYSICAL_PAGE)
+  {
+    return SLOT_SPACE + (address & 0x0FFF);
+  }
+  return static_cast<uint32_t>(physical) << 8 | (address & 0xFF);
+}
+
+void guest_profiler::beginInstruction(uint16_t pc, uint8_t sp, uint64_t cycle)
+{
+  location_ = locationOf(pc);
+  opcode_ = mmu_.peek(pc);
+  sp_ = sp;
+  start_cycle_ = cycle;
+  in_instruction_ = true;
+}
+
+void guest_profiler::endInstruction(uint16_t next_pc, uint8_t sp, uint64_t cycle)
+{
+  if (!in_instruction_)
+  {
+    return;
+  }
+  in_instruction_ = false;
+
+  const uint64_t cycles = cycle - start_cycle_;
+  ++location_instructions_[location_];
+  location_cycles_[location_] += cycles;
+  ++opcodes_[opcode_].count;
+  opcodes_[opcode_].cycles += cycles;
+  ++total_instructions_;
+  total_cycles_ += cycles;
+
+  // The instruction's cycles belong to the function it is in, including the
+  // JSR that leaves it and the RTS that returns from a callee
+  nodes_[stack_.empty() ? 0 : stack_.back().node].self_cycles += cycles;
+
+  if (opcode_ == OPCODE_JSR || opcode_ == OPCODE_BRK)
+  {
+    pushFrame(locationOf(next_pc), sp_, cycle);
+    return;
+  }
+
+  // Returned (or dropped the return address) once the stack is back above
+  // the return address
+  while (!stack_.empty() && sp >= stack_.back().sp)
+  {
+    popFrame(cycle);
+  }
+}
+
+uint32_t guest_profiler::childNode(uint32_t parent, uint32_t function)
+{
+  auto [it, added] = children_.try_emplace(edgeKey(parent, function), static_cast<uint32_t>(nodes_.size()));
+  if (added)
+  {
+    nodes_.push_back({function, parent, 0});
+  }
+  return it->second;
+}
+
+void guest_profiler::pushFrame(uint32_t function, uint8_t sp, uint64_t cycle)
+{
+  if (stack_.size() >= MAX_DEPTH)
+  {
+    return;
+  }
+
+  const uint32_t caller = stack_.empty() ? TOP_LEVEL : stack_.back().function;
+  const uint32_t parent = stack_.empty() ? 0 : stack_.back().node;
+  stack_.push_back({function, childNode(parent, function), cycle, sp});
+
+  function_counters &counters = functions_[function];
+  ++counters.calls;
+  ++counters.active;
+  ++edges_[edgeKey(caller, function)].calls;
+}
+
+void guest_profiler::popFrame(uint64_t cycle)
+{
+  const frame done = stack_.back();
+  stack_.pop_back();
+
+  const uint64_t cycles = cycle - done.entry_cycle;
+  const uint32_t caller = stack_.empty() ? TOP_LEVEL : stack_.back().function;
+  edges_[edgeKey(caller, done.function)].cycles += cycles;
+
+  // Under recursion only the outermost call counts toward inclusive time
+  function_counters &counters = functions_[done.function];
+  if (--counters.active == 0)
+  {
+    counters.inclusive_cycles += cycles;
+  }
+}
+
+std::vector<guest_profiler::hot_spot> guest_profiler::getHotSpots(size_t count) const
+{
+  std::vector<hot_spot> spots;
+  for (uint32_t location = 0; location < location_cycles_.size(); ++location)
+  {
+    if (location_instructions_[location])
+    {
+      spots.push_back({location, location_instructions_[location], location_cycles_[location]});
+    }
+  }
+
+  const size_t kept = std::min(count, spots.size());
+  std::partial_sort(spots.begin(), spots.begin() + static_cast<std::ptrdiff_t>(kept), spots.end(),
+                    [](const hot_spot &a, const hot_spot &b) { return a.cycles > b.cycles; });
+  spots.resize(kept);
+  return spots;
+}
+
+std::vector<guest_profiler::function_stats> guest_profiler::getFunctions() const
+{
+  std::unordered_map<uint32_t, function_stats> stats;
+  for (const auto &[function, counters] : functions_)
+  {
+    function_stats &entry = stats[function];
+    entry.entry = function;
+    entry.calls = counters.calls;
+    entry.inclusive_cycles = counters.inclusive_cycles;
+  }
+
+  // Calls still in progress count up to the last instruction
+  std::unordered_set<uint32_t> open;
+  for (const frame &f : stack_)
+  {
+    if (open.insert(f.function).second)
+    {
+      stats[f.function].inclusive_cycles += start_cycle_ - f.entry_cycle;
+    }
+  }
+
+  function_stats &top = stats[TOP_LEVEL];
+  top.entry = TOP_LEVEL;
+  top.inclusive_cycles = total_cycles_;
+  for (const path_node &node : nodes_)
+  {
+    stats[node.function].exclusive_cycles += node.self_cycles;
+  }
+
+  std::vector<function_stats> result;
+  result.reserve(stats.size());
+  for (const auto &[function, entry] : stats)
+  {
+    result.push_back(entry);
+  }
+  std::sort(result.begin(), result.end(), [](const function_stats &a, const function_stats &b)
+  {
+    return a.inclusive_cycles != b.inclusive_cycles ? a.inclusive_cycles > b.inclusive_cycles
+                                                    : a.exclusive_cycles > b.exclusive_cycles;
+  });
+  return result;
+}
+
+std::vector<guest_profiler::call_edge> guest_profiler::getCallEdges() const
+{
+  std::vector<call_edge> result;
+  result.reserve(edges_.size());
+  for (const auto &[key, counters] : edges_)
+  {
+    result.push_back({static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key), counters.calls, counters.cycles});
+  }
+  std::sort(result.begin(), result.end(), [](const call_edge &a, const call_edge &b) { return a.cycles > b.cycles; });
+  return result;
+}
+
+uint16_t guest_profiler::locationAddress(uint32_t location)
+{
+  if (location >= SLOT_SPACE)
+  {
+    return static_cast<uint16_t>(0xC000 + (location - SLOT_SPACE));
+  }
+
+  const uint32_t page = location >> 8;
+  const uint32_t offset = location & 0xFF;
+  if (page >= MMU::PHYS_ROM)
+  {
+    return static_cast<uint16_t>(0xD000 + ((page - MMU::PHYS_ROM) << 8) + offset);
+  }
+
+  // Language card bank 1 is stored at $C000-$CFFF of the RAM bank
+  const uint32_t bank_page = page & 0xFF;
+  if (bank_page >= 0xC0 && bank_page <= 0xCF)
+  {
+    return static_cast<uint16_t>((bank_page + 0x10) << 8 | offset);
+  }
+  return static_cast<uint16_t>(bank_page << 8 | offset);
+}
+
+std::string guest_profiler::describeLocation(uint32_t location)
+{
+  if (location == TOP_LEVEL)
+  {
+    return "[top]";
+  }
+
+  const char *bank = "";
+  const uint32_t page = location >> 8;
+  if (location < SLOT_SPACE)
+  {
+    if (page >= MMU::PHYS_ROM)
+    {
+      bank = "rom:";
+    }
+    else
+    {
+      const bool aux = page >= MMU::PHYS_AUX_RAM;
+      const uint32_t bank_page = page & 0xFF;
+      if (bank_page >= 0xC0 && bank_page <= 0xCF)
+      {
+        bank = aux ? "aux-lc1:" : "lc1:";
+      }
+      else if (bank_page >= 0xD0)
+      {
+        bank = aux ? "aux-lc:" : "lc:";
+      }
+      else if (aux)
+      {
+        bank = "aux:";
+      }
+    }
+  }
+
+  char name[24];
+  std::snprintf(name, sizeof(name), "%s$%04X", bank, locationAddress(location));
+  return name;
+}
+
+bool guest_profiler::writeCollapsedStacks(const std::string &path) const
+{
+  std::ofstream file(path, std::ios::trunc);
+  if (!file)
+  {
+    LOG_ERRORF("Failed to create profile file: %s", path.c_str());
+    return false;
+  }
+
+  std::vector<uint32_t> chain;
+  for (uint32_t id = 0; id < nodes_.size(); ++id)
+  {
+    if (nodes_[id].self_cycles == 0)
+    {
+      continue;
+    }
+
+    // Walk up to the top level, then print root first
+    chain.clear();
+    for (uint32_t n = id; n != 0; n = nodes_[n].parent)
+    {
+      chain.push_back(nodes_[n].function);
+    }
+    chain.push_back(TOP_LEVEL);
+
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+      file << (it == chain.rbegin() ? "" : ";") << describeLocation(*it);
+    }
+    file << ' ' << nodes_[id].self_cycles << '\n';
+  }
+
+  if (!file)
+  {
+    LOG_ERRORF("Error writing profile file: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool guest_profiler::writeReport(const std::string &path) const
+{
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (!file)
+  {
+    LOG_ERRORF("Failed to create profile report: %s", path.c_str());
+    return false;
+  }
+
+  std::fprintf(file, "%llu instructions, %llu cycles\n\n",
+               static_cast<unsigned long long>(total_instructions_), static_cast<unsigned long long>(total_cycles_));
+
+  std::fprintf(file, "Hot spots\n  %-14s %14s %14s %7s\n", "location", "instructions", "cycles", "%");
+  for (const hot_spot &spot : getHotSpots(REPORT_HOT_SPOTS))
+  {
+    std::fprintf(file, "  %-14s %14llu %14llu %6.2f%%\n", describeLocation(spot.location).c_str(),
+                 static_cast<unsigned long long>(spot.instructions), static_cast<unsigned long long>(spot.cycles),
+                 percent(spot.cycles, total_cycles_));
+  }
+
+  std::fprintf(file, "\nFunctions\n  %-14s %10s %14s %7s %14s %7s\n", "entry", "calls", "inclusive", "%", "exclusive", "%");
+  std::vector<function_stats> functions = getFunctions();
+  functions.resize(std::min(functions.size(), REPORT_FUNCTIONS));
+  for (const function_stats &f : functions)
+  {
+    std::fprintf(file, "  %-14s %10llu %14llu %6.2f%% %14llu %6.2f%%\n", describeLocation(f.entry).c_str(),
+                 static_cast<unsigned long long>(f.calls), static_cast<unsigned long long>(f.inclusive_cycles),
+                 percent(f.inclusive_cycles, total_cycles_), static_cast<unsigned long long>(f.exclusive_cycles),
+                 percent(f.exclusive_cycles, total_cycles_));
+  }
+
+  std::vector<int> order;
+  for (int op = 0; op < 256; ++op)
+  {
+    if (opcodes_[op].count)
+    {
+      order.push_back(op);
+    }
+  }
+  std::sort(order.begin(), order.end(), [this](int a, int b) { return opcodes_[a].cycles > opcodes_[b].cycles; });
+
+  std::fprintf(file, "\nOpcodes\n  %-4s %-6s %14s %14s %7s\n", "op", "", "count", "cycles", "%");
+  for (int op : order)
+  {
+    std::fprintf(file, "  $%02X  %-6s %14llu %14llu %6.2f%%\n", op, disassembler::OPCODES[op].mnemonic,
+                 static_cast<unsigned long long>(opcodes_[op].count),
+                 static_cast<unsigned long long>(opcodes_[op].cycles), percent(opcodes_[op].cycles, total_cycles_));
+  }
+
+  const bool ok = !std::ferror(file);
+  if (std::fclose(file) != 0 || !ok)
+  {
+    LOG_ERRORF("Error writing profile report: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,144 @@
+#include "emulator/idle_detector.hpp"
+#include "apple2e/soft_switches.hpp"
+#include <algorithm>
+
+namespace
+{
+// Status flag bits touched by the skipped code
+constexpr uint8_t FLAG_C = 0x01;
+constexpr uint8_t FLAG_Z = 0x02;
+constexpr uint8_t FLAG_D = 0x08;
+constexpr uint8_t FLAG_V = 0x40;
+constexpr uint8_t FLAG_N = 0x80;
+
+// Opcodes of the patterns
+constexpr uint8_t OP_INC_ZP = 0xE6;
+constexpr uint8_t OP_BNE = 0xD0;
+constexpr uint8_t OP_BPL = 0x10;
+constexpr uint8_t OP_LDA_ABS = 0xAD;
+constexpr uint8_t OP_BIT_ABS = 0x2C;
+
+// Monitor WAIT routine ($FCA8-$FCB3)
+constexpr uint8_t WAIT_CODE[] = {
+    0x38,             // WAIT   SEC
+    0x48,             // WAIT2  PHA
+    0xE9, 0x01,       // WAIT3  SBC #$01
+    0xD0, 0xFC,       //        BNE WAIT3
+    0x68,             //        PLA
+    0xE9, 0x01,       //        SBC #$01
+    0xD0, 0xF6,       //        BNE WAIT2
+    0x60              //        RTS
+};
+constexpr uint16_t WAIT_RTS_OFFSET = 11;
+constexpr uint64_t RTS_CYCLES = 6;
+} // namespace
+
+idle_detector::idle_detector(MMU &mmu)
+    : mmu_(mmu)
+{
+}
+
+uint64_t idle_detector::fastForward(block_cache::registers &regs, uint64_t max_cycles)
+{
+  if (regs.pc == WAIT_ENTRY)
+  {
+    return skipWait(regs, max_cycles);
+  }
+  return skipKeyboardPoll(regs, max_cycles);
+}
+
+uint64_t idle_detector::skipKeyboardPoll(block_cache::registers &regs, uint64_t max_cycles)
+{
+  const uint16_t loop = regs.pc;
+  if (mmu_.peek(loop) != OP_INC_ZP || mmu_.peek(static_cast<uint16_t>(loop + 2)) != OP_BNE)
+  {
+    return 0;
+  }
+
+  // BNE must go straight to the poll
+  const uint16_t after_bne = static_cast<uint16_t>(loop + 4);
+  const uint16_t poll = static_cast<uint16_t>(after_bne + static_cast<int8_t>(mmu_.peek(static_cast<uint16_t>(loop + 3))));
+  const uint8_t poll_op = mmu_.peek(poll);
+  if ((poll_op != OP_LDA_ABS && poll_op != OP_BIT_ABS) ||
+      mmu_.peek(static_cast<uint16_t>(poll + 1)) != (Apple2e::KBD & 0xFF) ||
+      mmu_.peek(static_cast<uint16_t>(poll + 2)) != (Apple2e::KBD >> 8) ||
+      mmu_.peek(static_cast<uint16_t>(poll + 3)) != OP_BPL)
+  {
+    return 0;
+  }
+
+  // ...and BPL straight back to the INC
+  const uint16_t after_bpl = static_cast<uint16_t>(poll + 5);
+  if (static_cast<uint16_t>(after_bpl + static_cast<int8_t>(mmu_.peek(static_cast<uint16_t>(poll + 4)))) != loop)
+  {
+    return 0;
+  }
+
+  // A waiting key ends the loop
+  const uint8_t key = mmu_.peek(Apple2e::KBD);
+  if (key & 0x80)
+  {
+    return 0;
+  }
+
+  // Only iterations where the INC doesn't wrap take the short path
+  const uint16_t counter_address = mmu_.peek(static_cast<uint16_t>(loop + 1));
+  const uint8_t counter = mmu_.peek(counter_address);
+  const uint64_t iteration_cycles = 5 + 3 + branchPenalty(after_bne, poll) +
+                                    4 + 3 + branchPenalty(after_bpl, loop);
+  uint64_t iterations = std::min<uint64_t>(0xFF - counter, max_cycles / iteration_cycles);
+  if (iterations == 0)
+  {
+    return 0;
+  }
+
+  mmu_.write(counter_address, static_cast<uint8_t>(counter + iterations));
+
+  // State after the final LDA/BIT $C000; C is untouched
+  if (poll_op == OP_LDA_ABS)
+  {
+    regs.a = key;
+    regs.p = static_cast<uint8_t>((regs.p & ~(FLAG_N | FLAG_Z)) | (key ? 0 : FLAG_Z));
+  }
+  else
+  {
+    regs.p = static_cast<uint8_t>((regs.p & ~(FLAG_N | FLAG_Z | FLAG_V)) | (key & FLAG_V) |
+                                  ((regs.a & key) ? 0 : FLAG_Z));
+  }
+
+  return iterations * iteration_cycles;
+}
+
+uint64_t idle_detector::skipWait(block_cache::registers &regs, uint64_t max_cycles)
+{
+  // A = 0 underflows on the first SBC and decimal mode changes the
+  // arithmetic; both are rare enough to leave to the CPU
+  if (regs.a == 0 || (regs.p & FLAG_D))
+  {
+    return 0;
+  }
+
+  for (uint16_t i = 0; i < sizeof(WAIT_CODE); ++i)
+  {
+    if (mmu_.peek(static_cast<uint16_t>(regs.pc + i)) != WAIT_CODE[i])
+    {
+      return 0;
+    }
+  }
+
+  // (26 + 27A + 5A^2) / 2 less the JSR (6) and the RTS (6), which still runs
+  const uint64_t a = regs.a;
+  const uint64_t cycles = (14 + 27 * a + 5 * a * a) / 2 - RTS_CYCLES;
+  if (cycles > max_cycles)
+  {
+    return 0;
+  }
+
+  // Final PHA left 1 on the stack; the last SBC took A from 1 to 0
+  mmu_.write(static_cast<uint16_t>(0x0100 | regs.sp), 0x01);
+  regs.a = 0;
+  regs.p = static_cast<uint8_t>((regs.p & ~(FLAG_N | FLAG_V)) | FLAG_Z | FLAG_C);
+  regs.pc = static_cast<uint16_t>(regs.pc + WAIT_RTS_OFFSET);
+
+  return cycles;
+}
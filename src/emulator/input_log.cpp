@@ -0,0 +1,87 @@
+#include "emulator/input_log.hpp"
+
+void input_log::begin(uint64_t start_cycle)
+{
+  start_cycle_ = start_cycle;
+  end_cycle_ = start_cycle;
+  events_.clear();
+}
+
+void input_log::saveState(state_writer &out) const
+{
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeU64(start_cycle_);
+  out.writeVarint(end_cycle_ - start_cycle_);
+  out.writeVarint(events_.size());
+
+  uint64_t cycle = start_cycle_;
+  for (const event &e : events_)
+  {
+    out.writeVarint(e.cycle - cycle);
+    cycle = e.cycle;
+    out.writeU8(static_cast<uint8_t>(e.type));
+    switch (e.type)
+    {
+    case event_type::KEY_DOWN:
+    case event_type::DISK_EJECT:
+      out.writeU8(e.value);
+      break;
+    case event_type::DISK_INSERT:
+      out.writeU8(e.value);
+      out.writeString(e.path);
+      break;
+    case event_type::RESET:
+    case event_type::WARM_RESET:
+      break;
+    }
+  }
+  out.endChunk();
+}
+
+bool input_log::loadState(state_chunk &chunk)
+{
+  const uint64_t start = chunk.readU64();
+  const uint64_t length = chunk.readVarint();
+  const uint64_t count = chunk.readVarint();
+  if (chunk.isTruncated() || count > chunk.getRemaining())
+  {
+    return false;  // Every event takes at least two bytes
+  }
+
+  std::vector<event> events;
+  events.reserve(static_cast<size_t>(count));
+  uint64_t cycle = start;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    event e;
+    cycle += chunk.readVarint();
+    e.cycle = cycle;
+    e.type = static_cast<event_type>(chunk.readU8());
+    switch (e.type)
+    {
+    case event_type::KEY_DOWN:
+    case event_type::DISK_EJECT:
+      e.value = chunk.readU8();
+      break;
+    case event_type::DISK_INSERT:
+      e.value = chunk.readU8();
+      e.path = chunk.readString();
+      break;
+    case event_type::RESET:
+    case event_type::WARM_RESET:
+      break;
+    default:
+      return false;
+    }
+    if (chunk.isTruncated())
+    {
+      return false;
+    }
+    events.push_back(std::move(e));
+  }
+
+  start_cycle_ = start;
+  end_cycle_ = start + length;
+  events_ = std::move(events);
+  return true;
+}
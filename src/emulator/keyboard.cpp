@@ -82,3 +82,28 @@ void Keyboard::keyUp(uint8_t key_code)
   // and only clear this when all keys are released
   any_key_down_ = false;
 }
+
+void Keyboard::saveState(state_writer &out) const
+{
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeU8(latched_keycode_);
+  out.writeBool(key_waiting_);
+  out.writeBool(any_key_down_);
+  out.endChunk();
+}
+
+bool Keyboard::loadState(state_chunk &chunk)
+{
+  uint8_t keycode = chunk.readU8();
+  bool waiting = chunk.readBool();
+  bool any_down = chunk.readBool();
+  if (chunk.isTruncated())
+  {
+    return false;
+  }
+
+  latched_keycode_ = keycode & 0x7F;
+  key_waiting_ = waiting;
+  any_key_down_ = any_down;
+  return true;
+}
@@ -1,63 +1,54 @@
 #include "emulator/memory_access_tracker.hpp"
 
-void memory_access_tracker::recordRead(uint16_t address)
+access_type memory_access_tracker::getAccess(uint16_t address, uint64_t current_cycle) const
 {
-  if (!enabled_)
-    return;
-
-  entries_[address].type = access_type::READ;
-  entries_[address].fade_timer = FADE_DURATION;
+  const uint32_t stamp = stamps_[address];
+  const uint32_t age = (static_cast<uint32_t>(current_cycle) & ~TYPE_MASK) - (stamp & ~TYPE_MASK);
+  if (stamp == 0 || age >= FADE_CYCLES)
+  {
+    return access_type::NONE;
+  }
+  return static_cast<access_type>(stamp & TYPE_MASK);
 }
 
-void memory_access_tracker::recordWrite(uint16_t address)
+void memory_access_tracker::buildHeatmap(uint64_t current_cycle, uint32_t *pixels)
 {
-  if (!enabled_)
-    return;
-
-  // Last access wins - write overwrites read
-  entries_[address].type = access_type::WRITE;
-  entries_[address].fade_timer = FADE_DURATION;
-}
+  // Integer and branch-free so the compiler can vectorize it. The fade
+  // level k runs from 256 (just accessed) down to 0 (grey); the accessed
+  // channel goes from 128 up to 255 and the others from 128 down to 0.
+  constexpr uint32_t FADE_SHIFT = 12; // FADE_CYCLES >> FADE_SHIFT == 256
+  static_assert((FADE_CYCLES >> FADE_SHIFT) == 256, "fade level must span 0-256");
 
-void memory_access_tracker::update(float deltaTime)
-{
-  if (!enabled_)
-    return;
+  const uint32_t now = static_cast<uint32_t>(current_cycle) & ~TYPE_MASK;
+  uint32_t *stamps = stamps_.data();
 
-  for (auto &entry : entries_)
+  for (uint32_t i = 0; i < 65536; ++i)
   {
-    if (entry.fade_timer > 0.0f)
-    {
-      entry.fade_timer -= deltaTime;
-      if (entry.fade_timer <= 0.0f)
-      {
-        entry.fade_timer = 0.0f;
-        entry.type = access_type::NONE;
-      }
-    }
+    const uint32_t stamp = stamps[i];
+    const uint32_t age = now - (stamp & ~TYPE_MASK);
+    const bool live = stamp != 0 && age < FADE_CYCLES;
+    const uint32_t k = live ? (FADE_CYCLES - age) >> FADE_SHIFT : 0;
+    stamps[i] = live ? stamp : 0;
+
+    const uint32_t up = 128 + ((127 * k) >> 8);
+    const uint32_t down = 128 - (k >> 1);
+    const bool write = (stamp & TYPE_MASK) == static_cast<uint32_t>(access_type::WRITE);
+    const uint32_t r = write ? up : down;
+    const uint32_t g = write ? down : up;
+    pixels[i] = 0xFF000000u | (down << 16) | (g << 8) | r;
   }
 }
 
-const memory_access_entry &memory_access_tracker::getEntry(uint16_t address) const
-{
-  return entries_[address];
-}
-
 void memory_access_tracker::setEnabled(bool enabled)
 {
+  if (enabled && !enabled_)
+  {
+    clear();
+  }
   enabled_ = enabled;
 }
 
-bool memory_access_tracker::isEnabled() const
-{
-  return enabled_;
-}
-
 void memory_access_tracker::clear()
 {
-  for (auto &entry : entries_)
-  {
-    entry.type = access_type::NONE;
-    entry.fade_timer = 0.0f;
-  }
+  stamps_.fill(0);
 }
@@ -0,0 +1,76 @@
+#include "emulator/metal_frame_sink.hpp"
+#include "emulator/video_display.hpp"
+#include <iostream>
+
+#import <Metal/Metal.h>
+
+metal_frame_sink::~metal_frame_sink()
+{
+  if (texture_)
+  {
+    // Without ARC, we own the +1 reference from newTextureWithDescriptor.
+    // Release it by casting back to id and calling release.
+    id<MTLTexture> tex = (__bridge id<MTLTexture>)texture_;
+    [tex release];
+    texture_ = nullptr;
+  }
+}
+
+bool metal_frame_sink::initialize(void *device)
+{
+  if (!device)
+  {
+    return false;
+  }
+
+  id<MTLDevice> mtlDevice = (__bridge id<MTLDevice>)device;
+
+  // Create texture descriptor
+  MTLTextureDescriptor *textureDescriptor = [[MTLTextureDescriptor alloc] init];
+  textureDescriptor.pixelFormat = MTLPixelFormatRGBA8Unorm;
+  textureDescriptor.width = video_display::getMaxDisplayWidth();
+  textureDescriptor.height = video_display::getDisplayHeight();
+  textureDescriptor.usage = MTLTextureUsageShaderRead;
+  // Use Shared storage mode to avoid synchronization issues between CPU writes and GPU reads
+  textureDescriptor.storageMode = MTLStorageModeShared;
+
+  // Create texture
+  id<MTLTexture> tex = [mtlDevice newTextureWithDescriptor:textureDescriptor];
+  if (!tex)
+  {
+    std::cerr << "Failed to create Metal texture" << std::endl;
+    return false;
+  }
+
+  // Without ARC, newTextureWithDescriptor returns a +1 retained object.
+  // Use __bridge to store the pointer - we own the reference and must release in destructor.
+  texture_ = (__bridge void *)tex;
+
+  std::cout << "Video texture initialized: " << video_display::getMaxDisplayWidth() << "x"
+            << video_display::getDisplayHeight() << std::endl;
+  return true;
+}
+
+bool metal_frame_sink::present(const video_frame &frame)
+{
+  if (!texture_)
+  {
+    return false;
+  }
+  if (frame.changed_line_count <= 0)
+  {
+    return true;
+  }
+
+  id<MTLTexture> tex = (__bridge id<MTLTexture>)texture_;
+
+  // Upload just the band of scanlines the last update changed
+  MTLRegion region = MTLRegionMake2D(0, frame.first_changed_line, frame.stride, frame.changed_line_count);
+
+  // Upload pixel data
+  [tex replaceRegion:region
+         mipmapLevel:0
+           withBytes:frame.pixels + frame.first_changed_line * frame.stride
+         bytesPerRow:frame.stride * sizeof(uint32_t)];
+  return true;
+}
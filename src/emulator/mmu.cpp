@@ -31,54 +31,23 @@ MMU::MMU(RAM &ram, ROM &rom, Keyboard *keyboard, Speaker *speaker)
   soft_switches_.read_bank = Apple2e::MemoryBank::MAIN;
   soft_switches_.write_bank = Apple2e::MemoryBank::MAIN;
   soft_switches_.keyboard_strobe = false;
+
+  updateMemoryMap();
 }
 
-uint8_t MMU::read(uint16_t address)
+uint8_t MMU::readIO(uint16_t address)
 {
-  // Track memory access for visualization
-  if (access_tracker_)
-  {
-    access_tracker_->recordRead(address);
-  }
-
-  // Zero page and stack ($0000-$01FF) - affected by ALTZP
-  if (address < 0x0200)
-  {
-    return ram_.readDirect(address, soft_switches_.altzp);
-  }
-
-  // Main RAM area ($0200-$BFFF)
-  if (address >= 0x0200 && address < Apple2e::MEM_IO_START)
-  {
-    // Determine which RAM bank to use for this read
-    // Default: use RAMRD flag
-    bool use_aux = soft_switches_.ramrd;
-
-    // 80STORE overrides RAMRD for text page 1 and (if HIRES) hires page 1
-    // When 80STORE is on, PAGE2 controls main/aux for these display memory areas
-    // This is true regardless of whether 80-column VIDEO mode is active
-    if (soft_switches_.store80)
-    {
-      bool is_text_page1 = (address >= Apple2e::MEM_TEXT_PAGE1_START &&
-                            address <= Apple2e::MEM_TEXT_PAGE1_END);
-      bool is_hires_page1 = soft_switches_.graphics_mode == Apple2e::GraphicsMode::HIRES &&
-                            (address >= Apple2e::MEM_HIRES_PAGE1_START &&
-                             address <= Apple2e::MEM_HIRES_PAGE1_END);
-
-      if (is_text_page1 || is_hires_page1)
-      {
-        // PAGE2 selects aux (true) or main (false) for display memory
-        use_aux = (soft_switches_.page_select == Apple2e::PageSelect::PAGE2);
-      }
-    }
-
-    return ram_.readDirect(address, use_aux);
-  }
-
   // I/O space ($C000-$C0FF)
   if (address >= Apple2e::MEM_IO_START && address <= Apple2e::MEM_IO_END)
   {
-    return readSoftSwitch(address);
+    if (!isVideoSwitch(address))
+    {
+      return readSoftSwitch(address);
+    }
+    const uint8_t video_before = video_switch_log::pack(soft_switches_);
+    const uint8_t value = readSoftSwitch(address);
+    noteVideoSwitches(video_before);
+    return value;
   }
 
   // Expansion ROM area ($C100-$CFFF)
@@ -108,108 +77,190 @@ uint8_t MMU::read(uint16_t address)
     return rom_.readExpansionROM(address);
   }
 
-  // Language card / ROM area ($D000-$FFFF)
-  if (address >= Apple2e::MEM_ROM_START && address <= Apple2e::MEM_ROM_END)
+  // Unmapped address
+  return 0xFF;
+}
+
+void MMU::writeIO(uint16_t address, uint8_t value)
+{
+  // I/O space ($C000-$C0FF)
+  if (address >= Apple2e::MEM_IO_START && address <= Apple2e::MEM_IO_END)
   {
-    if (soft_switches_.lcread)
+    if (!isVideoSwitch(address))
     {
-      // Read from language card RAM
-      // The $D000-$DFFF range has two banks; $E000-$FFFF is shared
-      uint16_t ram_address = address;
-      if (address < 0xE000 && !soft_switches_.lcbank2)
-      {
-        // Bank 1 is stored at $C000-$CFFF in the RAM array (unused I/O space)
-        ram_address = address - 0x1000;
-      }
-      uint8_t value = ram_.readDirect(ram_address, soft_switches_.altzp);
-      return value;
-    }
-    else
-    {
-      // Read from ROM
-      return rom_.read(address);
+      writeSoftSwitch(address, value);
+      return;
     }
+    const uint8_t video_before = video_switch_log::pack(soft_switches_);
+    writeSoftSwitch(address, value);
+    noteVideoSwitches(video_before);
+    return;
   }
 
-  // Unmapped address
-  return 0xFF;
+  // Expansion ROM area ($C100-$CFFF) and write-protected ROM / language card
+  // ($D000-$FFFF with LCWRITE off) - writes ignored
 }
 
-void MMU::write(uint16_t address, uint8_t value)
+void MMU::updateMemoryMap() const
 {
-  // Track memory access for visualization
-  if (access_tracker_)
+  memory_map_dirty_ = false;
+
+  const bool page2 = soft_switches_.page_select == Apple2e::PageSelect::PAGE2;
+  const bool hires = soft_switches_.graphics_mode == Apple2e::GraphicsMode::HIRES;
+
+  // Only rebuild when one of the switches that affect mapping has changed.
+  // PAGE2 and HIRES only move memory while 80STORE is on; otherwise they
+  // just flip the displayed page, and a rebuild would needlessly bump the
+  // generation (which cuts short the block cache's running block and links).
+  const uint16_t key = (soft_switches_.altzp ? 0x001 : 0) |
+                       (soft_switches_.ramrd ? 0x002 : 0) |
+                       (soft_switches_.ramwrt ? 0x004 : 0) |
+                       (soft_switches_.store80 ? 0x008 : 0) |
+                       (soft_switches_.store80 && page2 ? 0x010 : 0) |
+                       (soft_switches_.store80 && hires ? 0x020 : 0) |
+                       (soft_switches_.lcbank2 ? 0x040 : 0) |
+                       (soft_switches_.lcread ? 0x080 : 0) |
+                       (soft_switches_.lcwrite ? 0x100 : 0);
+  if (key == memory_map_key_)
   {
-    access_tracker_->recordWrite(address);
+    return;
   }
+  memory_map_key_ = key;
+  ++memory_map_generation_;
+
+  uint8_t *main_ram = ram_.getMainBank().data();
+  uint8_t *aux_ram = ram_.getAuxBank().data();
+  const uint8_t *rom = rom_.getData().data();
+
+  // Point a CPU page at a RAM page for reading and/or writing
+  auto mapRead = [&](size_t page, bool aux, size_t ram_page)
+  {
+    read_pages_[page] = (aux ? aux_ram : main_ram) + (ram_page << 8);
+    read_physical_[page] = static_cast<uint16_t>((aux ? PHYS_AUX_RAM : PHYS_MAIN_RAM) + ram_page);
+  };
+  auto mapWrite = [&](size_t page, bool aux, size_t ram_page)
+  {
+    write_pages_[page] = (aux ? aux_ram : main_ram) + (ram_page << 8);
+    write_physical_[page] = static_cast<uint16_t>((aux ? PHYS_AUX_RAM : PHYS_MAIN_RAM) + ram_page);
+  };
 
   // Zero page and stack ($0000-$01FF) - affected by ALTZP
-  if (address < 0x0200)
+  for (size_t page = 0x00; page < 0x02; ++page)
   {
-    ram_.writeDirect(address, value, soft_switches_.altzp);
-    return;
+    mapRead(page, soft_switches_.altzp, page);
+    mapWrite(page, soft_switches_.altzp, page);
   }
 
-  // Main RAM area ($0200-$BFFF)
-  if (address >= 0x0200 && address < Apple2e::MEM_IO_START)
+  // Main RAM area ($0200-$BFFF) - RAMRD selects the read bank, RAMWRT the write bank
+  for (size_t page = 0x02; page < 0xC0; ++page)
   {
-    // Determine which RAM bank to use for this write
-    // Default: use RAMWRT flag
-    bool use_aux = soft_switches_.ramwrt;
-
-    // 80STORE overrides RAMWRT for text page 1 and (if HIRES) hires page 1
-    // When 80STORE is on, PAGE2 controls main/aux for these display memory areas
-    // This is true regardless of whether 80-column VIDEO mode is active
-    if (soft_switches_.store80)
-    {
-      bool is_text_page1 = (address >= Apple2e::MEM_TEXT_PAGE1_START &&
-                            address <= Apple2e::MEM_TEXT_PAGE1_END);
-      bool is_hires_page1 = soft_switches_.graphics_mode == Apple2e::GraphicsMode::HIRES &&
-                            (address >= Apple2e::MEM_HIRES_PAGE1_START &&
-                             address <= Apple2e::MEM_HIRES_PAGE1_END);
+    mapRead(page, soft_switches_.ramrd, page);
+    mapWrite(page, soft_switches_.ramwrt, page);
+  }
 
-      if (is_text_page1 || is_hires_page1)
+  // 80STORE overrides RAMRD/RAMWRT for text page 1 and (if HIRES) hires page 1
+  // When 80STORE is on, PAGE2 controls main/aux for these display memory areas
+  // This is true regardless of whether 80-column VIDEO mode is active
+  if (soft_switches_.store80)
+  {
+    for (size_t page = Apple2e::MEM_TEXT_PAGE1_START >> 8; page <= Apple2e::MEM_TEXT_PAGE1_END >> 8; ++page)
+    {
+      mapRead(page, page2, page);
+      mapWrite(page, page2, page);
+    }
+    if (hires)
+    {
+      for (size_t page = Apple2e::MEM_HIRES_PAGE1_START >> 8; page <= Apple2e::MEM_HIRES_PAGE1_END >> 8; ++page)
       {
-        // PAGE2 selects aux (true) or main (false) for display memory
-        use_aux = (soft_switches_.page_select == Apple2e::PageSelect::PAGE2);
+        mapRead(page, page2, page);
+        mapWrite(page, page2, page);
       }
     }
-
-    ram_.writeDirect(address, value, use_aux);
-    return;
   }
 
-  // I/O space ($C000-$C0FF)
-  if (address >= Apple2e::MEM_IO_START && address <= Apple2e::MEM_IO_END)
+  // I/O and expansion ROM ($C000-$CFFF) - always through readIO()/writeIO()
+  // because of soft switch and INTC8ROM side effects
+  for (size_t page = 0xC0; page < 0xD0; ++page)
   {
-    writeSoftSwitch(address, value);
-    return;
+    read_pages_[page] = nullptr;
+    write_pages_[page] = nullptr;
+    read_physical_[page] = NO_PHYSICAL_PAGE;
+    write_physical_[page] = NO_PHYSICAL_PAGE;
   }
 
-  // Expansion ROM area ($C100-$CFFF) - writes ignored
-  if (address >= Apple2e::MEM_EXPANSION_START && address <= Apple2e::MEM_EXPANSION_END)
+  // Language card / ROM area ($D000-$FFFF)
+  // The $D000-$DFFF range has two banks; $E000-$FFFF is shared
+  for (size_t page = 0xD0; page <= 0xFF; ++page)
   {
-    return;
-  }
+    // Bank 1 is stored at $C000-$CFFF in the RAM array (unused I/O space)
+    size_t ram_page = (page < 0xE0 && !soft_switches_.lcbank2) ? page - 0x10 : page;
+
+    if (soft_switches_.lcread)
+    {
+      mapRead(page, soft_switches_.altzp, ram_page);
+    }
+    else
+    {
+      read_pages_[page] = rom + ((page - 0xD0) << 8);
+      read_physical_[page] = static_cast<uint16_t>(PHYS_ROM + (page - 0xD0));
+    }
 
-  // Language card area ($D000-$FFFF)
-  if (address >= Apple2e::MEM_ROM_START && address <= Apple2e::MEM_ROM_END)
-  {
     if (soft_switches_.lcwrite)
     {
-      // Write to language card RAM
-      // The $D000-$DFFF range has two banks; $E000-$FFFF is shared
-      uint16_t ram_address = address;
-      if (address < 0xE000 && !soft_switches_.lcbank2)
-      {
-        // Bank 1 is stored at $C000-$CFFF in the RAM array (unused I/O space)
-        ram_address = address - 0x1000;
-      }
-      ram_.writeDirect(ram_address, value, soft_switches_.altzp);
+      mapWrite(page, soft_switches_.altzp, ram_page);
     }
-    // ROM writes are ignored
+    else
+    {
+      // ROM writes are ignored
+      write_pages_[page] = nullptr;
+      write_physical_[page] = NO_PHYSICAL_PAGE;
+    }
+  }
+
+  updateCodeWriteWatch();
+}
+
+void MMU::updateCodeWriteWatch() const
+{
+  for (size_t page = 0; page < PAGE_COUNT; ++page)
+  {
+    uint16_t physical = write_physical_[page];
+    code_write_watch_[page] = physical != NO_PHYSICAL_PAGE && code_pages_[physical];
+  }
+}
+
+void MMU::setCodePage(uint16_t physical_page, bool has_code)
+{
+  if (physical_page >= PHYS_PAGE_COUNT || code_pages_[physical_page] == has_code)
+  {
     return;
   }
+
+  code_pages_[physical_page] = has_code;
+  if (memory_map_dirty_)
+  {
+    updateMemoryMap();
+  }
+  updateCodeWriteWatch();
+}
+
+void MMU::clearCodePages()
+{
+  code_pages_.fill(false);
+  code_write_watch_.fill(false);
+}
+
+void MMU::notifyCodeWrite(uint8_t page)
+{
+  // Clear the mark first; the cache re-marks the page if it decodes it again
+  uint16_t physical = write_physical_[page];
+  code_pages_[physical] = false;
+  updateCodeWriteWatch();
+
+  if (code_write_callback_)
+  {
+    code_write_callback_(physical);
+  }
 }
 
 uint8_t MMU::peek(uint16_t address) const
@@ -217,32 +268,16 @@ uint8_t MMU::peek(uint16_t address) const
   // Peek reads memory without triggering any side effects
   // Used by debuggers, memory viewers, etc.
 
-  // Zero page and stack ($0000-$01FF) - affected by ALTZP
-  if (address < 0x0200)
+  if (memory_map_dirty_)
   {
-    return ram_.readDirect(address, soft_switches_.altzp);
+    updateMemoryMap();
   }
 
-  // Main RAM area ($0200-$BFFF)
-  if (address >= 0x0200 && address < Apple2e::MEM_IO_START)
+  // RAM and ROM pages come straight from the read page table
+  const uint8_t *page = read_pages_[address >> 8];
+  if (page)
   {
-    bool use_aux = soft_switches_.ramrd;
-
-    if (soft_switches_.store80)
-    {
-      bool is_text_page1 = (address >= Apple2e::MEM_TEXT_PAGE1_START &&
-                            address <= Apple2e::MEM_TEXT_PAGE1_END);
-      bool is_hires_page1 = soft_switches_.graphics_mode == Apple2e::GraphicsMode::HIRES &&
-                            (address >= Apple2e::MEM_HIRES_PAGE1_START &&
-                             address <= Apple2e::MEM_HIRES_PAGE1_END);
-
-      if (is_text_page1 || is_hires_page1)
-      {
-        use_aux = (soft_switches_.page_select == Apple2e::PageSelect::PAGE2);
-      }
-    }
-
-    return ram_.readDirect(address, use_aux);
+    return page[address & 0xFF];
   }
 
   // I/O space ($C000-$C0FF) - return current state without side effects
@@ -308,6 +343,8 @@ uint8_t MMU::peek(uint16_t address) const
         return soft_switches_.altchar_mode ? 0x80 : 0x00;
       case Apple2e::RD80VID:
         return soft_switches_.col80_mode ? 0x80 : 0x00;
+      case Apple2e::RDDHIRES:
+        return soft_switches_.dhires ? 0x80 : 0x00;
       default:
         return 0x00;
     }
@@ -324,27 +361,6 @@ uint8_t MMU::peek(uint16_t address) const
     return rom_.readExpansionROM(address);
   }
 
-  // Language card / ROM area ($D000-$FFFF)
-  if (address >= Apple2e::MEM_ROM_START && address <= Apple2e::MEM_ROM_END)
-  {
-    if (soft_switches_.lcread)
-    {
-      // The $D000-$DFFF range has two banks; $E000-$FFFF is shared
-      uint16_t ram_address = address;
-      if (address < 0xE000 && !soft_switches_.lcbank2)
-      {
-        // Bank 1 is stored at $C000-$CFFF in the RAM array (unused I/O space)
-        ram_address = address - 0x1000;
-      }
-      uint8_t value = ram_.readDirect(ram_address, soft_switches_.altzp);
-      return value;
-    }
-    else
-    {
-      return rom_.read(address);
-    }
-  }
-
   return 0xFF;
 }
 
@@ -373,6 +389,71 @@ Apple2e::SoftSwitchState MMU::getSoftSwitchSnapshot() const
   return snapshot;
 }
 
+void MMU::saveState(state_writer &out) const
+{
+  const Apple2e::SoftSwitchState &sw = soft_switches_;
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeU8(static_cast<uint8_t>(sw.video_mode));
+  out.writeU8(static_cast<uint8_t>(sw.screen_mode));
+  out.writeU8(static_cast<uint8_t>(sw.page_select));
+  out.writeU8(static_cast<uint8_t>(sw.graphics_mode));
+  out.writeBool(sw.col80_mode);
+  out.writeBool(sw.altchar_mode);
+  out.writeBool(sw.store80);
+  out.writeBool(sw.ramrd);
+  out.writeBool(sw.ramwrt);
+  out.writeBool(sw.altzp);
+  out.writeBool(sw.intcxrom);
+  out.writeBool(sw.slotc3rom);
+  out.writeBool(sw.intc8rom);
+  out.writeBool(sw.lcbank2);
+  out.writeBool(sw.lcread);
+  out.writeBool(sw.lcwrite);
+  out.writeBool(sw.lcprewrite);
+  out.writeU8(static_cast<uint8_t>(sw.read_bank));
+  out.writeU8(static_cast<uint8_t>(sw.write_bank));
+  out.writeBool(sw.keyboard_strobe);
+  out.writeBool(sw.dhires);
+  out.endChunk();
+}
+
+bool MMU::loadState(state_chunk &chunk)
+{
+  Apple2e::SoftSwitchState sw;
+  sw.video_mode = static_cast<Apple2e::VideoMode>(chunk.readU8() & 1);
+  sw.screen_mode = static_cast<Apple2e::ScreenMode>(chunk.readU8() & 1);
+  sw.page_select = static_cast<Apple2e::PageSelect>(chunk.readU8() & 1);
+  sw.graphics_mode = static_cast<Apple2e::GraphicsMode>(chunk.readU8() & 1);
+  sw.col80_mode = chunk.readBool();
+  sw.altchar_mode = chunk.readBool();
+  sw.store80 = chunk.readBool();
+  sw.ramrd = chunk.readBool();
+  sw.ramwrt = chunk.readBool();
+  sw.altzp = chunk.readBool();
+  sw.intcxrom = chunk.readBool();
+  sw.slotc3rom = chunk.readBool();
+  sw.intc8rom = chunk.readBool();
+  sw.lcbank2 = chunk.readBool();
+  sw.lcread = chunk.readBool();
+  sw.lcwrite = chunk.readBool();
+  sw.lcprewrite = chunk.readBool();
+  sw.read_bank = static_cast<Apple2e::MemoryBank>(chunk.readU8() & 1);
+  sw.write_bank = static_cast<Apple2e::MemoryBank>(chunk.readU8() & 1);
+  sw.keyboard_strobe = chunk.readBool();
+  if (chunk.getVersion() >= 2)
+  {
+    sw.dhires = chunk.readBool();
+  }
+  if (chunk.isTruncated())
+  {
+    return false;
+  }
+
+  soft_switches_ = sw;
+  memory_map_dirty_ = true;
+  return true;
+}
+
 std::string MMU::getName() const
 {
   return "MMU";
@@ -386,11 +467,12 @@ uint8_t MMU::readSoftSwitch(uint16_t address)
   // Reference: Apple IIe Technical Reference Manual
   if (address >= 0xC000 && address <= 0xC00F)
   {
-    if (keyboard_)
+    uint8_t key = keyboard_ ? keyboard_->read(Apple2e::KBD) : 0x00;  // Always return keyboard data
+    if (!(key & 0x80))
     {
-      return keyboard_->read(Apple2e::KBD);  // Always return keyboard data
+      keyboard_polled_ = true;
     }
-    return 0x00;
+    return key;
   }
 
   // Keyboard strobe clear ($C010)
@@ -432,17 +514,8 @@ uint8_t MMU::readSoftSwitch(uint16_t address)
 
     case Apple2e::RDVBLBAR:
       // VBL (Vertical Blank) status - active LOW (bit 7 = 0 during VBL)
-      // Apple IIe runs at 1.023 MHz with 262 scanlines per frame
-      // Each scanline is 65 cycles, so one frame = 17030 cycles
-      // VBL occurs during scanlines 192-261 (70 scanlines = 4550 cycles)
-      // Non-VBL (active display) is scanlines 0-191 (192 scanlines = 12480 cycles)
-      {
-        constexpr uint64_t CYCLES_PER_FRAME = 17030;
-        constexpr uint64_t VBL_START_CYCLE = 12480;  // After 192 visible scanlines
-        uint64_t frame_cycle = cycle_count_ % CYCLES_PER_FRAME;
-        // Bit 7 = 0 during VBL (active low), bit 7 = 1 outside VBL
-        return (frame_cycle >= VBL_START_CYCLE) ? 0x00 : 0x80;
-      }
+      // The emulator's VBL start/end events keep vertical_blank_ current
+      return vertical_blank_ ? 0x00 : 0x80;
 
     case Apple2e::RDTEXT:
       return (soft_switches_.video_mode == Apple2e::VideoMode::TEXT) ? 0x80 : 0x00;
@@ -462,6 +535,9 @@ uint8_t MMU::readSoftSwitch(uint16_t address)
     case Apple2e::RD80VID:
       return soft_switches_.col80_mode ? 0x80 : 0x00;
 
+    case Apple2e::RDDHIRES:
+      return soft_switches_.dhires ? 0x80 : 0x00;
+
     // Note: $C000-$C00F are WRITE-ONLY switches. Reads return keyboard data
     // and are handled above before this switch statement.
     // The switch cases below ($C050-$C05F) ARE activated by both read and write.
@@ -485,18 +561,22 @@ uint8_t MMU::readSoftSwitch(uint16_t address)
 
     case Apple2e::TXTPAGE1:
       soft_switches_.page_select = Apple2e::PageSelect::PAGE1;
+      updateMemoryMap();  // Remaps display pages when 80STORE is on
       return 0x00;
 
     case Apple2e::TXTPAGE2:
       soft_switches_.page_select = Apple2e::PageSelect::PAGE2;
+      updateMemoryMap();  // Remaps display pages when 80STORE is on
       return 0x00;
 
     case Apple2e::LORES:
       soft_switches_.graphics_mode = Apple2e::GraphicsMode::LORES;
+      updateMemoryMap();  // Remaps display pages when 80STORE is on
       return 0x00;
 
     case Apple2e::HIRES:
       soft_switches_.graphics_mode = Apple2e::GraphicsMode::HIRES;
+      updateMemoryMap();  // Remaps display pages when 80STORE is on
       return 0x00;
 
     // Speaker
@@ -526,15 +606,22 @@ uint8_t MMU::readSoftSwitch(uint16_t address)
       // Reset paddle timers
       return 0x00;
 
-    // Annunciators - reading returns floating bus
+    // Annunciators - reading returns floating bus. AN3 doubles as the
+    // IIe's DHIRES switch, so reading it also switches
+    case Apple2e::CLRAN3:
+      soft_switches_.dhires = true;
+      return 0x00;
+
+    case Apple2e::SETAN3:
+      soft_switches_.dhires = false;
+      return 0x00;
+
     case Apple2e::CLRAN0:
     case Apple2e::SETAN0:
     case Apple2e::CLRAN1:
     case Apple2e::SETAN1:
     case Apple2e::CLRAN2:
     case Apple2e::SETAN2:
-    case Apple2e::CLRAN3:
-    case Apple2e::SETAN3:
       return 0x00;
 
     default:
@@ -683,6 +770,14 @@ void MMU::writeSoftSwitch(uint16_t address, uint8_t value)
       soft_switches_.graphics_mode = Apple2e::GraphicsMode::HIRES;
       break;
 
+    case Apple2e::CLRAN3:
+      soft_switches_.dhires = true;
+      break;
+
+    case Apple2e::SETAN3:
+      soft_switches_.dhires = false;
+      break;
+
     default:
       // Language card switches ($C080-$C08F)
       // Writes DO affect state but differently than reads:
@@ -704,6 +799,9 @@ void MMU::writeSoftSwitch(uint16_t address, uint8_t value)
       }
       break;
   }
+
+  // Rebuild the page tables if this write changed a mapping switch
+  updateMemoryMap();
 }
 
 void MMU::handleLanguageCard(uint16_t address)
@@ -764,6 +862,8 @@ void MMU::handleLanguageCard(uint16_t address)
       soft_switches_.lcprewrite = true;
       break;
   }
+
+  updateMemoryMap();
 }
 
 void MMU::handleLanguageCardWrite(uint16_t address)
@@ -813,6 +913,8 @@ void MMU::handleLanguageCardWrite(uint16_t address)
       soft_switches_.lcprewrite = false;
       break;
   }
+
+  updateMemoryMap();
 }
 
 void MMU::handleBankSwitch(uint16_t address)
@@ -1,4 +1,5 @@
 #include "emulator/ram.hpp"
+#include <cstring>
 
 RAM::RAM()
 {
@@ -63,3 +64,25 @@ void RAM::setWriteBank(bool aux_bank)
 {
   write_aux_bank_ = aux_bank;
 }
+
+void RAM::saveState(state_writer &out) const
+{
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeBytes(main_bank_.data(), main_bank_.size());
+  out.writeBytes(aux_bank_.data(), aux_bank_.size());
+  out.endChunk();
+}
+
+bool RAM::loadState(state_chunk &chunk)
+{
+  const uint8_t *main = chunk.readBytes(main_bank_.size());
+  const uint8_t *aux = chunk.readBytes(aux_bank_.size());
+  if (!main || !aux)
+  {
+    return false;
+  }
+
+  std::memcpy(main_bank_.data(), main, main_bank_.size());
+  std::memcpy(aux_bank_.data(), aux, aux_bank_.size());
+  return true;
+}
@@ -0,0 +1,166 @@
+#include "emulator/rewind_buffer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+rewind_buffer::rewind_buffer(size_t capacity, size_t keyframe_interval, size_t memory_budget)
+    : slots_(std::max<size_t>(capacity, 1)),
+      keyframe_interval_(std::max<size_t>(keyframe_interval, 1)),
+      memory_budget_(memory_budget)
+{
+}
+
+const uint8_t *rewind_buffer::pageData(const RAM &ram, uint16_t physical_page)
+{
+  const auto &bank = physical_page < BANK_PAGES ? ram.getMainBank() : ram.getAuxBank();
+  return bank.data() + (physical_page % BANK_PAGES) * PAGE_SIZE;
+}
+
+uint8_t *rewind_buffer::pageData(RAM &ram, uint16_t physical_page)
+{
+  auto &bank = physical_page < BANK_PAGES ? ram.getMainBank() : ram.getAuxBank();
+  return bank.data() + (physical_page % BANK_PAGES) * PAGE_SIZE;
+}
+
+void rewind_buffer::capture(const machine_state &state, const RAM &ram, const MMU::DirtyPageMap &dirty)
+{
+  if (count_ == slots_.size())
+  {
+    dropOldest();
+  }
+
+  snapshot &snap = slots_[slot(count_)];
+  release(snap);
+  snap.state = state;
+  snap.keyframe = count_ == 0 || since_keyframe_ + 1 >= keyframe_interval_;
+
+  if (snap.keyframe)
+  {
+    snap.data.resize(MMU::RAM_PAGE_COUNT * PAGE_SIZE);
+    std::memcpy(snap.data.data(), ram.getMainBank().data(), BANK_PAGES * PAGE_SIZE);
+    std::memcpy(snap.data.data() + BANK_PAGES * PAGE_SIZE, ram.getAuxBank().data(), BANK_PAGES * PAGE_SIZE);
+    since_keyframe_ = 0;
+  }
+  else
+  {
+    size_t dirty_count = 0;
+    for (uint64_t word : dirty)
+    {
+      dirty_count += static_cast<size_t>(std::popcount(word));
+    }
+    snap.pages.reserve(dirty_count);
+    snap.data.resize(dirty_count * PAGE_SIZE);
+
+    uint8_t *out = snap.data.data();
+    for (size_t w = 0; w < dirty.size(); ++w)
+    {
+      for (uint64_t bits = dirty[w]; bits != 0; bits &= bits - 1)
+      {
+        uint16_t page = static_cast<uint16_t>(w * 64 + static_cast<size_t>(std::countr_zero(bits)));
+        snap.pages.push_back(page);
+        std::memcpy(out, pageData(ram, page), PAGE_SIZE);
+        out += PAGE_SIZE;
+      }
+    }
+    ++since_keyframe_;
+  }
+
+  memory_used_ += snap.data.size() + snap.pages.size() * sizeof(uint16_t);
+  ++count_;
+
+  while (count_ > 1 && memory_used_ > memory_budget_)
+  {
+    dropOldest();
+  }
+}
+
+bool rewind_buffer::restore(size_t snapshots_back, machine_state &state, RAM &ram)
+{
+  if (count_ == 0)
+  {
+    return false;
+  }
+
+  const size_t target = count_ - 1 - std::min(snapshots_back, count_ - 1);
+
+  // The oldest snapshot is always a keyframe, so this stops
+  size_t key = target;
+  while (!slots_[slot(key)].keyframe)
+  {
+    --key;
+  }
+
+  const snapshot &base = slots_[slot(key)];
+  std::memcpy(ram.getMainBank().data(), base.data.data(), BANK_PAGES * PAGE_SIZE);
+  std::memcpy(ram.getAuxBank().data(), base.data.data() + BANK_PAGES * PAGE_SIZE, BANK_PAGES * PAGE_SIZE);
+
+  for (size_t i = key + 1; i <= target; ++i)
+  {
+    const snapshot &delta = slots_[slot(i)];
+    for (size_t p = 0; p < delta.pages.size(); ++p)
+    {
+      std::memcpy(pageData(ram, delta.pages[p]), delta.data.data() + p * PAGE_SIZE, PAGE_SIZE);
+    }
+  }
+
+  state = slots_[slot(target)].state;
+
+  // The future is gone; the next capture continues from here
+  for (size_t i = target + 1; i < count_; ++i)
+  {
+    release(slots_[slot(i)]);
+  }
+  count_ = target + 1;
+  since_keyframe_ = target - key;
+  return true;
+}
+
+void rewind_buffer::clear()
+{
+  for (snapshot &snap : slots_)
+  {
+    release(snap);
+  }
+  head_ = 0;
+  count_ = 0;
+  since_keyframe_ = 0;
+}
+
+void rewind_buffer::dropOldest()
+{
+  if (count_ == 0)
+  {
+    return;
+  }
+
+  snapshot &oldest = slots_[head_];
+  if (count_ > 1)
+  {
+    snapshot &next = slots_[slot(1)];
+    if (!next.keyframe)
+    {
+      // Apply the next delta to the oldest full copy and hand it over, so
+      // the buffer still starts with a keyframe
+      for (size_t p = 0; p < next.pages.size(); ++p)
+      {
+        std::memcpy(oldest.data.data() + next.pages[p] * PAGE_SIZE, next.data.data() + p * PAGE_SIZE, PAGE_SIZE);
+      }
+      release(next);
+      next.data = std::move(oldest.data);
+      next.keyframe = true;
+      oldest.data = {};
+    }
+  }
+
+  release(oldest);
+  head_ = slot(1);
+  --count_;
+}
+
+void rewind_buffer::release(snapshot &snap)
+{
+  memory_used_ -= snap.data.size() + snap.pages.size() * sizeof(uint16_t);
+  snap.pages = {};
+  snap.data = {};
+  snap.keyframe = false;
+}
@@ -96,6 +96,17 @@ bool ROM::loadFromData(const uint8_t *data, size_t size)
   return true;
 }
 
+bool ROM::loadExpansionFromData(const uint8_t *data, size_t size)
+{
+  if (!data || size != EXPANSION_ROM_SIZE)
+  {
+    return false;
+  }
+
+  std::copy(data, data + size, expansion_rom_.begin());
+  return true;
+}
+
 bool ROM::loadROMAtOffset(const std::string &filepath, size_t offset, size_t size)
 {
   // Use the resource path utility to locate the ROM file
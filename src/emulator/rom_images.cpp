@@ -0,0 +1,58 @@
+#include "emulator/rom_images.hpp"
+#include "utils/logger.hpp"
+#include "utils/resource_path.hpp"
+#include <fstream>
+
+namespace
+{
+constexpr const char *CHARACTER_ROM_PATH = "resources/roms/character/341-0160-A.bin";
+constexpr const char *DISK2_ROM_PATH = "resources/roms/disk/341-0027.bin";
+
+/**
+ * Read a whole resource file
+ * @return false if the file can't be read
+ */
+bool readResource(const char *path, std::vector<uint8_t> &data)
+{
+  std::ifstream file(getResourcePath(path), std::ios::binary | std::ios::ate);
+  if (!file)
+  {
+    return false;
+  }
+
+  data.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!file)
+  {
+    data.clear();
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+std::shared_ptr<const rom_images> rom_images::load()
+{
+  auto images = std::make_shared<rom_images>();
+
+  // ROM knows the system ROM file layouts (one 16KB image or CD + EF chips)
+  ROM rom;
+  if (!rom.loadAppleIIeROMs())
+  {
+    return nullptr;
+  }
+  images->system = rom.getData();
+  images->expansion = rom.getExpansionData();
+
+  if (!readResource(CHARACTER_ROM_PATH, images->character))
+  {
+    LOG_WARNINGF("Character ROM not found: %s", CHARACTER_ROM_PATH);
+  }
+  if (!readResource(DISK2_ROM_PATH, images->disk2))
+  {
+    LOG_WARNINGF("Disk II ROM not found: %s", DISK2_ROM_PATH);
+  }
+
+  return images;
+}
@@ -0,0 +1,302 @@
+#include "emulator/save_state.hpp"
+#include "utils/logger.hpp"
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define A2E_HAVE_MMAP 1
+#endif
+
+// ===== state_writer =====
+
+state_writer::state_writer()
+    : buffer_{save_state::MAGIC[0], save_state::MAGIC[1], save_state::MAGIC[2], save_state::FORMAT_CHUNKED}
+{
+}
+
+void state_writer::beginChunk(uint32_t tag, uint16_t version)
+{
+  if (in_chunk_)
+  {
+    endChunk();
+  }
+
+  chunk_start_ = buffer_.size();
+  in_chunk_ = true;
+  writeU32(tag);
+  writeU16(version);
+  writeU16(0);
+  writeU32(0);  // Size, filled in by endChunk()
+}
+
+void state_writer::endChunk()
+{
+  if (!in_chunk_)
+  {
+    return;
+  }
+
+  uint32_t size = static_cast<uint32_t>(buffer_.size() - chunk_start_ - save_state::CHUNK_HEADER_SIZE);
+  for (int i = 0; i < 4; ++i)
+  {
+    buffer_[chunk_start_ + 8 + i] = static_cast<uint8_t>(size >> (8 * i));
+  }
+  in_chunk_ = false;
+}
+
+void state_writer::writeU16(uint16_t value)
+{
+  writeU8(static_cast<uint8_t>(value));
+  writeU8(static_cast<uint8_t>(value >> 8));
+}
+
+void state_writer::writeU32(uint32_t value)
+{
+  writeU16(static_cast<uint16_t>(value));
+  writeU16(static_cast<uint16_t>(value >> 16));
+}
+
+void state_writer::writeU64(uint64_t value)
+{
+  writeU32(static_cast<uint32_t>(value));
+  writeU32(static_cast<uint32_t>(value >> 32));
+}
+
+void state_writer::writeVarint(uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    writeU8(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  writeU8(static_cast<uint8_t>(value));
+}
+
+void state_writer::writeString(const std::string &value)
+{
+  writeU32(static_cast<uint32_t>(value.size()));
+  writeBytes(value.data(), value.size());
+}
+
+void state_writer::writeBytes(const void *data, size_t size)
+{
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+bool state_writer::saveToFile(const std::string &path) const
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    LOG_ERRORF("Failed to open save file: %s", path.c_str());
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char *>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+  if (!file)
+  {
+    LOG_ERRORF("Error writing save file: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// ===== state_chunk =====
+
+uint8_t state_chunk::readU8()
+{
+  if (pos_ >= size_)
+  {
+    truncated_ = true;
+    return 0;
+  }
+  return data_[pos_++];
+}
+
+uint16_t state_chunk::readU16()
+{
+  uint16_t lo = readU8();
+  return static_cast<uint16_t>(lo | readU8() << 8);
+}
+
+uint32_t state_chunk::readU32()
+{
+  uint32_t lo = readU16();
+  return lo | static_cast<uint32_t>(readU16()) << 16;
+}
+
+uint64_t state_chunk::readU64()
+{
+  uint64_t lo = readU32();
+  return lo | static_cast<uint64_t>(readU32()) << 32;
+}
+
+uint64_t state_chunk::readVarint()
+{
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    uint8_t byte = readU8();
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+    {
+      return value;
+    }
+  }
+  truncated_ = true;  // Over-long encoding
+  return 0;
+}
+
+std::string state_chunk::readString()
+{
+  uint32_t length = readU32();
+  const uint8_t *bytes = readBytes(length);
+  return bytes ? std::string(reinterpret_cast<const char *>(bytes), length) : std::string();
+}
+
+const uint8_t *state_chunk::readBytes(size_t size)
+{
+  if (size > size_ - pos_)
+  {
+    pos_ = size_;
+    truncated_ = true;
+    return nullptr;
+  }
+  const uint8_t *bytes = data_ + pos_;
+  pos_ += size;
+  return bytes;
+}
+
+// ===== state_reader =====
+
+bool state_reader::open(const uint8_t *data, size_t size)
+{
+  chunks_.clear();
+
+  if (size < save_state::HEADER_SIZE ||
+      std::memcmp(data, save_state::MAGIC, sizeof(save_state::MAGIC)) != 0 ||
+      data[3] != save_state::FORMAT_CHUNKED)
+  {
+    return false;
+  }
+
+  size_t pos = save_state::HEADER_SIZE;
+  while (pos < size)
+  {
+    if (size - pos < save_state::CHUNK_HEADER_SIZE)
+    {
+      LOG_ERROR("Save state truncated in a chunk header");
+      return false;
+    }
+
+    state_chunk header(0, 0, data + pos, save_state::CHUNK_HEADER_SIZE);
+    uint32_t tag = header.readU32();
+    uint16_t version = header.readU16();
+    header.readU16();  // Reserved
+    uint32_t chunk_size = header.readU32();
+    pos += save_state::CHUNK_HEADER_SIZE;
+
+    if (chunk_size > size - pos)
+    {
+      LOG_ERROR("Save state truncated in a chunk payload");
+      return false;
+    }
+
+    chunks_.emplace_back(tag, version, data + pos, chunk_size);
+    pos += chunk_size;
+  }
+  return true;
+}
+
+bool state_reader::findChunk(uint32_t tag, state_chunk &chunk) const
+{
+  for (const state_chunk &candidate : chunks_)
+  {
+    if (candidate.getTag() == tag)
+    {
+      chunk = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+// ===== mapped_file =====
+
+mapped_file::~mapped_file()
+{
+  close();
+}
+
+bool mapped_file::open(const std::string &path)
+{
+  close();
+
+#ifdef A2E_HAVE_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ > 0)
+  {
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+    data_ = static_cast<const uint8_t *>(mapping);
+    mapped_ = true;
+  }
+  ::close(fd);
+  return true;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file)
+  {
+    return false;
+  }
+
+  fallback_.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(fallback_.data()), static_cast<std::streamsize>(fallback_.size()));
+  if (!file)
+  {
+    fallback_.clear();
+    return false;
+  }
+  data_ = fallback_.data();
+  size_ = fallback_.size();
+  return true;
+#endif
+}
+
+void mapped_file::close()
+{
+#ifdef A2E_HAVE_MMAP
+  if (mapped_)
+  {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  fallback_.clear();
+}
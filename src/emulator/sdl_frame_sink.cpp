@@ -0,0 +1,43 @@
+#include "emulator/sdl_frame_sink.hpp"
+#include "utils/logger.hpp"
+#include <SDL3/SDL.h>
+
+sdl_frame_sink::~sdl_frame_sink()
+{
+  if (texture_)
+  {
+    SDL_DestroyTexture(texture_);
+    texture_ = nullptr;
+  }
+}
+
+bool sdl_frame_sink::present(const video_frame &frame)
+{
+  if (!texture_)
+  {
+    // ABGR8888 is a packed 32-bit format, so it matches the frame's pixels
+    // (R in the low byte) on any host
+    texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING,
+                                 frame.stride, frame.height);
+    if (!texture_)
+    {
+      LOG_ERRORF("Failed to create SDL texture: %s", SDL_GetError());
+      return false;
+    }
+    SDL_SetTextureScaleMode(texture_, SDL_SCALEMODE_NEAREST);
+  }
+  if (frame.changed_line_count <= 0)
+  {
+    return true;
+  }
+
+  // Upload just the band of scanlines the last update changed
+  const SDL_Rect band = {0, frame.first_changed_line, frame.stride, frame.changed_line_count};
+  if (!SDL_UpdateTexture(texture_, &band, frame.pixels + frame.first_changed_line * frame.stride,
+                         frame.stride * static_cast<int>(sizeof(uint32_t))))
+  {
+    LOG_ERRORF("Failed to update SDL texture: %s", SDL_GetError());
+    return false;
+  }
+  return true;
+}
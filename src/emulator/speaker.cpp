@@ -1,6 +1,4 @@
 #include "emulator/speaker.hpp"
-#include <AudioToolbox/AudioToolbox.h>
-#include <CoreFoundation/CoreFoundation.h>
 #include <cstring>
 #include <algorithm>
 #include <iostream>
@@ -28,23 +26,6 @@ Speaker::~Speaker()
   shutdown();
 }
 
-void Speaker::audioQueueCallback(void* userData,
-                                  AudioQueueRef queue,
-                                  AudioQueueBufferRef buffer)
-{
-  auto* speaker = static_cast<Speaker*>(userData);
-  auto* out = static_cast<int16_t*>(buffer->mAudioData);
-  uint32_t frames = buffer->mAudioDataByteSize / sizeof(int16_t);
-  
-  {
-    std::lock_guard<std::mutex> lock(speaker->buffer_mutex_);
-    speaker->fillAudioBuffer(frames, out);
-  }
-  
-  // Re-enqueue the buffer
-  AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr);
-}
-
 void Speaker::fillAudioBuffer(uint32_t framesPerBuffer, int16_t* out)
 {
   // Calculate available samples
@@ -100,7 +81,7 @@ void Speaker::fillAudioBuffer(uint32_t framesPerBuffer, int16_t* out)
   }
 }
 
-bool Speaker::initialize()
+bool Speaker::initialize(std::unique_ptr<audio_sink> sink)
 {
   if (initialized_)
   {
@@ -113,78 +94,29 @@ bool Speaker::initialize()
     return false;
   }
 
-  // Set up the audio format
-  AudioStreamBasicDescription format = {};
-  format.mSampleRate = SAMPLE_RATE;
-  format.mFormatID = kAudioFormatLinearPCM;
-  format.mFormatFlags = kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked;
-  format.mBitsPerChannel = BITS_PER_SAMPLE;
-  format.mChannelsPerFrame = CHANNELS;
-  format.mBytesPerFrame = (BITS_PER_SAMPLE / 8) * CHANNELS;
-  format.mFramesPerPacket = 1;
-  format.mBytesPerPacket = format.mBytesPerFrame;
-
-  // Create the audio queue with NULL run loop - uses internal audio thread
-  OSStatus status = AudioQueueNewOutput(
-    &format,
-    audioQueueCallback,
-    this,
-    NULL,
-    NULL,
-    0,
-    &audioQueue_
-  );
-
-  if (status != noErr)
+  if (!sink)
   {
-    std::cerr << "AudioQueueNewOutput error: " << status << std::endl;
     return false;
   }
 
-  // Allocate and enqueue buffers
-  uint32_t bufferSize = FRAMES_PER_BUFFER * sizeof(int16_t);
-  for (int i = 0; i < NUM_BUFFERS; i++)
-  {
-    status = AudioQueueAllocateBuffer(audioQueue_, bufferSize, &audioBuffers_[i]);
-    if (status != noErr)
-    {
-      std::cerr << "AudioQueueAllocateBuffer error: " << status << std::endl;
-      AudioQueueDispose(audioQueue_, true);
-      audioQueue_ = nullptr;
-      return false;
-    }
-    
-    // Initialize buffer with silence
-    audioBuffers_[i]->mAudioDataByteSize = bufferSize;
-    memset(audioBuffers_[i]->mAudioData, 0, bufferSize);
-    
-    // Enqueue the buffer
-    status = AudioQueueEnqueueBuffer(audioQueue_, audioBuffers_[i], 0, nullptr);
-    if (status != noErr)
-    {
-      std::cerr << "AudioQueueEnqueueBuffer error: " << status << std::endl;
-      AudioQueueDispose(audioQueue_, true);
-      audioQueue_ = nullptr;
-      return false;
-    }
-  }
-
   // Pre-fill ring buffer before starting
   read_pos_ = 0;
   write_pos_ = buffer_size_ / 2;
 
-  // Start the audio queue
-  status = AudioQueueStart(audioQueue_, nullptr);
-  if (status != noErr)
+  bool opened = sink->open(SAMPLE_RATE, FRAMES_PER_BUFFER, [this](int16_t *out, uint32_t frames)
+  {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    fillAudioBuffer(frames, out);
+  });
+  if (!opened)
   {
-    std::cerr << "AudioQueueStart error: " << status << std::endl;
-    AudioQueueDispose(audioQueue_, true);
-    audioQueue_ = nullptr;
     return false;
   }
 
+  sink_ = std::move(sink);
   initialized_ = true;
-  std::cout << "Speaker initialized with CoreAudio (sample rate: " << SAMPLE_RATE << " Hz)" << std::endl;
+  std::cout << "Speaker initialized with " << sink_->getName()
+            << " (sample rate: " << SAMPLE_RATE << " Hz)" << std::endl;
   return true;
 }
 
@@ -197,17 +129,10 @@ void Speaker::shutdown()
 
   initialized_ = false;
 
-  if (audioQueue_)
+  if (sink_)
   {
-    AudioQueueStop(audioQueue_, true);
-    AudioQueueDispose(audioQueue_, true);
-    audioQueue_ = nullptr;
-  }
-  
-  // Clear buffer pointers (memory freed by AudioQueueDispose)
-  for (int i = 0; i < NUM_BUFFERS; i++)
-  {
-    audioBuffers_[i] = nullptr;
+    sink_->close();
+    sink_.reset();
   }
 }
 
@@ -219,6 +144,14 @@ void Speaker::toggle(uint64_t cycle)
     return;
   }
 
+  // Warp: keep the state and clock, skip the samples
+  if (suspended_)
+  {
+    last_cpu_cycle_ = cycle;
+    speaker_state_ = !speaker_state_;
+    return;
+  }
+
   // Generate samples up to this cycle with the current state
   if (cycle > last_cpu_cycle_)
   {
@@ -284,7 +217,7 @@ void Speaker::generateSamples(uint64_t cycles_to_process)
 
 void Speaker::update(uint64_t current_cycle)
 {
-  if (!initialized_)
+  if (!initialized_ || suspended_)
   {
     return;
   }
@@ -339,3 +272,22 @@ float Speaker::getBufferFillPercentage() const
   
   return static_cast<float>(available) / static_cast<float>(buffer_size_);
 }
+
+void Speaker::saveState(state_writer &out) const
+{
+  out.beginChunk(STATE_TAG, STATE_VERSION);
+  out.writeBool(speaker_state_);
+  out.endChunk();
+}
+
+bool Speaker::loadState(state_chunk &chunk)
+{
+  bool high = chunk.readBool();
+  if (chunk.isTruncated())
+  {
+    return false;
+  }
+
+  speaker_state_ = high;
+  return true;
+}
@@ -0,0 +1,62 @@
+#include "emulator/text_screen.hpp"
+#include "emulator/emulator.hpp"
+
+namespace
+{
+// Text screen row offsets from the page base
+constexpr uint16_t TEXT_ROW_OFFSETS[24] = {
+    0x000, 0x080, 0x100, 0x180, 0x200, 0x280, 0x300, 0x380,
+    0x028, 0x0A8, 0x128, 0x1A8, 0x228, 0x2A8, 0x328, 0x3A8,
+    0x050, 0x0D0, 0x150, 0x1D0, 0x250, 0x2D0, 0x350, 0x3D0};
+} // namespace
+
+char screenCodeToAscii(uint8_t code)
+{
+  uint8_t c = code & 0x7F;
+  if (code < 0x80 && c >= 0x40)
+  {
+    c -= 0x40;  // Flashing characters repeat the inverse ones
+  }
+  if (c < 0x20)
+  {
+    c += 0x40;  // @, A-Z, [\]^_
+  }
+  return (c >= 0x20 && c < 0x7F) ? static_cast<char>(c) : ' ';
+}
+
+std::vector<std::string> readTextScreen(const emulator &emu)
+{
+  Apple2e::SoftSwitchState state = emu.getSoftSwitchState();
+  const uint16_t base = (!state.store80 && state.page_select == Apple2e::PageSelect::PAGE2) ? 0x0800 : 0x0400;
+  const auto &main_ram = emu.getMainRAM();
+  const auto &aux_ram = emu.getAuxRAM();
+
+  std::vector<std::string> lines;
+  for (uint16_t offset : TEXT_ROW_OFFSETS)
+  {
+    std::string line;
+    for (uint16_t col = 0; col < 40; ++col)
+    {
+      uint16_t address = static_cast<uint16_t>(base + offset + col);
+      if (state.col80_mode)
+      {
+        line += screenCodeToAscii(aux_ram[address]);
+      }
+      line += screenCodeToAscii(main_ram[address]);
+    }
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+bool screenContains(const emulator &emu, const std::string &text)
+{
+  for (const std::string &line : readTextScreen(emu))
+  {
+    if (line.find(text) != std::string::npos)
+    {
+      return true;
+    }
+  }
+  return false;
+}
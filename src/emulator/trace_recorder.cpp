@@ -0,0 +1,241 @@
+#include "emulator/trace_recorder.hpp"
+#include "emulator/disassembler.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+namespace
+{
+// How long the writer sleeps when the ring is empty
+constexpr auto WRITER_IDLE = std::chrono::microseconds(500);
+
+bool writeHeader(std::ofstream &file)
+{
+  const uint16_t record_size = sizeof(trace_record);
+  const uint8_t header[trace_format::HEADER_SIZE] = {
+      trace_format::MAGIC[0], trace_format::MAGIC[1], trace_format::MAGIC[2], trace_format::MAGIC[3],
+      static_cast<uint8_t>(trace_format::VERSION), static_cast<uint8_t>(trace_format::VERSION >> 8),
+      static_cast<uint8_t>(record_size), static_cast<uint8_t>(record_size >> 8)};
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  return static_cast<bool>(file);
+}
+} // namespace
+
+trace_recorder::trace_recorder(size_t capacity)
+    : capacity_(std::bit_ceil(std::max<size_t>(capacity, 2)))
+{
+}
+
+trace_recorder::~trace_recorder()
+{
+  stopStreaming();
+}
+
+void trace_recorder::setEnabled(bool enabled)
+{
+  if (enabled && ring_.empty())
+  {
+    ring_.resize(capacity_);
+    mask_ = capacity_ - 1;
+  }
+  enabled_ = enabled;
+  in_instruction_ = false;
+}
+
+void trace_recorder::beginInstruction(uint64_t cycle, uint16_t pc, const uint8_t (&bytes)[3],
+                                      uint8_t a, uint8_t x, uint8_t y, uint8_t p, uint8_t sp)
+{
+  const int length = disassembler::OPCODES[bytes[0]].bytes;
+
+  current_ = trace_record{};
+  current_.cycle = cycle;
+  current_.pc = pc;
+  for (int i = 0; i < length; ++i)
+  {
+    current_.bytes[i] = bytes[i];
+  }
+  current_.a = a;
+  current_.x = x;
+  current_.y = y;
+  current_.p = p;
+  current_.sp = sp;
+
+  fetches_left_ = static_cast<uint8_t>(length);
+  next_fetch_ = pc;
+  in_instruction_ = true;
+}
+
+void trace_recorder::endInstruction()
+{
+  if (!in_instruction_)
+  {
+    return;
+  }
+  in_instruction_ = false;
+  ++recorded_;
+
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (streaming_ && head - tail_.load(std::memory_order_acquire) >= capacity_)
+  {
+    if (!lossless_)
+    {
+      // The writer is behind; don't wait for it
+      ++dropped_;
+      gap_ = true;
+      return;
+    }
+    while (head - tail_.load(std::memory_order_acquire) >= capacity_)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  if (gap_)
+  {
+    current_.flags |= trace_record::FLAG_GAP;
+    gap_ = false;
+  }
+  ring_[head & mask_] = current_;
+  head_.store(head + 1, std::memory_order_release);
+}
+
+bool trace_recorder::startStreaming(const std::string &path)
+{
+  stopStreaming();
+
+  if (ring_.empty())
+  {
+    ring_.resize(capacity_);
+    mask_ = capacity_ - 1;
+  }
+
+  stream_.open(path, std::ios::binary | std::ios::trunc);
+  if (!stream_ || !writeHeader(stream_))
+  {
+    LOG_ERRORF("Failed to create trace file: %s", path.c_str());
+    stream_.close();
+    return false;
+  }
+
+  // Stream only what is recorded from here on
+  tail_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  dropped_ = 0;
+  gap_ = false;
+  stop_writer_.store(false);
+  write_failed_.store(false);
+  streaming_ = true;
+  writer_ = std::thread(&trace_recorder::writerLoop, this);
+
+  LOG_INFOF("Streaming execution trace to %s", path.c_str());
+  return true;
+}
+
+bool trace_recorder::stopStreaming()
+{
+  if (!streaming_)
+  {
+    return true;
+  }
+
+  stop_writer_.store(true, std::memory_order_release);
+  writer_.join();
+  streaming_ = false;
+  stream_.close();
+
+  const bool ok = !write_failed_.load() && !stream_.fail();
+  if (!ok)
+  {
+    LOG_ERROR("Error writing trace file");
+  }
+  if (dropped_ > 0)
+  {
+    LOG_WARNINGF("Trace writer fell behind; %llu records dropped",
+                 static_cast<unsigned long long>(dropped_));
+  }
+  return ok;
+}
+
+void trace_recorder::writerLoop()
+{
+  for (;;)
+  {
+    // Read the stop flag first: once it is set, head_ holds every record
+    const bool stopping = stop_writer_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+
+    if (head == tail)
+    {
+      if (stopping)
+      {
+        return;
+      }
+      std::this_thread::sleep_for(WRITER_IDLE);
+      continue;
+    }
+
+    // Write up to the end of the ring in one piece; the rest goes next pass
+    const size_t start = static_cast<size_t>(tail & mask_);
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(head - tail, capacity_ - start));
+    if (!write_failed_.load(std::memory_order_relaxed))
+    {
+      stream_.write(reinterpret_cast<const char *>(&ring_[start]),
+                    static_cast<std::streamsize>(count * sizeof(trace_record)));
+      if (!stream_)
+      {
+        write_failed_.store(true, std::memory_order_relaxed);
+      }
+    }
+    tail_.store(tail + count, std::memory_order_release);
+  }
+}
+
+bool trace_recorder::saveBuffer(const std::string &path) const
+{
+  if (streaming_)
+  {
+    LOG_ERROR("Can't save the trace buffer while streaming");
+    return false;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file || !writeHeader(file))
+  {
+    LOG_ERRORF("Failed to create trace file: %s", path.c_str());
+    return false;
+  }
+
+  // Oldest first, in up to two pieces around the end of the ring
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  for (uint64_t pos = head - getBufferedCount(); pos < head;)
+  {
+    const size_t start = static_cast<size_t>(pos & mask_);
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(head - pos, capacity_ - start));
+    file.write(reinterpret_cast<const char *>(&ring_[start]),
+               static_cast<std::streamsize>(count * sizeof(trace_record)));
+    pos += count;
+  }
+
+  if (!file)
+  {
+    LOG_ERRORF("Error writing trace file: %s", path.c_str());
+    return false;
+  }
+  LOG_INFOF("Saved %zu trace records to %s", getBufferedCount(), path.c_str());
+  return true;
+}
+
+void trace_recorder::clear()
+{
+  if (!streaming_)
+  {
+    tail_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+}
+
+size_t trace_recorder::getBufferedCount() const
+{
+  const uint64_t held = head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+  return static_cast<size_t>(std::min<uint64_t>(held, ring_.size()));
+}
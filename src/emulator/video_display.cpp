@@ -0,0 +1,767 @@
+#include "emulator/video_display.hpp"
+#include "apple2e/memory_map.hpp"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+video_display::video_display()
+{
+  // Initialize frame buffer
+  frame_buffer_.resize(DISPLAY_WIDTH * DISPLAY_HEIGHT, COLOR_BLACK);
+
+  // Initialize character ROM to empty
+  char_rom_.fill(0x00);
+
+  buildHiResTable();
+  buildGlyphAtlas();
+}
+
+video_display::~video_display() = default;
+
+void video_display::setMemory(std::span<const uint8_t, 65536> main, std::span<const uint8_t, 65536> aux)
+{
+  main_memory_ = main;
+  aux_memory_ = aux;
+  full_redraw_ = true;
+}
+
+void video_display::setSoftSwitches(const Apple2e::SoftSwitchState &switches)
+{
+  soft_switches_ = &switches;
+  full_redraw_ = true;
+}
+
+void video_display::setDirtyCallback(std::function<video_dirty_map()> callback)
+{
+  dirty_callback_ = std::move(callback);
+  full_redraw_ = true;
+}
+
+void video_display::setSwitchLog(const video_switch_log &log, std::function<uint64_t()> cycle_callback)
+{
+  switch_log_ = &log;
+  cycle_callback_ = std::move(cycle_callback);
+  full_redraw_ = true;
+}
+
+void video_display::setColorFringing(bool enabled)
+{
+  if (enabled != color_fringing_enabled_)
+  {
+    color_fringing_enabled_ = enabled;
+    buildHiResTable();
+  }
+}
+
+void video_display::setVideoStandard(VideoStandard standard)
+{
+  if (standard != video_standard_)
+  {
+    video_standard_ = standard;
+    buildHiResTable();
+  }
+}
+
+bool video_display::loadCharacterROM(const std::string &filepath)
+{
+  std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open character ROM: " << filepath << std::endl;
+    return false;
+  }
+
+  std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+  file.seekg(0, std::ios::beg);
+  file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!file)
+  {
+    std::cerr << "Failed to read character ROM data: " << filepath << std::endl;
+    return false;
+  }
+
+  if (!loadCharacterROM(data.data(), data.size()))
+  {
+    return false;
+  }
+  std::cout << "Loaded character ROM: " << filepath << std::endl;
+  return true;
+}
+
+bool video_display::loadCharacterROM(const uint8_t *data, size_t size)
+{
+  if (!data || size < CHAR_SET_SIZE)
+  {
+    std::cerr << "Character ROM too small: " << size << " bytes" << std::endl;
+    return false;
+  }
+
+  // Apple IIe character ROM layout (8KB total):
+  // $0000-$07FF: Primary character set (normal characters)
+  // $0800-$0FFF: Primary set repeated
+  // $1000-$17FF: Alternate character set (MouseText at $40-$5F)
+  // $1800-$1FFF: Alternate set repeated
+  //
+  // We load primary from offset $0000 and alternate from offset $1000
+  std::memcpy(char_rom_.data(), data, CHAR_SET_SIZE);
+
+  if (size >= 0x1800) // Need at least $1000 + 2KB
+  {
+    std::memcpy(char_rom_.data() + CHAR_ROM_ALT_OFFSET, data + 0x1000, CHAR_SET_SIZE);
+  }
+  else
+  {
+    // No alternate set - copy primary set as fallback
+    std::memcpy(char_rom_.data() + CHAR_ROM_ALT_OFFSET, char_rom_.data(), CHAR_SET_SIZE);
+  }
+
+  char_rom_loaded_ = true;
+  buildGlyphAtlas();
+  full_redraw_ = true;
+  return true;
+}
+
+bool video_display::update()
+{
+  changed_first_line_ = DISPLAY_HEIGHT;
+  changed_last_line_ = -1;
+
+  if (main_memory_.empty())
+  {
+    return false;
+  }
+
+  // Take the video mode from the soft switches once per frame; the row
+  // renderers work from this copy
+  video_state_ = soft_switches_ ? *soft_switches_ : Apple2e::SoftSwitchState();
+
+  // 80-column text or double graphics make the whole frame 560 wide
+  updateColumnModes();
+  current_display_width_ = (effective_col80_mode_ || double_graphics_) ? DISPLAY_WIDTH_80 : DISPLAY_WIDTH_40;
+
+  // Update flash state (for text mode flashing characters)
+  bool flash_toggled = false;
+  flash_counter_++;
+  if (flash_counter_ >= FLASH_RATE)
+  {
+    flash_counter_ = 0;
+    flash_state_ = !flash_state_;
+    flash_toggled = true;
+  }
+
+  const bool page2 = showsPage2();
+  const render_key key{video_state_.video_mode, video_state_.graphics_mode, video_state_.screen_mode,
+                       page2, effective_col80_mode_, double_graphics_, video_state_.altchar_mode,
+                       video_standard_, color_fringing_enabled_, green_text_};
+
+  // Always take the marks so they don't pile up across a full redraw
+  video_dirty_map dirty;
+  if (dirty_callback_)
+  {
+    dirty = dirty_callback_();
+  }
+
+  // A mode change part way down the last scanned frame: draw it line by
+  // line, and redraw in full once the switches settle again
+  uint64_t frame_start = 0;
+  if (findMidFrameChanges(frame_start))
+  {
+    renderScannedFrame(frame_start);
+    full_redraw_ = true;
+    return true;
+  }
+
+  // Anything that changes how the same memory looks redraws everything,
+  // clearing first so a narrower mode leaves no stale pixels behind.
+  // Without a dirty callback every frame is a full redraw.
+  const bool full = full_redraw_ || !dirty_callback_ || key != render_key_;
+  if (full)
+  {
+    std::fill(frame_buffer_.begin(), frame_buffer_.end(), COLOR_BLACK);
+    render_key_ = key;
+    full_redraw_ = false;
+    flash_rows_ = 0;
+  }
+
+  // Scanlines above graphics_end show the graphics page, the rest text
+  const int graphics_end = graphicsLines();
+  const bool hires = video_state_.graphics_mode == Apple2e::GraphicsMode::HIRES;
+
+  if (hires && graphics_end > 0)
+  {
+    // Double hi-res also shows the aux copy of the page
+    const auto hires_source = page2 ? video_dirty_map::HIRES2 : video_dirty_map::HIRES1;
+    const auto &lines = dirty.get(hires_source, false);
+    const auto &aux_lines = dirty.get(hires_source, true);
+    for (int line = 0; line < graphics_end; line++)
+    {
+      uint64_t marks = lines[line >> 6];
+      if (double_graphics_)
+      {
+        marks |= aux_lines[line >> 6];
+      }
+      if (full || ((marks >> (line & 63)) & 1))
+      {
+        renderHiResLine(line);
+        markChanged(line, line);
+      }
+    }
+  }
+
+  // Text and lo-res rows (80-column text always comes from page 1). The
+  // aux copy shows in 80-column text and double lo-res
+  const auto lores_source = page2 ? video_dirty_map::TEXT2 : video_dirty_map::TEXT1;
+  const auto text_source = (page2 && !effective_col80_mode_) ? video_dirty_map::TEXT2 : video_dirty_map::TEXT1;
+  for (int row = 0; row < TEXT_HEIGHT; row++)
+  {
+    const int first_line = row * GLYPH_HEIGHT;
+    const bool graphics = first_line < graphics_end;
+    if (graphics && hires)
+    {
+      continue;
+    }
+
+    const auto source = graphics ? lores_source : text_source;
+    const bool aux_shown = graphics ? double_graphics_ : effective_col80_mode_;
+    bool redraw = full || rowDirty(dirty.get(source, false), row) ||
+                  (aux_shown && rowDirty(dirty.get(source, true), row));
+    if (!graphics)
+    {
+      redraw = redraw || (flash_toggled && ((flash_rows_ >> row) & 1));
+    }
+    if (!redraw)
+    {
+      continue;
+    }
+
+    if (graphics)
+    {
+      renderLoResRow(row);
+    }
+    else
+    {
+      renderTextRow(row);
+    }
+    markChanged(first_line, first_line + GLYPH_HEIGHT - 1);
+  }
+
+  return changed_last_line_ >= 0;
+}
+
+bool video_display::showsPage2() const
+{
+  // When 80STORE is active, PAGE2 controls bank switching, not page selection
+  return !video_state_.store80 && video_state_.page_select == Apple2e::PageSelect::PAGE2;
+}
+
+void video_display::updateColumnModes()
+{
+  // 80COL widens the text window (all of it, or the bottom four rows in
+  // mixed mode) and, with DHIRES, the graphics
+  const bool graphics = video_state_.video_mode == Apple2e::VideoMode::GRAPHICS;
+  effective_col80_mode_ = video_state_.col80_mode &&
+                          (!graphics || video_state_.screen_mode == Apple2e::ScreenMode::MIXED);
+  double_graphics_ = graphics && video_state_.col80_mode && video_state_.dhires;
+}
+
+int video_display::graphicsLines() const
+{
+  if (video_state_.video_mode != Apple2e::VideoMode::GRAPHICS)
+  {
+    return 0;
+  }
+  return video_state_.screen_mode == Apple2e::ScreenMode::MIXED ? MIXED_GRAPHICS_LINES : DISPLAY_HEIGHT;
+}
+
+bool video_display::findMidFrameChanges(uint64_t &frame_start) const
+{
+  if (!switch_log_ || !cycle_callback_)
+  {
+    return false;
+  }
+
+  // Until the beam reaches vertical blank, the current frame's visible
+  // scanlines are only partly scanned and the one before is shown
+  const uint64_t now = cycle_callback_();
+  uint64_t start = now - now % Apple2e::CYCLES_PER_VIDEO_FRAME;
+  if (now - start < Apple2e::VBL_START_CYCLE)
+  {
+    if (start < Apple2e::CYCLES_PER_VIDEO_FRAME)
+    {
+      return false;
+    }
+    start -= Apple2e::CYCLES_PER_VIDEO_FRAME;
+  }
+
+  // Changes during vertical blank (page flipping) don't split the frame
+  const uint64_t last_line = start + (Apple2e::VISIBLE_SCANLINES - 1) * Apple2e::CYCLES_PER_SCANLINE;
+  if (!switch_log_->covers(start) || !switch_log_->changedBetween(start, last_line))
+  {
+    return false;
+  }
+  frame_start = start;
+  return true;
+}
+
+void video_display::renderScannedFrame(uint64_t frame_start)
+{
+  const Apple2e::SoftSwitchState current = video_state_;
+  const uint8_t current_bits = video_switch_log::pack(current);
+
+  // The switches each scanline was scanned with. If any shows 80-column
+  // text or double graphics the frame is 560 wide, and the renderers double
+  // 280-pixel lines to match.
+  std::array<uint8_t, DISPLAY_HEIGHT> line_bits;
+  bool wide = false;
+  for (int line = 0; line < DISPLAY_HEIGHT; line++)
+  {
+    const uint8_t bits = switch_log_->bitsAt(frame_start + line * Apple2e::CYCLES_PER_SCANLINE, current_bits);
+    const bool text = (bits & video_switch_log::TEXT) ||
+                      ((bits & video_switch_log::MIXED) && line >= MIXED_GRAPHICS_LINES);
+    wide = wide || ((bits & video_switch_log::COL80) && (text || (bits & video_switch_log::DHIRES)));
+    line_bits[line] = bits;
+  }
+  current_display_width_ = wide ? DISPLAY_WIDTH_80 : DISPLAY_WIDTH_40;
+  std::fill(frame_buffer_.begin(), frame_buffer_.end(), COLOR_BLACK);
+
+  // Draw each run of scanlines that share a mode
+  int first = 0;
+  while (first < DISPLAY_HEIGHT)
+  {
+    int end = first + 1;
+    while (end < DISPLAY_HEIGHT && line_bits[end] == line_bits[first])
+    {
+      end++;
+    }
+
+    video_state_ = current;
+    video_switch_log::unpack(line_bits[first], video_state_);
+    updateColumnModes();
+    renderLines(first, end);
+    first = end;
+  }
+
+  video_state_ = current;
+  updateColumnModes();
+  markChanged(0, DISPLAY_HEIGHT - 1);
+}
+
+void video_display::renderLines(int first_line, int end_line)
+{
+  const int graphics_end = graphicsLines();
+  const bool hires = video_state_.graphics_mode == Apple2e::GraphicsMode::HIRES;
+
+  int line = first_line;
+  while (line < end_line)
+  {
+    if (line < graphics_end && hires)
+    {
+      renderHiResLine(line);
+      line++;
+      continue;
+    }
+
+    // Text and lo-res draw the part of the row inside the run
+    const int row = line / GLYPH_HEIGHT;
+    const int stop = std::min(end_line, (row + 1) * GLYPH_HEIGHT);
+    if (line < graphics_end)
+    {
+      renderLoResRow(row, line - row * GLYPH_HEIGHT, stop - row * GLYPH_HEIGHT);
+    }
+    else
+    {
+      renderTextRow(row, line - row * GLYPH_HEIGHT, stop - row * GLYPH_HEIGHT);
+    }
+    line = stop;
+  }
+}
+
+void video_display::widenLine(int line)
+{
+  // Right to left, so no pixel is overwritten before it is copied
+  uint32_t *out = &frame_buffer_[line * DISPLAY_WIDTH];
+  for (int x = DISPLAY_WIDTH_40 - 1; x >= 0; x--)
+  {
+    const uint32_t pixel = out[x];
+    out[2 * x] = pixel;
+    out[2 * x + 1] = pixel;
+  }
+}
+
+bool video_display::rowDirty(const video_dirty_map::scanline_bits &lines, int row)
+{
+  // A text row's 8 scanlines share a byte of the bitmap
+  return ((lines[row >> 3] >> ((row & 7) * 8)) & 0xFF) != 0;
+}
+
+void video_display::markChanged(int first_line, int last_line)
+{
+  changed_first_line_ = std::min(changed_first_line_, first_line);
+  changed_last_line_ = std::max(changed_last_line_, last_line);
+}
+
+void video_display::renderTextRow(int row, int from, int to)
+{
+  if (!char_rom_loaded_)
+  {
+    return;
+  }
+
+  // Glyphs for the current character set and flash phase
+  const uint32_t *glyphs = &glyph_atlas_[glyphIndex(0, video_state_.altchar_mode, flash_state_) * GLYPH_PIXELS];
+  uint32_t *out = &frame_buffer_[row * GLYPH_HEIGHT * DISPLAY_WIDTH];
+
+  bool flashing = false;
+  if (effective_col80_mode_)
+  {
+    // 80-column mode only uses page 1. Memory interleaving: even columns
+    // (0,2,4...) from AUX, odd columns (1,3,5...) from MAIN, each bank
+    // holding 40 characters of the row
+    const uint16_t row_addr = TEXT_PAGE1_BASE + ROW_OFFSETS[row];
+    for (int col = 0; col < TEXT_WIDTH_80; col++)
+    {
+      uint16_t addr = row_addr + (col / 2);
+      uint8_t ch = ((col % 2) == 0) ? aux_memory_[addr] : main_memory_[addr];
+      flashing = flashing || (ch & 0xC0) == 0x40;
+      drawGlyph(out + col * GLYPH_WIDTH, glyphs + ch * GLYPH_PIXELS, from, to);
+    }
+  }
+  else
+  {
+    const uint16_t row_addr = (showsPage2() ? TEXT_PAGE2_BASE : TEXT_PAGE1_BASE) + ROW_OFFSETS[row];
+    for (int col = 0; col < TEXT_WIDTH_40; col++)
+    {
+      uint8_t ch = main_memory_[row_addr + col];
+      flashing = flashing || (ch & 0xC0) == 0x40;
+      drawGlyph(out + col * GLYPH_WIDTH, glyphs + ch * GLYPH_PIXELS, from, to);
+    }
+  }
+
+  // 40-column text in a 560-wide frame
+  if (!effective_col80_mode_ && current_display_width_ == DISPLAY_WIDTH_80)
+  {
+    for (int y = from; y < to; y++)
+    {
+      widenLine(row * GLYPH_HEIGHT + y);
+    }
+  }
+
+  // Remember which rows need redrawing when the flash state toggles
+  if (flashing)
+  {
+    flash_rows_ |= 1u << row;
+  }
+  else
+  {
+    flash_rows_ &= ~(1u << row);
+  }
+}
+
+uint16_t video_display::hiResLineAddress(int line) const
+{
+  // Memory address for this line using the Apple II interleaved layout
+  uint16_t line_offset = ((line % 8) * 0x400) +
+                         ((line / 64) * 0x28) +
+                         (((line / 8) % 8) * 0x80);
+  return (showsPage2() ? HIRES_PAGE2_BASE : HIRES_PAGE1_BASE) + line_offset;
+}
+
+void video_display::renderHiResLine(int line)
+{
+  if (double_graphics_)
+  {
+    renderDoubleHiResLine(line);
+    return;
+  }
+  const uint16_t line_addr = hiResLineAddress(line);
+
+  // Each line is 40 bytes, each byte represents 7 pixels. Copy the line
+  // with a zero byte either side for the edges
+  uint8_t bytes[42] = {};
+  std::memcpy(bytes + 1, main_memory_.data() + line_addr, 40);
+
+  uint32_t *out = &frame_buffer_[line * DISPLAY_WIDTH];
+  for (int col = 0; col < 40; col++)
+  {
+    const size_t index = ((bytes[col] >> 6) & 1) | (bytes[col + 1] << 1) |
+                         ((bytes[col + 2] & 1) << 9) | ((col & 3) << 10);
+    std::memcpy(out + col * 7, hires_table_[index].data(), 7 * sizeof(uint32_t));
+  }
+
+  // Single hi-res in a 560-wide frame (mixed with 80-column text)
+  if (current_display_width_ == DISPLAY_WIDTH_80)
+  {
+    widenLine(line);
+  }
+}
+
+void video_display::renderDoubleHiResLine(int line)
+{
+  const uint16_t line_addr = hiResLineAddress(line);
+  const uint8_t *aux = aux_memory_.data() + line_addr;
+  const uint8_t *main = main_memory_.data() + line_addr;
+
+  // A pair of columns is 28 dots (aux, main, aux, main; 7 bits each, bit 7
+  // unused) and so exactly 7 four-dot color cells, copied from dhgr_table_
+  uint32_t *out = &frame_buffer_[line * DISPLAY_WIDTH];
+  for (int col = 0; col < 40; col += 2)
+  {
+    const uint32_t dots = (aux[col] & 0x7Fu) | (main[col] & 0x7Fu) << 7 |
+                          (aux[col + 1] & 0x7Fu) << 14 | (main[col + 1] & 0x7Fu) << 21;
+    uint32_t *cells = out + col * 14;
+    for (int cell = 0; cell < 7; cell++)
+    {
+      std::memcpy(cells + cell * 4, dhgr_table_[(dots >> (cell * 4)) & 0x0F].data(), 4 * sizeof(uint32_t));
+    }
+  }
+}
+
+void video_display::buildHiResTable()
+{
+  hires_table_.resize(HIRES_TABLE_SIZE);
+  for (size_t index = 0; index < HIRES_TABLE_SIZE; index++)
+  {
+    const bool prev_tail = index & 1;
+    const uint8_t byte = static_cast<uint8_t>(index >> 1);
+    const bool next_head = (index >> 9) & 1;
+    const int col = static_cast<int>(index >> 10);
+    const bool high_bit = (byte & 0x80) != 0; // Palette select bit
+
+    for (int bit = 0; bit < 7; bit++)
+    {
+      // Adjacent bits come from the neighbouring bytes at the edges
+      bool pixel_on = (byte & (1 << bit)) != 0;
+      bool prev_bit = (bit == 0) ? prev_tail : (byte & (1 << (bit - 1))) != 0;
+      bool next_bit = (bit == 6) ? next_head : (byte & (1 << (bit + 1))) != 0;
+      hires_table_[index][bit] = getHiResColor(pixel_on, col * 7 + bit, high_bit, prev_bit, next_bit);
+    }
+  }
+
+  // Double hi-res shows each cell in a lo-res color, or the dots
+  // themselves in monochrome. A cell starts a quarter color cycle in, so
+  // its bits rotated left one are the color number (magenta, 1, is the
+  // last dot of each cell: $08 $11 $22 $44)
+  const uint32_t *palette = loResPalette();
+  for (int cell = 0; cell < 16; cell++)
+  {
+    const int color = ((cell << 1) | (cell >> 3)) & 0x0F;
+    for (int dot = 0; dot < 4; dot++)
+    {
+      if (video_standard_ == VideoStandard::PAL_MONO)
+      {
+        dhgr_table_[cell][dot] = ((cell >> dot) & 1) ? COLOR_WHITE : COLOR_BLACK;
+      }
+      else
+      {
+        dhgr_table_[cell][dot] = palette[color];
+      }
+    }
+  }
+}
+
+uint32_t video_display::getHiResColor(bool bit_on, int x_pos, bool high_bit, bool prev_bit, bool next_bit)
+{
+  // If pixel is off, it's black (no fringing for off pixels)
+  if (!bit_on)
+  {
+    return COLOR_BLACK;
+  }
+
+  // Handle PAL Mono mode - pure black and white
+  // This is what most European users actually saw without a PAL encoder card
+  if (video_standard_ == VideoStandard::PAL_MONO)
+  {
+    return COLOR_WHITE;
+  }
+
+  // Handle PAL Color mode (TCA650 encoder style)
+  // The PAL encoder only changed colors every 2 hi-res pixels (not every pixel like NTSC)
+  // Unlike NTSC, PAL produces solid stable colors without fringing - the TCA650 decoded
+  // the artifact colors and re-encoded them as proper PAL color signals
+  if (video_standard_ == VideoStandard::PAL_COLOR)
+  {
+    // PAL color changes every 2 pixels, so we use pairs
+    // Divide by 2 to group pixels into pairs, then check odd/even of the pair
+    bool is_odd_pair = ((x_pos / 2) % 2) == 1;
+
+    if (!high_bit)
+    {
+      // PAL Palette 1: Cyan (even pairs) / Red (odd pairs)
+      return is_odd_pair ? COLOR_PAL_RED : COLOR_PAL_CYAN;
+    }
+    else
+    {
+      // PAL Palette 2: Blue (even pairs) / Yellow (odd pairs)
+      return is_odd_pair ? COLOR_PAL_YELLOW : COLOR_PAL_BLUE;
+    }
+  }
+
+  // NTSC mode (original behavior)
+  bool is_odd_column = (x_pos % 2) == 1;
+
+  // Select base artifact color based on column position and high bit
+  uint32_t artifact_color;
+  if (!high_bit)
+  {
+    // Palette 1: Purple (even columns) / Green (odd columns)
+    artifact_color = is_odd_column ? COLOR_GREEN_HIRES : COLOR_PURPLE;
+  }
+  else
+  {
+    // Palette 2: Blue (even columns) / Orange (odd columns)
+    artifact_color = is_odd_column ? COLOR_ORANGE : COLOR_BLUE;
+  }
+
+  if (color_fringing_enabled_)
+  {
+    // With fringing: adjacent pixels blend to white
+    if (prev_bit || next_bit)
+    {
+      return COLOR_WHITE;
+    }
+    return artifact_color;
+  }
+  else
+  {
+    // Without fringing: always show the artifact color
+    return artifact_color;
+  }
+}
+
+const uint32_t *video_display::loResPalette() const
+{
+  // Select color palette based on video standard
+  switch (video_standard_)
+  {
+  case VideoStandard::PAL_MONO:
+    return LORES_COLORS_MONO;
+  case VideoStandard::PAL_COLOR:
+    return LORES_COLORS_PAL;
+  case VideoStandard::NTSC:
+  default:
+    return LORES_COLORS;
+  }
+}
+
+void video_display::renderLoResRow(int row, int from, int to)
+{
+  if (double_graphics_)
+  {
+    renderDoubleLoResRow(row, from, to);
+    return;
+  }
+  const uint32_t *palette = loResPalette();
+
+  // Lo-res uses same memory layout as text mode
+  uint16_t row_addr = (showsPage2() ? TEXT_PAGE2_BASE : TEXT_PAGE1_BASE) + ROW_OFFSETS[row];
+
+  // Fill one scanline for each block half, then copy them down: the top
+  // blocks (low nibbles) fill scanlines 0-3 and the bottom blocks (high
+  // nibbles) 4-7
+  std::array<uint32_t, DISPLAY_WIDTH_40> top;
+  std::array<uint32_t, DISPLAY_WIDTH_40> bottom;
+  for (int col = 0; col < 40; col++)
+  {
+    uint8_t byte = main_memory_[row_addr + col];
+    std::fill_n(top.data() + col * 7, 7, palette[byte & 0x0F]);
+    std::fill_n(bottom.data() + col * 7, 7, palette[(byte >> 4) & 0x0F]);
+  }
+  uint32_t *out = &frame_buffer_[row * GLYPH_HEIGHT * DISPLAY_WIDTH];
+  for (int y = from; y < to; y++)
+  {
+    std::memcpy(out + y * DISPLAY_WIDTH, (y < 4 ? top : bottom).data(), DISPLAY_WIDTH_40 * sizeof(uint32_t));
+    if (current_display_width_ == DISPLAY_WIDTH_80)
+    {
+      widenLine(row * GLYPH_HEIGHT + y);
+    }
+  }
+}
+
+void video_display::renderDoubleLoResRow(int row, int from, int to)
+{
+  const uint32_t *palette = loResPalette();
+  uint16_t row_addr = (showsPage2() ? TEXT_PAGE2_BASE : TEXT_PAGE1_BASE) + ROW_OFFSETS[row];
+
+  // 7-dot blocks, aux then main for each byte column. Aux blocks start a
+  // quarter color cycle out of phase with main ones (as double hi-res
+  // cells do), so their color number is rotated left a bit
+  std::array<uint32_t, DISPLAY_WIDTH_80> top;
+  std::array<uint32_t, DISPLAY_WIDTH_80> bottom;
+  for (int col = 0; col < 40; col++)
+  {
+    const uint8_t aux = aux_memory_[row_addr + col];
+    const uint8_t main = main_memory_[row_addr + col];
+    const uint8_t aux_rotated = static_cast<uint8_t>(((aux << 1) & 0xEE) | ((aux >> 3) & 0x11));
+    std::fill_n(top.data() + col * 14, 7, palette[aux_rotated & 0x0F]);
+    std::fill_n(top.data() + col * 14 + 7, 7, palette[main & 0x0F]);
+    std::fill_n(bottom.data() + col * 14, 7, palette[aux_rotated >> 4]);
+    std::fill_n(bottom.data() + col * 14 + 7, 7, palette[main >> 4]);
+  }
+  uint32_t *out = &frame_buffer_[row * GLYPH_HEIGHT * DISPLAY_WIDTH];
+  for (int y = from; y < to; y++)
+  {
+    std::memcpy(out + y * DISPLAY_WIDTH, (y < 4 ? top : bottom).data(), DISPLAY_WIDTH_80 * sizeof(uint32_t));
+  }
+}
+
+void video_display::setGreenText(bool green)
+{
+  if (green != green_text_)
+  {
+    green_text_ = green;
+    buildGlyphAtlas();
+  }
+}
+
+void video_display::buildGlyphAtlas()
+{
+  glyph_atlas_.resize(GLYPH_COUNT * GLYPH_PIXELS);
+  const uint32_t text_color = green_text_ ? COLOR_GREEN : COLOR_WHITE;
+
+  for (int altchar = 0; altchar < 2; altchar++)
+  {
+    for (int flash_on = 0; flash_on < 2; flash_on++)
+    {
+      for (int code = 0; code < 256; code++)
+      {
+        const uint8_t ch = static_cast<uint8_t>(code);
+
+        // Apple IIe character encoding:
+        // $00-$3F: Inverse (white on black becomes black on green)
+        // $40-$7F: Flashing
+        // $80-$FF: Normal
+        bool is_inverse = (ch & 0xC0) == 0x00;
+        bool is_flash = (ch & 0xC0) == 0x40;
+
+        // Character index (mask off high bits for inverse/flash), from the
+        // alternate set in ALTCHARSET mode
+        uint8_t char_index = (is_inverse || is_flash) ? (ch & 0x3F) : (ch & 0x7F);
+        size_t rom_offset = altchar ? CHAR_ROM_ALT_OFFSET : 0;
+        const uint8_t *char_data = &char_rom_[rom_offset + char_index * 8];
+
+        // Inverse chars, and flashing chars in the flash phase, are inverted
+        bool show_inverse = is_inverse || (is_flash && flash_on);
+
+        uint32_t *glyph = &glyph_atlas_[glyphIndex(ch, altchar, flash_on) * GLYPH_PIXELS];
+        for (int y = 0; y < GLYPH_HEIGHT; y++)
+        {
+          uint8_t row_data = show_inverse ? static_cast<uint8_t>(~char_data[y]) : char_data[y];
+          for (int x = 0; x < GLYPH_WIDTH; x++)
+          {
+            // Apple II character ROM has bit 0 as leftmost pixel
+            glyph[y * GLYPH_WIDTH + x] = (row_data & (1 << x)) ? text_color : COLOR_BLACK;
+          }
+        }
+      }
+    }
+  }
+}
+
+void video_display::drawGlyph(uint32_t *out, const uint32_t *glyph, int from, int to)
+{
+  for (int y = from; y < to; y++)
+  {
+    std::memcpy(out + y * DISPLAY_WIDTH, glyph + y * GLYPH_WIDTH, GLYPH_WIDTH * sizeof(uint32_t));
+  }
+}
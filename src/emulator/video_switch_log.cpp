@@ -0,0 +1,68 @@
+#include "emulator/video_switch_log.hpp"
+
+uint8_t video_switch_log::pack(const Apple2e::SoftSwitchState &state)
+{
+  return (state.video_mode == Apple2e::VideoMode::TEXT ? TEXT : 0) |
+         (state.screen_mode == Apple2e::ScreenMode::MIXED ? MIXED : 0) |
+         (state.page_select == Apple2e::PageSelect::PAGE2 ? PAGE2 : 0) |
+         (state.graphics_mode == Apple2e::GraphicsMode::HIRES ? HIRES : 0) |
+         (state.col80_mode ? COL80 : 0) |
+         (state.altchar_mode ? ALTCHAR : 0) |
+         (state.store80 ? STORE80 : 0) |
+         (state.dhires ? DHIRES : 0);
+}
+
+void video_switch_log::unpack(uint8_t bits, Apple2e::SoftSwitchState &state)
+{
+  state.video_mode = (bits & TEXT) ? Apple2e::VideoMode::TEXT : Apple2e::VideoMode::GRAPHICS;
+  state.screen_mode = (bits & MIXED) ? Apple2e::ScreenMode::MIXED : Apple2e::ScreenMode::FULL;
+  state.page_select = (bits & PAGE2) ? Apple2e::PageSelect::PAGE2 : Apple2e::PageSelect::PAGE1;
+  state.graphics_mode = (bits & HIRES) ? Apple2e::GraphicsMode::HIRES : Apple2e::GraphicsMode::LORES;
+  state.col80_mode = (bits & COL80) != 0;
+  state.altchar_mode = (bits & ALTCHAR) != 0;
+  state.store80 = (bits & STORE80) != 0;
+  state.dhires = (bits & DHIRES) != 0;
+}
+
+bool video_switch_log::covers(uint64_t cycle) const
+{
+  // Nothing was dropped yet, or the oldest held change is no later than
+  // the cycle (so anything dropped came before it)
+  return count_ <= CAPACITY || changes_[count_ % CAPACITY].cycle <= cycle;
+}
+
+bool video_switch_log::changedBetween(uint64_t after, uint64_t until) const
+{
+  const uint64_t held = count_ < CAPACITY ? count_ : CAPACITY;
+  for (uint64_t i = 1; i <= held; ++i)
+  {
+    const change &c = changes_[(count_ - i) % CAPACITY];
+    if (c.cycle <= after)
+    {
+      return false;
+    }
+    if (c.cycle <= until)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t video_switch_log::bitsAt(uint64_t cycle, uint8_t current) const
+{
+  // Walk back over the changes made after the cycle; the switches were as
+  // the earliest of them found them
+  uint8_t bits = current;
+  const uint64_t held = count_ < CAPACITY ? count_ : CAPACITY;
+  for (uint64_t i = 1; i <= held; ++i)
+  {
+    const change &c = changes_[(count_ - i) % CAPACITY];
+    if (c.cycle <= cycle)
+    {
+      break;
+    }
+    bits = c.before;
+  }
+  return bits;
+}
@@ -0,0 +1,395 @@
+#include "emulator/watch_condition.hpp"
+#include <algorithm>
+#include <cctype>
+
+/**
+ * Recursive descent compiler, one function per precedence level:
+ *
+ *   or      := and ('||' and)*
+ *   and     := compare ('&&' compare)*
+ *   compare := bitand (('=='|'!='|'<'|'<='|'>'|'>=') bitand)?
+ *   bitand  := unary ('&' unary)*
+ *   unary   := '!' unary | primary
+ *   primary := '(' or ')' | '[' or ']' | number | name
+ *
+ * Each level emits its operands' code and then its operator, giving
+ * postfix bytecode. The stack depth is tracked as code is emitted.
+ */
+class watch_condition::compiler
+{
+public:
+  compiler(const std::string &text, std::vector<instruction> &code)
+    : text_(text), code_(code)
+  {
+  }
+
+  bool run(std::string &error)
+  {
+    parseOr();
+    skipSpace();
+    if (error_.empty() && pos_ < text_.size())
+    {
+      fail("unexpected '" + std::string(1, text_[pos_]) + "'");
+    }
+    if (error_.empty() && max_depth_ > MAX_STACK)
+    {
+      fail("expression too complex");
+    }
+    error = error_;
+    return error_.empty();
+  }
+
+private:
+  void parseOr()
+  {
+    parseAnd();
+    while (error_.empty() && match("||"))
+    {
+      parseAnd();
+      emit(opcode::LOGICAL_OR);
+    }
+  }
+
+  void parseAnd()
+  {
+    parseCompare();
+    while (error_.empty() && match("&&"))
+    {
+      parseCompare();
+      emit(opcode::LOGICAL_AND);
+    }
+  }
+
+  void parseCompare()
+  {
+    parseBitAnd();
+    if (!error_.empty())
+    {
+      return;
+    }
+
+    // Two-character operators first so "<=" isn't taken as "<"
+    static const struct
+    {
+      const char *text;
+      opcode op;
+    } operators[] = {{"==", opcode::EQ}, {"!=", opcode::NE}, {"<=", opcode::LE},
+                     {">=", opcode::GE}, {"<", opcode::LT},  {">", opcode::GT}};
+    for (const auto &entry : operators)
+    {
+      if (match(entry.text))
+      {
+        parseBitAnd();
+        emit(entry.op);
+        return;
+      }
+    }
+  }
+
+  void parseBitAnd()
+  {
+    parseUnary();
+    // A lone '&' is bitwise; "&&" belongs to parseAnd()
+    while (error_.empty() && peekChar() == '&' && peekChar(1) != '&')
+    {
+      ++pos_;
+      parseUnary();
+      emit(opcode::BIT_AND);
+    }
+  }
+
+  void parseUnary()
+  {
+    if (peekChar() == '!' && peekChar(1) != '=')
+    {
+      ++pos_;
+      parseUnary();
+      emit(opcode::NOT);
+      return;
+    }
+    parsePrimary();
+  }
+
+  void parsePrimary()
+  {
+    skipSpace();
+    if (pos_ >= text_.size())
+    {
+      fail("expression ends early");
+      return;
+    }
+
+    char c = text_[pos_];
+    if (c == '(' || c == '[')
+    {
+      ++pos_;
+      parseOr();
+      if (!error_.empty())
+      {
+        return;
+      }
+      const char close = (c == '(') ? ')' : ']';
+      if (!match(std::string(1, close).c_str()))
+      {
+        fail(std::string("missing '") + close + "'");
+        return;
+      }
+      if (c == '[')
+      {
+        emit(opcode::LOAD);
+      }
+      return;
+    }
+
+    if (std::isalpha(static_cast<unsigned char>(c)))
+    {
+      parseName();
+      return;
+    }
+    parseNumber();
+  }
+
+  void parseName()
+  {
+    size_t start = pos_;
+    while (pos_ < text_.size() && std::isalnum(static_cast<unsigned char>(text_[pos_])))
+    {
+      ++pos_;
+    }
+    std::string name = text_.substr(start, pos_ - start);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+
+    static const struct
+    {
+      const char *name;
+      opcode op;
+    } names[] = {{"A", opcode::REG_A},   {"X", opcode::REG_X},        {"Y", opcode::REG_Y},
+                 {"SP", opcode::REG_SP}, {"S", opcode::REG_SP},       {"P", opcode::REG_P},
+                 {"PC", opcode::REG_PC}, {"VALUE", opcode::VALUE},    {"ADDR", opcode::ADDRESS}};
+    for (const auto &entry : names)
+    {
+      if (name == entry.name)
+      {
+        emit(entry.op);
+        return;
+      }
+    }
+    fail("unknown name '" + name + "'");
+  }
+
+  void parseNumber()
+  {
+    if (peekChar() == '#')
+    {
+      ++pos_;
+    }
+
+    int base = 10;
+    if (pos_ < text_.size() && text_[pos_] == '$')
+    {
+      base = 16;
+      ++pos_;
+    }
+    else if (pos_ < text_.size() && text_[pos_] == '%')
+    {
+      base = 2;
+      ++pos_;
+    }
+    else if (pos_ + 1 < text_.size() && text_[pos_] == '0' && (text_[pos_ + 1] == 'x' || text_[pos_ + 1] == 'X'))
+    {
+      base = 16;
+      pos_ += 2;
+    }
+
+    uint32_t value = 0;
+    size_t digits = 0;
+    while (pos_ < text_.size())
+    {
+      int digit = digitValue(text_[pos_]);
+      if (digit < 0 || digit >= base)
+      {
+        break;
+      }
+      value = value * static_cast<uint32_t>(base) + static_cast<uint32_t>(digit);
+      if (value > 0xFFFF)
+      {
+        fail("number out of range");
+        return;
+      }
+      ++pos_;
+      ++digits;
+    }
+
+    if (digits == 0)
+    {
+      fail(pos_ < text_.size() ? "unexpected '" + std::string(1, text_[pos_]) + "'" : "expression ends early");
+      return;
+    }
+    emit(opcode::PUSH, static_cast<uint16_t>(value));
+  }
+
+  static int digitValue(char c)
+  {
+    if (c >= '0' && c <= '9')
+    {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  void emit(opcode op, uint16_t operand = 0)
+  {
+    if (!error_.empty())
+    {
+      return;
+    }
+    code_.push_back({op, operand});
+
+    // Operands push one entry; binary operators pop two and push one;
+    // NOT and LOAD replace the top
+    switch (op)
+    {
+    case opcode::NOT:
+    case opcode::LOAD:
+      break;
+    case opcode::PUSH:
+    case opcode::REG_A:
+    case opcode::REG_X:
+    case opcode::REG_Y:
+    case opcode::REG_SP:
+    case opcode::REG_P:
+    case opcode::REG_PC:
+    case opcode::VALUE:
+    case opcode::ADDRESS:
+      max_depth_ = std::max(max_depth_, ++depth_);
+      break;
+    default:
+      --depth_;
+      break;
+    }
+  }
+
+  void skipSpace()
+  {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+    {
+      ++pos_;
+    }
+  }
+
+  char peekChar(size_t ahead = 0)
+  {
+    skipSpace();
+    return pos_ + ahead < text_.size() ? text_[pos_ + ahead] : '\0';
+  }
+
+  bool match(const char *token)
+  {
+    skipSpace();
+    size_t length = std::char_traits<char>::length(token);
+    if (text_.compare(pos_, length, token) == 0)
+    {
+      pos_ += length;
+      return true;
+    }
+    return false;
+  }
+
+  void fail(const std::string &message)
+  {
+    if (error_.empty())
+    {
+      error_ = message + " at column " + std::to_string(pos_ + 1);
+    }
+  }
+
+  const std::string &text_;
+  std::vector<instruction> &code_;
+  size_t pos_ = 0;
+  size_t depth_ = 0;
+  size_t max_depth_ = 0;
+  std::string error_;
+};
+
+bool watch_condition::compile(const std::string &text, std::string &error)
+{
+  code_.clear();
+  text_.clear();
+  error.clear();
+
+  if (text.find_first_not_of(" \t") == std::string::npos)
+  {
+    return true;
+  }
+
+  compiler c(text, code_);
+  if (!c.run(error))
+  {
+    code_.clear();
+    return false;
+  }
+  text_ = text;
+  return true;
+}
+
+bool watch_condition::evaluate(const context &ctx, const PeekFunction &peek) const
+{
+  if (code_.empty())
+  {
+    return true;
+  }
+
+  uint32_t stack[MAX_STACK];
+  size_t top = 0;
+
+  for (const instruction &ins : code_)
+  {
+    switch (ins.op)
+    {
+    case opcode::PUSH:    stack[top++] = ins.operand; break;
+    case opcode::REG_A:   stack[top++] = ctx.a; break;
+    case opcode::REG_X:   stack[top++] = ctx.x; break;
+    case opcode::REG_Y:   stack[top++] = ctx.y; break;
+    case opcode::REG_SP:  stack[top++] = ctx.sp; break;
+    case opcode::REG_P:   stack[top++] = ctx.p; break;
+    case opcode::REG_PC:  stack[top++] = ctx.pc; break;
+    case opcode::VALUE:   stack[top++] = ctx.value; break;
+    case opcode::ADDRESS: stack[top++] = ctx.address; break;
+    case opcode::LOAD:
+      stack[top - 1] = peek ? peek(static_cast<uint16_t>(stack[top - 1])) : 0;
+      break;
+    case opcode::NOT:
+      stack[top - 1] = stack[top - 1] == 0;
+      break;
+    default:
+    {
+      const uint32_t rhs = stack[--top];
+      uint32_t &lhs = stack[top - 1];
+      switch (ins.op)
+      {
+      case opcode::BIT_AND:     lhs = lhs & rhs; break;
+      case opcode::EQ:          lhs = lhs == rhs; break;
+      case opcode::NE:          lhs = lhs != rhs; break;
+      case opcode::LT:          lhs = lhs < rhs; break;
+      case opcode::LE:          lhs = lhs <= rhs; break;
+      case opcode::GT:          lhs = lhs > rhs; break;
+      case opcode::GE:          lhs = lhs >= rhs; break;
+      case opcode::LOGICAL_AND: lhs = lhs && rhs; break;
+      case opcode::LOGICAL_OR:  lhs = lhs || rhs; break;
+      default: break;
+      }
+      break;
+    }
+    }
+  }
+  return stack[0] != 0;
+}
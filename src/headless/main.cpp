@@ -0,0 +1,550 @@
+/**
+ * a2e-headless - Run the emulator without a window or audio
+ *
+ * Boots the Apple IIe (optionally with disk images in slot 6) and runs it for
+ * a number of CPU cycles or until a condition is met, then exits. Intended for
+ * scripted and build-farm use, so it depends only on the a2e_core library and
+ * runs on any platform with a C++20 compiler.
+ *
+ * Exit status:
+ *   0  cycle limit reached, or the --until condition was met
+ *   1  setup error (bad arguments, missing ROMs or disk image)
+ *   2  an --until condition was given but the cycle limit ran out first
+ */
+
+#include "emulator/emulator.hpp"
+#include "emulator/file_frame_sink.hpp"
+#include "emulator/text_screen.hpp"
+#include "utils/logger.hpp"
+#include "utils/resource_path.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Ten seconds of emulated time
+constexpr uint64_t DEFAULT_CYCLES = 10230000;
+
+// Conditions and typed keys are checked once per video frame
+constexpr uint64_t SLICE_CYCLES = Apple2e::CYCLES_PER_VIDEO_FRAME;
+
+constexpr double CPU_CLOCK_HZ = 1023000.0;
+
+constexpr const char *CHARACTER_ROM_PATH = "resources/roms/character/341-0160-A.bin";
+
+struct options
+{
+  std::vector<std::string> disks;
+  uint64_t cycles = DEFAULT_CYCLES;
+  bool until_pc_set = false;
+  uint16_t until_pc = 0;
+  std::string until_text;
+  std::vector<std::string> until_watch;
+  std::string type_text;
+  std::string resource_dir;
+  std::string load_state;
+  std::string save_state;
+  std::string record;
+  std::string replay;
+  std::string trace;
+  std::string profile;
+  std::string profile_report;
+  std::string screenshot;
+  std::string dump_frames;
+  uint32_t dump_every = 1;
+  bool cycles_set = false;
+  bool realtime = false;
+  bool print_screen = false;
+  bool save_disks = false;
+  bool idle_skip = true;
+  bool block_cache = false;
+  bool verbose = false;
+};
+
+void printUsage(const char *program)
+{
+  std::cout
+      << "Usage: " << program << " [options] [disk1 [disk2]]\n"
+      << "\n"
+      << "Options:\n"
+      << "  -c, --cycles N       Stop after N CPU cycles (default " << DEFAULT_CYCLES << ", 10 s)\n"
+      << "  --until-pc ADDR      Stop when the PC reaches ADDR (hex, e.g. D43C)\n"
+      << "  --until-text TEXT    Stop when TEXT appears on the text screen\n"
+      << "  --until-watch SPEC   Stop when a watchpoint hits, e.g. 'write $C0E9' or\n"
+      << "                       'read $2000-$3FFF if A==#$FF' (may be repeated)\n"
+      << "  --type TEXT          Type TEXT on the keyboard (\\n for Return)\n"
+      << "  --realtime           Run at 1.023 MHz instead of as fast as possible\n"
+      << "  --screen             Print the text screen on exit\n"
+      << "  --save-disks         Write disk changes back to the image files\n"
+      << "  --load-state FILE    Start from a save state\n"
+      << "  --save-state FILE    Write a save state on exit\n"
+      << "  --record FILE        Record the run's input for replay\n"
+      << "  --replay FILE        Replay a recording (runs to its end unless -c is given)\n"
+      << "  --trace FILE         Write an execution trace (see a2e-tracedump)\n"
+      << "  --profile FILE       Profile the run; write cycles per call path in\n"
+      << "                       collapsed-stack (flame graph) format\n"
+      << "  --profile-report FILE  Profile the run; write a hot spot report\n"
+      << "  --screenshot FILE    Write the screen on exit as a PNG (or .ppm) image\n"
+      << "  --dump-frames PATTERN  Write each video frame as an image; %d or %05d in\n"
+      << "                       PATTERN is replaced by the frame number\n"
+      << "  --dump-every N       With --dump-frames, write only every Nth frame\n"
+      << "  --resources DIR      Directory containing resources/roms\n"
+      << "  --no-idle-skip       Run idle loops instead of fast-forwarding them\n"
+      << "  --block-cache        Run code from the predecoded block cache\n"
+      << "  -v, --verbose        Echo the emulator log to the console\n"
+      << "  -h, --help           Show this help\n";
+}
+
+/**
+ * Expand \n, \r and \\ in a --type argument
+ */
+std::string unescape(const std::string &text)
+{
+  std::string result;
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    if (text[i] == '\\' && i + 1 < text.size())
+    {
+      char next = text[++i];
+      result += (next == 'n' || next == 'r') ? '\r' : next;
+    }
+    else
+    {
+      result += text[i] == '\n' ? '\r' : text[i];
+    }
+  }
+  return result;
+}
+
+bool parseOptions(int argc, char **argv, options &opts)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto value = [&](const char *name) -> const char *
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << name << " needs a value" << std::endl;
+        return nullptr;
+      }
+      return argv[++i];
+    };
+
+    try
+    {
+      if (arg == "-h" || arg == "--help")
+      {
+        printUsage(argv[0]);
+        std::exit(0);
+      }
+      else if (arg == "-c" || arg == "--cycles")
+      {
+        const char *v = value("--cycles");
+        if (!v)
+        {
+          return false;
+        }
+        opts.cycles = std::stoull(v);
+        opts.cycles_set = true;
+      }
+      else if (arg == "--until-pc")
+      {
+        const char *v = value("--until-pc");
+        if (!v)
+        {
+          return false;
+        }
+        std::string addr = v;
+        if (!addr.empty() && addr[0] == '$')
+        {
+          addr.erase(0, 1);
+        }
+        unsigned long pc = std::stoul(addr, nullptr, 16);
+        if (pc > 0xFFFF)
+        {
+          std::cerr << "--until-pc address out of range: " << v << std::endl;
+          return false;
+        }
+        opts.until_pc = static_cast<uint16_t>(pc);
+        opts.until_pc_set = true;
+      }
+      else if (arg == "--until-text")
+      {
+        const char *v = value("--until-text");
+        if (!v)
+        {
+          return false;
+        }
+        opts.until_text = v;
+      }
+      else if (arg == "--type")
+      {
+        const char *v = value("--type");
+        if (!v)
+        {
+          return false;
+        }
+        opts.type_text += unescape(v);
+      }
+      else if (arg == "--resources")
+      {
+        const char *v = value("--resources");
+        if (!v)
+        {
+          return false;
+        }
+        opts.resource_dir = v;
+      }
+      else if (arg == "--load-state" || arg == "--save-state")
+      {
+        const char *v = value(arg.c_str());
+        if (!v)
+        {
+          return false;
+        }
+        (arg == "--load-state" ? opts.load_state : opts.save_state) = v;
+      }
+      else if (arg == "--record" || arg == "--replay")
+      {
+        const char *v = value(arg.c_str());
+        if (!v)
+        {
+          return false;
+        }
+        (arg == "--record" ? opts.record : opts.replay) = v;
+      }
+      else if (arg == "--until-watch")
+      {
+        const char *v = value("--until-watch");
+        if (!v)
+        {
+          return false;
+        }
+        opts.until_watch.push_back(v);
+      }
+      else if (arg == "--trace")
+      {
+        const char *v = value("--trace");
+        if (!v)
+        {
+          return false;
+        }
+        opts.trace = v;
+      }
+      else if (arg == "--profile" || arg == "--profile-report")
+      {
+        const char *v = value(arg.c_str());
+        if (!v)
+        {
+          return false;
+        }
+        (arg == "--profile" ? opts.profile : opts.profile_report) = v;
+      }
+      else if (arg == "--screenshot" || arg == "--dump-frames")
+      {
+        const char *v = value(arg.c_str());
+        if (!v)
+        {
+          return false;
+        }
+        (arg == "--screenshot" ? opts.screenshot : opts.dump_frames) = v;
+      }
+      else if (arg == "--dump-every")
+      {
+        const char *v = value("--dump-every");
+        if (!v)
+        {
+          return false;
+        }
+        unsigned long every = std::stoul(v);
+        if (every == 0 || every > UINT32_MAX)
+        {
+          std::cerr << "--dump-every out of range: " << v << std::endl;
+          return false;
+        }
+        opts.dump_every = static_cast<uint32_t>(every);
+      }
+      else if (arg == "--realtime")
+      {
+        opts.realtime = true;
+      }
+      else if (arg == "--screen")
+      {
+        opts.print_screen = true;
+      }
+      else if (arg == "--save-disks")
+      {
+        opts.save_disks = true;
+      }
+      else if (arg == "--no-idle-skip")
+      {
+        opts.idle_skip = false;
+      }
+      else if (arg == "--block-cache")
+      {
+        opts.block_cache = true;
+      }
+      else if (arg == "-v" || arg == "--verbose")
+      {
+        opts.verbose = true;
+      }
+      else if (!arg.empty() && arg[0] == '-')
+      {
+        std::cerr << "Unknown option: " << arg << std::endl;
+        return false;
+      }
+      else if (opts.disks.size() < 2)
+      {
+        opts.disks.push_back(arg);
+      }
+      else
+      {
+        std::cerr << "At most two disk images can be given" << std::endl;
+        return false;
+      }
+    }
+    catch (const std::exception &)
+    {
+      std::cerr << "Bad value for " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  options opts;
+  if (!parseOptions(argc, argv, opts))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  Logger::instance().setEchoToConsole(opts.verbose);
+  if (!opts.resource_dir.empty())
+  {
+    setResourcePath(opts.resource_dir);
+  }
+
+  emulator emu;
+  if (!emu.initialize())
+  {
+    std::cerr << "Failed to initialize emulator (are the ROMs in resources/roms?)" << std::endl;
+    return 1;
+  }
+
+  emu.setIdleSkipEnabled(opts.idle_skip);
+  emu.setBlockCacheEnabled(opts.block_cache);
+
+  Disk2Controller *disk = emu.getDiskController();
+  disk->setWriteBack(opts.save_disks);
+
+  // The state puts back the disk images it was saved with; ones given on the
+  // command line go in afterwards and replace them
+  if (!opts.load_state.empty() && !emu.loadState(opts.load_state))
+  {
+    std::cerr << "Failed to load save state: " << opts.load_state << std::endl;
+    return 1;
+  }
+  for (size_t drive = 0; drive < opts.disks.size(); ++drive)
+  {
+    if (!disk->insertDisk(static_cast<int>(drive), opts.disks[drive]))
+    {
+      std::cerr << "Failed to load disk image: " << opts.disks[drive] << std::endl;
+      return 1;
+    }
+  }
+
+  // A replay brings its own starting state and disks
+  if (!opts.replay.empty() && !emu.startReplay(opts.replay))
+  {
+    std::cerr << "Failed to load recording: " << opts.replay << std::endl;
+    return 1;
+  }
+  if (!opts.record.empty())
+  {
+    emu.startRecording();
+  }
+
+  if (!opts.trace.empty())
+  {
+    // Not tied to real time, so wait for the trace writer rather than drop
+    emu.getTraceRecorder()->setLossless(true);
+    if (!emu.getTraceRecorder()->startStreaming(opts.trace))
+    {
+      std::cerr << "Failed to create trace file: " << opts.trace << std::endl;
+      return 1;
+    }
+    emu.setTracing(true);
+  }
+
+  const bool profiling = !opts.profile.empty() || !opts.profile_report.empty();
+  emu.setProfiling(profiling);
+
+  if (opts.until_pc_set)
+  {
+    emu.getBreakpointManager()->addBreakpoint(opts.until_pc, breakpoint_type::EXECUTION);
+  }
+  for (const std::string &spec : opts.until_watch)
+  {
+    std::string error;
+    if (!emu.getBreakpointManager()->addWatchpoint(spec, error))
+    {
+      std::cerr << "Bad --until-watch '" << spec << "': " << error << std::endl;
+      return 1;
+    }
+  }
+
+  // Frames are rendered only when something will look at them, and only
+  // then is the character ROM needed
+  video_display *display = emu.getVideoDisplay();
+  const bool capturing = !opts.screenshot.empty() || !opts.dump_frames.empty();
+  if (capturing && !emu.loadCharacterROM(getResourcePath(CHARACTER_ROM_PATH)))
+  {
+    std::cerr << "Failed to load character ROM: " << CHARACTER_ROM_PATH << std::endl;
+    return 1;
+  }
+  std::unique_ptr<file_frame_sink> frame_dump;
+  if (!opts.dump_frames.empty())
+  {
+    frame_dump = std::make_unique<file_frame_sink>(opts.dump_frames, opts.dump_every);
+  }
+
+  std::deque<char> keys(opts.type_text.begin(), opts.type_text.end());
+  const bool has_condition = opts.until_pc_set || !opts.until_text.empty() || !opts.until_watch.empty();
+  const uint64_t start_cycles = emu.getCPUState().total_cycles;
+  const uint64_t end_cycles = (emu.isReplaying() && !opts.cycles_set) ? emu.getReplayEndCycle()
+                                                                     : start_cycles + opts.cycles;
+  const auto start_time = std::chrono::steady_clock::now();
+  std::string reason = "cycle limit";
+  bool condition_met = false;
+
+  uint64_t cycles = start_cycles;
+  while (cycles < end_cycles)
+  {
+    // Feed typed keys one at a time as the program reads them
+    if (!keys.empty() && !emu.isKeyboardStrobeSet())
+    {
+      emu.keyDown(static_cast<uint8_t>(keys.front()));
+      keys.pop_front();
+    }
+
+    emu.runCycles(std::min(end_cycles, cycles + SLICE_CYCLES));
+    cycles = emu.getCPUState().total_cycles;
+
+    if (frame_dump)
+    {
+      display->update();
+      if (!frame_dump->present(display->getFrame()))
+      {
+        std::cerr << "Failed to write frame image: " << opts.dump_frames << std::endl;
+        return 1;
+      }
+    }
+
+    if (emu.isPaused())
+    {
+      const breakpoint_hit &hit = emu.getBreakpointManager()->getLastHit();
+      const bool pc_reached = opts.until_pc_set && hit.type == breakpoint_type::EXECUTION && hit.address == opts.until_pc;
+      reason = pc_reached ? "PC reached" : "watchpoint " + breakpoint_manager::describe(hit);
+      condition_met = true;
+      break;
+    }
+    if (!opts.until_text.empty() && screenContains(emu, opts.until_text))
+    {
+      reason = "text found";
+      condition_met = true;
+      break;
+    }
+
+    // Real time: sleep off whatever host time the slice didn't need, which
+    // is most of it while idle loops are being skipped
+    if (opts.realtime)
+    {
+      auto emulated = std::chrono::duration<double>((cycles - start_cycles) / CPU_CLOCK_HZ);
+      std::this_thread::sleep_until(start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(emulated));
+    }
+  }
+
+  const double host_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  const emulator::cpu_state state = emu.getCPUState();
+  std::printf("Stopped (%s) after %llu cycles at PC=$%04X in %.2fs (%.1fx real time)\n",
+              reason.c_str(), static_cast<unsigned long long>(state.total_cycles - start_cycles), state.pc,
+              host_seconds,
+              host_seconds > 0.0 ? (state.total_cycles - start_cycles) / CPU_CLOCK_HZ / host_seconds : 0.0);
+
+  if (!opts.trace.empty())
+  {
+    emu.setTracing(false);
+    trace_recorder *tracer = emu.getTraceRecorder();
+    if (!tracer->stopStreaming())
+    {
+      std::cerr << "Failed to write trace file: " << opts.trace << std::endl;
+      return 1;
+    }
+    if (tracer->getDroppedCount() > 0)
+    {
+      std::cerr << "Trace writer fell behind; " << tracer->getDroppedCount() << " records dropped" << std::endl;
+    }
+  }
+
+  if (profiling)
+  {
+    emu.setProfiling(false);
+    const guest_profiler *profiler = emu.getProfiler();
+    if (!opts.profile.empty() && !profiler->writeCollapsedStacks(opts.profile))
+    {
+      std::cerr << "Failed to write profile: " << opts.profile << std::endl;
+      return 1;
+    }
+    if (!opts.profile_report.empty() && !profiler->writeReport(opts.profile_report))
+    {
+      std::cerr << "Failed to write profile report: " << opts.profile_report << std::endl;
+      return 1;
+    }
+  }
+
+  if (!opts.record.empty() && !emu.stopRecording(opts.record))
+  {
+    std::cerr << "Failed to write recording: " << opts.record << std::endl;
+    return 1;
+  }
+
+  if (!opts.save_state.empty() && !emu.saveState(opts.save_state))
+  {
+    std::cerr << "Failed to write save state: " << opts.save_state << std::endl;
+    return 1;
+  }
+
+  if (!opts.screenshot.empty())
+  {
+    display->update();
+    if (!file_frame_sink::writeImage(opts.screenshot, display->getFrame()))
+    {
+      std::cerr << "Failed to write screenshot: " << opts.screenshot << std::endl;
+      return 1;
+    }
+  }
+
+  if (opts.print_screen)
+  {
+    for (const std::string &line : readTextScreen(emu))
+    {
+      std::printf("%s\n", line.c_str());
+    }
+  }
+
+  return (has_condition && !condition_met) ? 2 : 0;
+}
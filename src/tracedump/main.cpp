@@ -0,0 +1,283 @@
+/**
+ * a2e-tracedump - Decode an execution trace to text
+ *
+ * Reads a trace written by the debugger or by a2e-headless --trace and
+ * prints one line per instruction: cycle, address, bytes, disassembly,
+ * registers before the instruction, and the data accesses it made.
+ *
+ *        cycle  addr   bytes     instruction     registers                   accesses
+ *     17032554  $C65C: BD 8C C0  LDA $C08C,X     A=00 X=60 Y=00 P=30 SP=F0  R $C0EC=D5
+ *
+ * Exit status:
+ *   0  trace decoded
+ *   1  bad arguments or unreadable trace
+ */
+
+#include "emulator/disassembler.hpp"
+#include "emulator/save_state.hpp"
+#include "emulator/trace_recorder.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+struct options
+{
+  std::string path;
+  uint16_t pc_low = 0x0000;
+  uint16_t pc_high = 0xFFFF;
+  uint64_t cycle_low = 0;
+  uint64_t cycle_high = std::numeric_limits<uint64_t>::max();
+  uint64_t limit = std::numeric_limits<uint64_t>::max();
+  bool show_accesses = true;
+};
+
+void printUsage(const char *program)
+{
+  std::cout
+      << "Usage: " << program << " [options] TRACE\n"
+      << "\n"
+      << "Options:\n"
+      << "  --pc START-END       Only instructions at START..END (hex, inclusive)\n"
+      << "  --cycles FROM-TO     Only instructions starting in FROM..TO (either may be\n"
+      << "                       left out, e.g. 5000000-)\n"
+      << "  -n, --limit N        Stop after printing N instructions\n"
+      << "  --no-accesses        Leave out the memory access column\n"
+      << "  -h, --help           Show this help\n";
+}
+
+/**
+ * Strip an optional $ or 0x prefix from a hex address
+ */
+std::string stripHexPrefix(std::string text)
+{
+  if (!text.empty() && text[0] == '$')
+  {
+    text.erase(0, 1);
+  }
+  else if (text.size() > 1 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+  {
+    text.erase(0, 2);
+  }
+  return text;
+}
+
+/**
+ * Split "LOW-HIGH" into its halves; a missing half is left empty
+ */
+bool splitRange(const std::string &text, std::string &low, std::string &high)
+{
+  size_t dash = text.find('-');
+  if (dash == std::string::npos)
+  {
+    low = high = text;
+    return !text.empty();
+  }
+  low = text.substr(0, dash);
+  high = text.substr(dash + 1);
+  return !low.empty() || !high.empty();
+}
+
+bool parseOptions(int argc, char **argv, options &opts)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto value = [&](const char *name) -> const char *
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << name << " needs a value" << std::endl;
+        return nullptr;
+      }
+      return argv[++i];
+    };
+
+    try
+    {
+      if (arg == "-h" || arg == "--help")
+      {
+        printUsage(argv[0]);
+        std::exit(0);
+      }
+      else if (arg == "--pc")
+      {
+        const char *v = value("--pc");
+        std::string low, high;
+        if (!v || !splitRange(v, low, high))
+        {
+          return false;
+        }
+        unsigned long start = low.empty() ? 0x0000 : std::stoul(stripHexPrefix(low), nullptr, 16);
+        unsigned long end = high.empty() ? 0xFFFF : std::stoul(stripHexPrefix(high), nullptr, 16);
+        if (start > 0xFFFF || end > 0xFFFF || start > end)
+        {
+          std::cerr << "Bad --pc range: " << v << std::endl;
+          return false;
+        }
+        opts.pc_low = static_cast<uint16_t>(start);
+        opts.pc_high = static_cast<uint16_t>(end);
+      }
+      else if (arg == "--cycles")
+      {
+        const char *v = value("--cycles");
+        std::string low, high;
+        if (!v || !splitRange(v, low, high))
+        {
+          return false;
+        }
+        opts.cycle_low = low.empty() ? 0 : std::stoull(low);
+        opts.cycle_high = high.empty() ? std::numeric_limits<uint64_t>::max() : std::stoull(high);
+        if (opts.cycle_low > opts.cycle_high)
+        {
+          std::cerr << "Bad --cycles range: " << v << std::endl;
+          return false;
+        }
+      }
+      else if (arg == "-n" || arg == "--limit")
+      {
+        const char *v = value("--limit");
+        if (!v)
+        {
+          return false;
+        }
+        opts.limit = std::stoull(v);
+      }
+      else if (arg == "--no-accesses")
+      {
+        opts.show_accesses = false;
+      }
+      else if (!arg.empty() && arg[0] == '-')
+      {
+        std::cerr << "Unknown option: " << arg << std::endl;
+        return false;
+      }
+      else if (opts.path.empty())
+      {
+        opts.path = arg;
+      }
+      else
+      {
+        std::cerr << "Only one trace file can be given" << std::endl;
+        return false;
+      }
+    }
+    catch (const std::exception &)
+    {
+      std::cerr << "Bad value for " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (opts.path.empty())
+  {
+    std::cerr << "No trace file given" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void printRecord(const trace_record &record, bool show_accesses)
+{
+  const int length = disassembler::OPCODES[record.bytes[0]].bytes;
+
+  char bytes[12];
+  int used = 0;
+  for (int i = 0; i < length; ++i)
+  {
+    used += std::snprintf(bytes + used, sizeof(bytes) - used, i ? " %02X" : "%02X", record.bytes[i]);
+  }
+  std::string instruction = disassembler::formatInstruction(record.pc, record.bytes[0],
+                                                            record.bytes[1], record.bytes[2]);
+
+  std::printf("%12llu  $%04X: %-9s %-15s A=%02X X=%02X Y=%02X P=%02X SP=%02X",
+              static_cast<unsigned long long>(record.cycle), record.pc, bytes, instruction.c_str(),
+              record.a, record.x, record.y, record.p, record.sp);
+
+  if (show_accesses)
+  {
+    const size_t kept = std::min<size_t>(record.access_count, trace_record::MAX_ACCESSES);
+    for (size_t i = 0; i < kept; ++i)
+    {
+      std::printf("  %c $%04X=%02X", (record.flags & (1 << i)) ? 'W' : 'R', record.address[i], record.value[i]);
+    }
+    if (record.access_count > kept)
+    {
+      std::printf("  +%u more", static_cast<unsigned>(record.access_count - kept));
+    }
+  }
+  std::printf("\n");
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  options opts;
+  if (!parseOptions(argc, argv, opts))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  mapped_file file;
+  if (!file.open(opts.path))
+  {
+    std::cerr << "Failed to open trace file: " << opts.path << std::endl;
+    return 1;
+  }
+
+  const uint8_t *data = file.getData();
+  const size_t size = file.getSize();
+  if (size < trace_format::HEADER_SIZE ||
+      std::memcmp(data, trace_format::MAGIC, sizeof(trace_format::MAGIC)) != 0)
+  {
+    std::cerr << "Not an a2e trace file: " << opts.path << std::endl;
+    return 1;
+  }
+
+  const uint16_t version = static_cast<uint16_t>(data[4] | data[5] << 8);
+  const size_t record_size = static_cast<size_t>(data[6] | data[7] << 8);
+  if (version > trace_format::VERSION || record_size < sizeof(trace_record))
+  {
+    std::cerr << "Unsupported trace version " << version << " (record size " << record_size << ")" << std::endl;
+    return 1;
+  }
+
+  uint64_t printed = 0;
+  for (size_t pos = trace_format::HEADER_SIZE; pos + record_size <= size && printed < opts.limit; pos += record_size)
+  {
+    trace_record record;
+    std::memcpy(&record, data + pos, sizeof(record));
+
+    // Not a sorted search: loading a state mid-trace can send the cycle
+    // count back
+    if (record.cycle < opts.cycle_low || record.cycle > opts.cycle_high)
+    {
+      continue;
+    }
+
+    if (record.flags & trace_record::FLAG_GAP)
+    {
+      std::printf("  -- records dropped --\n");
+    }
+    if (record.pc < opts.pc_low || record.pc > opts.pc_high)
+    {
+      continue;
+    }
+
+    printRecord(record, opts.show_accesses);
+    ++printed;
+  }
+
+  if ((size - trace_format::HEADER_SIZE) % record_size != 0)
+  {
+    std::cerr << "Warning: trace ends with a partial record" << std::endl;
+  }
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "ui/cpu_window.hpp"
 #include "emulator/emulator.hpp"
+#include "emulator/disassembler.hpp"
 #include <imgui.h>
 #include <cstdio>
 #include <cstring>
@@ -14,82 +15,6 @@ static constexpr uint8_t FLAG_U = 0x20; // Unused (always 1)
 static constexpr uint8_t FLAG_V = 0x40; // Overflow
 static constexpr uint8_t FLAG_N = 0x80; // Negative
 
-// Opcode information for disassembly
-struct OpcodeInfo
-{
-  const char *mnemonic;
-  int bytes;
-  const char *mode; // Addressing mode format
-};
-
-// Simplified opcode table for 65C02
-static const OpcodeInfo OPCODES[256] = {
-    {"BRK", 1, ""},        {"ORA", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"TSB", 2, "$%02X"},   {"ORA", 2, "$%02X"},     {"ASL", 2, "$%02X"},     {"RMB0", 2, "$%02X"},
-    {"PHP", 1, ""},        {"ORA", 2, "#$%02X"},    {"ASL", 1, "A"},         {"???", 1, ""},
-    {"TSB", 3, "$%04X"},   {"ORA", 3, "$%04X"},     {"ASL", 3, "$%04X"},     {"BBR0", 3, "$%02X,$%04X"},
-    {"BPL", 2, "$%04X"},   {"ORA", 2, "($%02X),Y"}, {"ORA", 2, "($%02X)"},   {"???", 1, ""},
-    {"TRB", 2, "$%02X"},   {"ORA", 2, "$%02X,X"},   {"ASL", 2, "$%02X,X"},   {"RMB1", 2, "$%02X"},
-    {"CLC", 1, ""},        {"ORA", 3, "$%04X,Y"},   {"INC", 1, "A"},         {"???", 1, ""},
-    {"TRB", 3, "$%04X"},   {"ORA", 3, "$%04X,X"},   {"ASL", 3, "$%04X,X"},   {"BBR1", 3, "$%02X,$%04X"},
-    {"JSR", 3, "$%04X"},   {"AND", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"BIT", 2, "$%02X"},   {"AND", 2, "$%02X"},     {"ROL", 2, "$%02X"},     {"RMB2", 2, "$%02X"},
-    {"PLP", 1, ""},        {"AND", 2, "#$%02X"},    {"ROL", 1, "A"},         {"???", 1, ""},
-    {"BIT", 3, "$%04X"},   {"AND", 3, "$%04X"},     {"ROL", 3, "$%04X"},     {"BBR2", 3, "$%02X,$%04X"},
-    {"BMI", 2, "$%04X"},   {"AND", 2, "($%02X),Y"}, {"AND", 2, "($%02X)"},   {"???", 1, ""},
-    {"BIT", 2, "$%02X,X"}, {"AND", 2, "$%02X,X"},   {"ROL", 2, "$%02X,X"},   {"RMB3", 2, "$%02X"},
-    {"SEC", 1, ""},        {"AND", 3, "$%04X,Y"},   {"DEC", 1, "A"},         {"???", 1, ""},
-    {"BIT", 3, "$%04X,X"}, {"AND", 3, "$%04X,X"},   {"ROL", 3, "$%04X,X"},   {"BBR3", 3, "$%02X,$%04X"},
-    {"RTI", 1, ""},        {"EOR", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"???", 1, ""},        {"EOR", 2, "$%02X"},     {"LSR", 2, "$%02X"},     {"RMB4", 2, "$%02X"},
-    {"PHA", 1, ""},        {"EOR", 2, "#$%02X"},    {"LSR", 1, "A"},         {"???", 1, ""},
-    {"JMP", 3, "$%04X"},   {"EOR", 3, "$%04X"},     {"LSR", 3, "$%04X"},     {"BBR4", 3, "$%02X,$%04X"},
-    {"BVC", 2, "$%04X"},   {"EOR", 2, "($%02X),Y"}, {"EOR", 2, "($%02X)"},   {"???", 1, ""},
-    {"???", 1, ""},        {"EOR", 2, "$%02X,X"},   {"LSR", 2, "$%02X,X"},   {"RMB5", 2, "$%02X"},
-    {"CLI", 1, ""},        {"EOR", 3, "$%04X,Y"},   {"PHY", 1, ""},          {"???", 1, ""},
-    {"???", 1, ""},        {"EOR", 3, "$%04X,X"},   {"LSR", 3, "$%04X,X"},   {"BBR5", 3, "$%02X,$%04X"},
-    {"RTS", 1, ""},        {"ADC", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"STZ", 2, "$%02X"},   {"ADC", 2, "$%02X"},     {"ROR", 2, "$%02X"},     {"RMB6", 2, "$%02X"},
-    {"PLA", 1, ""},        {"ADC", 2, "#$%02X"},    {"ROR", 1, "A"},         {"???", 1, ""},
-    {"JMP", 3, "($%04X)"}, {"ADC", 3, "$%04X"},     {"ROR", 3, "$%04X"},     {"BBR6", 3, "$%02X,$%04X"},
-    {"BVS", 2, "$%04X"},   {"ADC", 2, "($%02X),Y"}, {"ADC", 2, "($%02X)"},   {"???", 1, ""},
-    {"STZ", 2, "$%02X,X"}, {"ADC", 2, "$%02X,X"},   {"ROR", 2, "$%02X,X"},   {"RMB7", 2, "$%02X"},
-    {"SEI", 1, ""},        {"ADC", 3, "$%04X,Y"},   {"PLY", 1, ""},          {"???", 1, ""},
-    {"JMP", 3, "($%04X,X)"},{"ADC", 3, "$%04X,X"},  {"ROR", 3, "$%04X,X"},   {"BBR7", 3, "$%02X,$%04X"},
-    {"BRA", 2, "$%04X"},   {"STA", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"STY", 2, "$%02X"},   {"STA", 2, "$%02X"},     {"STX", 2, "$%02X"},     {"SMB0", 2, "$%02X"},
-    {"DEY", 1, ""},        {"BIT", 2, "#$%02X"},    {"TXA", 1, ""},          {"???", 1, ""},
-    {"STY", 3, "$%04X"},   {"STA", 3, "$%04X"},     {"STX", 3, "$%04X"},     {"BBS0", 3, "$%02X,$%04X"},
-    {"BCC", 2, "$%04X"},   {"STA", 2, "($%02X),Y"}, {"STA", 2, "($%02X)"},   {"???", 1, ""},
-    {"STY", 2, "$%02X,X"}, {"STA", 2, "$%02X,X"},   {"STX", 2, "$%02X,Y"},   {"SMB1", 2, "$%02X"},
-    {"TYA", 1, ""},        {"STA", 3, "$%04X,Y"},   {"TXS", 1, ""},          {"???", 1, ""},
-    {"STZ", 3, "$%04X"},   {"STA", 3, "$%04X,X"},   {"STZ", 3, "$%04X,X"},   {"BBS1", 3, "$%02X,$%04X"},
-    {"LDY", 2, "#$%02X"},  {"LDA", 2, "($%02X,X)"}, {"LDX", 2, "#$%02X"},    {"???", 1, ""},
-    {"LDY", 2, "$%02X"},   {"LDA", 2, "$%02X"},     {"LDX", 2, "$%02X"},     {"SMB2", 2, "$%02X"},
-    {"TAY", 1, ""},        {"LDA", 2, "#$%02X"},    {"TAX", 1, ""},          {"???", 1, ""},
-    {"LDY", 3, "$%04X"},   {"LDA", 3, "$%04X"},     {"LDX", 3, "$%04X"},     {"BBS2", 3, "$%02X,$%04X"},
-    {"BCS", 2, "$%04X"},   {"LDA", 2, "($%02X),Y"}, {"LDA", 2, "($%02X)"},   {"???", 1, ""},
-    {"LDY", 2, "$%02X,X"}, {"LDA", 2, "$%02X,X"},   {"LDX", 2, "$%02X,Y"},   {"SMB3", 2, "$%02X"},
-    {"CLV", 1, ""},        {"LDA", 3, "$%04X,Y"},   {"TSX", 1, ""},          {"???", 1, ""},
-    {"LDY", 3, "$%04X,X"}, {"LDA", 3, "$%04X,X"},   {"LDX", 3, "$%04X,Y"},   {"BBS3", 3, "$%02X,$%04X"},
-    {"CPY", 2, "#$%02X"},  {"CMP", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"CPY", 2, "$%02X"},   {"CMP", 2, "$%02X"},     {"DEC", 2, "$%02X"},     {"SMB4", 2, "$%02X"},
-    {"INY", 1, ""},        {"CMP", 2, "#$%02X"},    {"DEX", 1, ""},          {"WAI", 1, ""},
-    {"CPY", 3, "$%04X"},   {"CMP", 3, "$%04X"},     {"DEC", 3, "$%04X"},     {"BBS4", 3, "$%02X,$%04X"},
-    {"BNE", 2, "$%04X"},   {"CMP", 2, "($%02X),Y"}, {"CMP", 2, "($%02X)"},   {"???", 1, ""},
-    {"???", 1, ""},        {"CMP", 2, "$%02X,X"},   {"DEC", 2, "$%02X,X"},   {"SMB5", 2, "$%02X"},
-    {"CLD", 1, ""},        {"CMP", 3, "$%04X,Y"},   {"PHX", 1, ""},          {"STP", 1, ""},
-    {"???", 1, ""},        {"CMP", 3, "$%04X,X"},   {"DEC", 3, "$%04X,X"},   {"BBS5", 3, "$%02X,$%04X"},
-    {"CPX", 2, "#$%02X"},  {"SBC", 2, "($%02X,X)"}, {"???", 1, ""},          {"???", 1, ""},
-    {"CPX", 2, "$%02X"},   {"SBC", 2, "$%02X"},     {"INC", 2, "$%02X"},     {"SMB6", 2, "$%02X"},
-    {"INX", 1, ""},        {"SBC", 2, "#$%02X"},    {"NOP", 1, ""},          {"???", 1, ""},
-    {"CPX", 3, "$%04X"},   {"SBC", 3, "$%04X"},     {"INC", 3, "$%04X"},     {"BBS6", 3, "$%02X,$%04X"},
-    {"BEQ", 2, "$%04X"},   {"SBC", 2, "($%02X),Y"}, {"SBC", 2, "($%02X)"},   {"???", 1, ""},
-    {"???", 1, ""},        {"SBC", 2, "$%02X,X"},   {"INC", 2, "$%02X,X"},   {"SMB7", 2, "$%02X"},
-    {"SED", 1, ""},        {"SBC", 3, "$%04X,Y"},   {"PLX", 1, ""},          {"???", 1, ""},
-    {"???", 1, ""},        {"SBC", 3, "$%04X,X"},   {"INC", 3, "$%04X,X"},   {"BBS7", 3, "$%02X,$%04X"},
-};
-
 cpu_window::cpu_window(emulator& emu)
 {
   // Set up CPU state callback
@@ -104,6 +29,9 @@ cpu_window::cpu_window(emulator& emu)
     state.x = emu_state.x;
     state.y = emu_state.y;
     state.total_cycles = emu_state.total_cycles;
+    state.instructions_executed = emu_state.instructions_executed;
+    state.instructions_per_host_second = emu_state.instructions_per_host_second;
+    state.idle_cycles_skipped = emu_state.idle_cycles_skipped;
     state.initialized = emu_state.initialized;
     return state;
   };
@@ -156,55 +84,10 @@ std::string cpu_window::disassembleInstruction(uint16_t address)
   }
 
   uint8_t opcode = memory_read_callback_(address);
-  const OpcodeInfo &info = OPCODES[opcode];
-  
-  char buf[64];
-  
-  if (info.bytes == 1)
-  {
-    if (strlen(info.mode) > 0)
-    {
-      snprintf(buf, sizeof(buf), "%s %s", info.mnemonic, info.mode);
-    }
-    else
-    {
-      snprintf(buf, sizeof(buf), "%s", info.mnemonic);
-    }
-  }
-  else if (info.bytes == 2)
-  {
-    uint8_t op1 = memory_read_callback_(address + 1);
-    // Handle relative branches - calculate target address
-    if (opcode == 0x10 || opcode == 0x30 || opcode == 0x50 || opcode == 0x70 ||
-        opcode == 0x90 || opcode == 0xB0 || opcode == 0xD0 || opcode == 0xF0 ||
-        opcode == 0x80) // BRA
-    {
-      int8_t offset = static_cast<int8_t>(op1);
-      uint16_t target = address + 2 + offset;
-      snprintf(buf, sizeof(buf), "%s $%04X", info.mnemonic, target);
-    }
-    else
-    {
-      char operand[32];
-      snprintf(operand, sizeof(operand), info.mode, op1);
-      snprintf(buf, sizeof(buf), "%s %s", info.mnemonic, operand);
-    }
-  }
-  else if (info.bytes == 3)
-  {
-    uint8_t op1 = memory_read_callback_(address + 1);
-    uint8_t op2 = memory_read_callback_(address + 2);
-    uint16_t addr16 = static_cast<uint16_t>(op1) | (static_cast<uint16_t>(op2) << 8);
-    char operand[32];
-    snprintf(operand, sizeof(operand), info.mode, addr16);
-    snprintf(buf, sizeof(buf), "%s %s", info.mnemonic, operand);
-  }
-  else
-  {
-    snprintf(buf, sizeof(buf), "???");
-  }
-
-  return std::string(buf);
+  int bytes = disassembler::OPCODES[opcode].bytes;
+  uint8_t op1 = bytes >= 2 ? memory_read_callback_(address + 1) : 0;
+  uint8_t op2 = bytes >= 3 ? memory_read_callback_(address + 2) : 0;
+  return disassembler::formatInstruction(address, opcode, op1, op2);
 }
 
 void cpu_window::render()
@@ -529,7 +412,7 @@ void cpu_window::renderDisassembly()
     for (int i = 0; i < disasm_lines_; ++i)
     {
       uint8_t opcode = memory_read_callback_(addr);
-      const OpcodeInfo &info = OPCODES[opcode];
+      const disassembler::opcode_info &info = disassembler::OPCODES[opcode];
       
       bool isCurrent = (i == 0);
       
@@ -605,6 +488,18 @@ void cpu_window::renderPerformance()
 
     // Progress bar for speed
     ImGui::ProgressBar(speed_percent / 100.0f, ImVec2(-1, 0), "");
+
+    // Raw run loop throughput, independent of audio-driven throttling
+    ImGui::Text("Instructions: %llu", static_cast<unsigned long long>(state_.instructions_executed));
+    ImGui::Text("Throughput: %.2f M instr/host sec", state_.instructions_per_host_second / 1000000.0);
+
+    // Share of emulated time fast-forwarded over keyboard poll and WAIT loops
+    if (state_.total_cycles > 0)
+    {
+      double idle_percent = 100.0 * static_cast<double>(state_.idle_cycles_skipped) /
+                            static_cast<double>(state_.total_cycles);
+      ImGui::Text("Idle skipped: %.1f%%", idle_percent);
+    }
   }
 }
 
@@ -78,6 +78,21 @@ debugger_window::debugger_window(emulator& emu)
   {
     return emu.getBreakpointManager();
   };
+
+  set_tracing_callback_ = [&emu](bool enabled)
+  {
+    emu.setTracing(enabled);
+  };
+
+  is_tracing_callback_ = [&emu]()
+  {
+    return emu.isTracing();
+  };
+
+  get_trace_recorder_callback_ = [&emu]()
+  {
+    return emu.getTraceRecorder();
+  };
 }
 
 void debugger_window::update(float deltaTime)
@@ -133,6 +148,11 @@ void debugger_window::render()
   if (ImGui::Begin(getName(), &open_))
   {
     renderControls();
+    if (show_trace_)
+    {
+      ImGui::Separator();
+      renderTrace();
+    }
     ImGui::Separator();
     renderDisassembly();
     if (show_breakpoints_)
@@ -226,6 +246,85 @@ void debugger_window::renderControls()
     show_breakpoints_ = !show_breakpoints_;
   }
   if (ImGui::IsItemHovered()) ImGui::SetTooltip(show_breakpoints_ ? "Hide breakpoints" : "Show breakpoints");
+
+  ImGui::SameLine();
+  bool tracing = is_tracing_callback_();
+  if (tracing)
+  {
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+  }
+  if (ImGui::Button(show_trace_ ? "TR" : "tr"))
+  {
+    show_trace_ = !show_trace_;
+  }
+  if (tracing)
+  {
+    ImGui::PopStyleColor();
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip(tracing ? "Execution trace (recording)" : "Execution trace");
+}
+
+void debugger_window::renderTrace()
+{
+  trace_recorder* tracer = get_trace_recorder_callback_();
+  if (!tracer)
+  {
+    return;
+  }
+
+  // Tracing runs the emulator one instruction at a time; the records go to
+  // a ring holding the most recent ones, or to a file while streaming
+  bool tracing = is_tracing_callback_();
+  if (ImGui::Checkbox("Record", &tracing))
+  {
+    set_tracing_callback_(tracing);
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Record every executed instruction (slower)");
+
+  ImGui::SameLine();
+  ImGui::TextDisabled("%zu buffered, %llu total", tracer->getBufferedCount(),
+                      static_cast<unsigned long long>(tracer->getRecordCount()));
+
+  ImGui::SetNextItemWidth(-150);
+  ImGui::InputText("##tracepath", trace_path_, sizeof(trace_path_));
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Trace file (decode with a2e-tracedump)");
+
+  const bool streaming = tracer->isStreaming();
+  ImGui::SameLine();
+  if (streaming)
+  {
+    if (ImGui::Button("Stop"))
+    {
+      tracer->stopStreaming();
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Finish the trace file");
+  }
+  else
+  {
+    if (ImGui::Button("Stream"))
+    {
+      if (tracer->startStreaming(trace_path_))
+      {
+        set_tracing_callback_(true);
+      }
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Write new records to the file as they are made");
+  }
+
+  ImGui::SameLine();
+  ImGui::BeginDisabled(streaming);
+  if (ImGui::Button("Save"))
+  {
+    tracer->saveBuffer(trace_path_);
+  }
+  ImGui::EndDisabled();
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Write the buffered records to the file");
+
+  if (tracer->getDroppedCount() > 0)
+  {
+    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "%llu records dropped (writer behind)",
+                       static_cast<unsigned long long>(tracer->getDroppedCount()));
+  }
 }
 
 void debugger_window::renderDisassembly()
@@ -402,6 +501,35 @@ void debugger_window::renderBreakpoints()
       return;
     }
 
+    // Add a breakpoint or watchpoint by description
+    ImGui::SetNextItemWidth(-40);
+    bool add_pressed = ImGui::InputTextWithHint("##watchspec", "write $C0E9 if A==#$FF", watch_spec_,
+                                                sizeof(watch_spec_), ImGuiInputTextFlags_EnterReturnsTrue);
+    if (ImGui::IsItemHovered())
+    {
+      ImGui::SetTooltip("exec|read|write ADDR[-END] [if CONDITION]\n"
+                        "e.g. read $2000-$3FFF, exec $0800 if [$36]!=$F0");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add") || add_pressed)
+    {
+      std::string error;
+      if (bp_mgr->addWatchpoint(watch_spec_, error))
+      {
+        watch_spec_[0] = '\0';
+        watch_error_.clear();
+        updateDisassemblyCache(cache_center_address_);
+      }
+      else
+      {
+        watch_error_ = error;
+      }
+    }
+    if (!watch_error_.empty())
+    {
+      ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", watch_error_.c_str());
+    }
+
     const auto& breakpoints = bp_mgr->getBreakpoints();
 
     if (breakpoints.empty())
@@ -416,16 +544,18 @@ void debugger_window::renderBreakpoints()
       if (ImGui::BeginTable("BreakpointList", show_type_col ? 4 : 3,
                            ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_NoPadOuterX))
       {
-        ImGui::TableSetupColumn("Addr", ImGuiTableColumnFlags_WidthFixed, 52.0f);
+        ImGui::TableSetupColumn("Addr", ImGuiTableColumnFlags_WidthStretch);
         if (show_type_col)
           ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 45.0f);
         ImGui::TableSetupColumn("##en", ImGuiTableColumnFlags_WidthFixed, 24.0f);
-        ImGui::TableSetupColumn("##del", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("##del", ImGuiTableColumnFlags_WidthFixed, 24.0f);
 
-        std::vector<std::pair<uint16_t, breakpoint_type>> to_remove;
+        size_t to_remove = breakpoints.size();
 
-        for (const auto& bp : breakpoints)
+        for (size_t i = 0; i < breakpoints.size(); ++i)
         {
+          const auto& bp = breakpoints[i];
+          ImGui::PushID(static_cast<int>(i));
           ImGui::TableNextRow();
 
           // Address column - color-coded by type when type column hidden
@@ -436,8 +566,12 @@ void debugger_window::renderBreakpoints()
           else if (bp.type == breakpoint_type::WRITE)
             type_color = ImVec4(1.0f, 0.5f, 0.0f, 1.0f);  // Orange for write
 
-          char addr_buf[8];
-          std::snprintf(addr_buf, sizeof(addr_buf), "$%04X", bp.address);
+          char addr_buf[24];
+          const char* bank = breakpoint_manager::bankPrefix(bp.bank);
+          if (bp.end_address != bp.address)
+            std::snprintf(addr_buf, sizeof(addr_buf), "%s$%04X-$%04X", bank, bp.address, bp.end_address);
+          else
+            std::snprintf(addr_buf, sizeof(addr_buf), "%s$%04X", bank, bp.address);
 
           ImGui::PushStyleColor(ImGuiCol_Text, show_type_col ? ImVec4(0.6f, 0.6f, 1.0f, 1.0f) : type_color);
           if (ImGui::Selectable(addr_buf, false, ImGuiSelectableFlags_AllowOverlap))
@@ -448,6 +582,14 @@ void debugger_window::renderBreakpoints()
           }
           ImGui::PopStyleColor();
 
+          // Condition after the address, full text on hover
+          if (!bp.condition.empty())
+          {
+            ImGui::SameLine();
+            ImGui::TextDisabled("if %s", bp.condition.getText().c_str());
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", breakpoint_manager::describe(bp).c_str());
+          }
+
           // Type column - only if wide enough
           if (show_type_col)
           {
@@ -461,30 +603,27 @@ void debugger_window::renderBreakpoints()
           // Enable checkbox
           ImGui::TableNextColumn();
           bool enabled = bp.enabled;
-          char checkbox_id[32];
-          std::snprintf(checkbox_id, sizeof(checkbox_id), "##en_%04X_%d", bp.address, static_cast<int>(bp.type));
-          if (ImGui::Checkbox(checkbox_id, &enabled))
+          if (ImGui::Checkbox("##en", &enabled))
           {
-            bp_mgr->setEnabled(bp.address, bp.type, enabled);
+            bp_mgr->setEnabledAt(i, enabled);
           }
 
           // Delete button
           ImGui::TableNextColumn();
-          char remove_id[32];
-          std::snprintf(remove_id, sizeof(remove_id), "X##%04X_%d", bp.address, static_cast<int>(bp.type));
-          if (ImGui::SmallButton(remove_id))
+          if (ImGui::SmallButton("X"))
           {
-            to_remove.push_back({bp.address, bp.type});
+            to_remove = i;
           }
+          ImGui::PopID();
         }
 
-        for (const auto& [addr, type] : to_remove)
+        ImGui::EndTable();
+
+        if (to_remove < breakpoints.size())
         {
-          bp_mgr->removeBreakpoint(addr, type);
+          bp_mgr->removeBreakpointAt(to_remove);
           updateDisassemblyCache(cache_center_address_);
         }
-
-        ImGui::EndTable();
       }
     }
   }
@@ -538,7 +677,8 @@ void debugger_window::updateDisassemblyCache(uint16_t center_address)
     line.byte_count = byte_count;
     line.instruction = extractMnemonic(instr);
     line.is_current_pc = (address == current_pc_);
-    line.has_exec_breakpoint = bp_mgr ? bp_mgr->hasBreakpoint(address, breakpoint_type::EXECUTION) : false;
+    line.has_exec_breakpoint = bp_mgr ? bp_mgr->hasBreakpoint(address, breakpoint_type::EXECUTION,
+        address >= 0xD000 ? bp_mgr->bankAt(address, breakpoint_type::EXECUTION) : memory_bank::ANY) : false;
     line.has_read_breakpoint = bp_mgr ? bp_mgr->hasBreakpoint(address, breakpoint_type::READ) : false;
     line.has_write_breakpoint = bp_mgr ? bp_mgr->hasBreakpoint(address, breakpoint_type::WRITE) : false;
 
@@ -602,7 +742,10 @@ void debugger_window::handleBreakpointClick(uint16_t address, breakpoint_type ty
   breakpoint_manager* bp_mgr = get_breakpoint_mgr_callback_();
   if (bp_mgr)
   {
-    bp_mgr->toggleBreakpoint(address, type);
+    // In $D000-$FFFF the breakpoint is for whatever is mapped there now
+    // (ROM or a language card bank), so it doesn't fire in the others
+    memory_bank bank = address >= 0xD000 ? bp_mgr->bankAt(address, type) : memory_bank::ANY;
+    bp_mgr->toggleBreakpoint(address, type, bank);
     // Force cache update to reflect breakpoint change
     updateDisassemblyCache(cache_center_address_);
   }
@@ -84,24 +84,20 @@ disk_window::disk_window(emulator& emu)
     return disk ? disk->getDiskImage(drive) : nullptr;
   };
 
+  // Inserts and ejects go through the emulator so input recording sees them
   insert_disk_callback_ = [&emu](int drive, const std::string& path) -> bool
   {
-    auto* disk = emu.getDiskController();
-    return disk ? disk->insertDisk(drive, path) : false;
+    return emu.insertDisk(drive, path);
   };
 
   eject_disk_callback_ = [&emu](int drive) -> void
   {
-    auto* disk = emu.getDiskController();
-    if (disk) disk->ejectDisk(drive);
+    emu.ejectDisk(drive);
   };
 
   // Create disk callback - creates a new DOS 3.3 formatted disk and inserts it
   create_disk_callback_ = [&emu](int drive, const std::string& path) -> bool
   {
-    auto* disk = emu.getDiskController();
-    if (!disk) return false;
-
     // Create a new DOS 3.3 formatted disk image
     auto new_disk = WozDiskImage::createEmptyDOS33Disk(path);
     if (!new_disk)
@@ -110,7 +106,7 @@ disk_window::disk_window(emulator& emu)
     }
 
     // Insert the newly created disk
-    return disk->insertDisk(drive, path);
+    return emu.insertDisk(drive, path);
   };
 
   // Create file browser dialog for loading disks
@@ -7,7 +7,7 @@
 memory_access_window::memory_access_window(emulator &emu)
 {
   // Initialize frame buffer with grey
-  frame_buffer_.resize(TEXTURE_SIZE * TEXTURE_SIZE, COLOR_GREY);
+  frame_buffer_.resize(TEXTURE_SIZE * TEXTURE_SIZE, memory_access_tracker::COLOR_GREY);
 
   // Set up callbacks
   get_tracker_ = [&emu]()
@@ -19,6 +19,11 @@ memory_access_window::memory_access_window(emulator &emu)
   {
     return emu.peekMemory(addr);
   };
+
+  get_cycles_ = [&emu]()
+  {
+    return emu.getCPUState().total_cycles;
+  };
 }
 
 memory_access_window::~memory_access_window()
@@ -80,9 +85,6 @@ void memory_access_window::update([[maybe_unused]] float deltaTime)
   // Enable tracking when window is open
   tracker->setEnabled(true);
 
-  // Update tracker fade timers
-  tracker->update(deltaTime);
-
   // Update frame buffer and upload texture
   updateFrameBuffer();
   uploadTexture();
@@ -96,46 +98,7 @@ void memory_access_window::updateFrameBuffer()
     return;
   }
 
-  for (uint32_t addr = 0; addr < 65536; ++addr)
-  {
-    const auto &entry = tracker->getEntry(static_cast<uint16_t>(addr));
-
-    if (entry.type == access_type::NONE || entry.fade_timer <= 0.0f)
-    {
-      frame_buffer_[addr] = COLOR_GREY;
-    }
-    else
-    {
-      // Calculate fade factor (1.0 = full color, 0.0 = grey)
-      float fade = entry.fade_timer / memory_access_tracker::FADE_DURATION;
-
-      uint32_t target_color = (entry.type == access_type::READ) ? COLOR_GREEN : COLOR_RED;
-      frame_buffer_[addr] = interpolateColor(COLOR_GREY, target_color, fade);
-    }
-  }
-}
-
-uint32_t memory_access_window::interpolateColor(uint32_t colorA, uint32_t colorB, float t) const
-{
-  // Extract components (ABGR format)
-  uint8_t a_a = (colorA >> 24) & 0xFF;
-  uint8_t b_a = (colorA >> 16) & 0xFF;
-  uint8_t g_a = (colorA >> 8) & 0xFF;
-  uint8_t r_a = colorA & 0xFF;
-
-  uint8_t a_b = (colorB >> 24) & 0xFF;
-  uint8_t b_b = (colorB >> 16) & 0xFF;
-  uint8_t g_b = (colorB >> 8) & 0xFF;
-  uint8_t r_b = colorB & 0xFF;
-
-  // Interpolate
-  uint8_t a = static_cast<uint8_t>(a_a + (a_b - a_a) * t);
-  uint8_t b = static_cast<uint8_t>(b_a + (b_b - b_a) * t);
-  uint8_t g = static_cast<uint8_t>(g_a + (g_b - g_a) * t);
-  uint8_t r = static_cast<uint8_t>(r_a + (r_b - r_a) * t);
-
-  return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(b) << 16) |
-         (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(r);
+  tracker->buildHeatmap(get_cycles_(), frame_buffer_.data());
 }
 
 void memory_access_window::uploadTexture()
@@ -265,18 +228,17 @@ void memory_access_window::renderTooltip(uint16_t address)
   auto *tracker = get_tracker_();
   if (tracker)
   {
-    const auto &entry = tracker->getEntry(address);
     const char *access = "None";
-    if (entry.fade_timer > 0)
+    switch (tracker->getAccess(address, get_cycles_()))
     {
-      if (entry.type == access_type::READ)
-      {
-        access = "Read (recent)";
-      }
-      else if (entry.type == access_type::WRITE)
-      {
-        access = "Write (recent)";
-      }
+    case access_type::READ:
+      access = "Read (recent)";
+      break;
+    case access_type::WRITE:
+      access = "Write (recent)";
+      break;
+    default:
+      break;
     }
     ImGui::Text("Access:  %s", access);
   }
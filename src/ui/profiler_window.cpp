@@ -0,0 +1,305 @@
+#include "ui/profiler_window.hpp"
+#include "emulator/emulator.hpp"
+#include "emulator/disassembler.hpp"
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+profiler_window::profiler_window(emulator& emu)
+{
+  // Set up callbacks to emulator
+  get_profiler_callback_ = [&emu]()
+  {
+    return emu.getProfiler();
+  };
+
+  set_profiling_callback_ = [&emu](bool enabled)
+  {
+    emu.setProfiling(enabled);
+  };
+
+  is_profiling_callback_ = [&emu]()
+  {
+    return emu.isProfiling();
+  };
+
+  memory_read_callback_ = [&emu](uint16_t addr)
+  {
+    return emu.peekMemory(addr);
+  };
+}
+
+void profiler_window::update(float deltaTime)
+{
+  guest_profiler* profiler = get_profiler_callback_();
+  if (!open_ || !profiler)
+  {
+    return;
+  }
+
+  since_refresh_ += deltaTime;
+  if (since_refresh_ >= REFRESH_INTERVAL)
+  {
+    refresh(*profiler);
+    since_refresh_ = 0.0f;
+  }
+}
+
+void profiler_window::refresh(const guest_profiler& profiler)
+{
+  hot_spots_ = profiler.getHotSpots(HOT_SPOT_ROWS);
+  functions_ = profiler.getFunctions();
+  call_edges_ = profiler.getCallEdges();
+  total_cycles_ = profiler.getTotalCycles();
+  total_instructions_ = profiler.getTotalInstructions();
+
+  const auto& opcodes = profiler.getOpcodeStats();
+  opcode_order_.clear();
+  for (int op = 0; op < 256; ++op)
+  {
+    if (opcodes[op].count)
+    {
+      opcode_order_.push_back(op);
+    }
+  }
+  std::sort(opcode_order_.begin(), opcode_order_.end(), [&opcodes](int a, int b)
+  {
+    return opcodes[a].cycles > opcodes[b].cycles;
+  });
+}
+
+double profiler_window::percentOfTotal(uint64_t cycles) const
+{
+  return total_cycles_ ? 100.0 * static_cast<double>(cycles) / static_cast<double>(total_cycles_) : 0.0;
+}
+
+void profiler_window::render()
+{
+  if (!open_)
+  {
+    return;
+  }
+
+  ImGui::SetNextWindowSize(ImVec2(520, 480), ImGuiCond_FirstUseEver);
+
+  if (ImGui::Begin(getName(), &open_))
+  {
+    guest_profiler* profiler = get_profiler_callback_();
+    if (!profiler)
+    {
+      ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Emulator not initialized");
+      ImGui::End();
+      return;
+    }
+
+    renderControls(*profiler);
+    ImGui::Separator();
+
+    if (ImGui::BeginTabBar("ProfilerTabs"))
+    {
+      if (ImGui::BeginTabItem("Hot Spots"))
+      {
+        renderHotSpots(*profiler);
+        ImGui::EndTabItem();
+      }
+      if (ImGui::BeginTabItem("Functions"))
+      {
+        renderFunctions();
+        ImGui::EndTabItem();
+      }
+      if (ImGui::BeginTabItem("Call Graph"))
+      {
+        renderCallGraph();
+        ImGui::EndTabItem();
+      }
+      if (ImGui::BeginTabItem("Opcodes"))
+      {
+        renderOpcodes(*profiler);
+        ImGui::EndTabItem();
+      }
+      ImGui::EndTabBar();
+    }
+  }
+  ImGui::End();
+}
+
+void profiler_window::renderControls(guest_profiler& profiler)
+{
+  // Profiling runs the emulator one instruction at a time
+  bool profiling = is_profiling_callback_();
+  if (ImGui::Checkbox("Profile", &profiling))
+  {
+    set_profiling_callback_(profiling);
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Count every executed instruction (slower)");
+
+  ImGui::SameLine();
+  if (ImGui::Button("Reset"))
+  {
+    profiler.clear();
+    refresh(profiler);
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Discard all counts");
+
+  ImGui::SameLine();
+  ImGui::TextDisabled("%llu instructions, %llu cycles",
+                      static_cast<unsigned long long>(total_instructions_),
+                      static_cast<unsigned long long>(total_cycles_));
+
+  ImGui::SetNextItemWidth(-110);
+  ImGui::InputText("##exportpath", export_path_, sizeof(export_path_));
+  ImGui::SameLine();
+  if (ImGui::Button("Export Stacks", ImVec2(100, 0)))
+  {
+    profiler.writeCollapsedStacks(export_path_);
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Cycles per call path, collapsed-stack format for flame graphs");
+
+  ImGui::SetNextItemWidth(-110);
+  ImGui::InputText("##reportpath", report_path_, sizeof(report_path_));
+  ImGui::SameLine();
+  if (ImGui::Button("Write Report", ImVec2(100, 0)))
+  {
+    profiler.writeReport(report_path_);
+  }
+  if (ImGui::IsItemHovered()) ImGui::SetTooltip("Hot spots, functions and opcodes as text");
+}
+
+void profiler_window::renderHotSpots(const guest_profiler& profiler)
+{
+  if (ImGui::BeginTable("HotSpots", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Location", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+    ImGui::TableSetupColumn("Instr", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+    ImGui::TableSetupColumn("Cycles", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("%", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+    ImGui::TableSetupColumn("Instruction", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+
+    for (const auto& spot : hot_spots_)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(guest_profiler::describeLocation(spot.location).c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(spot.instructions));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(spot.cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", percentOfTotal(spot.cycles));
+      ImGui::TableNextColumn();
+
+      // Disassemble only while the location's bank is mapped in
+      uint16_t addr = guest_profiler::locationAddress(spot.location);
+      if (profiler.locationOf(addr) == spot.location)
+      {
+        uint8_t opcode = memory_read_callback_(addr);
+        std::string instr = disassembler::formatInstruction(addr, opcode,
+            memory_read_callback_(static_cast<uint16_t>(addr + 1)),
+            memory_read_callback_(static_cast<uint16_t>(addr + 2)));
+        ImGui::TextUnformatted(instr.c_str());
+      }
+      else
+      {
+        ImGui::TextDisabled("(not mapped)");
+      }
+    }
+    ImGui::EndTable();
+  }
+}
+
+void profiler_window::renderFunctions()
+{
+  if (ImGui::BeginTable("Functions", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Entry", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+    ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+    ImGui::TableSetupColumn("Inclusive", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("%", ImGuiTableColumnFlags_WidthFixed, 45.0f);
+    ImGui::TableSetupColumn("Exclusive", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("% ", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+
+    for (const auto& f : functions_)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(guest_profiler::describeLocation(f.entry).c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(f.calls));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(f.inclusive_cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", percentOfTotal(f.inclusive_cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(f.exclusive_cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", percentOfTotal(f.exclusive_cycles));
+    }
+    ImGui::EndTable();
+  }
+}
+
+void profiler_window::renderCallGraph()
+{
+  if (ImGui::BeginTable("CallGraph", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Caller", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+    ImGui::TableSetupColumn("Callee", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+    ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+    ImGui::TableSetupColumn("Cycles", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("%", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+
+    for (const auto& edge : call_edges_)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(guest_profiler::describeLocation(edge.caller).c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(guest_profiler::describeLocation(edge.callee).c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(edge.calls));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(edge.cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", percentOfTotal(edge.cycles));
+    }
+    ImGui::EndTable();
+  }
+}
+
+void profiler_window::renderOpcodes(const guest_profiler& profiler)
+{
+  const auto& opcodes = profiler.getOpcodeStats();
+
+  if (ImGui::BeginTable("Opcodes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Op", ImGuiTableColumnFlags_WidthFixed, 40.0f);
+    ImGui::TableSetupColumn("Mnemonic", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+    ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("Cycles", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+    ImGui::TableSetupColumn("%", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+
+    for (int op : opcode_order_)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("$%02X", op);
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(disassembler::OPCODES[op].mnemonic);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(opcodes[op].count));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(opcodes[op].cycles));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", percentOfTotal(opcodes[op].cycles));
+    }
+    ImGui::EndTable();
+  }
+}
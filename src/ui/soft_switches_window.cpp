@@ -68,6 +68,7 @@ void soft_switches_window::render()
     renderSwitch("HIRES", state.graphics_mode == Apple2e::GraphicsMode::HIRES, "HIRES", "LORES");
     renderSwitch("80COL", state.col80_mode, "80 COL", "40 COL");
     renderSwitch("ALTCHAR", state.altchar_mode, "ALT", "PRIMARY");
+    renderSwitch("DHIRES", state.dhires, "DOUBLE", "SINGLE");
 
     // Memory Management Section
     renderSectionHeader("Memory Management");
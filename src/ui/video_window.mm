@@ -16,8 +16,9 @@ video_window::video_window(emulator& emu)
   };
 }
 
-video_window::~video_window()
+bool video_window::initializeTexture(void *device)
 {
+  return sink_.initialize(device);
 }
 
 uint8_t video_window::convertKeyCode(int key, bool shift, bool ctrl, bool caps_lock)
@@ -195,8 +196,11 @@ void video_window::update([[maybe_unused]] float deltaTime)
     return;
   }
 
-  // Update video display (generates new frame)
-  video_display_->update();
+  // Update video display (redraws what changed) and upload it, if anything did
+  if (video_display_->update())
+  {
+    sink_.present(video_display_->getFrame());
+  }
 }
 
 void video_window::render()
@@ -225,7 +229,7 @@ void video_window::render()
       handleKeyboardInput();
     }
 
-    void *texture = video_display_->getTexture();
+    void *texture = sink_.getTexture();
     if (texture)
     {
       // Get available content region size
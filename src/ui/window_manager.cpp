@@ -8,12 +8,6 @@ window_manager::~window_manager() = default;
 
 void window_manager::initialize(emulator& emu, void* metal_device)
 {
-  // Initialize video texture with Metal device (needed before creating video window)
-  if (metal_device)
-  {
-    emu.initializeVideoTexture(metal_device);
-  }
-
   // Create CPU window
   auto cpu_win = std::make_unique<cpu_window>(emu);
   cpu_win->setOpen(true);
@@ -29,6 +23,10 @@ void window_manager::initialize(emulator& emu, void* metal_device)
   // Create video window
   auto vid_win = std::make_unique<video_window>(emu);
   vid_win->setOpen(true);
+  if (metal_device)
+  {
+    vid_win->initializeTexture(metal_device);
+  }
   video_window_ = vid_win.get();
   windows_.push_back(std::move(vid_win));
 
@@ -44,6 +42,12 @@ void window_manager::initialize(emulator& emu, void* metal_device)
   debugger_window_ = dbg_win.get();
   windows_.push_back(std::move(dbg_win));
 
+  // Create profiler window
+  auto prof_win = std::make_unique<profiler_window>(emu);
+  prof_win->setOpen(false);  // Start closed by default
+  profiler_window_ = prof_win.get();
+  windows_.push_back(std::move(prof_win));
+
   // Create memory access window
   auto mem_access_win = std::make_unique<memory_access_window>(emu);
   mem_access_win->setOpen(false);  // Start closed by default
@@ -111,6 +115,11 @@ void window_manager::loadState(preferences& prefs)
     debugger_window_->loadState(prefs);
   }
 
+  if (profiler_window_)
+  {
+    profiler_window_->setOpen(prefs.getBool("window.profiler.visible", false));
+  }
+
   if (memory_access_window_)
   {
     memory_access_window_->setOpen(prefs.getBool("window.memory_access.visible", false));
@@ -163,6 +172,11 @@ void window_manager::saveState(preferences& prefs)
     debugger_window_->saveState(prefs);
   }
 
+  if (profiler_window_)
+  {
+    prefs.setBool("window.profiler.visible", profiler_window_->isOpen());
+  }
+
   if (memory_access_window_)
   {
     prefs.setBool("window.memory_access.visible", memory_access_window_->isOpen());
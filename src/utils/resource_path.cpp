@@ -0,0 +1,42 @@
+#include "utils/resource_path.hpp"
+#include <string>
+#include <iostream>
+#include <filesystem>
+
+namespace
+{
+std::string resource_path_override;
+}
+
+std::string getResourcePath() {
+    if (!resource_path_override.empty()) {
+        return resource_path_override;
+    }
+    return findResourcePath();
+}
+
+std::string getResourcePath(const std::string& resourceName) {
+    return getResourcePath() + resourceName;
+}
+
+void setResourcePath(const std::string& path) {
+    resource_path_override = path;
+    if (!resource_path_override.empty() && resource_path_override.back() != '/') {
+        resource_path_override += '/';
+    }
+}
+
+#ifndef __APPLE__
+// No bundle outside macOS: look for resources/ next to or above the working
+// directory, as when running from the source or build directory
+std::string findResourcePath() {
+    if (std::filesystem::exists("../resources/roms")) {
+        return "../";
+    } else if (std::filesystem::exists("./resources/roms")) {
+        return "./";
+    } else {
+        std::cerr << "Warning: Could not find resources/roms directory. Using current directory." << std::endl;
+        return "./";
+    }
+}
+#endif
@@ -4,7 +4,7 @@
 #include <filesystem>
 #include <Foundation/Foundation.h>
 
-std::string getResourcePath() {
+std::string findResourcePath() {
     @autoreleasepool {
         NSBundle* mainBundle = [NSBundle mainBundle];
 
@@ -29,7 +29,3 @@ std::string getResourcePath() {
         }
     }
 }
-
-std::string getResourcePath(const std::string& resourceName) {
-    return getResourcePath() + resourceName;
-}
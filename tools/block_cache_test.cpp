@@ -0,0 +1,329 @@
+/**
+ * Block Cache Tests
+ *
+ * Validates the predecoded basic-block engine against known 65C02 results:
+ * instruction semantics and cycle counts, decimal mode, invalidation of
+ * self-modifying code, and physical page keying across bank switches.
+ *
+ * References:
+ * - WDC W65C02S datasheet (cycle counts)
+ * - "Decimal Mode" tutorial by Bruce Clark (65C02 BCD flags)
+ */
+
+#include "emulator/block_cache.hpp"
+#include "emulator/mmu.hpp"
+#include "emulator/ram.hpp"
+#include "emulator/rom.hpp"
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition) ASSERT_TRUE(!(condition))
+
+#define ASSERT_EQ(expected, actual) \
+    if ((expected) != (actual)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #expected " == " #actual << std::endl; \
+        std::cerr << "    Expected: 0x" << std::hex << static_cast<int>(expected) \
+                  << " Actual: 0x" << static_cast<int>(actual) << std::dec << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+/**
+ * Test fixture with an MMU and a block cache over it
+ */
+class BlockCacheTestFixture
+{
+public:
+    RAM ram;
+    ROM rom;
+    MMU mmu;
+    block_cache cache;
+    block_cache::registers regs;
+
+    BlockCacheTestFixture() : mmu(ram, rom), cache(mmu)
+    {
+        regs.sp = 0xFF;
+        regs.p = 0x24;
+    }
+
+    /**
+     * Store a program in main RAM
+     */
+    void load(uint16_t address, std::initializer_list<uint8_t> bytes)
+    {
+        for (uint8_t b : bytes)
+        {
+            mmu.write(address++, b);
+        }
+    }
+
+    /**
+     * Run from pc until the cycle budget is spent or the cache stops
+     */
+    uint64_t run(uint16_t pc, uint64_t cycles)
+    {
+        regs.pc = pc;
+        return cache.run(regs, 0, cache.getCycles() + cycles);
+    }
+};
+
+// ============================================================================
+// Test: Straight-line code and loop cycle counts
+// ============================================================================
+bool test_counting_loop()
+{
+    TEST_CASE("Counting loop result and cycle count");
+    BlockCacheTestFixture f;
+
+    // LDX #$05 / loop: DEX / BNE loop / BRK
+    f.load(0x0300, {0xA2, 0x05, 0xCA, 0xD0, 0xFD, 0x00});
+    f.run(0x0300, 1000);
+
+    ASSERT_EQ(0x00, f.regs.x);
+    ASSERT_EQ(0x0305, f.regs.pc);  // Stopped on BRK for the interpreter
+    // LDX 2 + 5 * DEX 2 + 4 taken BNE 3 + final BNE 2
+    ASSERT_EQ(2 + 10 + 12 + 2, f.cache.getCycles());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Page crossing penalty on indexed reads
+// ============================================================================
+bool test_page_cross_penalty()
+{
+    TEST_CASE("abs,X read page crossing adds a cycle");
+    BlockCacheTestFixture f;
+
+    f.mmu.write(0x1100, 0x42);
+    // LDX #$01 / LDA $10FF,X / BRK
+    f.load(0x0300, {0xA2, 0x01, 0xBD, 0xFF, 0x10, 0x00});
+    f.run(0x0300, 1000);
+
+    ASSERT_EQ(0x42, f.regs.a);
+    ASSERT_EQ(2 + 5, f.cache.getCycles());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: 65C02 decimal mode
+// ============================================================================
+bool test_decimal_mode()
+{
+    TEST_CASE("Decimal ADC/SBC results, flags and extra cycle");
+    BlockCacheTestFixture f;
+
+    // SED / CLC / LDA #$58 / ADC #$46 / BRK  ->  $04 with carry
+    f.load(0x0300, {0xF8, 0x18, 0xA9, 0x58, 0x69, 0x46, 0x00});
+    f.run(0x0300, 1000);
+
+    ASSERT_EQ(0x04, f.regs.a);
+    ASSERT_TRUE(f.regs.p & 0x01);
+    ASSERT_FALSE(f.regs.p & 0x02);
+    ASSERT_EQ(2 + 2 + 2 + 3, f.cache.getCycles());
+
+    // SEC / LDA #$12 / SBC #$21 / BRK  ->  $91 with borrow, N set
+    f.load(0x0400, {0x38, 0xA9, 0x12, 0xE9, 0x21, 0x00});
+    f.run(0x0400, 1000);
+
+    ASSERT_EQ(0x91, f.regs.a);
+    ASSERT_FALSE(f.regs.p & 0x01);
+    ASSERT_TRUE(f.regs.p & 0x80);
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Subroutine call and return through the stack
+// ============================================================================
+bool test_jsr_rts()
+{
+    TEST_CASE("JSR/RTS round trip");
+    BlockCacheTestFixture f;
+
+    // JSR $0310 / BRK ... $0310: LDY #$07 / RTS
+    f.load(0x0300, {0x20, 0x10, 0x03, 0x00});
+    f.load(0x0310, {0xA0, 0x07, 0x60});
+    f.run(0x0300, 1000);
+
+    ASSERT_EQ(0x07, f.regs.y);
+    ASSERT_EQ(0x0303, f.regs.pc);
+    ASSERT_EQ(0xFF, f.regs.sp);
+    ASSERT_EQ(0x03, f.mmu.read(0x01FF));  // Return address - 1 = $0302
+    ASSERT_EQ(0x02, f.mmu.read(0x01FE));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Self-modifying code invalidates its page
+// ============================================================================
+bool test_self_modifying_code()
+{
+    TEST_CASE("Store into decoded code is seen on next pass");
+    BlockCacheTestFixture f;
+
+    // LDA #$11 / BRK, then patch the operand from outside and rerun
+    f.load(0x0300, {0xA9, 0x11, 0x00});
+    f.run(0x0300, 1000);
+    ASSERT_EQ(0x11, f.regs.a);
+
+    f.mmu.write(0x0301, 0x22);
+    f.run(0x0300, 1000);
+    ASSERT_EQ(0x22, f.regs.a);
+
+    // LDA #$33 / STA $0506 / LDX #$00 / BRK
+    // The store patches the LDX operand later in the same block
+    f.load(0x0500, {0xA9, 0x33, 0x8D, 0x06, 0x05, 0xA2, 0x00, 0x00});
+    f.run(0x0500, 1000);
+    ASSERT_EQ(0x33, f.regs.x);
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Blocks are keyed by physical page
+// ============================================================================
+bool test_bank_switched_code()
+{
+    TEST_CASE("Language card bank switch selects different code");
+    BlockCacheTestFixture f;
+
+    // Put LDA #$01 / BRK in bank 2 and LDA #$02 / BRK in bank 1 at $D000
+    auto &main_ram = f.ram.getMainBank();
+    main_ram[0xD000] = 0xA9; main_ram[0xD001] = 0x01; main_ram[0xD002] = 0x00;
+    main_ram[0xC000] = 0xA9; main_ram[0xC001] = 0x02; main_ram[0xC002] = 0x00;
+
+    f.mmu.read(0xC080);  // Read bank 2 RAM
+    f.run(0xD000, 1000);
+    ASSERT_EQ(0x01, f.regs.a);
+
+    f.mmu.read(0xC088);  // Read bank 1 RAM
+    f.run(0xD000, 1000);
+    ASSERT_EQ(0x02, f.regs.a);
+
+    f.mmu.read(0xC080);
+    f.run(0xD000, 1000);
+    ASSERT_EQ(0x01, f.regs.a);
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Links into ROM blocks follow the memory map
+// ============================================================================
+bool test_rom_link_follows_memory_map()
+{
+    TEST_CASE("Linked ROM block is not reused after a bank switch");
+    BlockCacheTestFixture f;
+
+    // $0300: JMP $D000, with LDA #$01 / BRK in ROM and LDA #$02 / BRK in bank 2
+    f.load(0x0300, {0x4C, 0x00, 0xD0});
+    auto &rom_data = f.rom.getData();
+    rom_data[0x0000] = 0xA9; rom_data[0x0001] = 0x01; rom_data[0x0002] = 0x00;
+    auto &main_ram = f.ram.getMainBank();
+    main_ram[0xD000] = 0xA9; main_ram[0xD001] = 0x02; main_ram[0xD002] = 0x00;
+
+    f.run(0x0300, 1000);
+    ASSERT_EQ(0x01, f.regs.a);
+    f.run(0x0300, 1000);  // Through the recorded link
+    ASSERT_EQ(0x01, f.regs.a);
+
+    f.mmu.read(0xC080);  // Read bank 2 RAM
+    f.run(0x0300, 1000);
+    ASSERT_EQ(0x02, f.regs.a);
+
+    f.mmu.read(0xC082);  // Back to ROM
+    f.run(0x0300, 1000);
+    ASSERT_EQ(0x01, f.regs.a);
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: I/O space is never cached
+// ============================================================================
+bool test_io_space_not_cached()
+{
+    TEST_CASE("Code in $C000-$CFFF is left to the interpreter");
+    BlockCacheTestFixture f;
+
+    ASSERT_EQ(0u, f.run(0xC600, 1000));
+    ASSERT_EQ(0xC600, f.regs.pc);
+    ASSERT_EQ(0u, f.cache.getCycles());
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Block Cache Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        test_counting_loop,
+        test_page_cross_penalty,
+        test_decimal_mode,
+        test_jsr_rts,
+        test_self_modifying_code,
+        test_bank_switched_code,
+        test_rom_link_follows_memory_map,
+        test_io_space_not_cached,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}
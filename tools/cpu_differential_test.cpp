@@ -0,0 +1,555 @@
+/**
+ * Interpreter vs Block Cache Differential Tests
+ *
+ * Runs two identical machines side by side - one on the MOS6502 interpreter
+ * alone, one on the block cache with interpreter fallback - and compares
+ * registers and total cycle counts every few dozen cycles, then RAM at the
+ * end. Any difference means the block cache disagrees with the reference
+ * interpreter, and the PC where the diverging slice started is reported.
+ *
+ * The idle skipping tests run the firmware's keyboard polls and the Monitor
+ * WAIT routine with and without the idle detector fast-forwarding them, and
+ * compare registers, memory and cycle counts where both runs stop.
+ *
+ * Needs the Apple IIe ROMs: run from the source or build directory so that
+ * resources/roms/system can be found. The disk boot test also reads
+ * disk_images/, which is only in the source directory.
+ */
+
+#include <MOS6502/CPU6502.hpp>
+#include "emulator/block_cache.hpp"
+#include "emulator/disk2_controller.hpp"
+#include "emulator/idle_detector.hpp"
+#include "emulator/mmu.hpp"
+#include "emulator/ram.hpp"
+#include "emulator/rom.hpp"
+#include "apple2e/soft_switches.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+// Cycles per lockstep slice; registers are compared at the end of each
+static constexpr uint64_t SLICE_CYCLES = 64;
+
+static constexpr const char *DOS33_DISK = "disk_images/Apple DOS 3.3 January 1983.dsk";
+
+struct bus_read
+{
+    MMU *mmu;
+    uint8_t operator()(uint16_t address) const { return mmu->read(address); }
+};
+
+struct bus_write
+{
+    MMU *mmu;
+    void operator()(uint16_t address, uint8_t value) const { mmu->write(address, value); }
+};
+
+/**
+ * One Apple IIe core (no keyboard or speaker), optionally with a block cache,
+ * an idle detector and a Disk II controller in slot 6
+ */
+class Machine
+{
+public:
+    using CPU = MOS6502::CPU6502<bus_read, bus_write, MOS6502::CPUVariant::CMOS_65C02>;
+
+    RAM ram;
+    ROM rom;
+    MMU mmu;
+    CPU cpu;
+    std::unique_ptr<block_cache> cache;
+    std::unique_ptr<idle_detector> idle;
+    std::unique_ptr<Disk2Controller> disk;
+    std::vector<uint64_t> disk_clock;  // Cycle count the disk saw on each access
+    uint64_t skipped_cycles = 0;       // Cycles fast-forwarded over idle loops
+    bool rom_loaded = false;
+
+    explicit Machine(bool cached)
+        : mmu(ram, rom), cpu(bus_read{&mmu}, bus_write{&mmu})
+    {
+        rom_loaded = rom.loadAppleIIeROMs();
+        if (cached)
+        {
+            cache = std::make_unique<block_cache>(mmu);
+        }
+        cpu.reset();
+    }
+
+    /**
+     * Add a Disk II controller timed by this machine's clock, as the
+     * emulator does, and insert an image in drive 1
+     */
+    bool insertDisk(const std::string &path)
+    {
+        disk = std::make_unique<Disk2Controller>();
+        if (!disk->initialize())
+        {
+            return false;
+        }
+        disk->setWriteBack(false);
+        disk->setCycleCallback([this]()
+        {
+            disk_clock.push_back(cycles());
+            return disk_clock.back();
+        });
+        mmu.setDiskController(disk.get());
+        return disk->insertDisk(0, path);
+    }
+
+    uint64_t cycles() const
+    {
+        return cpu.getTotalCycles() + (cache ? cache->getCycles() : 0) + skipped_cycles;
+    }
+
+    void step()
+    {
+        mmu.setCycleCount(cycles());
+        cpu.executeInstruction();
+    }
+
+    block_cache::registers registers() const
+    {
+        block_cache::registers regs;
+        regs.pc = cpu.getPC();
+        regs.sp = cpu.getSP();
+        regs.p = cpu.getP();
+        regs.a = cpu.getA();
+        regs.x = cpu.getX();
+        regs.y = cpu.getY();
+        return regs;
+    }
+
+    /**
+     * Run cached blocks up to target, syncing registers with the interpreter
+     * @return Instructions executed by the cache
+     */
+    uint64_t runCached(uint64_t target)
+    {
+        block_cache::registers regs = registers();
+        uint64_t instructions = cache->run(regs, cpu.getTotalCycles(), target);
+        setRegisters(regs);
+        return instructions;
+    }
+
+    void setRegisters(const block_cache::registers &regs)
+    {
+        cpu.setPC(regs.pc);
+        cpu.setSP(regs.sp);
+        cpu.setP(regs.p);
+        cpu.setA(regs.a);
+        cpu.setX(regs.x);
+        cpu.setY(regs.y);
+    }
+
+    /**
+     * Run the interpreter to the first instruction boundary at or past end,
+     * or until the PC reaches stop_pc. With an idle detector, idle loops are
+     * fast-forwarded wherever one starts, as long as they fit before end.
+     */
+    void runUntil(uint64_t end, int stop_pc = -1)
+    {
+        while (cycles() < end && cpu.getPC() != stop_pc)
+        {
+            if (idle)
+            {
+                block_cache::registers regs = registers();
+                uint64_t skipped = idle->fastForward(regs, end - cycles());
+                if (skipped > 0)
+                {
+                    setRegisters(regs);
+                    skipped_cycles += skipped;
+                    continue;
+                }
+            }
+            step();
+        }
+    }
+
+    void load(uint16_t address, std::initializer_list<uint8_t> bytes)
+    {
+        for (uint8_t b : bytes)
+        {
+            mmu.write(address++, b);
+        }
+    }
+};
+
+static void printRegisters(const char *label, const block_cache::registers &r, uint64_t cycles)
+{
+    std::cerr << "    " << label << std::hex << std::uppercase << std::setfill('0')
+              << " PC=$" << std::setw(4) << r.pc
+              << " A=$" << std::setw(2) << static_cast<int>(r.a)
+              << " X=$" << std::setw(2) << static_cast<int>(r.x)
+              << " Y=$" << std::setw(2) << static_cast<int>(r.y)
+              << " SP=$" << std::setw(2) << static_cast<int>(r.sp)
+              << " P=$" << std::setw(2) << static_cast<int>(r.p)
+              << std::dec << std::setfill(' ') << " cycles=" << cycles << std::endl;
+}
+
+static bool sameState(const Machine &reference, const Machine &cached, uint16_t slice_pc,
+                      const char *label = "block cache: ")
+{
+    block_cache::registers a = reference.registers();
+    block_cache::registers b = cached.registers();
+    bool same = a.pc == b.pc && a.sp == b.sp && (a.p | 0x30) == (b.p | 0x30) &&
+                a.a == b.a && a.x == b.x && a.y == b.y &&
+                reference.cycles() == cached.cycles();
+    if (!same)
+    {
+        std::cerr << std::endl << "    Diverged in slice starting at $" << std::hex << std::uppercase
+                  << slice_pc << std::dec << std::endl;
+        printRegisters("interpreter: ", a, reference.cycles());
+        printRegisters(label, b, cached.cycles());
+    }
+    return same;
+}
+
+/**
+ * Run both machines for the given number of cycles in lockstep
+ * The cached machine leads; the reference runs the same instruction count.
+ */
+static bool runLockstep(Machine &reference, Machine &cached, uint64_t cycles)
+{
+    const uint64_t end = cached.cycles() + cycles;
+    while (cached.cycles() < end)
+    {
+        const uint16_t slice_pc = cached.cpu.getPC();
+        uint64_t instructions = cached.runCached(std::min(end, cached.cycles() + SLICE_CYCLES));
+        for (uint64_t i = 0; i < instructions; ++i)
+        {
+            reference.step();
+        }
+
+        if (instructions == 0)
+        {
+            // Interpreter fallback on both sides
+            cached.step();
+            reference.step();
+        }
+
+        if (!sameState(reference, cached, slice_pc))
+        {
+            return false;
+        }
+    }
+
+    if (reference.ram.getMainBank() != cached.ram.getMainBank() ||
+        reference.ram.getAuxBank() != cached.ram.getAuxBank())
+    {
+        std::cerr << std::endl << "    RAM contents differ" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Test: Cold boot through the ROM
+// ============================================================================
+bool test_cold_boot()
+{
+    TEST_CASE("Cold boot (Monitor and Applesoft init) matches interpreter");
+    Machine reference(false);
+    Machine cached(true);
+    ASSERT_TRUE(reference.rom_loaded && cached.rom_loaded);
+
+    ASSERT_TRUE(runLockstep(reference, cached, 3000000));
+
+    TEST_PASS();
+    return true;
+}
+
+/**
+ * Exhaustive ADC/SBC sweep: for every operand and accumulator value, fold
+ * the result and resulting flags into checksums at $11/$12
+ * @param decimal SED instead of CLD
+ * @param subtract SBC with carry set instead of ADC with carry clear
+ */
+static void loadArithmeticSweep(Machine &m, bool decimal, bool subtract)
+{
+    m.load(0x0300, {
+        static_cast<uint8_t>(decimal ? 0xF8 : 0xD8),  // SED / CLD
+        0xA9, 0x00,                                    // LDA #$00
+        0x85, 0x10,                                    // STA $10
+        0x85, 0x11,                                    // STA $11
+        0x85, 0x12,                                    // STA $12
+        0xA0, 0x00,                                    // $0309: LDY #$00
+        0x98,                                          // $030B: TYA
+        static_cast<uint8_t>(subtract ? 0x38 : 0x18),  // SEC / CLC
+        static_cast<uint8_t>(subtract ? 0xE5 : 0x65), 0x10, // SBC / ADC $10
+        0x08,                                          // PHP
+        0x45, 0x11,                                    // EOR $11
+        0x85, 0x11,                                    // STA $11
+        0x68,                                          // PLA
+        0x45, 0x12,                                    // EOR $12
+        0x85, 0x12,                                    // STA $12
+        0xC8,                                          // INY
+        0xD0, 0xEF,                                    // BNE $030B
+        0xE6, 0x10,                                    // INC $10
+        0xD0, 0xE9,                                    // BNE $0309
+        0x4C, 0x20, 0x03,                              // $0320: JMP $0320
+    });
+    m.cpu.setPC(0x0300);
+    m.cpu.setSP(0xFF);
+}
+
+static bool runArithmeticSweep(bool decimal, bool subtract)
+{
+    Machine reference(false);
+    Machine cached(true);
+    loadArithmeticSweep(reference, decimal, subtract);
+    loadArithmeticSweep(cached, decimal, subtract);
+
+    // 65536 iterations of about 40 cycles each
+    return runLockstep(reference, cached, 3000000);
+}
+
+bool test_binary_adc()
+{
+    TEST_CASE("Binary ADC sweep matches interpreter");
+    ASSERT_TRUE(runArithmeticSweep(false, false));
+    TEST_PASS();
+    return true;
+}
+
+bool test_binary_sbc()
+{
+    TEST_CASE("Binary SBC sweep matches interpreter");
+    ASSERT_TRUE(runArithmeticSweep(false, true));
+    TEST_PASS();
+    return true;
+}
+
+bool test_decimal_adc()
+{
+    TEST_CASE("Decimal ADC sweep matches interpreter");
+    ASSERT_TRUE(runArithmeticSweep(true, false));
+    TEST_PASS();
+    return true;
+}
+
+bool test_decimal_sbc()
+{
+    TEST_CASE("Decimal SBC sweep matches interpreter");
+    ASSERT_TRUE(runArithmeticSweep(true, true));
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Booting DOS 3.3 from disk
+// ============================================================================
+bool test_disk_boot()
+{
+    TEST_CASE("DOS 3.3 disk boot (RWTS nibble reads) matches interpreter");
+    Machine reference(false);
+    Machine cached(true);
+    ASSERT_TRUE(reference.rom_loaded && cached.rom_loaded);
+    ASSERT_TRUE(reference.insertDisk(DOS33_DISK) && cached.insertDisk(DOS33_DISK));
+
+    ASSERT_TRUE(runLockstep(reference, cached, 8000000));
+
+    // Every disk access, including the RWTS reads of $C08C,X from cached
+    // blocks, saw the same clock on both sides
+    ASSERT_TRUE(!reference.disk_clock.empty());
+    ASSERT_TRUE(reference.disk_clock == cached.disk_clock);
+
+    // DOS is in memory and has set up its $03D0 warm start vector
+    ASSERT_TRUE(reference.mmu.peek(0x03D0) == 0x4C);
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Idle skipping
+// ============================================================================
+
+/**
+ * Compare an idle-skipping run against the plain interpreter where both stopped
+ */
+static bool sameAfterIdle(const Machine &reference, const Machine &skipping, uint16_t start_pc)
+{
+    if (!sameState(reference, skipping, start_pc, "idle skip:   "))
+    {
+        return false;
+    }
+    if (reference.ram.getMainBank() != skipping.ram.getMainBank())
+    {
+        std::cerr << std::endl << "    RAM contents differ after skipping from $" << std::hex
+                  << std::uppercase << start_pc << std::dec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Enter a firmware keyboard poll with the internal $C100-$CFFF ROM mapped,
+ * the cursor on the top text line and its two blink bytes on the stack
+ */
+static void enterKeyboardPoll(Machine &m, uint16_t pc, uint8_t counter)
+{
+    m.mmu.write(Apple2e::SETINTCXROM, 0);
+    m.mmu.write(0x24, 0x05);      // CH
+    m.mmu.write(0x28, 0x00);      // BASL/BASH: $0400
+    m.mmu.write(0x29, 0x04);
+    m.mmu.write(0x4E, counter);   // Random seed counted while waiting
+    m.mmu.write(0x4F, 0x3E);
+    m.mmu.write(0x01F1, 0xFF);    // Cursor and saved screen character
+    m.mmu.write(0x01F2, 0xC1);
+    m.cpu.setSP(0xF0);
+    m.cpu.setA(0x5A);
+    m.cpu.setP(0x31);
+    m.cpu.setPC(pc);
+}
+
+static bool runKeyboardPoll(uint16_t pc)
+{
+    // Short runs stop inside the first few iterations; long ones carry the
+    // counter into $4F and through cursor blinks
+    const uint64_t lengths[] = {1, 5, 12, 16, 17, 31, 33, 100, 4099, 1200003};
+    Machine reference(false);
+    Machine skipping(false);
+    if (!reference.rom_loaded || !skipping.rom_loaded)
+    {
+        return false;
+    }
+    skipping.idle = std::make_unique<idle_detector>(skipping.mmu);
+
+    for (uint8_t counter : {0x00, 0x7F, 0xFE, 0xFF})
+    {
+        for (uint64_t length : lengths)
+        {
+            enterKeyboardPoll(reference, pc, counter);
+            enterKeyboardPoll(skipping, pc, counter);
+            reference.runUntil(reference.cycles() + length);
+            skipping.runUntil(skipping.cycles() + length);
+            if (!sameAfterIdle(reference, skipping, pc))
+            {
+                std::cerr << "    counter=$" << std::hex << static_cast<int>(counter) << std::dec
+                          << " length=" << length << std::endl;
+                return false;
+            }
+        }
+    }
+    if (skipping.skipped_cycles == 0)
+    {
+        std::cerr << std::endl << "    Loop was never skipped" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool test_idle_skip_keyin()
+{
+    TEST_CASE("Idle skipping the $C27D KEYIN loop matches interpreter");
+    ASSERT_TRUE(runKeyboardPoll(0xC27D));
+    TEST_PASS();
+    return true;
+}
+
+bool test_idle_skip_80col_keyin()
+{
+    TEST_CASE("Idle skipping the $C841 80-column poll matches interpreter");
+    ASSERT_TRUE(runKeyboardPoll(0xC841));
+    TEST_PASS();
+    return true;
+}
+
+bool test_idle_skip_wait()
+{
+    TEST_CASE("Idle skipping Monitor WAIT for A=0..255 matches interpreter");
+
+    // JSR WAIT; then spin
+    constexpr uint16_t DONE = 0x0303;
+    Machine reference(false);
+    Machine skipping(false);
+    ASSERT_TRUE(reference.rom_loaded && skipping.rom_loaded);
+    skipping.idle = std::make_unique<idle_detector>(skipping.mmu);
+    reference.load(0x0300, {0x20, 0xA8, 0xFC, 0x4C, 0x03, 0x03});
+    skipping.load(0x0300, {0x20, 0xA8, 0xFC, 0x4C, 0x03, 0x03});
+
+    for (int a = 0; a <= 0xFF; ++a)
+    {
+        const uint64_t skipped_before = skipping.skipped_cycles;
+        for (Machine *m : {&reference, &skipping})
+        {
+            m->cpu.setSP(0xFF);
+            m->cpu.setA(static_cast<uint8_t>(a));
+            m->cpu.setP(0x30);
+            m->cpu.setPC(0x0300);
+            m->runUntil(m->cycles() + 1000000, DONE);
+        }
+        ASSERT_TRUE(reference.cpu.getPC() == DONE);
+        ASSERT_TRUE(sameAfterIdle(reference, skipping, idle_detector::WAIT_ENTRY));
+        // A = 0 is left to the CPU
+        ASSERT_TRUE((skipping.skipped_cycles > skipped_before) == (a != 0));
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Interpreter vs Block Cache Differential Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        test_cold_boot,
+        test_binary_adc,
+        test_binary_sbc,
+        test_decimal_adc,
+        test_decimal_sbc,
+        test_disk_boot,
+        test_idle_skip_keyin,
+        test_idle_skip_80col_keyin,
+        test_idle_skip_wait,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}
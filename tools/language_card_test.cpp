@@ -918,6 +918,82 @@ bool test_80store_text_page_switching()
     return true;
 }
 
+bool test_80store_hires_page_switching()
+{
+    TEST_CASE("80STORE+HIRES causes PAGE2 to switch hires page 1 between main/aux");
+    LanguageCardTestFixture f;
+
+    f.ram.getMainBank()[0x2000] = 0xAA;
+    f.ram.getAuxBank()[0x2000] = 0xBB;
+
+    f.writeSwitch(Apple2e::SET80STORE);
+    f.readSwitch(Apple2e::TXTPAGE2);
+
+    // LORES - hires page 1 is not affected by 80STORE, RAMRD selects main
+    f.readSwitch(Apple2e::LORES);
+    ASSERT_EQ(0xAA, f.mmu.read(0x2000));
+
+    // HIRES - PAGE2 now selects aux for hires page 1
+    f.readSwitch(Apple2e::HIRES);
+    ASSERT_EQ(0xBB, f.mmu.read(0x2000));
+
+    // Writes follow the same mapping
+    f.mmu.write(0x2001, 0xCC);
+    ASSERT_EQ(0xCC, f.ram.getAuxBank()[0x2001]);
+
+    TEST_PASS();
+    return true;
+}
+
+bool test_peek_follows_memory_map()
+{
+    TEST_CASE("peek() follows switch changes, including direct state edits");
+    LanguageCardTestFixture f;
+
+    // ROM visible by default
+    ASSERT_EQ(0xEE, f.mmu.peek(0xD000));
+
+    // Switch to bank 1 RAM through the soft switch
+    f.readSwitch(0xC088);
+    ASSERT_EQ(0xD1, f.mmu.peek(0xD000));
+    ASSERT_EQ(0xD2, f.mmu.peek(0xE000));
+
+    // Editing the switch state directly must also be honoured
+    f.state().lcbank2 = true;
+    ASSERT_EQ(0xD2, f.mmu.peek(0xD000));
+    ASSERT_EQ(0xD2, f.mmu.read(0xD000));
+
+    f.reset();
+    ASSERT_EQ(0xEE, f.mmu.read(0xD000));
+
+    TEST_PASS();
+    return true;
+}
+
+bool test_page_flip_keeps_memory_map()
+{
+    TEST_CASE("PAGE2/HIRES flips only rebuild the memory map while 80STORE is on");
+    LanguageCardTestFixture f;
+
+    // Without 80STORE the flips only change the displayed page
+    const uint32_t generation = f.mmu.getMemoryMapGeneration();
+    f.readSwitch(Apple2e::TXTPAGE2);
+    f.readSwitch(Apple2e::HIRES);
+    f.readSwitch(Apple2e::TXTPAGE1);
+    f.readSwitch(Apple2e::LORES);
+    ASSERT_EQ(generation, f.mmu.getMemoryMapGeneration());
+
+    // With 80STORE, PAGE2 moves text page 1 to aux memory
+    f.writeSwitch(Apple2e::SET80STORE);
+    const uint32_t store80_generation = f.mmu.getMemoryMapGeneration();
+    ASSERT_TRUE(store80_generation != generation);
+    f.readSwitch(Apple2e::TXTPAGE2);
+    ASSERT_TRUE(f.mmu.getMemoryMapGeneration() != store80_generation);
+
+    TEST_PASS();
+    return true;
+}
+
 // ============================================================================
 // Test: Video Soft Switches
 // ============================================================================
@@ -1071,6 +1147,14 @@ bool test_status_registers()
     ASSERT_EQ(0x80, f.mmu.peek(Apple2e::RDCXROM));
     ASSERT_EQ(0x80, f.mmu.peek(Apple2e::RDC3ROM));
 
+    // Double hi-res follows AN3, and peek() reports it like a read does
+    ASSERT_EQ(0x00, f.mmu.peek(Apple2e::RDDHIRES));
+    f.writeSwitch(Apple2e::CLRAN3);
+    ASSERT_EQ(0x80, f.mmu.peek(Apple2e::RDDHIRES));
+    ASSERT_EQ(0x80, f.mmu.read(Apple2e::RDDHIRES) & 0x80);
+    f.writeSwitch(Apple2e::SETAN3);
+    ASSERT_EQ(0x00, f.mmu.peek(Apple2e::RDDHIRES));
+
     // Clear states
     f.writeSwitch(Apple2e::CLR80STORE);
     f.writeSwitch(Apple2e::RDMAINRAM);
@@ -1472,6 +1556,11 @@ int main()
 
         // 80STORE and PAGE2
         test_80store_text_page_switching,
+        test_80store_hires_page_switching,
+
+        // Page table mapping
+        test_peek_follows_memory_map,
+        test_page_flip_keeps_memory_map,
 
         // Video switches
         test_video_text_graphics_switch,
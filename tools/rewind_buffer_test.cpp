@@ -0,0 +1,358 @@
+/**
+ * Rewind Buffer Tests
+ *
+ * Captures snapshots of RAM with known dirty pages, restores them some
+ * steps back and compares RAM and state against copies kept on the side.
+ * Covers keyframe/delta reconstruction, folding the oldest delta into a
+ * keyframe when the ring wraps or the memory budget is exceeded, the
+ * memory accounting, and dropping the future on restore.
+ */
+
+#include "emulator/rewind_buffer.hpp"
+#include "emulator/mmu.hpp"
+#include "emulator/ram.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition) ASSERT_TRUE(!(condition))
+
+#define ASSERT_EQ(expected, actual) \
+    if ((expected) != (actual)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #expected " == " #actual << std::endl; \
+        std::cerr << "    Expected: " << (expected) << " Actual: " << (actual) << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+static constexpr size_t PAGE_SIZE = 256;
+static constexpr size_t BANK_PAGES = MMU::RAM_PAGE_COUNT / 2;
+static constexpr size_t KEYFRAME_BYTES = MMU::RAM_PAGE_COUNT * PAGE_SIZE;
+static constexpr size_t PAGES_PER_CAPTURE = 3;
+static constexpr size_t DELTA_BYTES = PAGES_PER_CAPTURE * (PAGE_SIZE + sizeof(uint16_t));
+
+/**
+ * A RAM that is written between captures, with a copy of every captured
+ * RAM kept for comparison
+ */
+struct History
+{
+    RAM ram;
+    rewind_buffer buffer;
+    std::vector<std::vector<uint8_t>> expected;  // RAM at each capture, by sequence number
+    uint8_t generation = 0;                       // Varies the contents of the timeline
+
+    History(size_t capacity, size_t keyframe_interval, size_t memory_budget)
+        : buffer(capacity, keyframe_interval, memory_budget)
+    {
+    }
+
+    uint8_t *page(uint16_t physical_page)
+    {
+        auto &bank = physical_page < BANK_PAGES ? ram.getMainBank() : ram.getAuxBank();
+        return bank.data() + (physical_page % BANK_PAGES) * PAGE_SIZE;
+    }
+
+    std::vector<uint8_t> contents() const
+    {
+        std::vector<uint8_t> all(ram.getMainBank().begin(), ram.getMainBank().end());
+        all.insert(all.end(), ram.getAuxBank().begin(), ram.getAuxBank().end());
+        return all;
+    }
+
+    /**
+     * Write a few pages in both banks, then capture with just those pages dirty
+     */
+    void step()
+    {
+        const size_t n = expected.size();
+        MMU::DirtyPageMap dirty{};
+        for (size_t j = 0; j < PAGES_PER_CAPTURE; ++j)
+        {
+            const uint16_t p = static_cast<uint16_t>((n * 37 + j * 173 + generation * 11) % MMU::RAM_PAGE_COUNT);
+            uint8_t *bytes = page(p);
+            for (size_t b = 0; b < PAGE_SIZE; ++b)
+            {
+                bytes[b] = static_cast<uint8_t>(n * 7 + j * 3 + b + generation * 29);
+            }
+            dirty[p / 64] |= uint64_t{1} << (p % 64);
+        }
+
+        rewind_buffer::machine_state state;
+        state.cycle = n * 1000;
+        state.pc = static_cast<uint16_t>(n);
+        state.a = generation;
+        buffer.capture(state, ram, dirty);
+        expected.push_back(contents());
+    }
+
+    /**
+     * Restore snapshots_back steps, scribbling over RAM first so nothing
+     * survives by accident, and check RAM and state against the copy
+     */
+    bool restoreAndCheck(size_t snapshots_back, size_t expected_sequence)
+    {
+        std::fill(ram.getMainBank().begin(), ram.getMainBank().end(), 0xEE);
+        std::fill(ram.getAuxBank().begin(), ram.getAuxBank().end(), 0xDD);
+
+        rewind_buffer::machine_state state;
+        if (!buffer.restore(snapshots_back, state, ram))
+        {
+            return false;
+        }
+        if (state.cycle != expected_sequence * 1000 || state.pc != expected_sequence ||
+            state.a != generation || contents() != expected[expected_sequence])
+        {
+            std::cerr << std::endl << "    Restore " << snapshots_back << " back gave snapshot at cycle "
+                      << state.cycle << ", expected " << expected_sequence * 1000 << std::endl;
+            return false;
+        }
+
+        // Later captures continue from the restored snapshot
+        expected.resize(expected_sequence + 1);
+        return true;
+    }
+};
+
+// ============================================================================
+// Test: Keyframes and deltas
+// ============================================================================
+bool test_restore_through_deltas()
+{
+    TEST_CASE("Restoring k steps back rebuilds RAM from keyframe and deltas");
+
+    for (size_t back = 0; back < 12; ++back)
+    {
+        History h(16, 4, SIZE_MAX);
+        for (int i = 0; i < 10; ++i)
+        {
+            h.step();
+        }
+
+        // Keyframes at 0, 4 and 8
+        ASSERT_EQ(10u, h.buffer.size());
+        ASSERT_EQ(3 * KEYFRAME_BYTES + 7 * DELTA_BYTES, h.buffer.getMemoryUsage());
+
+        // Clamped to the oldest
+        const size_t target = 9 - std::min<size_t>(back, 9);
+        ASSERT_TRUE(h.restoreAndCheck(back, target));
+        ASSERT_EQ(target + 1, h.buffer.size());
+
+        const size_t keyframes = target / 4 + 1;
+        ASSERT_EQ(keyframes * KEYFRAME_BYTES + (target + 1 - keyframes) * DELTA_BYTES, h.buffer.getMemoryUsage());
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Restore drops the future
+// ============================================================================
+bool test_restore_truncates_future()
+{
+    TEST_CASE("Captures after a restore replace the dropped future");
+
+    History h(16, 4, SIZE_MAX);
+    for (int i = 0; i < 10; ++i)
+    {
+        h.step();
+    }
+    const std::vector<uint8_t> old_seventh = h.expected[7];
+    ASSERT_TRUE(h.restoreAndCheck(3, 6));
+    ASSERT_EQ(2 * KEYFRAME_BYTES + 5 * DELTA_BYTES, h.buffer.getMemoryUsage());
+
+    // A different timeline from snapshot 6 on; the keyframe cadence carries
+    // on from there (7 delta, 8 keyframe)
+    h.generation = 1;
+    for (int i = 0; i < 4; ++i)
+    {
+        h.step();
+    }
+    ASSERT_EQ(11u, h.buffer.size());
+    ASSERT_EQ(3 * KEYFRAME_BYTES + 8 * DELTA_BYTES, h.buffer.getMemoryUsage());
+    ASSERT_TRUE(h.expected[7] != old_seventh);
+
+    // Snapshots 7-10 come from the new timeline
+    ASSERT_TRUE(h.restoreAndCheck(0, 10));
+    ASSERT_TRUE(h.restoreAndCheck(2, 8));
+    ASSERT_TRUE(h.restoreAndCheck(1, 7));
+    ASSERT_EQ(8u, h.buffer.size());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Ring wrap
+// ============================================================================
+bool test_wrap_folds_keyframe()
+{
+    TEST_CASE("A full ring folds the oldest delta into a keyframe");
+
+    for (size_t back = 0; back < 7; ++back)
+    {
+        History h(5, 3, SIZE_MAX);
+        for (int i = 0; i < 12; ++i)
+        {
+            h.step();
+        }
+
+        // 7-11 are left: 7 (a delta, folded into a keyframe), 8, 9 (a
+        // keyframe), 10 and 11
+        ASSERT_EQ(5u, h.buffer.size());
+        ASSERT_EQ(2 * KEYFRAME_BYTES + 3 * DELTA_BYTES, h.buffer.getMemoryUsage());
+
+        const size_t target = 11 - std::min<size_t>(back, 4);
+        ASSERT_TRUE(h.restoreAndCheck(back, target));
+        ASSERT_EQ(target - 6, h.buffer.size());
+    }
+
+    // Wrapping many times over, with restores in between
+    History h(5, 3, SIZE_MAX);
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int i = 0; i < 7; ++i)
+        {
+            h.step();
+        }
+        ASSERT_EQ(5u, h.buffer.size());
+        ASSERT_TRUE(h.restoreAndCheck(round % 5, h.expected.size() - 1 - round % 5));
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Memory budget
+// ============================================================================
+bool test_memory_budget()
+{
+    TEST_CASE("Going over the memory budget drops the oldest snapshots");
+
+    // Room for the keyframe and ten deltas
+    const size_t budget = KEYFRAME_BYTES + 10 * DELTA_BYTES;
+    History h(100, 100, budget);
+    for (int i = 0; i < 11; ++i)
+    {
+        h.step();
+    }
+    ASSERT_EQ(11u, h.buffer.size());
+    ASSERT_EQ(budget, h.buffer.getMemoryUsage());
+
+    for (int i = 0; i < 30; ++i)
+    {
+        h.step();
+        ASSERT_TRUE(h.buffer.getMemoryUsage() <= budget);
+    }
+    ASSERT_EQ(11u, h.buffer.size());
+    ASSERT_EQ(budget, h.buffer.getMemoryUsage());
+
+    // The oldest left is snapshot 30, rebuilt from folded deltas
+    ASSERT_TRUE(h.restoreAndCheck(SIZE_MAX, 30));
+    ASSERT_EQ(1u, h.buffer.size());
+    ASSERT_EQ(KEYFRAME_BYTES, h.buffer.getMemoryUsage());
+
+    // A budget below one keyframe still keeps the latest snapshot
+    History tight(10, 4, 1000);
+    for (int i = 0; i < 5; ++i)
+    {
+        tight.step();
+        ASSERT_EQ(1u, tight.buffer.size());
+    }
+    ASSERT_TRUE(tight.restoreAndCheck(0, 4));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Empty buffer
+// ============================================================================
+bool test_clear_and_empty()
+{
+    TEST_CASE("clear() frees everything; restoring an empty buffer fails");
+
+    History h(8, 4, SIZE_MAX);
+    rewind_buffer::machine_state state;
+    ASSERT_FALSE(h.buffer.restore(0, state, h.ram));
+
+    for (int i = 0; i < 6; ++i)
+    {
+        h.step();
+    }
+    h.buffer.clear();
+    ASSERT_EQ(0u, h.buffer.size());
+    ASSERT_EQ(0u, h.buffer.getMemoryUsage());
+    ASSERT_FALSE(h.buffer.restore(0, state, h.ram));
+
+    // The first capture after clear() is a keyframe
+    h.step();
+    ASSERT_EQ(KEYFRAME_BYTES, h.buffer.getMemoryUsage());
+    ASSERT_TRUE(h.restoreAndCheck(0, 6));
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Rewind Buffer Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        test_restore_through_deltas,
+        test_restore_truncates_future,
+        test_wrap_folds_keyframe,
+        test_memory_budget,
+        test_clear_and_empty,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}
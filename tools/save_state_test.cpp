@@ -0,0 +1,362 @@
+/**
+ * Save State Tests
+ *
+ * Saves a running machine, loads it into a fresh emulator and saves it
+ * again, expecting the same bytes; loads a hand-built version 1 file; and
+ * checks that unknown chunks and newer chunk versions with appended fields
+ * are read as the format promises.
+ *
+ * Needs the Apple IIe ROMs and disk_images/: run from the source directory.
+ */
+
+#include "emulator/emulator.hpp"
+#include "emulator/disk2_controller.hpp"
+#include "emulator/save_state.hpp"
+#include "apple2e/soft_switches.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition) ASSERT_TRUE(!(condition))
+
+#define ASSERT_EQ(expected, actual) \
+    if ((expected) != (actual)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #expected " == " #actual << std::endl; \
+        std::cerr << "    Expected: 0x" << std::hex << static_cast<int>(expected) \
+                  << " Actual: 0x" << static_cast<int>(actual) << std::dec << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+static constexpr const char *DOS33_DISK = "disk_images/Apple DOS 3.3 January 1983.dsk";
+
+// Version 1 layout: magic, PC(2) SP P A X Y, SoftSwitchState up to csw/ksw,
+// then the main and aux banks
+static constexpr size_t LEGACY_REGISTERS_SIZE = 7;
+static constexpr size_t LEGACY_SWITCHES_SIZE = 24;
+static constexpr size_t BANK_SIZE = 0x10000;
+
+static std::string tempPath(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / ("a2e_save_state_test_" + name)).string();
+}
+
+static std::vector<uint8_t> readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool writeFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    return file.good();
+}
+
+static void putU16(std::vector<uint8_t> &out, uint16_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void putU32(std::vector<uint8_t> &out, uint32_t value)
+{
+    putU16(out, static_cast<uint16_t>(value));
+    putU16(out, static_cast<uint16_t>(value >> 16));
+}
+
+static uint32_t getU32(const std::vector<uint8_t> &data, size_t offset)
+{
+    return static_cast<uint32_t>(data[offset]) | static_cast<uint32_t>(data[offset + 1]) << 8 |
+           static_cast<uint32_t>(data[offset + 2]) << 16 | static_cast<uint32_t>(data[offset + 3]) << 24;
+}
+
+/**
+ * Boot an emulator that won't write to the disk images it is given
+ */
+static bool boot(emulator &emu)
+{
+    if (!emu.initialize())
+    {
+        return false;
+    }
+    emu.getDiskController()->setWriteBack(false);
+    return true;
+}
+
+/**
+ * Save a state and return the file's bytes
+ */
+static std::vector<uint8_t> saveBytes(emulator &emu, const std::string &name)
+{
+    const std::string path = tempPath(name);
+    std::vector<uint8_t> data = emu.saveState(path) ? readFile(path) : std::vector<uint8_t>();
+    std::filesystem::remove(path);
+    return data;
+}
+
+/**
+ * Load a state from bytes
+ */
+static bool loadBytes(emulator &emu, const std::vector<uint8_t> &data, const std::string &name)
+{
+    const std::string path = tempPath(name);
+    bool loaded = writeFile(path, data) && emu.loadState(path);
+    std::filesystem::remove(path);
+    return loaded;
+}
+
+static bool sameMachine(const emulator &a, const emulator &b)
+{
+    const emulator::cpu_state sa = a.getCPUState();
+    const emulator::cpu_state sb = b.getCPUState();
+    return sa.pc == sb.pc && sa.sp == sb.sp && sa.p == sb.p && sa.a == sb.a && sa.x == sb.x &&
+           sa.y == sb.y && sa.total_cycles == sb.total_cycles &&
+           a.getMainRAM() == b.getMainRAM() && a.getAuxRAM() == b.getAuxRAM();
+}
+
+/**
+ * A machine part way through booting DOS 3.3, with the drive running, a
+ * key waiting and some 80-column state set
+ */
+static bool bootIntoDos(emulator &emu)
+{
+    if (!boot(emu) || !emu.insertDisk(0, DOS33_DISK))
+    {
+        return false;
+    }
+    emu.runCycles(1500000);
+    emu.keyDown('A');
+    emu.writeMemory(Apple2e::SET80STORE, 0);
+    emu.runCycles(emu.getCPUState().total_cycles + 12345);
+    return true;
+}
+
+// ============================================================================
+// Test: Save, load and save again
+// ============================================================================
+bool test_round_trip()
+{
+    TEST_CASE("A reloaded state saves to the same bytes and runs the same");
+
+    emulator original;
+    ASSERT_TRUE(bootIntoDos(original));
+    const std::vector<uint8_t> saved = saveBytes(original, "first.a2s");
+    ASSERT_TRUE(saved.size() > 2 * BANK_SIZE);
+    ASSERT_EQ(save_state::FORMAT_CHUNKED, saved[3]);
+
+    emulator restored;
+    ASSERT_TRUE(boot(restored));
+    ASSERT_TRUE(loadBytes(restored, saved, "first.a2s"));
+    ASSERT_TRUE(sameMachine(original, restored));
+    ASSERT_TRUE(restored.getDiskController()->hasDisk(0));
+
+    const std::vector<uint8_t> resaved = saveBytes(restored, "second.a2s");
+    ASSERT_TRUE(resaved == saved);
+
+    // Both carry on to the same place
+    const uint64_t end = original.getCPUState().total_cycles + 2000000;
+    original.runCycles(end);
+    restored.runCycles(end);
+    ASSERT_TRUE(sameMachine(original, restored));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Version 1 files
+// ============================================================================
+bool test_load_version1()
+{
+    TEST_CASE("A version 1 struct dump loads registers, switches and both banks");
+
+    std::vector<uint8_t> data = {'A', '2', 'E', 0x01};
+    putU16(data, 0x0803);
+    data.insert(data.end(), {0xF4, 0x31, 0x12, 0x34, 0x56});  // SP P A X Y
+
+    // SoftSwitchState as version 1 laid it out
+    uint8_t switches[LEGACY_SWITCHES_SIZE] = {};
+    switches[0] = 1;       // video_mode: GRAPHICS
+    switches[3] = 1;       // graphics_mode: HIRES
+    switches[4] = 1;       // col80_mode
+    switches[6] = 1;       // store80
+    switches[9] = 1;       // altzp
+    switches[13] = 0;      // lcbank2: bank 1
+    switches[14] = 1;      // lcread
+    switches[20] = 0xF0;   // csw
+    switches[21] = 0xFD;
+    data.insert(data.end(), switches, switches + LEGACY_SWITCHES_SIZE);
+
+    for (size_t i = 0; i < BANK_SIZE; ++i)
+    {
+        data.push_back(static_cast<uint8_t>(i * 7 + (i >> 8)));
+    }
+    for (size_t i = 0; i < BANK_SIZE; ++i)
+    {
+        data.push_back(static_cast<uint8_t>(~(i * 3)));
+    }
+    ASSERT_EQ(save_state::HEADER_SIZE + LEGACY_REGISTERS_SIZE + LEGACY_SWITCHES_SIZE + 2 * BANK_SIZE,
+              data.size());
+
+    emulator emu;
+    ASSERT_TRUE(boot(emu));
+    ASSERT_TRUE(loadBytes(emu, data, "v1.a2s"));
+
+    const emulator::cpu_state cpu = emu.getCPUState();
+    ASSERT_EQ(0x0803, cpu.pc);
+    ASSERT_EQ(0xF4, cpu.sp);
+    ASSERT_EQ(0x31, cpu.p);
+    ASSERT_EQ(0x12, cpu.a);
+    ASSERT_EQ(0x34, cpu.x);
+    ASSERT_EQ(0x56, cpu.y);
+
+    const Apple2e::SoftSwitchState sw = emu.getSoftSwitchState();
+    ASSERT_TRUE(sw.video_mode == Apple2e::VideoMode::GRAPHICS);
+    ASSERT_TRUE(sw.graphics_mode == Apple2e::GraphicsMode::HIRES);
+    ASSERT_TRUE(sw.col80_mode);
+    ASSERT_TRUE(sw.store80);
+    ASSERT_TRUE(sw.altzp);
+    ASSERT_FALSE(sw.lcbank2);
+    ASSERT_TRUE(sw.lcread);
+    ASSERT_FALSE(sw.ramrd);
+    ASSERT_EQ(0xFDF0, sw.csw);
+    ASSERT_EQ(0, sw.ksw);
+    ASSERT_FALSE(sw.dhires);
+
+    for (size_t i = 0; i < BANK_SIZE; i += 0x101)
+    {
+        ASSERT_EQ(static_cast<uint8_t>(i * 7 + (i >> 8)), emu.getMainRAM()[i]);
+        ASSERT_EQ(static_cast<uint8_t>(~(i * 3)), emu.getAuxRAM()[i]);
+    }
+
+    // Any other size is some other build's layout
+    data.pop_back();
+    emulator other;
+    ASSERT_TRUE(boot(other));
+    ASSERT_FALSE(loadBytes(other, data, "v1short.a2s"));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Forward compatibility
+// ============================================================================
+bool test_unknown_and_newer_chunks()
+{
+    TEST_CASE("Unknown chunks are skipped and newer chunks read up to what is known");
+
+    emulator original;
+    ASSERT_TRUE(bootIntoDos(original));
+    const std::vector<uint8_t> saved = saveBytes(original, "base.a2s");
+    ASSERT_TRUE(saved.size() > save_state::HEADER_SIZE);
+
+    // Bump every chunk's version and append fields this build doesn't
+    // know, then add a chunk from some future component
+    std::vector<uint8_t> newer(saved.begin(), saved.begin() + save_state::HEADER_SIZE);
+    size_t offset = save_state::HEADER_SIZE;
+    int chunks = 0;
+    while (offset < saved.size())
+    {
+        ASSERT_TRUE(offset + save_state::CHUNK_HEADER_SIZE <= saved.size());
+        const uint32_t tag = getU32(saved, offset);
+        const uint16_t version = static_cast<uint16_t>(saved[offset + 4] | saved[offset + 5] << 8);
+        const uint32_t size = getU32(saved, offset + 8);
+        const size_t payload = offset + save_state::CHUNK_HEADER_SIZE;
+        ASSERT_TRUE(payload + size <= saved.size());
+
+        putU32(newer, tag);
+        putU16(newer, static_cast<uint16_t>(version + 1));
+        putU16(newer, 0);
+        putU32(newer, size + 9);
+        newer.insert(newer.end(), saved.begin() + payload, saved.begin() + payload + size);
+        newer.insert(newer.end(), {0xA5, 0x5A, 0xFF, 0x00, 0x01, 0x80, 0x7F, 0xEE, 0x11});
+
+        offset = payload + size;
+        ++chunks;
+    }
+    ASSERT_TRUE(chunks >= 6);
+
+    putU32(newer, save_state::makeTag("XTRA"));
+    putU16(newer, 3);
+    putU16(newer, 0);
+    putU32(newer, 5);
+    newer.insert(newer.end(), {1, 2, 3, 4, 5});
+
+    emulator restored;
+    ASSERT_TRUE(boot(restored));
+    ASSERT_TRUE(loadBytes(restored, newer, "newer.a2s"));
+    ASSERT_TRUE(sameMachine(original, restored));
+    ASSERT_TRUE(saveBytes(restored, "resaved.a2s") == saved);
+
+    // A chunk that claims more than the file holds is rejected outright
+    std::vector<uint8_t> truncated(newer.begin(), newer.end() - 1);
+    emulator damaged;
+    ASSERT_TRUE(boot(damaged));
+    ASSERT_FALSE(loadBytes(damaged, truncated, "truncated.a2s"));
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Save State Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        test_round_trip,
+        test_load_version1,
+        test_unknown_and_newer_chunks,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}
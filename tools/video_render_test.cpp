@@ -0,0 +1,329 @@
+/**
+ * Video Incremental Rendering Tests
+ *
+ * Checks that video_dirty_map::markWrite() maps every byte of the text and
+ * hi-res pages to the right text row or scanline (and the screen holes and
+ * other memory to nothing), then drives random video memory writes and
+ * mode switches through the emulator and compares the display, which
+ * redraws only marked scanlines, against a second display that redraws
+ * every frame in full.
+ *
+ * Needs the Apple IIe ROMs: run from the source or build directory so that
+ * resources/roms can be found.
+ */
+
+#include "emulator/emulator.hpp"
+#include "emulator/video_dirty_map.hpp"
+#include "emulator/video_display.hpp"
+#include "apple2e/soft_switches.hpp"
+#include "utils/resource_path.hpp"
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+static constexpr const char *CHARACTER_ROM_PATH = "resources/roms/character/341-0160-A.bin";
+
+/**
+ * Check that exactly the given scanlines of one source are marked
+ * @param first First scanline expected
+ * @param count Number of scanlines expected from first
+ */
+static bool onlyMarked(const video_dirty_map &map, video_dirty_map::source src, bool aux, int first, int count)
+{
+    for (int s = 0; s < video_dirty_map::SOURCE_COUNT; ++s)
+    {
+        for (bool bank : {false, true})
+        {
+            const auto &lines = map.get(static_cast<video_dirty_map::source>(s), bank);
+            for (int line = 0; line < video_dirty_map::SCANLINES; ++line)
+            {
+                const bool marked = (lines[line >> 6] >> (line & 63)) & 1;
+                const bool expected = s == src && bank == aux && line >= first && line < first + count;
+                if (marked != expected)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool nothingMarked(const video_dirty_map &map)
+{
+    for (const auto &lines : map.bits)
+    {
+        for (uint64_t word : lines)
+        {
+            if (word)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void mark(video_dirty_map &map, uint16_t address, bool aux)
+{
+    map.markWrite(static_cast<uint16_t>((aux ? 0x100 : 0) | address >> 8), static_cast<uint8_t>(address));
+}
+
+// ============================================================================
+// Test: Text and lo-res rows
+// ============================================================================
+bool test_text_row_decoding()
+{
+    TEST_CASE("Every text page byte marks the 8 scanlines of its row");
+
+    for (bool aux : {false, true})
+    {
+        for (int page = 0; page < 2; ++page)
+        {
+            const uint16_t base = page ? 0x0800 : 0x0400;
+            const auto src = page ? video_dirty_map::TEXT2 : video_dirty_map::TEXT1;
+            for (int row = 0; row < 24; ++row)
+            {
+                for (int col = 0; col < 40; ++col)
+                {
+                    video_dirty_map map;
+                    mark(map, static_cast<uint16_t>(base + (row % 8) * 0x80 + (row / 8) * 0x28 + col), aux);
+                    ASSERT_TRUE(onlyMarked(map, src, aux, row * 8, 8));
+                }
+            }
+
+            // The last 8 bytes of each 128 are screen holes
+            for (int block = 0; block < 8; ++block)
+            {
+                for (int hole = 0x78; hole < 0x80; ++hole)
+                {
+                    video_dirty_map map;
+                    mark(map, static_cast<uint16_t>(base + block * 0x80 + hole), aux);
+                    ASSERT_TRUE(nothingMarked(map));
+                }
+            }
+        }
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Hi-res scanlines
+// ============================================================================
+bool test_hires_line_decoding()
+{
+    TEST_CASE("Every hi-res page byte marks its one scanline");
+
+    for (bool aux : {false, true})
+    {
+        for (int page = 0; page < 2; ++page)
+        {
+            const uint16_t base = page ? 0x4000 : 0x2000;
+            const auto src = page ? video_dirty_map::HIRES2 : video_dirty_map::HIRES1;
+            for (int line = 0; line < 192; ++line)
+            {
+                const uint16_t line_base = static_cast<uint16_t>(base + (line % 8) * 0x400 +
+                                                                 ((line / 8) % 8) * 0x80 + (line / 64) * 0x28);
+                for (int col = 0; col < 40; ++col)
+                {
+                    video_dirty_map map;
+                    mark(map, static_cast<uint16_t>(line_base + col), aux);
+                    ASSERT_TRUE(onlyMarked(map, src, aux, line, 1));
+                }
+            }
+
+            for (int block = 0; block < 64; ++block)
+            {
+                video_dirty_map map;
+                for (int hole = 0x78; hole < 0x80; ++hole)
+                {
+                    mark(map, static_cast<uint16_t>(base + block * 0x80 + hole), aux);
+                }
+                ASSERT_TRUE(nothingMarked(map));
+            }
+        }
+    }
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Memory outside the display pages
+// ============================================================================
+bool test_other_memory_unmarked()
+{
+    TEST_CASE("Writes outside the display pages mark nothing");
+
+    for (bool aux : {false, true})
+    {
+        video_dirty_map map;
+        for (uint32_t address = 0; address < 0x10000; ++address)
+        {
+            if ((address >= 0x0400 && address < 0x0C00) || (address >= 0x2000 && address < 0x6000))
+            {
+                continue;
+            }
+            mark(map, static_cast<uint16_t>(address), aux);
+        }
+        ASSERT_TRUE(nothingMarked(map));
+    }
+
+    // markAll() marks every scanline of every source; clear() forgets them
+    video_dirty_map map;
+    map.markAll();
+    for (int s = 0; s < video_dirty_map::SOURCE_COUNT; ++s)
+    {
+        for (bool aux : {false, true})
+        {
+            const auto &lines = map.get(static_cast<video_dirty_map::source>(s), aux);
+            for (int line = 0; line < video_dirty_map::SCANLINES; ++line)
+            {
+                ASSERT_TRUE((lines[line >> 6] >> (line & 63)) & 1);
+            }
+        }
+    }
+    map.clear();
+    ASSERT_TRUE(nothingMarked(map));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Incremental frames against full redraws
+// ============================================================================
+bool test_incremental_matches_full_redraw()
+{
+    TEST_CASE("Incremental frames match full redraws across random writes and modes");
+
+    emulator emu;
+    ASSERT_TRUE(emu.initialize());
+    ASSERT_TRUE(emu.loadCharacterROM(getResourcePath(CHARACTER_ROM_PATH)));
+    video_display *incremental = emu.getVideoDisplay();
+    ASSERT_TRUE(incremental != nullptr);
+
+    // Same memory and switches, no dirty marks: every frame is redrawn
+    video_display reference;
+    ASSERT_TRUE(reference.loadCharacterROM(getResourcePath(CHARACTER_ROM_PATH)));
+    Apple2e::SoftSwitchState switches = emu.getSoftSwitchState();
+    reference.setMemory(emu.getMainRAM(), emu.getAuxRAM());
+    reference.setSoftSwitches(switches);
+
+    const uint16_t mode_switches[] = {
+        Apple2e::TXTCLR, Apple2e::TXTSET, Apple2e::MIXCLR, Apple2e::MIXSET,
+        Apple2e::TXTPAGE1, Apple2e::TXTPAGE2, Apple2e::LORES, Apple2e::HIRES,
+        Apple2e::CLR80VID, Apple2e::SET80VID, Apple2e::CLRALTCHAR, Apple2e::SETALTCHAR,
+        Apple2e::CLR80STORE, Apple2e::SET80STORE, Apple2e::WRMAINRAM, Apple2e::WRCARDRAM,
+        Apple2e::CLRAN3, Apple2e::SETAN3,
+    };
+
+    std::mt19937 rng(1);
+    int partial_frames = 0;
+    for (int frame = 0; frame < 3000; ++frame)
+    {
+        if (rng() % 20 == 0)
+        {
+            emu.writeMemory(mode_switches[rng() % std::size(mode_switches)], 0);
+        }
+
+        // A handful of bytes per frame, or none
+        const int writes = rng() % 4 == 0 ? 0 : static_cast<int>(rng() % 30);
+        for (int i = 0; i < writes; ++i)
+        {
+            const uint16_t address = (rng() & 1) ? static_cast<uint16_t>(0x0400 + rng() % 0x800)
+                                                 : static_cast<uint16_t>(0x2000 + rng() % 0x4000);
+            emu.writeMemory(address, static_cast<uint8_t>(rng()));
+        }
+
+        if (frame % 500 == 250)
+        {
+            incremental->setGreenText(!incremental->isGreenText());
+            reference.setGreenText(incremental->isGreenText());
+        }
+
+        const bool changed = incremental->update();
+        switches = emu.getSoftSwitchState();
+        reference.update();
+        if (changed && incremental->getChangedLineCount() < video_display::getDisplayHeight())
+        {
+            partial_frames++;
+        }
+
+        const size_t pixels = static_cast<size_t>(video_display::getMaxDisplayWidth()) *
+                              video_display::getDisplayHeight();
+        if (incremental->getCurrentDisplayWidth() != reference.getCurrentDisplayWidth() ||
+            std::memcmp(incremental->getFrameBuffer(), reference.getFrameBuffer(), pixels * sizeof(uint32_t)) != 0)
+        {
+            std::cerr << std::endl << "    Frame " << frame << " differs from a full redraw" << std::endl;
+            ASSERT_TRUE(false);
+        }
+    }
+
+    // The incremental path was actually taken
+    ASSERT_TRUE(partial_frames > 100);
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Video Incremental Rendering Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        test_text_row_decoding,
+        test_hires_line_decoding,
+        test_other_memory_unmarked,
+        test_incremental_matches_full_redraw,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}
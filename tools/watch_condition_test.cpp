@@ -0,0 +1,503 @@
+/**
+ * Watch Condition and Breakpoint Spec Tests
+ *
+ * Validates the breakpoint condition compiler (precedence, operator
+ * lookahead, number formats, errors), the "TYPE [BANK:]ADDR[-END] [if
+ * CONDITION]" spec parser, bank-limited hits against a live memory map,
+ * and the persisted breakpoint string, including the older
+ * "ADDR:TYPE:ENABLED" form.
+ */
+
+#include "emulator/breakpoint_manager.hpp"
+#include "emulator/mmu.hpp"
+#include "emulator/ram.hpp"
+#include "emulator/rom.hpp"
+#include "emulator/watch_condition.hpp"
+#include "apple2e/soft_switches.hpp"
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <vector>
+#include <string>
+
+// Test framework
+static int tests_passed = 0;
+static int tests_failed = 0;
+static std::string current_test_name;
+
+#define TEST_CASE(name) \
+    current_test_name = name; \
+    std::cout << "  Testing: " << name << "... " << std::flush;
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #condition << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define ASSERT_FALSE(condition) ASSERT_TRUE(!(condition))
+
+#define ASSERT_EQ(expected, actual) \
+    if ((expected) != (actual)) { \
+        std::cout << "FAILED" << std::endl; \
+        std::cerr << "    Assertion failed: " #expected " == " #actual << std::endl; \
+        std::cerr << "    Expected: 0x" << std::hex << static_cast<int>(expected) \
+                  << " Actual: 0x" << static_cast<int>(actual) << std::dec << std::endl; \
+        std::cerr << "    at " << __FILE__ << ":" << __LINE__ << std::endl; \
+        tests_failed++; \
+        return false; \
+    }
+
+#define TEST_PASS() \
+    std::cout << "PASSED" << std::endl; \
+    tests_passed++;
+
+/**
+ * Compile and evaluate a condition against registers and a small memory
+ * @return 1 or 0 for the result, -1 if it failed to compile
+ */
+static int check(const std::string &text, const watch_condition::context &ctx = {},
+                 const std::vector<uint8_t> &memory = {})
+{
+    watch_condition condition;
+    std::string error;
+    if (!condition.compile(text, error))
+    {
+        return -1;
+    }
+    auto peek = [&memory](uint16_t address) -> uint8_t
+    {
+        return address < memory.size() ? memory[address] : 0;
+    };
+    return condition.evaluate(ctx, peek) ? 1 : 0;
+}
+
+/**
+ * Compile a condition that must fail
+ * @return The error message, or empty if it compiled
+ */
+static std::string compileError(const std::string &text)
+{
+    watch_condition condition;
+    std::string error;
+    condition.compile(text, error);
+    return error;
+}
+
+// ============================================================================
+// Test: Operands and number formats
+// ============================================================================
+bool test_operands()
+{
+    TEST_CASE("Registers, VALUE, ADDR and hex/binary/decimal numbers");
+
+    watch_condition::context ctx;
+    ctx.a = 0xFF;
+    ctx.x = 3;
+    ctx.y = 0x10;
+    ctx.sp = 0xF0;
+    ctx.p = 0x31;
+    ctx.pc = 0x0803;
+    ctx.address = 0xC0E9;
+    ctx.value = 0x80;
+
+    ASSERT_EQ(1, check("A==#$FF", ctx));
+    ASSERT_EQ(1, check("a == 0xff", ctx));
+    ASSERT_EQ(1, check("X==%11", ctx));
+    ASSERT_EQ(1, check("Y==16", ctx));
+    ASSERT_EQ(1, check("SP==$F0 && S==$F0", ctx));
+    ASSERT_EQ(1, check("PC==$0803", ctx));
+    ASSERT_EQ(1, check("ADDR==$C0E9", ctx));
+    ASSERT_EQ(1, check("VALUE>=$80", ctx));
+    ASSERT_EQ(0, check("VALUE<$80", ctx));
+    ASSERT_EQ(1, check("X<4 && X<=3 && X>2 && X>=3 && X!=4", ctx));
+
+    // An empty condition always holds
+    ASSERT_EQ(1, check("", ctx));
+    ASSERT_EQ(1, check("   ", ctx));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Precedence
+// ============================================================================
+bool test_precedence()
+{
+    TEST_CASE("|| binds looser than &&, comparisons looser than &");
+
+    watch_condition::context ctx;
+    ctx.a = 1;
+    ctx.x = 0;
+    ctx.p = 0x03;
+
+    // 1 || (0 && 0), not (1 || 0) && 0
+    ASSERT_EQ(1, check("A==1 || X==1 && X==2", ctx));
+    ASSERT_EQ(0, check("(A==1 || X==1) && X==2", ctx));
+
+    // (P & 2) == 2, not P & (2 == 2)
+    ASSERT_EQ(1, check("P&2==2", ctx));
+    ASSERT_EQ(0, check("P&4==4", ctx));
+
+    // A bare value is true when non-zero
+    ASSERT_EQ(1, check("P&$01", ctx));
+    ASSERT_EQ(0, check("P&$80", ctx));
+    ASSERT_EQ(0, check("X", ctx));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: '&'/'&&' and '!'/'!=' lookahead
+// ============================================================================
+bool test_operator_lookahead()
+{
+    TEST_CASE("'&' vs '&&' and '!' vs '!=' are told apart");
+
+    watch_condition::context ctx;
+    ctx.a = 0x0F;
+    ctx.x = 0xF0;
+
+    // Bitwise: $0F & $F0 == 0
+    ASSERT_EQ(0, check("A&X", ctx));
+    // Logical: both non-zero
+    ASSERT_EQ(1, check("A&&X", ctx));
+    ASSERT_EQ(1, check("A && X", ctx));
+
+    ASSERT_EQ(1, check("!(A==0)", ctx));
+    ASSERT_EQ(1, check("!!A", ctx));
+    ASSERT_EQ(0, check("!A", ctx));
+    ASSERT_EQ(1, check("A!=0", ctx));
+    ASSERT_EQ(1, check("A != 0 && !(X == 0)", ctx));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Memory operands
+// ============================================================================
+bool test_memory_operands()
+{
+    TEST_CASE("[addr] reads memory, with expression addresses");
+
+    std::vector<uint8_t> memory(0x100, 0);
+    memory[0x36] = 0xF0;
+    memory[0x37] = 0xFD;
+    memory[0x13] = 0x36;
+
+    watch_condition::context ctx;
+    ctx.x = 0x13;
+
+    ASSERT_EQ(1, check("[$36]==$F0", {}, memory));
+    ASSERT_EQ(0, check("[$36]!=$F0", {}, memory));
+    ASSERT_EQ(1, check("[$37]==$FD && [$36]==$F0", {}, memory));
+    // Address taken from a register, and nested loads
+    ASSERT_EQ(1, check("[X]==$36", ctx, memory));
+    ASSERT_EQ(1, check("[[X]]==$F0", ctx, memory));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Compile errors
+// ============================================================================
+bool test_compile_errors()
+{
+    TEST_CASE("Malformed conditions are rejected with a reason");
+
+    ASSERT_TRUE(compileError("A==").find("ends early") != std::string::npos);
+    ASSERT_TRUE(compileError("(A==1").find("missing ')'") != std::string::npos);
+    ASSERT_TRUE(compileError("[$36==1").find("missing ']'") != std::string::npos);
+    ASSERT_TRUE(compileError("Q==1").find("unknown name 'Q'") != std::string::npos);
+    ASSERT_TRUE(compileError("A==$10000").find("out of range") != std::string::npos);
+    ASSERT_TRUE(compileError("A==1 )").find("unexpected ')'") != std::string::npos);
+    ASSERT_TRUE(compileError("A==$G").find("unexpected") != std::string::npos);
+    ASSERT_TRUE(compileError("A==1").empty());
+    ASSERT_TRUE(compileError("A==$FFFF").empty());
+
+    // Errors point at the column
+    ASSERT_TRUE(compileError("A==1 && Q").find("column") != std::string::npos);
+
+    // Far too deep for the evaluation stack
+    std::string deep = "A";
+    for (int i = 0; i < 20; ++i)
+    {
+        deep = "(A==" + deep + ")";
+    }
+    ASSERT_TRUE(compileError(deep).find("too complex") != std::string::npos);
+
+    // A failed compile leaves the condition empty
+    watch_condition condition;
+    std::string error;
+    ASSERT_TRUE(condition.compile("A==1", error));
+    ASSERT_FALSE(condition.compile("A==", error));
+    ASSERT_TRUE(condition.empty());
+    ASSERT_TRUE(condition.getText().empty());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Breakpoint specs
+// ============================================================================
+bool test_watchpoint_specs()
+{
+    TEST_CASE("addWatchpoint() parses types, ranges, banks and conditions");
+
+    breakpoint_manager manager;
+    std::string error;
+
+    ASSERT_TRUE(manager.addWatchpoint("write $C0E9", error));
+    ASSERT_TRUE(manager.addWatchpoint("r $2000-$3FFF if A==#$FF", error));
+    ASSERT_TRUE(manager.addWatchpoint("EXEC lc1:$D000", error));
+    ASSERT_TRUE(manager.addWatchpoint("x aux-lc2:0xE000", error));
+    ASSERT_TRUE(manager.addWatchpoint("exec $0800 if [$36]!=$F0", error));
+
+    const auto &bps = manager.getBreakpoints();
+    ASSERT_EQ(5u, bps.size());
+    ASSERT_TRUE(bps[0].type == breakpoint_type::WRITE);
+    ASSERT_EQ(0xC0E9, bps[0].address);
+    ASSERT_EQ(0xC0E9, bps[0].end_address);
+    ASSERT_TRUE(bps[1].type == breakpoint_type::READ);
+    ASSERT_EQ(0x2000, bps[1].address);
+    ASSERT_EQ(0x3FFF, bps[1].end_address);
+    ASSERT_TRUE(bps[2].bank == memory_bank::LC1);
+    // "lc2:" is an alias for "lc:"
+    ASSERT_TRUE(bps[3].bank == memory_bank::AUX_LC);
+
+    // describe() gives back the spec form
+    ASSERT_TRUE(breakpoint_manager::describe(bps[0]) == "write $C0E9");
+    ASSERT_TRUE(breakpoint_manager::describe(bps[1]) == "read $2000-$3FFF if A==#$FF");
+    ASSERT_TRUE(breakpoint_manager::describe(bps[2]) == "exec lc1:$D000");
+    ASSERT_TRUE(breakpoint_manager::describe(bps[3]) == "exec aux-lc:$E000");
+
+    ASSERT_FALSE(manager.addWatchpoint("jump $0800", error));
+    ASSERT_TRUE(error.find("unknown type") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read $3FFF-$2000", error));
+    ASSERT_TRUE(error.find("ends before") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read $12345", error));
+    ASSERT_TRUE(error.find("bad address") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read bank9:$2000", error));
+    ASSERT_TRUE(error.find("unknown bank") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read $2000 when A==1", error));
+    ASSERT_TRUE(error.find("'if'") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read $2000 if", error));
+    ASSERT_TRUE(error.find("missing condition") != std::string::npos);
+    ASSERT_FALSE(manager.addWatchpoint("read $2000 if A==", error));
+    ASSERT_FALSE(manager.addWatchpoint("read", error));
+    ASSERT_EQ(5u, manager.getBreakpoints().size());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Hits with conditions
+// ============================================================================
+bool test_conditional_hits()
+{
+    TEST_CASE("Ranges and conditions decide hits; VALUE is the opcode for exec");
+
+    RAM ram;
+    ROM rom;
+    MMU mmu(ram, rom);
+    breakpoint_manager manager;
+    uint8_t a = 0;
+    manager.setEvaluationContext([&a](watch_condition::context &ctx) { ctx.a = a; }, &mmu);
+
+    std::string error;
+    ASSERT_TRUE(manager.addWatchpoint("write $2000-$3FFF if VALUE>=$80", error));
+    ASSERT_TRUE(manager.addWatchpoint("exec $0800 if VALUE==$A9 && A==0", error));
+
+    ASSERT_FALSE(manager.checkWrite(0x1FFF, 0xFF));
+    ASSERT_FALSE(manager.checkWrite(0x2000, 0x7F));
+    ASSERT_TRUE(manager.checkWrite(0x3FFF, 0x80));
+    ASSERT_TRUE(manager.consumeHit(0x0300));
+    ASSERT_TRUE(manager.getLastHit().type == breakpoint_type::WRITE);
+    ASSERT_EQ(0x3FFF, manager.getLastHit().address);
+    ASSERT_EQ(0x80, manager.getLastHit().value);
+    ASSERT_EQ(0x0300, manager.getLastHit().pc);
+    ASSERT_FALSE(manager.consumeHit(0x0300));
+
+    // LDA #$00 at $0800
+    mmu.write(0x0800, 0xA9);
+    mmu.write(0x0801, 0x00);
+    ASSERT_TRUE(manager.checkExecution(0x0800));
+    ASSERT_TRUE(manager.consumeHit(0x0800));
+    a = 1;
+    ASSERT_FALSE(manager.checkExecution(0x0800));
+    a = 0;
+    mmu.write(0x0800, 0xEA);
+    ASSERT_FALSE(manager.checkExecution(0x0800));
+
+    // Disabled breakpoints never hit
+    manager.setEnabledAt(0, false);
+    ASSERT_FALSE(manager.checkWrite(0x3FFF, 0x80));
+    ASSERT_FALSE(manager.hasEnabledWatchpoints());
+    ASSERT_TRUE(manager.hasEnabledExecutionBreakpoints());
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Bank prefixes against the memory map
+// ============================================================================
+bool test_bank_limited_hits()
+{
+    TEST_CASE("Bank-limited breakpoints follow the soft switches");
+
+    RAM ram;
+    ROM rom;
+    MMU mmu(ram, rom);
+    breakpoint_manager manager;
+    manager.setEvaluationContext(nullptr, &mmu);
+
+    std::string error;
+    ASSERT_TRUE(manager.addWatchpoint("exec lc1:$D000", error));
+    ASSERT_TRUE(manager.addWatchpoint("write aux:$0400", error));
+    ASSERT_TRUE(manager.addWatchpoint("exec rom:$E000", error));
+
+    // ROM is mapped at power on
+    ASSERT_FALSE(manager.checkExecution(0xD000));
+    ASSERT_TRUE(manager.checkExecution(0xE000));
+    manager.consumeHit(0xE000);
+
+    // Language card bank 1 RAM, read enabled
+    mmu.read(0xC088);
+    ASSERT_TRUE(manager.bankAt(0xD000, breakpoint_type::EXECUTION) == memory_bank::LC1);
+    ASSERT_TRUE(manager.checkExecution(0xD000));
+    manager.consumeHit(0xD000);
+    ASSERT_FALSE(manager.checkExecution(0xE000));
+
+    // Writes to $0400 go to aux memory with RAMWRT on
+    ASSERT_FALSE(manager.checkWrite(0x0400, 0));
+    mmu.write(Apple2e::WRCARDRAM, 0);
+    ASSERT_TRUE(manager.checkWrite(0x0400, 0));
+    manager.consumeHit(0x0300);
+
+    // ...or with 80STORE and PAGE2
+    mmu.write(Apple2e::WRMAINRAM, 0);
+    mmu.write(Apple2e::SET80STORE, 0);
+    mmu.read(Apple2e::TXTPAGE2);
+    ASSERT_TRUE(manager.checkWrite(0x0400, 0));
+
+    // Without an MMU a bank-limited breakpoint never matches
+    breakpoint_manager unmapped;
+    ASSERT_TRUE(unmapped.addWatchpoint("exec rom:$E000", error));
+    ASSERT_FALSE(unmapped.checkExecution(0xE000));
+
+    TEST_PASS();
+    return true;
+}
+
+// ============================================================================
+// Test: Persistence
+// ============================================================================
+bool test_serialize_round_trip()
+{
+    TEST_CASE("serialize()/deserialize() keep ranges, banks, conditions and state");
+
+    breakpoint_manager manager;
+    std::string error;
+    ASSERT_TRUE(manager.addWatchpoint("read $2000-$3FFF if A==#$FF || [$36]!=$F0", error));
+    ASSERT_TRUE(manager.addWatchpoint("exec aux-lc1:$D000", error));
+    ASSERT_TRUE(manager.addWatchpoint("write $C0E9", error));
+    manager.setEnabledAt(2, false);
+
+    const std::string saved = manager.serialize();
+    breakpoint_manager restored;
+    restored.deserialize(saved);
+
+    const auto &before = manager.getBreakpoints();
+    const auto &after = restored.getBreakpoints();
+    ASSERT_EQ(before.size(), after.size());
+    for (size_t i = 0; i < before.size(); ++i)
+    {
+        ASSERT_TRUE(breakpoint_manager::describe(before[i]) == breakpoint_manager::describe(after[i]));
+        ASSERT_EQ(before[i].enabled, after[i].enabled);
+    }
+    ASSERT_TRUE(restored.serialize() == saved);
+
+    TEST_PASS();
+    return true;
+}
+
+bool test_deserialize_legacy()
+{
+    TEST_CASE("Older \"ADDR:TYPE:ENABLED\" strings still load; bad entries are skipped");
+
+    breakpoint_manager manager;
+    manager.deserialize("0800:0:1;c0e9:2:0;2000:1:1:3fff");
+
+    const auto &bps = manager.getBreakpoints();
+    ASSERT_EQ(3u, bps.size());
+    ASSERT_TRUE(breakpoint_manager::describe(bps[0]) == "exec $0800");
+    ASSERT_TRUE(bps[0].enabled);
+    ASSERT_TRUE(breakpoint_manager::describe(bps[1]) == "write $C0E9");
+    ASSERT_FALSE(bps[1].enabled);
+    ASSERT_TRUE(breakpoint_manager::describe(bps[2]) == "read $2000-$3FFF");
+    ASSERT_TRUE(bps[0].bank == memory_bank::ANY);
+    ASSERT_TRUE(manager.checkExecution(0x0800));
+
+    // Unknown types and banks, reversed ranges, bad conditions and junk
+    manager.deserialize("0800:7:1;0800:0:1:0800::9;2000:1:1:1000;0800:0:1:0800:A==:0;xyz;0300:0:1");
+    ASSERT_EQ(1u, manager.getBreakpoints().size());
+    ASSERT_TRUE(breakpoint_manager::describe(manager.getBreakpoints()[0]) == "exec $0300");
+
+    manager.deserialize("");
+    ASSERT_TRUE(manager.getBreakpoints().empty());
+    ASSERT_FALSE(manager.hasEnabledExecutionBreakpoints());
+
+    TEST_PASS();
+    return true;
+}
+
+int main()
+{
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Watch Condition and Breakpoint Spec Tests" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<std::function<bool()>> tests = {
+        // Condition compiler
+        test_operands,
+        test_precedence,
+        test_operator_lookahead,
+        test_memory_operands,
+        test_compile_errors,
+
+        // Breakpoint manager
+        test_watchpoint_specs,
+        test_conditional_hits,
+        test_bank_limited_hits,
+        test_serialize_round_trip,
+        test_deserialize_legacy,
+    };
+
+    std::cout << "Running " << tests.size() << " tests..." << std::endl;
+    std::cout << std::endl;
+
+    for (auto& test : tests)
+    {
+        test();
+    }
+
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "  Results: " << tests_passed << " passed, " << tests_failed << " failed" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << std::endl;
+
+    return tests_failed > 0 ? 1 : 0;
+}